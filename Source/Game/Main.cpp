@@ -19,11 +19,16 @@
 #include "Cube/RotatingCube.h"
 #include "Game/Game.h"
 #include "Light/RotatingPointLight.h"
+#include "Model/CpuSkinning.h"
 #include "Model/Model.h"
 #include "Renderer/Skybox.h"
+#include "Renderer/TangentGenerator.h"
 #include "Scene/Scene.h"
+#include "Scene/Terrain.h"
 #include "Scene/Voxel.h"
 #include "Shader/SkyMapVertexShader.h"
+#include "Shader/TerrainVertexShader.h"
+#include "Statistics.h"
 
 /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
   Function: wWinMain
@@ -49,10 +54,12 @@
 INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine, _In_ INT nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
 
     std::unique_ptr<library::Game> game = std::make_unique<library::Game>(L"Game Graphics Programming Assignment 3: Cube Mapping");
 
+    // With -stats, debug builds log the load and frame statistics of every subsystem
+    library::Statistics::SetLogging(lpCmdLine != nullptr && wcsstr(lpCmdLine, L"-stats") != nullptr);
+
     std::ofstream sceneFile;
     sceneFile.open("HeightMap.txt");
     constexpr const UINT MAP_WIDTH = 0;
@@ -283,6 +290,12 @@ INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         return 0;
     }
 
+    // eVoxelInstanceOrder::FILE keeps the order of the height map to compare the frame times
+    if (FAILED(mainScene->SetInstanceOrderOfVoxel(library::eVoxelInstanceOrder::MORTON_FRONT_TO_BACK)))
+    {
+        return 0;
+    }
+
     std::shared_ptr<library::Skybox> skybox = std::make_shared<library::Skybox>(L"Content/Common/Maskonaive2_1024.dds", 900.0f);
     skybox->SetVertexShader(cubeMapVertexShader);
     skybox->SetPixelShader(cubeMapPixelShader);
@@ -291,6 +304,37 @@ INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         return 0;
     }
 
+    // With -terrain, the continuous terrain of the same height map is drawn with the voxels,
+    // and its triangle count and node selection are checked once it is built
+    BOOL bTerrain = lpCmdLine != nullptr && wcsstr(lpCmdLine, L"-terrain") != nullptr;
+    if (bTerrain && mainScene->GetHeightField().IsEmpty())
+    {
+        OutputDebugStringA("Terrain: the height map is empty, set MAP_WIDTH, MAP_HEIGHT and MAP_DEPTH\n");
+        bTerrain = FALSE;
+    }
+    std::shared_ptr<library::Terrain> terrain;
+    if (bTerrain)
+    {
+        std::shared_ptr<library::TerrainVertexShader> terrainVertexShader = std::make_shared<library::TerrainVertexShader>(L"Shaders/TerrainShaders.fxh", "VSTerrain", "vs_5_0");
+        if (FAILED(mainScene->AddVertexShader(L"TerrainShader", terrainVertexShader)))
+        {
+            return 0;
+        }
+        std::shared_ptr<library::PixelShader> terrainPixelShader = std::make_shared<library::PixelShader>(L"Shaders/TerrainShaders.fxh", "PSTerrain", "ps_5_0");
+        if (FAILED(mainScene->AddPixelShader(L"TerrainShader", terrainPixelShader)))
+        {
+            return 0;
+        }
+
+        terrain = std::make_shared<library::Terrain>(mainScene->GetHeightField());
+        terrain->SetVertexShader(terrainVertexShader);
+        terrain->SetPixelShader(terrainPixelShader);
+        if (FAILED(mainScene->AddTerrain(terrain)))
+        {
+            return 0;
+        }
+    }
+
 
     //--------------------------------------------------------------------
     //  TODO: Example model definition (remove the comment)
@@ -327,6 +371,33 @@ INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     //     return 0;
     // }
 
+    // With -benchmarkskinning, the CPU skinning of the Nanosuit and the boblamp models is timed once they are loaded,
+    // with -benchmarkrays, ray casts against them, the boblamp in its skinned pose, and with -benchmarkanimation,
+    // the animation updates of the boblamp
+    BOOL bBenchmarkSkinning = lpCmdLine != nullptr && wcsstr(lpCmdLine, L"-benchmarkskinning") != nullptr;
+    BOOL bBenchmarkRays = lpCmdLine != nullptr && wcsstr(lpCmdLine, L"-benchmarkrays") != nullptr;
+    BOOL bBenchmarkAnimation = lpCmdLine != nullptr && wcsstr(lpCmdLine, L"-benchmarkanimation") != nullptr;
+    std::shared_ptr<library::Model> benchmarkNanosuit;
+    std::shared_ptr<library::Model> benchmarkBobLamp;
+    if (bBenchmarkSkinning || bBenchmarkRays || bBenchmarkAnimation)
+    {
+        benchmarkNanosuit = std::make_shared<library::Model>(L"Content/Nanosuit/nanosuit.obj");
+        benchmarkBobLamp = std::make_shared<library::Model>(L"Content/BobLampClean/boblampclean.md5mesh");
+        if (FAILED(mainScene->AddModel(L"BenchmarkNanosuit", benchmarkNanosuit)) ||
+            FAILED(mainScene->AddModel(L"BenchmarkBobLamp", benchmarkBobLamp)))
+        {
+            return 0;
+        }
+        for (PCWSTR pszModelName : { L"BenchmarkNanosuit", L"BenchmarkBobLamp" })
+        {
+            if (FAILED(mainScene->SetVertexShaderOfModel(pszModelName, L"PhongShader")) ||
+                FAILED(mainScene->SetPixelShaderOfModel(pszModelName, L"PhongShader")))
+            {
+                return 0;
+            }
+        }
+    }
+
     XMFLOAT4 color;
     XMStoreFloat4(&color, Colors::Orange);
 
@@ -411,5 +482,62 @@ INT WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         return 0;
     }
 
+    if (bTerrain)
+    {
+        // Selected from the middle of the map and from far above it
+        const library::HeightField& heightField = mainScene->GetHeightField();
+        FLOAT centerX = heightField.GetWorldX(static_cast<FLOAT>(heightField.GetWidth()) * 0.5f);
+        FLOAT centerZ = heightField.GetWorldZ(static_cast<FLOAT>(heightField.GetDepth()) * 0.5f);
+        for (FLOAT eyeHeight : { 10.0f, 500.0f })
+        {
+            UINT uNumTriangles = 0u;
+            BOOL bIsCovered = terrain->CheckSelection(XMVectorSet(centerX, eyeHeight, centerZ, 1.0f), uNumTriangles);
+
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Terrain: %u triangles from %.0f above the center, %u at full detail, voxels draw %u, selection %s\n",
+                uNumTriangles,
+                eyeHeight,
+                terrain->GetNumFullDetailTriangles(),
+                mainScene->GetNumVoxelTriangles(),
+                bIsCovered ? "covers every column once" : "FAILED"
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+    }
+
+    if (bBenchmarkSkinning)
+    {
+        // Pose the models once, so the bone palette holds the first frame of their clip
+        benchmarkNanosuit->Update(0.0f);
+        benchmarkBobLamp->Update(0.0f);
+        library::CpuSkinning::Benchmark(*benchmarkNanosuit, "Nanosuit", 100u);
+        library::CpuSkinning::Benchmark(*benchmarkBobLamp, "boblamp", 100u);
+    }
+
+    if (bBenchmarkRays)
+    {
+        benchmarkBobLamp->Update(0.0f);
+        library::CpuSkinning skinning;
+        if (FAILED(skinning.Skin(*benchmarkBobLamp)) || FAILED(benchmarkBobLamp->RefitRayBvh(skinning.GetPositions())))
+        {
+            return 0;
+        }
+        benchmarkNanosuit->GetRayBvh().Benchmark("Nanosuit", 100000u);
+        benchmarkBobLamp->GetRayBvh().Benchmark("boblamp", 100000u);
+    }
+
+    if (bBenchmarkAnimation)
+    {
+        benchmarkBobLamp->BenchmarkUpdate("boblamp", 6000u);
+    }
+
+    // With -checktangents, the tangent frames of a sphere, of mirrored UVs and of one against many threads are checked
+    if (lpCmdLine != nullptr && wcsstr(lpCmdLine, L"-checktangents") != nullptr)
+    {
+        library::TangentGenerator::Check();
+    }
+
     return game->Run();
 }
\ No newline at end of file
@@ -0,0 +1,812 @@
+#include "Model/AnimationClip.h"
+
+#include "assimp/scene.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const FLOAT CONSTANT_TOLERANCE = 1.0e-5f;
+        constexpr const FLOAT CONSTANT_ROTATION_TOLERANCE = 5.0e-5f;
+        constexpr const FLOAT SMALLEST_THREE_RANGE = 0.70710678f;
+        constexpr const FLOAT QUATERNION_COMPONENT_SCALE = 32767.0f;
+        constexpr const FLOAT TRANSLATION_COMPONENT_SCALE = 65535.0f;
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: evaluateVectorKeys
+
+          Summary:  Interpolates assimp vector keys linearly the way the
+                    keys were played before compression
+
+          Args:     const aiVectorKey* aKeys
+                      Keys sorted by time
+                    UINT uNumKeys
+                      Number of keys, at least 1
+                    DOUBLE timeInTicks
+                      Animation time
+
+          Returns:  XMFLOAT3
+                      Interpolated vector
+        -----------------------------------------------------------------F-F*/
+        XMFLOAT3 evaluateVectorKeys(_In_ const aiVectorKey* aKeys, _In_ UINT uNumKeys, _In_ DOUBLE timeInTicks)
+        {
+            const aiVectorKey* pNextKey = std::upper_bound(
+                aKeys,
+                aKeys + uNumKeys,
+                timeInTicks,
+                [](DOUBLE time, const aiVectorKey& key) { return time < key.mTime; }
+            );
+
+            aiVector3D value;
+            if (pNextKey == aKeys)
+            {
+                value = aKeys[0].mValue;
+            }
+            else if (pNextKey == aKeys + uNumKeys)
+            {
+                value = aKeys[uNumKeys - 1u].mValue;
+            }
+            else
+            {
+                const aiVectorKey& start = *(pNextKey - 1);
+                FLOAT factor = static_cast<FLOAT>((timeInTicks - start.mTime) / (pNextKey->mTime - start.mTime));
+                value = start.mValue + factor * (pNextKey->mValue - start.mValue);
+            }
+
+            return XMFLOAT3(value.x, value.y, value.z);
+        }
+
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: evaluateQuaternionKeys
+
+          Summary:  Interpolates assimp rotation keys spherically the way
+                    the keys were played before compression
+
+          Args:     const aiQuatKey* aKeys
+                      Keys sorted by time
+                    UINT uNumKeys
+                      Number of keys, at least 1
+                    DOUBLE timeInTicks
+                      Animation time
+
+          Returns:  XMFLOAT4
+                      Interpolated unit quaternion
+        -----------------------------------------------------------------F-F*/
+        XMFLOAT4 evaluateQuaternionKeys(_In_ const aiQuatKey* aKeys, _In_ UINT uNumKeys, _In_ DOUBLE timeInTicks)
+        {
+            const aiQuatKey* pNextKey = std::upper_bound(
+                aKeys,
+                aKeys + uNumKeys,
+                timeInTicks,
+                [](DOUBLE time, const aiQuatKey& key) { return time < key.mTime; }
+            );
+
+            aiQuaternion value;
+            if (pNextKey == aKeys)
+            {
+                value = aKeys[0].mValue;
+            }
+            else if (pNextKey == aKeys + uNumKeys)
+            {
+                value = aKeys[uNumKeys - 1u].mValue;
+            }
+            else
+            {
+                const aiQuatKey& start = *(pNextKey - 1);
+                FLOAT factor = static_cast<FLOAT>((timeInTicks - start.mTime) / (pNextKey->mTime - start.mTime));
+                aiQuaternion::Interpolate(value, start.mValue, pNextKey->mValue, factor);
+            }
+            value.Normalize();
+
+            return XMFLOAT4(value.x, value.y, value.z, value.w);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::AnimationClip
+
+      Summary:  Constructor of an empty clip
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AnimationClip::AnimationClip()
+        : m_name()
+        , m_ticksPerSecond(0.0f)
+        , m_duration(0.0f)
+        , m_sampleRate(0.0f)
+        , m_uNumSamples(0u)
+        , m_aChannels()
+        , m_uNumRotationTracks(0u)
+        , m_uNumTranslationTracks(0u)
+        , m_uNumScalingTracks(0u)
+        , m_aRotationSamples()
+        , m_aTranslationSamples()
+        , m_aScalingSamples()
+        , m_translationMin()
+        , m_translationExtent()
+        , m_uSourceMemorySize(0u)
+        , m_maxTranslationError(0.0f)
+        , m_maxRotationError(0.0f)
+        , m_maxScalingError(0.0f)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::Initialize
+
+      Summary:  Samples every channel of the given animation at a fixed
+                rate, drops the constant tracks and compresses the
+                others, then measures the error against the keys
+
+      Args:     const aiAnimation* pAnimation
+                  Pointer to an assimp animation object
+                PCSTR pszName
+                  Name the clip is played by
+
+      Modifies: [all members].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT AnimationClip::Initialize(_In_ const aiAnimation* pAnimation, _In_ PCSTR pszName)
+    {
+        if (pAnimation == nullptr || pAnimation->mNumChannels == 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        m_name = pszName;
+
+        m_ticksPerSecond = static_cast<FLOAT>(pAnimation->mTicksPerSecond != 0.0 ? pAnimation->mTicksPerSecond : 25.0);
+        m_duration = static_cast<FLOAT>(pAnimation->mDuration) / m_ticksPerSecond;
+
+        // Clips keyed at a low rate are sampled at their own rate so the samples fall on the keys
+        m_sampleRate = m_ticksPerSecond <= MAX_SAMPLE_RATE ? m_ticksPerSecond : DEFAULT_SAMPLE_RATE;
+        m_uNumSamples = static_cast<UINT>(std::ceil(m_duration * m_sampleRate)) + 1u;
+
+        const UINT uNumChannels = pAnimation->mNumChannels;
+
+        // Sample every channel at the fixed rate
+        std::vector<XMFLOAT4> aRotations(static_cast<SIZE_T>(uNumChannels) * m_uNumSamples);
+        std::vector<XMFLOAT3> aTranslations(static_cast<SIZE_T>(uNumChannels) * m_uNumSamples);
+        std::vector<XMFLOAT3> aScalings(static_cast<SIZE_T>(uNumChannels) * m_uNumSamples);
+
+        m_uSourceMemorySize = 0u;
+        for (UINT uChannel = 0u; uChannel < uNumChannels; ++uChannel)
+        {
+            const aiNodeAnim* pNodeAnim = pAnimation->mChannels[uChannel];
+            if (pNodeAnim->mNumRotationKeys == 0u || pNodeAnim->mNumPositionKeys == 0u || pNodeAnim->mNumScalingKeys == 0u)
+            {
+                return E_INVALIDARG;
+            }
+
+            m_uSourceMemorySize += sizeof(aiNodeAnim)
+                + pNodeAnim->mNumRotationKeys * sizeof(aiQuatKey)
+                + pNodeAnim->mNumPositionKeys * sizeof(aiVectorKey)
+                + pNodeAnim->mNumScalingKeys * sizeof(aiVectorKey);
+
+            for (UINT uSample = 0u; uSample < m_uNumSamples; ++uSample)
+            {
+                DOUBLE timeInTicks = std::min(static_cast<DOUBLE>(uSample) / m_sampleRate, static_cast<DOUBLE>(m_duration)) * m_ticksPerSecond;
+                SIZE_T uIndex = static_cast<SIZE_T>(uChannel) * m_uNumSamples + uSample;
+
+                aRotations[uIndex] = evaluateQuaternionKeys(pNodeAnim->mRotationKeys, pNodeAnim->mNumRotationKeys, timeInTicks);
+                aTranslations[uIndex] = evaluateVectorKeys(pNodeAnim->mPositionKeys, pNodeAnim->mNumPositionKeys, timeInTicks);
+                aScalings[uIndex] = evaluateVectorKeys(pNodeAnim->mScalingKeys, pNodeAnim->mNumScalingKeys, timeInTicks);
+            }
+        }
+
+        // Keep a single value of the constant tracks and number the others
+        m_aChannels.resize(uNumChannels);
+        m_uNumRotationTracks = 0u;
+        m_uNumTranslationTracks = 0u;
+        m_uNumScalingTracks = 0u;
+
+        XMVECTOR translationMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR translationMax = XMVectorReplicate(-FLT_MAX);
+
+        for (UINT uChannel = 0u; uChannel < uNumChannels; ++uChannel)
+        {
+            SIZE_T uFirst = static_cast<SIZE_T>(uChannel) * m_uNumSamples;
+            Channel& channel = m_aChannels[uChannel];
+            channel.ConstantRotation = aRotations[uFirst];
+            channel.ConstantTranslation = aTranslations[uFirst];
+            channel.ConstantScaling = aScalings[uFirst];
+
+            BOOL bIsRotationConstant = TRUE;
+            BOOL bIsTranslationConstant = TRUE;
+            BOOL bIsScalingConstant = TRUE;
+            for (UINT uSample = 1u; uSample < m_uNumSamples; ++uSample)
+            {
+                XMVECTOR rotation = XMLoadFloat4(&aRotations[uFirst + uSample]);
+                XMVECTOR constantRotation = XMLoadFloat4(&channel.ConstantRotation);
+                if (XMVectorGetX(XMVector4Dot(rotation, constantRotation)) < 0.0f)
+                {
+                    constantRotation = -constantRotation;
+                }
+                XMVECTOR translation = XMLoadFloat3(&aTranslations[uFirst + uSample]);
+                XMVECTOR scaling = XMLoadFloat3(&aScalings[uFirst + uSample]);
+
+                // Chord between the unit quaternions, about half the angle between the rotations
+                bIsRotationConstant &= XMVectorGetX(XMVector4Length(rotation - constantRotation)) <= CONSTANT_ROTATION_TOLERANCE;
+                bIsTranslationConstant &= XMVector3NearEqual(translation, XMLoadFloat3(&channel.ConstantTranslation), XMVectorReplicate(CONSTANT_TOLERANCE));
+                bIsScalingConstant &= XMVector3NearEqual(scaling, XMLoadFloat3(&channel.ConstantScaling), XMVectorReplicate(CONSTANT_TOLERANCE));
+            }
+
+            channel.uRotationTrack = bIsRotationConstant ? INVALID_TRACK : m_uNumRotationTracks++;
+            channel.uTranslationTrack = bIsTranslationConstant ? INVALID_TRACK : m_uNumTranslationTracks++;
+            channel.uScalingTrack = bIsScalingConstant ? INVALID_TRACK : m_uNumScalingTracks++;
+
+            if (!bIsTranslationConstant)
+            {
+                for (UINT uSample = 0u; uSample < m_uNumSamples; ++uSample)
+                {
+                    XMVECTOR translation = XMLoadFloat3(&aTranslations[uFirst + uSample]);
+                    translationMin = XMVectorMin(translationMin, translation);
+                    translationMax = XMVectorMax(translationMax, translation);
+                }
+            }
+        }
+
+        if (m_uNumTranslationTracks > 0u)
+        {
+            XMStoreFloat3(&m_translationMin, translationMin);
+            XMStoreFloat3(&m_translationExtent, translationMax - translationMin);
+        }
+        else
+        {
+            m_translationMin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            m_translationExtent = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+
+        // Store the animated tracks sample by sample, so a pose reads one contiguous run per track kind
+        m_aRotationSamples.resize(static_cast<SIZE_T>(m_uNumRotationTracks) * m_uNumSamples);
+        m_aTranslationSamples.resize(static_cast<SIZE_T>(m_uNumTranslationTracks) * m_uNumSamples);
+        m_aScalingSamples.resize(static_cast<SIZE_T>(m_uNumScalingTracks) * m_uNumSamples);
+
+        for (UINT uChannel = 0u; uChannel < uNumChannels; ++uChannel)
+        {
+            SIZE_T uFirst = static_cast<SIZE_T>(uChannel) * m_uNumSamples;
+            const Channel& channel = m_aChannels[uChannel];
+
+            for (UINT uSample = 0u; uSample < m_uNumSamples; ++uSample)
+            {
+                if (channel.uRotationTrack != INVALID_TRACK)
+                {
+                    m_aRotationSamples[static_cast<SIZE_T>(uSample) * m_uNumRotationTracks + channel.uRotationTrack] = compressQuaternion(aRotations[uFirst + uSample]);
+                }
+                if (channel.uTranslationTrack != INVALID_TRACK)
+                {
+                    m_aTranslationSamples[static_cast<SIZE_T>(uSample) * m_uNumTranslationTracks + channel.uTranslationTrack] = quantizeTranslation(aTranslations[uFirst + uSample]);
+                }
+                if (channel.uScalingTrack != INVALID_TRACK)
+                {
+                    m_aScalingSamples[static_cast<SIZE_T>(uSample) * m_uNumScalingTracks + channel.uScalingTrack] = aScalings[uFirst + uSample];
+                }
+            }
+        }
+
+        measureError(pAnimation);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::Initialize
+
+      Summary:  Reads back a clip written by WriteToCache, so a cached
+                model is neither resampled nor measured again
+
+      Args:     MeshCache& cache
+                  Opened cache, positioned at the clip
+
+      Modifies: [all members].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the cached clip is malformed
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT AnimationClip::Initialize(_Inout_ MeshCache& cache)
+    {
+        UINT64 uSourceMemorySize = 0ull;
+
+        HRESULT hr = S_OK;
+        if (FAILED(hr = cache.ReadString(m_name)) ||
+            FAILED(hr = cache.Read(m_ticksPerSecond)) ||
+            FAILED(hr = cache.Read(m_duration)) ||
+            FAILED(hr = cache.Read(m_sampleRate)) ||
+            FAILED(hr = cache.Read(m_uNumSamples)) ||
+            FAILED(hr = cache.Read(m_aChannels)) ||
+            FAILED(hr = cache.Read(m_uNumRotationTracks)) ||
+            FAILED(hr = cache.Read(m_uNumTranslationTracks)) ||
+            FAILED(hr = cache.Read(m_uNumScalingTracks)) ||
+            FAILED(hr = cache.Read(m_aRotationSamples)) ||
+            FAILED(hr = cache.Read(m_aTranslationSamples)) ||
+            FAILED(hr = cache.Read(m_aScalingSamples)) ||
+            FAILED(hr = cache.Read(m_translationMin)) ||
+            FAILED(hr = cache.Read(m_translationExtent)) ||
+            FAILED(hr = cache.Read(uSourceMemorySize)) ||
+            FAILED(hr = cache.Read(m_maxTranslationError)) ||
+            FAILED(hr = cache.Read(m_maxRotationError)) ||
+            FAILED(hr = cache.Read(m_maxScalingError)))
+        {
+            return hr;
+        }
+
+        m_uSourceMemorySize = static_cast<SIZE_T>(uSourceMemorySize);
+
+        // Sampling indexes the tracks without checks, so they are checked once here
+        if (m_aChannels.empty() ||
+            m_uNumSamples == 0u ||
+            m_aRotationSamples.size() != static_cast<SIZE_T>(m_uNumRotationTracks) * m_uNumSamples ||
+            m_aTranslationSamples.size() != static_cast<SIZE_T>(m_uNumTranslationTracks) * m_uNumSamples ||
+            m_aScalingSamples.size() != static_cast<SIZE_T>(m_uNumScalingTracks) * m_uNumSamples)
+        {
+            return E_FAIL;
+        }
+
+        for (const Channel& channel : m_aChannels)
+        {
+            if ((channel.uRotationTrack != INVALID_TRACK && channel.uRotationTrack >= m_uNumRotationTracks) ||
+                (channel.uTranslationTrack != INVALID_TRACK && channel.uTranslationTrack >= m_uNumTranslationTracks) ||
+                (channel.uScalingTrack != INVALID_TRACK && channel.uScalingTrack >= m_uNumScalingTracks))
+            {
+                return E_FAIL;
+            }
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::WriteToCache
+
+      Summary:  Appends the compressed tracks and the measured errors
+                to a mesh cache, in the order Initialize reads them
+
+      Args:     MeshCache& cache
+                  Cache being built
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationClip::WriteToCache(_Inout_ MeshCache& cache) const
+    {
+        cache.WriteString(m_name);
+        cache.Write(m_ticksPerSecond);
+        cache.Write(m_duration);
+        cache.Write(m_sampleRate);
+        cache.Write(m_uNumSamples);
+        cache.Write(m_aChannels);
+        cache.Write(m_uNumRotationTracks);
+        cache.Write(m_uNumTranslationTracks);
+        cache.Write(m_uNumScalingTracks);
+        cache.Write(m_aRotationSamples);
+        cache.Write(m_aTranslationSamples);
+        cache.Write(m_aScalingSamples);
+        cache.Write(m_translationMin);
+        cache.Write(m_translationExtent);
+        cache.Write(static_cast<UINT64>(m_uSourceMemorySize));
+        cache.Write(m_maxTranslationError);
+        cache.Write(m_maxRotationError);
+        cache.Write(m_maxScalingError);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::Sample
+
+      Summary:  Interpolates the two samples around the given time
+
+      Args:     FLOAT time
+                  Time in seconds, clamped to the clip
+                UINT uChannelIndex
+                  Index of the channel
+                XMVECTOR& outScaling
+                XMVECTOR& outRotation
+                XMVECTOR& outTranslation
+                  Scaling, rotation quaternion and translation
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationClip::Sample(_In_ FLOAT time, _In_ UINT uChannelIndex, _Out_ XMVECTOR& outScaling, _Out_ XMVECTOR& outRotation, _Out_ XMVECTOR& outTranslation) const
+    {
+        const Channel& channel = m_aChannels[uChannelIndex];
+
+        FLOAT sample = std::clamp(time * m_sampleRate, 0.0f, static_cast<FLOAT>(m_uNumSamples - 1u));
+        UINT uSample = static_cast<UINT>(sample);
+        UINT uNextSample = std::min(uSample + 1u, m_uNumSamples - 1u);
+        FLOAT factor = sample - static_cast<FLOAT>(uSample);
+
+        if (channel.uRotationTrack != INVALID_TRACK)
+        {
+            outRotation = XMQuaternionSlerp(
+                decompressQuaternion(m_aRotationSamples[static_cast<SIZE_T>(uSample) * m_uNumRotationTracks + channel.uRotationTrack]),
+                decompressQuaternion(m_aRotationSamples[static_cast<SIZE_T>(uNextSample) * m_uNumRotationTracks + channel.uRotationTrack]),
+                factor
+            );
+        }
+        else
+        {
+            outRotation = XMLoadFloat4(&channel.ConstantRotation);
+        }
+
+        if (channel.uTranslationTrack != INVALID_TRACK)
+        {
+            outTranslation = XMVectorLerp(
+                dequantizeTranslation(m_aTranslationSamples[static_cast<SIZE_T>(uSample) * m_uNumTranslationTracks + channel.uTranslationTrack]),
+                dequantizeTranslation(m_aTranslationSamples[static_cast<SIZE_T>(uNextSample) * m_uNumTranslationTracks + channel.uTranslationTrack]),
+                factor
+            );
+        }
+        else
+        {
+            outTranslation = XMLoadFloat3(&channel.ConstantTranslation);
+        }
+
+        if (channel.uScalingTrack != INVALID_TRACK)
+        {
+            outScaling = XMVectorLerp(
+                XMLoadFloat3(&m_aScalingSamples[static_cast<SIZE_T>(uSample) * m_uNumScalingTracks + channel.uScalingTrack]),
+                XMLoadFloat3(&m_aScalingSamples[static_cast<SIZE_T>(uNextSample) * m_uNumScalingTracks + channel.uScalingTrack]),
+                factor
+            );
+        }
+        else
+        {
+            outScaling = XMLoadFloat3(&channel.ConstantScaling);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::SamplePose
+
+      Summary:  Samples every channel at the given time
+
+      Args:     FLOAT time
+                  Time in seconds, clamped to the clip
+                AnimationPose& outPose
+                  Pose indexed by channel, resized to the channels
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationClip::SamplePose(_In_ FLOAT time, _Inout_ AnimationPose& outPose) const
+    {
+        outPose.aScalings.resize(m_aChannels.size());
+        outPose.aRotations.resize(m_aChannels.size());
+        outPose.aTranslations.resize(m_aChannels.size());
+
+        for (UINT i = 0u; i < m_aChannels.size(); ++i)
+        {
+            Sample(time, i, outPose.aScalings[i], outPose.aRotations[i], outPose.aTranslations[i]);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetName
+
+      Summary:  Returns the name of the clip
+
+      Returns:  const std::string&
+                  Name of the clip
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::string& AnimationClip::GetName() const
+    {
+        return m_name;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetNumChannels
+
+      Summary:  Returns the number of channels, 0 before the clip is
+                initialized
+
+      Returns:  UINT
+                  Number of channels
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT AnimationClip::GetNumChannels() const
+    {
+        return static_cast<UINT>(m_aChannels.size());
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetDuration
+
+      Summary:  Returns the duration of the clip
+
+      Returns:  FLOAT
+                  Duration in seconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationClip::GetDuration() const
+    {
+        return m_duration;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetSampleRate
+
+      Summary:  Returns the rate the clip was sampled at
+
+      Returns:  FLOAT
+                  Samples per second
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationClip::GetSampleRate() const
+    {
+        return m_sampleRate;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetMemorySize
+
+      Summary:  Returns the memory taken by the channels and the
+                compressed samples
+
+      Returns:  SIZE_T
+                  Size in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    SIZE_T AnimationClip::GetMemorySize() const
+    {
+        return sizeof(AnimationClip)
+            + m_aChannels.size() * sizeof(Channel)
+            + m_aRotationSamples.size() * sizeof(CompressedQuaternion)
+            + m_aTranslationSamples.size() * sizeof(QuantizedVector)
+            + m_aScalingSamples.size() * sizeof(XMFLOAT3);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetSourceMemorySize
+
+      Summary:  Returns the memory the channels and keys of the assimp
+                animation took
+
+      Returns:  SIZE_T
+                  Size in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    SIZE_T AnimationClip::GetSourceMemorySize() const
+    {
+        return m_uSourceMemorySize;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetMaxTranslationError
+
+      Summary:  Returns the largest distance between a sampled and a
+                keyed translation
+
+      Returns:  FLOAT
+                  Distance in model units
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationClip::GetMaxTranslationError() const
+    {
+        return m_maxTranslationError;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetMaxRotationError
+
+      Summary:  Returns the largest angle between a sampled and a keyed
+                rotation
+
+      Returns:  FLOAT
+                  Angle in radians
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationClip::GetMaxRotationError() const
+    {
+        return m_maxRotationError;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::GetMaxScalingError
+
+      Summary:  Returns the largest distance between a sampled and a
+                keyed scaling
+
+      Returns:  FLOAT
+                  Distance between the scaling vectors
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationClip::GetMaxScalingError() const
+    {
+        return m_maxScalingError;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::compressQuaternion
+
+      Summary:  Drops the largest component of the unit quaternion,
+                which is recovered from the other three. The index of
+                the dropped component takes the top bits of the first
+                two words, the other components 15 bits each
+
+      Args:     const XMFLOAT4& quaternion
+                  Unit quaternion
+
+      Returns:  CompressedQuaternion
+                  Quaternion in 48 bits
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AnimationClip::CompressedQuaternion AnimationClip::compressQuaternion(_In_ const XMFLOAT4& quaternion)
+    {
+        const FLOAT aComponents[4] = { quaternion.x, quaternion.y, quaternion.z, quaternion.w };
+
+        UINT uLargest = 0u;
+        for (UINT i = 1u; i < 4u; ++i)
+        {
+            if (std::abs(aComponents[i]) > std::abs(aComponents[uLargest]))
+            {
+                uLargest = i;
+            }
+        }
+
+        // q and -q are the same rotation, so the dropped component is made positive
+        FLOAT sign = aComponents[uLargest] < 0.0f ? -1.0f : 1.0f;
+
+        CompressedQuaternion compressed = {};
+        UINT uSlot = 0u;
+        for (UINT i = 0u; i < 4u; ++i)
+        {
+            if (i == uLargest)
+            {
+                continue;
+            }
+
+            FLOAT normalized = (sign * aComponents[i] + SMALLEST_THREE_RANGE) / (2.0f * SMALLEST_THREE_RANGE);
+            compressed.aComponents[uSlot++] = static_cast<WORD>(std::lround(std::clamp(normalized, 0.0f, 1.0f) * QUATERNION_COMPONENT_SCALE));
+        }
+
+        compressed.aComponents[0] |= static_cast<WORD>((uLargest >> 1u) << 15u);
+        compressed.aComponents[1] |= static_cast<WORD>((uLargest & 1u) << 15u);
+
+        return compressed;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::decompressQuaternion
+
+      Summary:  Rebuilds the unit quaternion from its smallest three
+                components
+
+      Args:     const CompressedQuaternion& compressed
+                  Quaternion in 48 bits
+
+      Returns:  XMVECTOR
+                  Unit quaternion
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    XMVECTOR AnimationClip::decompressQuaternion(_In_ const CompressedQuaternion& compressed)
+    {
+        UINT uLargest = ((compressed.aComponents[0] >> 15u) << 1u) | (compressed.aComponents[1] >> 15u);
+
+        FLOAT aSmallest[3];
+        FLOAT sumOfSquares = 0.0f;
+        for (UINT i = 0u; i < 3u; ++i)
+        {
+            FLOAT normalized = static_cast<FLOAT>(compressed.aComponents[i] & 0x7FFF) / QUATERNION_COMPONENT_SCALE;
+            aSmallest[i] = normalized * 2.0f * SMALLEST_THREE_RANGE - SMALLEST_THREE_RANGE;
+            sumOfSquares += aSmallest[i] * aSmallest[i];
+        }
+
+        FLOAT aComponents[4];
+        UINT uSlot = 0u;
+        for (UINT i = 0u; i < 4u; ++i)
+        {
+            aComponents[i] = i == uLargest ? std::sqrt(std::max(1.0f - sumOfSquares, 0.0f)) : aSmallest[uSlot++];
+        }
+
+        return XMQuaternionNormalize(XMVectorSet(aComponents[0], aComponents[1], aComponents[2], aComponents[3]));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::quantizeTranslation
+
+      Summary:  Quantizes a translation to 16 bits per component within
+                the translation bounds of the clip
+
+      Args:     const XMFLOAT3& translation
+                  Translation inside the bounds
+
+      Returns:  QuantizedVector
+                  Quantized translation
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AnimationClip::QuantizedVector AnimationClip::quantizeTranslation(_In_ const XMFLOAT3& translation) const
+    {
+        const FLOAT aValues[3] = { translation.x, translation.y, translation.z };
+        const FLOAT aMin[3] = { m_translationMin.x, m_translationMin.y, m_translationMin.z };
+        const FLOAT aExtent[3] = { m_translationExtent.x, m_translationExtent.y, m_translationExtent.z };
+
+        QuantizedVector quantized = {};
+        for (UINT i = 0u; i < 3u; ++i)
+        {
+            FLOAT normalized = aExtent[i] > 0.0f ? (aValues[i] - aMin[i]) / aExtent[i] : 0.0f;
+            quantized.aComponents[i] = static_cast<WORD>(std::lround(std::clamp(normalized, 0.0f, 1.0f) * TRANSLATION_COMPONENT_SCALE));
+        }
+
+        return quantized;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::dequantizeTranslation
+
+      Summary:  Maps a quantized translation back into the bounds of
+                the clip
+
+      Args:     const QuantizedVector& quantized
+                  Quantized translation
+
+      Returns:  XMVECTOR
+                  Translation
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    XMVECTOR AnimationClip::dequantizeTranslation(_In_ const QuantizedVector& quantized) const
+    {
+        XMVECTOR normalized = XMVectorSet(
+            static_cast<FLOAT>(quantized.aComponents[0]),
+            static_cast<FLOAT>(quantized.aComponents[1]),
+            static_cast<FLOAT>(quantized.aComponents[2]),
+            0.0f
+        ) / TRANSLATION_COMPONENT_SCALE;
+
+        return XMVectorMultiplyAdd(normalized, XMLoadFloat3(&m_translationExtent), XMLoadFloat3(&m_translationMin));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationClip::measureError
+
+      Summary:  Compares the clip against the assimp keys at
+                NUM_ERROR_STEPS_PER_SAMPLE times between samples
+
+      Args:     const aiAnimation* pAnimation
+                  Animation the clip was built from
+
+      Modifies: [m_maxTranslationError, m_maxRotationError,
+                 m_maxScalingError].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationClip::measureError(_In_ const aiAnimation* pAnimation)
+    {
+        m_maxTranslationError = 0.0f;
+        m_maxRotationError = 0.0f;
+        m_maxScalingError = 0.0f;
+
+        UINT uNumSteps = (m_uNumSamples - 1u) * NUM_ERROR_STEPS_PER_SAMPLE + 1u;
+        for (UINT uStep = 0u; uStep < uNumSteps; ++uStep)
+        {
+            FLOAT time = std::min(static_cast<FLOAT>(uStep) / (m_sampleRate * NUM_ERROR_STEPS_PER_SAMPLE), m_duration);
+            DOUBLE timeInTicks = static_cast<DOUBLE>(time) * m_ticksPerSecond;
+
+            for (UINT uChannel = 0u; uChannel < pAnimation->mNumChannels; ++uChannel)
+            {
+                const aiNodeAnim* pNodeAnim = pAnimation->mChannels[uChannel];
+
+                XMVECTOR scaling;
+                XMVECTOR rotation;
+                XMVECTOR translation;
+                Sample(time, uChannel, scaling, rotation, translation);
+
+                XMFLOAT4 keyedRotation = evaluateQuaternionKeys(pNodeAnim->mRotationKeys, pNodeAnim->mNumRotationKeys, timeInTicks);
+                XMFLOAT3 keyedTranslation = evaluateVectorKeys(pNodeAnim->mPositionKeys, pNodeAnim->mNumPositionKeys, timeInTicks);
+                XMFLOAT3 keyedScaling = evaluateVectorKeys(pNodeAnim->mScalingKeys, pNodeAnim->mNumScalingKeys, timeInTicks);
+
+                // The chord between the unit quaternions keeps its precision for small angles, unlike acos of their dot product
+                XMVECTOR keyed = XMLoadFloat4(&keyedRotation);
+                if (XMVectorGetX(XMVector4Dot(rotation, keyed)) < 0.0f)
+                {
+                    keyed = -keyed;
+                }
+                FLOAT chord = std::min(XMVectorGetX(XMVector4Length(rotation - keyed)), 2.0f);
+                m_maxRotationError = std::max(m_maxRotationError, 4.0f * std::asin(0.5f * chord));
+                m_maxTranslationError = std::max(m_maxTranslationError, XMVectorGetX(XMVector3Length(translation - XMLoadFloat3(&keyedTranslation))));
+                m_maxScalingError = std::max(m_maxScalingError, XMVectorGetX(XMVector3Length(scaling - XMLoadFloat3(&keyedScaling))));
+            }
+        }
+    }
+}
@@ -0,0 +1,172 @@
+/*+===================================================================
+  File:      ANIMATIONCLIP.H
+
+  Summary:   AnimationClip header file contains declarations of
+             AnimationClip class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: AnimationClip
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Model/MeshCache.h"
+
+struct aiAnimation;
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   AnimationPose
+
+      Summary:  Local scalings, rotation quaternions and translations,
+                one array per component kind, indexed by channel for a
+                sampled clip or by skeleton node for a blended pose
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct AnimationPose
+    {
+        std::vector<XMVECTOR> aScalings;
+        std::vector<XMVECTOR> aRotations;
+        std::vector<XMVECTOR> aTranslations;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    AnimationClip
+
+      Summary:  Skeletal animation resampled at a fixed rate and
+                compressed. Every channel of the assimp animation gets
+                a rotation, a translation and a scaling track. Constant
+                tracks keep a single value, the others store one value
+                per sample, laid out sample by sample across tracks:
+                rotations as the smallest three components in 48 bits,
+                translations as 16 bits per component within the
+                bounds of the clip, scalings as floats. Sampling is a
+                direct index into the samples around the given time
+
+      Methods:  Initialize
+                  Resamples and compresses the given animation, or
+                  reads a clip back from a mesh cache
+                WriteToCache
+                  Appends the compressed clip to a mesh cache
+                Sample
+                  Returns the scaling, rotation and translation of a
+                  channel at the given time
+                SamplePose
+                  Samples every channel at the given time
+                GetName
+                  Returns the name of the clip
+                GetNumChannels
+                  Returns the number of channels
+                GetDuration
+                  Returns the duration in seconds
+                GetSampleRate
+                  Returns the number of samples per second
+                GetMemorySize
+                  Returns the bytes taken by the compressed tracks
+                GetSourceMemorySize
+                  Returns the bytes taken by the assimp keys
+                GetMaxTranslationError
+                GetMaxRotationError
+                GetMaxScalingError
+                  Return the largest errors against the assimp keys
+                AnimationClip
+                  Constructor.
+                ~AnimationClip
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class AnimationClip
+    {
+    public:
+        static constexpr const FLOAT DEFAULT_SAMPLE_RATE = 30.0f;
+        static constexpr const FLOAT MAX_SAMPLE_RATE = 60.0f;
+        static constexpr const UINT NUM_ERROR_STEPS_PER_SAMPLE = 4u;
+
+    public:
+        AnimationClip();
+        AnimationClip(const AnimationClip& other) = delete;
+        AnimationClip(AnimationClip&& other) = delete;
+        AnimationClip& operator=(const AnimationClip& other) = delete;
+        AnimationClip& operator=(AnimationClip&& other) = delete;
+        ~AnimationClip() = default;
+
+        HRESULT Initialize(_In_ const aiAnimation* pAnimation, _In_ PCSTR pszName);
+        HRESULT Initialize(_Inout_ MeshCache& cache);
+        void WriteToCache(_Inout_ MeshCache& cache) const;
+
+        void Sample(_In_ FLOAT time, _In_ UINT uChannelIndex, _Out_ XMVECTOR& outScaling, _Out_ XMVECTOR& outRotation, _Out_ XMVECTOR& outTranslation) const;
+        void SamplePose(_In_ FLOAT time, _Inout_ AnimationPose& outPose) const;
+
+        const std::string& GetName() const;
+
+        UINT GetNumChannels() const;
+        FLOAT GetDuration() const;
+        FLOAT GetSampleRate() const;
+        SIZE_T GetMemorySize() const;
+        SIZE_T GetSourceMemorySize() const;
+        FLOAT GetMaxTranslationError() const;
+        FLOAT GetMaxRotationError() const;
+        FLOAT GetMaxScalingError() const;
+
+    private:
+        struct CompressedQuaternion
+        {
+            WORD aComponents[3];
+        };
+
+        struct QuantizedVector
+        {
+            WORD aComponents[3];
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Channel
+
+          Summary:  Tracks of a node. A track index of INVALID_TRACK
+                    means the track is constant and its value is kept
+                    in the channel
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Channel
+        {
+            UINT uRotationTrack;
+            UINT uTranslationTrack;
+            UINT uScalingTrack;
+            XMFLOAT4 ConstantRotation;
+            XMFLOAT3 ConstantTranslation;
+            XMFLOAT3 ConstantScaling;
+        };
+
+        static constexpr const UINT INVALID_TRACK = (0xFFFFFFFF);
+
+        static CompressedQuaternion compressQuaternion(_In_ const XMFLOAT4& quaternion);
+        static XMVECTOR decompressQuaternion(_In_ const CompressedQuaternion& compressed);
+        QuantizedVector quantizeTranslation(_In_ const XMFLOAT3& translation) const;
+        XMVECTOR dequantizeTranslation(_In_ const QuantizedVector& quantized) const;
+        void measureError(_In_ const aiAnimation* pAnimation);
+
+    private:
+        std::string m_name;
+        FLOAT m_ticksPerSecond;
+        FLOAT m_duration;
+        FLOAT m_sampleRate;
+        UINT m_uNumSamples;
+
+        std::vector<Channel> m_aChannels;
+        UINT m_uNumRotationTracks;
+        UINT m_uNumTranslationTracks;
+        UINT m_uNumScalingTracks;
+        std::vector<CompressedQuaternion> m_aRotationSamples;
+        std::vector<QuantizedVector> m_aTranslationSamples;
+        std::vector<XMFLOAT3> m_aScalingSamples;
+
+        XMFLOAT3 m_translationMin;
+        XMFLOAT3 m_translationExtent;
+
+        SIZE_T m_uSourceMemorySize;
+        FLOAT m_maxTranslationError;
+        FLOAT m_maxRotationError;
+        FLOAT m_maxScalingError;
+    };
+}
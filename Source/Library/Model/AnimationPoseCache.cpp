@@ -0,0 +1,104 @@
+#include "Model/AnimationPoseCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationPoseCache::AnimationPoseCache
+
+      Summary:  Constructor of an empty cache
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AnimationPoseCache::AnimationPoseCache()
+        : m_aSlots(NUM_SLOTS, Slot{ nullptr, 0u, AnimationPose() })
+        , m_uNumHits(0u)
+        , m_uNumMisses(0u)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationPoseCache::GetPose
+
+      Summary:  Rounds the time to a step of the clip and returns the
+                pose cached for it, sampling the clip into the slot of
+                the step when another pose holds it
+
+      Args:     const AnimationClip& clip
+                  Clip to sample
+                FLOAT time
+                  Time in seconds
+
+      Modifies: [m_aSlots, m_uNumHits, m_uNumMisses].
+
+      Returns:  const AnimationPose&
+                  Pose indexed by the channels of the clip
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const AnimationPose& AnimationPoseCache::GetPose(_In_ const AnimationClip& clip, _In_ FLOAT time)
+    {
+        FLOAT stepsPerSecond = clip.GetSampleRate() * static_cast<FLOAT>(STEPS_PER_SAMPLE);
+        UINT uStep = static_cast<UINT>(std::lround(std::max(time, 0.0f) * stepsPerSecond));
+
+        // Spread the clips over the table, consecutive steps of a clip fall in consecutive slots
+        SIZE_T uClipHash = reinterpret_cast<SIZE_T>(&clip) / alignof(AnimationClip);
+        Slot& slot = m_aSlots[(uClipHash * 2654435761u + uStep) % NUM_SLOTS];
+
+        if (slot.pClip == &clip && slot.uStep == uStep)
+        {
+            ++m_uNumHits;
+            return slot.Pose;
+        }
+
+        clip.SamplePose(static_cast<FLOAT>(uStep) / stepsPerSecond, slot.Pose);
+        slot.pClip = &clip;
+        slot.uStep = uStep;
+        ++m_uNumMisses;
+
+        return slot.Pose;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationPoseCache::GetNumHits
+
+      Summary:  Returns the number of poses found in the cache since
+                the counters were reset
+
+      Returns:  UINT
+                  Number of hits
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT AnimationPoseCache::GetNumHits() const
+    {
+        return m_uNumHits;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationPoseCache::GetNumMisses
+
+      Summary:  Returns the number of poses sampled since the counters
+                were reset
+
+      Returns:  UINT
+                  Number of misses
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT AnimationPoseCache::GetNumMisses() const
+    {
+        return m_uNumMisses;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationPoseCache::ResetCounters
+
+      Summary:  Clears the hit and miss counters
+
+      Modifies: [m_uNumHits, m_uNumMisses].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationPoseCache::ResetCounters()
+    {
+        m_uNumHits = 0u;
+        m_uNumMisses = 0u;
+    }
+}
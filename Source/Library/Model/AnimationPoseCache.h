@@ -0,0 +1,78 @@
+/*+===================================================================
+  File:      ANIMATIONPOSECACHE.H
+
+  Summary:   AnimationPoseCache header file contains declarations of
+             AnimationPoseCache class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: AnimationPoseCache
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Model/AnimationClip.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    AnimationPoseCache
+
+      Summary:  Poses of the clips sampled at quantized times, shared
+                by every model that plays the same clip. The time is
+                rounded to STEPS_PER_SAMPLE steps between two samples
+                of the clip, and a clip and a step map to one slot of
+                a fixed table, so a crowd playing the same clip in
+                step evaluates each pose once. A pose is only valid
+                until the next call, which may reuse its slot
+
+      Methods:  GetPose
+                  Returns the pose of a clip at the quantized time,
+                  sampling it when it is not cached
+                GetNumHits
+                  Returns the number of poses found in the cache
+                GetNumMisses
+                  Returns the number of poses sampled
+                ResetCounters
+                  Clears the hit and miss counters
+                AnimationPoseCache
+                  Constructor.
+                ~AnimationPoseCache
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class AnimationPoseCache
+    {
+    public:
+        static constexpr const UINT NUM_SLOTS = 256u;
+        static constexpr const UINT STEPS_PER_SAMPLE = 4u;
+
+    public:
+        AnimationPoseCache();
+        AnimationPoseCache(const AnimationPoseCache& other) = delete;
+        AnimationPoseCache(AnimationPoseCache&& other) = delete;
+        AnimationPoseCache& operator=(const AnimationPoseCache& other) = delete;
+        AnimationPoseCache& operator=(AnimationPoseCache&& other) = delete;
+        ~AnimationPoseCache() = default;
+
+        const AnimationPose& GetPose(_In_ const AnimationClip& clip, _In_ FLOAT time);
+
+        UINT GetNumHits() const;
+        UINT GetNumMisses() const;
+        void ResetCounters();
+
+    private:
+        struct Slot
+        {
+            const AnimationClip* pClip;
+            UINT uStep;
+            AnimationPose Pose;
+        };
+
+    private:
+        std::vector<Slot> m_aSlots;
+        UINT m_uNumHits;
+        UINT m_uNumMisses;
+    };
+}
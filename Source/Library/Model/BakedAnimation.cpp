@@ -0,0 +1,411 @@
+#include "Model/BakedAnimation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::BakedAnimation
+
+      Summary:  Constructor of an empty bake
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BakedAnimation::BakedAnimation()
+        : m_aClips()
+        , m_uNumBones(0u)
+        , m_uNumFrames(0u)
+        , m_aTexels()
+        , m_texture()
+        , m_textureView()
+        , m_maxError(0.0f)
+        , m_bakeTime(0.0f)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::Bake
+
+      Summary:  Evaluates the bone transforms of every clip of the
+                model at the sample rate of the clip, then measures the
+                error of the interpolated frames against the clips
+                evaluated directly in between. Runs on the CPU only
+
+      Args:     Model& model
+                  Initialized model with at least one clip
+
+      Modifies: [m_aClips, m_uNumBones, m_uNumFrames, m_aTexels,
+                 m_maxError, m_bakeTime].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL when the model has no clips or the
+                  texture would exceed the Direct3D 11 limits
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT BakedAnimation::Bake(_In_ Model& model)
+    {
+        LARGE_INTEGER startingTime;
+        LARGE_INTEGER endingTime;
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        const std::vector<std::shared_ptr<AnimationClip>>& aAnimationClips = model.GetAnimationClips();
+        if (aAnimationClips.empty())
+        {
+            return E_FAIL;
+        }
+
+        // Lay the clips out one after the other, each frame a row
+        m_aClips.clear();
+        m_uNumFrames = 0u;
+        for (const std::shared_ptr<AnimationClip>& clip : aAnimationClips)
+        {
+            FLOAT duration = clip->GetDuration();
+            UINT uNumFrames = std::max(static_cast<UINT>(std::ceil(duration * clip->GetSampleRate())) + 1u, 2u);
+
+            m_aClips.push_back(
+                {
+                    .uFrameOffset = m_uNumFrames,
+                    .uNumFrames = uNumFrames,
+                    .frameRate = duration > 0.0f ? static_cast<FLOAT>(uNumFrames - 1u) / duration : clip->GetSampleRate(),
+                    .duration = duration
+                }
+            );
+            m_uNumFrames += uNumFrames;
+        }
+
+        m_uNumBones = static_cast<UINT>(model.GetBoneTransforms().size());
+        if (m_uNumBones == 0u || m_uNumBones * TEXELS_PER_BONE > MAX_TEXTURE_DIMENSION || m_uNumFrames > MAX_TEXTURE_DIMENSION)
+        {
+            m_aClips.clear();
+            m_uNumFrames = 0u;
+            return E_FAIL;
+        }
+
+        m_aTexels.resize(static_cast<SIZE_T>(m_uNumFrames) * m_uNumBones * TEXELS_PER_BONE);
+
+        std::vector<XMMATRIX> aBoneTransforms;
+        for (UINT uClipIndex = 0u; uClipIndex < m_aClips.size(); ++uClipIndex)
+        {
+            const BakedClip& clip = m_aClips[uClipIndex];
+            for (UINT uFrame = 0u; uFrame < clip.uNumFrames; ++uFrame)
+            {
+                FLOAT time = std::min(static_cast<FLOAT>(uFrame) / clip.frameRate, clip.duration);
+                HRESULT hr = model.EvaluateClip(uClipIndex, time, aBoneTransforms);
+                if (FAILED(hr))
+                {
+                    return hr;
+                }
+
+                // The columns of a bone transform are the rows of its transpose
+                XMFLOAT4* pRow = &m_aTexels[static_cast<SIZE_T>(clip.uFrameOffset + uFrame) * m_uNumBones * TEXELS_PER_BONE];
+                for (UINT uBoneIndex = 0u; uBoneIndex < m_uNumBones; ++uBoneIndex)
+                {
+                    XMMATRIX transposed = XMMatrixTranspose(aBoneTransforms[uBoneIndex]);
+                    for (UINT i = 0u; i < TEXELS_PER_BONE; ++i)
+                    {
+                        XMStoreFloat4(&pRow[uBoneIndex * TEXELS_PER_BONE + i], transposed.r[i]);
+                    }
+                }
+            }
+        }
+
+        HRESULT hr = measureError(model);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        QueryPerformanceCounter(&endingTime);
+        m_bakeTime = static_cast<FLOAT>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0f / static_cast<FLOAT>(frequency.QuadPart);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::Initialize
+
+      Summary:  Creates the texture of the baked frames
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the texture
+
+      Modifies: [m_texture, m_textureView].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL before the clips are baked
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT BakedAnimation::Initialize(_In_ ID3D11Device* pDevice)
+    {
+        if (!IsBaked())
+        {
+            return E_FAIL;
+        }
+
+        D3D11_SUBRESOURCE_DATA initData =
+        {
+            .pSysMem = m_aTexels.data(),
+            .SysMemPitch = m_uNumBones * TEXELS_PER_BONE * static_cast<UINT>(sizeof(XMFLOAT4)),
+            .SysMemSlicePitch = 0u
+        };
+
+        // The frames never change once baked
+        D3D11_TEXTURE2D_DESC textureDesc =
+        {
+            .Width = m_uNumBones * TEXELS_PER_BONE,
+            .Height = m_uNumFrames,
+            .MipLevels = 1u,
+            .ArraySize = 1u,
+            .Format = DXGI_FORMAT_R32G32B32A32_FLOAT,
+            .SampleDesc = {.Count = 1u, .Quality = 0u },
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+            .CPUAccessFlags = 0u,
+            .MiscFlags = 0u
+        };
+        HRESULT hr = pDevice->CreateTexture2D(&textureDesc, &initData, m_texture.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = pDevice->CreateShaderResourceView(m_texture.Get(), nullptr, m_textureView.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::IsBaked
+
+      Summary:  Returns whether the clips have been baked
+
+      Returns:  BOOL
+                  TRUE once Bake succeeded
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL BakedAnimation::IsBaked() const
+    {
+        return !m_aTexels.empty();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetBoneTransform
+
+      Summary:  Interpolates a bone transform between the two frames
+                around the time, the same way VSCrowd does
+
+      Args:     UINT uClipIndex
+                  Index of the clip
+                FLOAT time
+                  Time in seconds, looping over the clip
+                UINT uBoneIndex
+                  Index of the bone
+
+      Returns:  XMMATRIX
+                  Bone transform
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    XMMATRIX BakedAnimation::GetBoneTransform(_In_ UINT uClipIndex, _In_ FLOAT time, _In_ UINT uBoneIndex) const
+    {
+        const BakedClip& clip = m_aClips[uClipIndex];
+
+        FLOAT loopedTime = clip.duration > 0.0f ? std::fmod(time, clip.duration) : 0.0f;
+        if (loopedTime < 0.0f)
+        {
+            loopedTime += clip.duration;
+        }
+
+        FLOAT framePosition = loopedTime * clip.frameRate;
+        UINT uFrame = std::min(static_cast<UINT>(framePosition), clip.uNumFrames - 2u);
+        FLOAT blend = framePosition - static_cast<FLOAT>(uFrame);
+
+        const XMFLOAT4* pFrame = &m_aTexels[(static_cast<SIZE_T>(clip.uFrameOffset + uFrame) * m_uNumBones + uBoneIndex) * TEXELS_PER_BONE];
+        const XMFLOAT4* pNextFrame = pFrame + static_cast<SIZE_T>(m_uNumBones) * TEXELS_PER_BONE;
+
+        XMMATRIX transposed = XMMatrixIdentity();
+        for (UINT i = 0u; i < TEXELS_PER_BONE; ++i)
+        {
+            transposed.r[i] = XMVectorLerp(XMLoadFloat4(&pFrame[i]), XMLoadFloat4(&pNextFrame[i]), blend);
+        }
+
+        return XMMatrixTranspose(transposed);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetClip
+
+      Summary:  Returns the rows of a clip
+
+      Args:     UINT uClipIndex
+                  Index of the clip
+
+      Returns:  const BakedClip&
+                  Rows of the clip
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const BakedClip& BakedAnimation::GetClip(_In_ UINT uClipIndex) const
+    {
+        assert(uClipIndex < m_aClips.size());
+
+        return m_aClips[uClipIndex];
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetNumClips
+
+      Summary:  Returns the number of clips
+
+      Returns:  UINT
+                  Number of clips
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT BakedAnimation::GetNumClips() const
+    {
+        return static_cast<UINT>(m_aClips.size());
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetNumBones
+
+      Summary:  Returns the number of bones per frame
+
+      Returns:  UINT
+                  Number of bones
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT BakedAnimation::GetNumBones() const
+    {
+        return m_uNumBones;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetNumFrames
+
+      Summary:  Returns the number of frames of all the clips, the
+                height of the texture
+
+      Returns:  UINT
+                  Number of frames
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT BakedAnimation::GetNumFrames() const
+    {
+        return m_uNumFrames;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetTextureView
+
+      Summary:  Returns the baked texture
+
+      Returns:  ComPtr<ID3D11ShaderResourceView>&
+                  Shader resource view of the texture
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11ShaderResourceView>& BakedAnimation::GetTextureView()
+    {
+        return m_textureView;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetMemorySize
+
+      Summary:  Returns the bytes taken by the texels
+
+      Returns:  SIZE_T
+                  Size in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    SIZE_T BakedAnimation::GetMemorySize() const
+    {
+        return m_aTexels.size() * sizeof(XMFLOAT4);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetMaxError
+
+      Summary:  Returns the largest difference of a bone matrix element
+                between the interpolated frames and the clips evaluated
+                directly
+
+      Returns:  FLOAT
+                  Largest error
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT BakedAnimation::GetMaxError() const
+    {
+        return m_maxError;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::GetBakeTime
+
+      Summary:  Returns the time the last bake took, verification
+                included
+
+      Returns:  FLOAT
+                  Time in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT BakedAnimation::GetBakeTime() const
+    {
+        return m_bakeTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   BakedAnimation::measureError
+
+      Summary:  Compares the interpolated frames against the clips
+                evaluated directly, at NUM_ERROR_STEPS_PER_FRAME times
+                per frame including the frames themselves
+
+      Args:     Model& model
+                  Model the clips were baked from
+
+      Modifies: [m_maxError].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT BakedAnimation::measureError(_In_ Model& model)
+    {
+        m_maxError = 0.0f;
+
+        std::vector<XMMATRIX> aBoneTransforms;
+        XMVECTOR maxError = XMVectorZero();
+        for (UINT uClipIndex = 0u; uClipIndex < m_aClips.size(); ++uClipIndex)
+        {
+            const BakedClip& clip = m_aClips[uClipIndex];
+            for (UINT uStep = 0u; uStep < (clip.uNumFrames - 1u) * NUM_ERROR_STEPS_PER_FRAME; ++uStep)
+            {
+                FLOAT time = static_cast<FLOAT>(uStep) / (clip.frameRate * static_cast<FLOAT>(NUM_ERROR_STEPS_PER_FRAME));
+                HRESULT hr = model.EvaluateClip(uClipIndex, time, aBoneTransforms);
+                if (FAILED(hr))
+                {
+                    return hr;
+                }
+
+                for (UINT uBoneIndex = 0u; uBoneIndex < m_uNumBones; ++uBoneIndex)
+                {
+                    XMMATRIX baked = GetBoneTransform(uClipIndex, time, uBoneIndex);
+                    for (UINT i = 0u; i < 4u; ++i)
+                    {
+                        maxError = XMVectorMax(maxError, XMVectorAbs(baked.r[i] - aBoneTransforms[uBoneIndex].r[i]));
+                    }
+                }
+            }
+        }
+
+        XMFLOAT4 errors;
+        XMStoreFloat4(&errors, maxError);
+        m_maxError = std::max(std::max(errors.x, errors.y), std::max(errors.z, errors.w));
+
+        return S_OK;
+    }
+}
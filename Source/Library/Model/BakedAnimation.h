@@ -0,0 +1,127 @@
+/*+===================================================================
+  File:      BAKEDANIMATION.H
+
+  Summary:   BakedAnimation header file contains declarations of
+             BakedAnimation class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: BakedAnimation
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Model/Model.h"
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   BakedClip
+
+      Summary:  Rows of a clip in the baked texture. The frames are
+                spread evenly over the duration, the first at time 0
+                and the last at the duration, so a looping time never
+                needs to wrap between two frames
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct BakedClip
+    {
+        UINT uFrameOffset;
+        UINT uNumFrames;
+        FLOAT frameRate;
+        FLOAT duration;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    BakedAnimation
+
+      Summary:  Bone transforms of every clip of a model, evaluated
+                offline at a fixed rate and stored in a float texture.
+                A row holds one frame, a bone takes TEXELS_PER_BONE
+                texels holding the three columns of its transform, the
+                fourth column of an affine transform being implicit.
+                The skinning vertex shader reads the two frames around
+                the time of an instance and interpolates them, so a
+                crowd needs no per-instance bone upload
+
+      Methods:  Bake
+                  Evaluates the clips of the model into the texels
+                  and measures the interpolation error
+                Initialize
+                  Creates the texture from the texels
+                IsBaked
+                  Returns whether the clips have been baked
+                GetBoneTransform
+                  Interpolates a bone transform from the texels as the
+                  vertex shader does
+                GetClip
+                  Returns the rows of a clip
+                GetNumClips
+                  Returns the number of clips
+                GetNumBones
+                  Returns the number of bones per frame
+                GetNumFrames
+                  Returns the number of rows of the texture
+                GetTextureView
+                  Returns the baked texture
+                GetMemorySize
+                  Returns the bytes taken by the texels
+                GetMaxError
+                  Returns the largest difference of a matrix element
+                  against the clips evaluated directly
+                GetBakeTime
+                  Returns the time the last bake took
+                BakedAnimation
+                  Constructor.
+                ~BakedAnimation
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class BakedAnimation
+    {
+    public:
+        static constexpr const UINT TEXELS_PER_BONE = 3u;
+        static constexpr const UINT MAX_TEXTURE_DIMENSION = 16384u;
+        static constexpr const UINT NUM_ERROR_STEPS_PER_FRAME = 4u;
+
+    public:
+        BakedAnimation();
+        BakedAnimation(const BakedAnimation& other) = delete;
+        BakedAnimation(BakedAnimation&& other) = delete;
+        BakedAnimation& operator=(const BakedAnimation& other) = delete;
+        BakedAnimation& operator=(BakedAnimation&& other) = delete;
+        ~BakedAnimation() = default;
+
+        HRESULT Bake(_In_ Model& model);
+        HRESULT Initialize(_In_ ID3D11Device* pDevice);
+
+        BOOL IsBaked() const;
+        XMMATRIX GetBoneTransform(_In_ UINT uClipIndex, _In_ FLOAT time, _In_ UINT uBoneIndex) const;
+
+        const BakedClip& GetClip(_In_ UINT uClipIndex) const;
+        UINT GetNumClips() const;
+        UINT GetNumBones() const;
+        UINT GetNumFrames() const;
+
+        ComPtr<ID3D11ShaderResourceView>& GetTextureView();
+
+        SIZE_T GetMemorySize() const;
+        FLOAT GetMaxError() const;
+        FLOAT GetBakeTime() const;
+
+    private:
+        HRESULT measureError(_In_ Model& model);
+
+    private:
+        std::vector<BakedClip> m_aClips;
+        UINT m_uNumBones;
+        UINT m_uNumFrames;
+        std::vector<XMFLOAT4> m_aTexels;
+
+        ComPtr<ID3D11Texture2D> m_texture;
+        ComPtr<ID3D11ShaderResourceView> m_textureView;
+
+        FLOAT m_maxError;
+        FLOAT m_bakeTime;
+    };
+}
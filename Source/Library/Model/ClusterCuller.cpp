@@ -0,0 +1,839 @@
+#include "Model/ClusterCuller.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::ClusterCuller
+
+      Summary:  Constructor
+
+      Modifies: [m_aGroups, m_aClusterRanges, m_aFirstGroups,
+                 m_aClusterBones, m_aFirstClusterBones,
+                 m_uNumTestedClusters, m_uNumCulledClusters,
+                 m_uNumCulledTriangles].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ClusterCuller::ClusterCuller()
+        : m_aGroups(std::vector<ClusterGroup>())
+        , m_aClusterRanges(std::vector<IndexRange>())
+        , m_aFirstGroups(std::vector<UINT>())
+        , m_aClusterBones(std::vector<UINT>())
+        , m_aFirstClusterBones(std::vector<UINT>())
+        , m_uNumTestedClusters(0ull)
+        , m_uNumCulledClusters(0ull)
+        , m_uNumCulledTriangles(0ull)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::Build
+
+      Summary:  Splits the triangles of a mesh into clusters in their
+                order. A cluster ends when the next triangle would
+                exceed MAX_NUM_CLUSTER_TRIANGLES or
+                MAX_NUM_CLUSTER_VERTICES, or, past
+                MIN_NUM_CLUSTER_TRIANGLES, when it faces away from the
+                triangles gathered so far, which would open the cone
+                too wide to ever cull. The clusters are padded with
+                empty ones to a multiple of NUM_LANES
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices of the mesh
+                const AnimationData* pAnimationData
+                  Bone influences of the vertices, nullptr for a mesh
+                  that is not skinned
+                UINT uNumVertices
+                  Number of vertices
+                const UINT* pIndices
+                  Triangle list of the mesh, local to its vertices
+                UINT uNumIndices
+                  Number of indices
+                UINT uBaseIndex
+                  Position of the first index in the index buffer
+                UINT uMeshIndex
+                  Index of the mesh
+                std::vector<MeshCluster>& aOutClusters
+                  The clusters of the mesh are appended here
+                std::vector<UINT>& aOutClusterBones
+                  The bones of the clusters are appended here
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if an index is out of range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT ClusterCuller::Build(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+        _In_ UINT uNumVertices,
+        _In_reads_(uNumIndices) const UINT* pIndices,
+        _In_ UINT uNumIndices,
+        _In_ UINT uBaseIndex,
+        _In_ UINT uMeshIndex,
+        _Inout_ std::vector<MeshCluster>& aOutClusters,
+        _Inout_ std::vector<UINT>& aOutClusterBones
+    )
+    {
+        static constexpr const UINT INVALID_INDEX = (0xFFFFFFFF);
+
+        if (uNumIndices % 3u != 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        for (UINT i = 0u; i < uNumIndices; ++i)
+        {
+            if (pIndices[i] >= uNumVertices)
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        // A vertex belongs to the current cluster when it carries its number
+        std::vector<UINT> aVertexClusters(uNumVertices, INVALID_INDEX);
+        UINT uCluster = 0u;
+        UINT uClusterStart = 0u;
+        UINT uNumClusterVertices = 0u;
+        XMVECTOR normalSum = XMVectorZero();
+
+        for (UINT uIndex = 0u; uIndex < uNumIndices; uIndex += 3u)
+        {
+            const UINT* pTriangle = pIndices + uIndex;
+            XMVECTOR p0 = XMLoadFloat3(&pVertices[pTriangle[0]].Position);
+            XMVECTOR p1 = XMLoadFloat3(&pVertices[pTriangle[1]].Position);
+            XMVECTOR p2 = XMLoadFloat3(&pVertices[pTriangle[2]].Position);
+            XMVECTOR normal = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+
+            UINT uNumNewVertices = 0u;
+            for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+            {
+                if (aVertexClusters[pTriangle[uCorner]] != uCluster &&
+                    (uCorner == 0u || pTriangle[uCorner] != pTriangle[0]) &&
+                    (uCorner < 2u || pTriangle[2] != pTriangle[1]))
+                {
+                    ++uNumNewVertices;
+                }
+            }
+
+            const UINT uNumClusterTriangles = (uIndex - uClusterStart) / 3u;
+            if (uNumClusterTriangles > 0u &&
+                (uNumClusterTriangles >= MAX_NUM_CLUSTER_TRIANGLES ||
+                 uNumClusterVertices + uNumNewVertices > MAX_NUM_CLUSTER_VERTICES ||
+                 (uNumClusterTriangles >= MIN_NUM_CLUSTER_TRIANGLES && XMVectorGetX(XMVector3Dot(normal, normalSum)) < 0.0f)))
+            {
+                addCluster(pVertices, pAnimationData, uNumVertices, pIndices + uClusterStart, uIndex - uClusterStart, uBaseIndex + uClusterStart, uMeshIndex, aOutClusters, aOutClusterBones);
+
+                ++uCluster;
+                uClusterStart = uIndex;
+                uNumClusterVertices = 0u;
+                normalSum = XMVectorZero();
+            }
+
+            for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+            {
+                if (aVertexClusters[pTriangle[uCorner]] != uCluster)
+                {
+                    aVertexClusters[pTriangle[uCorner]] = uCluster;
+                    ++uNumClusterVertices;
+                }
+            }
+            normalSum = XMVectorAdd(normalSum, normal);
+        }
+
+        if (uClusterStart < uNumIndices)
+        {
+            addCluster(pVertices, pAnimationData, uNumVertices, pIndices + uClusterStart, uNumIndices - uClusterStart, uBaseIndex + uClusterStart, uMeshIndex, aOutClusters, aOutClusterBones);
+        }
+
+        // Empty clusters fail every test, so the next mesh starts on a group of its own
+        while (aOutClusters.size() % NUM_LANES != 0u)
+        {
+            MeshCluster padding =
+            {
+                .Center = XMFLOAT3(0.0f, 0.0f, 0.0f),
+                .radius = -FLT_MAX,
+                .ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f),
+                .coneCutoff = 1.0f,
+                .uBaseIndex = uBaseIndex + uNumIndices,
+                .uNumIndices = 0u,
+                .uMeshIndex = uMeshIndex,
+                .uFirstBone = static_cast<UINT>(aOutClusterBones.size()),
+            };
+            aOutClusters.push_back(padding);
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::Initialize
+
+      Summary:  Transposes the clusters of a model into groups of
+                NUM_LANES, one lane per cluster, and finds the groups
+                and the bones of every mesh
+
+      Args:     const std::vector<MeshCluster>& aClusters
+                  Clusters of every mesh, as Build appended them
+                const std::vector<UINT>& aClusterBones
+                  Bones of the clusters, as Build appended them
+                UINT uNumMeshes
+                  Number of meshes of the model
+                UINT uNumBones
+                  Number of bones of the model
+
+      Modifies: [m_aGroups, m_aClusterRanges, m_aFirstGroups,
+                 m_aClusterBones, m_aFirstClusterBones].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if the clusters are not
+                  padded or not in mesh order, or a bone is out of
+                  range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT ClusterCuller::Initialize(
+        _In_ const std::vector<MeshCluster>& aClusters,
+        _In_ const std::vector<UINT>& aClusterBones,
+        _In_ UINT uNumMeshes,
+        _In_ UINT uNumBones
+    )
+    {
+        m_aGroups.clear();
+        m_aClusterRanges.clear();
+        m_aFirstGroups.assign(uNumMeshes + 1u, 0u);
+        m_aClusterBones.clear();
+        m_aFirstClusterBones.clear();
+
+        if (aClusters.size() % NUM_LANES != 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        for (UINT uBone : aClusterBones)
+        {
+            if (uBone >= uNumBones && uBone != ORIGIN_BONE)
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        // The bones of a cluster end where those of the next one start
+        m_aFirstClusterBones.resize(aClusters.size() + 1u);
+        m_aFirstClusterBones.back() = static_cast<UINT>(aClusterBones.size());
+        for (SIZE_T uCluster = aClusters.size(); uCluster-- > 0u;)
+        {
+            if (aClusters[uCluster].uFirstBone > m_aFirstClusterBones[uCluster + 1u])
+            {
+                m_aFirstClusterBones.clear();
+                return E_INVALIDARG;
+            }
+
+            m_aFirstClusterBones[uCluster] = aClusters[uCluster].uFirstBone;
+        }
+        m_aClusterBones = aClusterBones;
+
+        const UINT uNumGroups = static_cast<UINT>(aClusters.size() / NUM_LANES);
+        UINT uMesh = 0u;
+        for (UINT uGroup = 0u; uGroup < uNumGroups; ++uGroup)
+        {
+            const MeshCluster* pClusters = aClusters.data() + uGroup * NUM_LANES;
+            for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+            {
+                if (pClusters[uLane].uMeshIndex != pClusters[0].uMeshIndex)
+                {
+                    return E_INVALIDARG;
+                }
+            }
+
+            if (pClusters[0].uMeshIndex < uMesh || pClusters[0].uMeshIndex >= uNumMeshes)
+            {
+                return E_INVALIDARG;
+            }
+
+            while (uMesh < pClusters[0].uMeshIndex)
+            {
+                m_aFirstGroups[++uMesh] = uGroup;
+            }
+        }
+        while (uMesh < uNumMeshes)
+        {
+            m_aFirstGroups[++uMesh] = uNumGroups;
+        }
+
+        m_aGroups.resize(uNumGroups);
+        m_aClusterRanges.resize(aClusters.size());
+        for (UINT uGroup = 0u; uGroup < uNumGroups; ++uGroup)
+        {
+            const MeshCluster* pClusters = aClusters.data() + uGroup * NUM_LANES;
+            ClusterGroup& group = m_aGroups[uGroup];
+            group.CenterX = XMVectorSet(pClusters[0].Center.x, pClusters[1].Center.x, pClusters[2].Center.x, pClusters[3].Center.x);
+            group.CenterY = XMVectorSet(pClusters[0].Center.y, pClusters[1].Center.y, pClusters[2].Center.y, pClusters[3].Center.y);
+            group.CenterZ = XMVectorSet(pClusters[0].Center.z, pClusters[1].Center.z, pClusters[2].Center.z, pClusters[3].Center.z);
+            group.Radius = XMVectorSet(pClusters[0].radius, pClusters[1].radius, pClusters[2].radius, pClusters[3].radius);
+            group.ConeAxisX = XMVectorSet(pClusters[0].ConeAxis.x, pClusters[1].ConeAxis.x, pClusters[2].ConeAxis.x, pClusters[3].ConeAxis.x);
+            group.ConeAxisY = XMVectorSet(pClusters[0].ConeAxis.y, pClusters[1].ConeAxis.y, pClusters[2].ConeAxis.y, pClusters[3].ConeAxis.y);
+            group.ConeAxisZ = XMVectorSet(pClusters[0].ConeAxis.z, pClusters[1].ConeAxis.z, pClusters[2].ConeAxis.z, pClusters[3].ConeAxis.z);
+            group.ConeCutoff = XMVectorSet(pClusters[0].coneCutoff, pClusters[1].coneCutoff, pClusters[2].coneCutoff, pClusters[3].coneCutoff);
+
+            for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+            {
+                m_aClusterRanges[uGroup * NUM_LANES + uLane] = { pClusters[uLane].uBaseIndex, pClusters[uLane].uNumIndices };
+            }
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::Cull
+
+      Summary:  Tests the clusters of a mesh against the six planes of
+                the frustum and their cones against the eye, four at a
+                time, and appends the index ranges of the visible
+                ones. Neighbouring visible clusters are one range.
+                The planes are taken from the world view projection
+                matrix, so they are in the space of the model and the
+                clusters need no transform
+
+      Args:     UINT uMeshIndex
+                  Index of the mesh
+                const XMMATRIX& worldViewProjection
+                  World, view and projection matrices of the model
+                FXMVECTOR localEyePosition
+                  Position of the camera in the space of the model
+                std::vector<IndexRange>& aOutRanges
+                  Ranges to draw are appended here
+
+      Modifies: [m_uNumTestedClusters, m_uNumCulledClusters,
+                 m_uNumCulledTriangles].
+
+      Returns:  UINT
+                  Number of triangles culled
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT ClusterCuller::Cull(
+        _In_ UINT uMeshIndex,
+        _In_ const XMMATRIX& worldViewProjection,
+        _In_ FXMVECTOR localEyePosition,
+        _Inout_ std::vector<IndexRange>& aOutRanges
+    )
+    {
+        if (!HasClusters(uMeshIndex))
+        {
+            return 0u;
+        }
+
+        XMVECTOR aPlanes[6];
+        extractPlanes(worldViewProjection, aPlanes);
+
+        const XMVECTOR eyeX = XMVectorSplatX(localEyePosition);
+        const XMVECTOR eyeY = XMVectorSplatY(localEyePosition);
+        const XMVECTOR eyeZ = XMVectorSplatZ(localEyePosition);
+
+        const SIZE_T uFirstRange = aOutRanges.size();
+        UINT uNumCulledTriangles = 0u;
+        for (UINT uGroup = m_aFirstGroups[uMeshIndex]; uGroup < m_aFirstGroups[uMeshIndex + 1u]; ++uGroup)
+        {
+            const ClusterGroup& group = m_aGroups[uGroup];
+            XMVECTOR visible = testPlanes(aPlanes, group.CenterX, group.CenterY, group.CenterZ, group.Radius);
+
+            // Every triangle faces away when the eye is outside the cone widened by the sphere
+            const XMVECTOR toCenterX = XMVectorSubtract(group.CenterX, eyeX);
+            const XMVECTOR toCenterY = XMVectorSubtract(group.CenterY, eyeY);
+            const XMVECTOR toCenterZ = XMVectorSubtract(group.CenterZ, eyeZ);
+            XMVECTOR lengthSq = XMVectorMultiply(toCenterX, toCenterX);
+            lengthSq = XMVectorMultiplyAdd(toCenterY, toCenterY, lengthSq);
+            lengthSq = XMVectorMultiplyAdd(toCenterZ, toCenterZ, lengthSq);
+            XMVECTOR along = XMVectorMultiply(toCenterX, group.ConeAxisX);
+            along = XMVectorMultiplyAdd(toCenterY, group.ConeAxisY, along);
+            along = XMVectorMultiplyAdd(toCenterZ, group.ConeAxisZ, along);
+            const XMVECTOR backFacing = XMVectorGreaterOrEqual(along, XMVectorMultiplyAdd(group.ConeCutoff, XMVectorSqrt(lengthSq), group.Radius));
+            visible = XMVectorAndCInt(visible, backFacing);
+
+            uNumCulledTriangles += appendRanges(uGroup, visible, uFirstRange, aOutRanges);
+        }
+
+        return uNumCulledTriangles;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::CullPose
+
+      Summary:  Tests the clusters of a skinned mesh against the six
+                planes of the frustum, four at a time, and appends the
+                index ranges of the visible ones. A skinned vertex is
+                a weighted average of its positions moved by each of
+                its bones, so it stays inside the union of the posed
+                boxes of its bones, and a cluster is bounded by the
+                sphere around the union of the boxes of its bones. The
+                cone is not tested, skinning turns the triangles away
+                from the normals it was built from
+
+      Args:     UINT uMeshIndex
+                  Index of the mesh
+                const XMMATRIX& worldViewProjection
+                  World, view and projection matrices of the model
+                const std::vector<BoneBox>& aPoseBoneBoxes
+                  Box of every bone in the current pose, in the space
+                  of the model
+                std::vector<IndexRange>& aOutRanges
+                  Ranges to draw are appended here
+
+      Modifies: [m_uNumTestedClusters, m_uNumCulledClusters,
+                 m_uNumCulledTriangles].
+
+      Returns:  UINT
+                  Number of triangles culled
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT ClusterCuller::CullPose(
+        _In_ UINT uMeshIndex,
+        _In_ const XMMATRIX& worldViewProjection,
+        _In_ const std::vector<BoneBox>& aPoseBoneBoxes,
+        _Inout_ std::vector<IndexRange>& aOutRanges
+    )
+    {
+        if (!HasClusters(uMeshIndex))
+        {
+            return 0u;
+        }
+
+        // Clusters without bones cannot be bounded in the pose, so they are all drawn
+        const SIZE_T uFirstRange = aOutRanges.size();
+        if (m_aClusterBones.empty())
+        {
+            for (UINT uGroup = m_aFirstGroups[uMeshIndex]; uGroup < m_aFirstGroups[uMeshIndex + 1u]; ++uGroup)
+            {
+                appendRanges(uGroup, XMVectorTrueInt(), uFirstRange, aOutRanges);
+            }
+            return 0u;
+        }
+
+        XMVECTOR aPlanes[6];
+        extractPlanes(worldViewProjection, aPlanes);
+
+        UINT uNumCulledTriangles = 0u;
+        for (UINT uGroup = m_aFirstGroups[uMeshIndex]; uGroup < m_aFirstGroups[uMeshIndex + 1u]; ++uGroup)
+        {
+            XMFLOAT4 aCenters[NUM_LANES];
+            FLOAT aRadii[NUM_LANES];
+            for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+            {
+                const UINT uCluster = uGroup * NUM_LANES + uLane;
+                XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+                XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+                for (UINT uBone = m_aFirstClusterBones[uCluster]; uBone < m_aFirstClusterBones[uCluster + 1u]; ++uBone)
+                {
+                    const UINT uBoneIndex = m_aClusterBones[uBone];
+                    if (uBoneIndex == ORIGIN_BONE)
+                    {
+                        boundsMin = XMVectorMin(boundsMin, XMVectorZero());
+                        boundsMax = XMVectorMax(boundsMax, XMVectorZero());
+                    }
+                    else if (uBoneIndex < aPoseBoneBoxes.size() && aPoseBoneBoxes[uBoneIndex].Min.x <= aPoseBoneBoxes[uBoneIndex].Max.x)
+                    {
+                        boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&aPoseBoneBoxes[uBoneIndex].Min));
+                        boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&aPoseBoneBoxes[uBoneIndex].Max));
+                    }
+                }
+
+                // A cluster the pose does not bound is never culled, padding is skipped when the ranges are appended
+                if (XMVectorGetX(boundsMin) > XMVectorGetX(boundsMax))
+                {
+                    aCenters[uLane] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+                    aRadii[uLane] = FLT_MAX;
+                    continue;
+                }
+
+                XMStoreFloat4(&aCenters[uLane], XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f));
+                aRadii[uLane] = XMVectorGetX(XMVector3Length(XMVectorSubtract(boundsMax, boundsMin))) * 0.5f;
+            }
+
+            const XMVECTOR visible = testPlanes(
+                aPlanes,
+                XMVectorSet(aCenters[0].x, aCenters[1].x, aCenters[2].x, aCenters[3].x),
+                XMVectorSet(aCenters[0].y, aCenters[1].y, aCenters[2].y, aCenters[3].y),
+                XMVectorSet(aCenters[0].z, aCenters[1].z, aCenters[2].z, aCenters[3].z),
+                XMVectorSet(aRadii[0], aRadii[1], aRadii[2], aRadii[3])
+            );
+
+            uNumCulledTriangles += appendRanges(uGroup, visible, uFirstRange, aOutRanges);
+        }
+
+        return uNumCulledTriangles;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::HasClusters
+
+      Summary:  Returns whether a mesh has clusters to cull
+
+      Args:     UINT uMeshIndex
+                  Index of the mesh
+
+      Returns:  BOOL
+                  TRUE if the mesh has clusters
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL ClusterCuller::HasClusters(_In_ UINT uMeshIndex) const
+    {
+        return static_cast<SIZE_T>(uMeshIndex) + 1u < m_aFirstGroups.size() && m_aFirstGroups[uMeshIndex] < m_aFirstGroups[uMeshIndex + 1u];
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::GetNumTestedClusters
+
+      Summary:  Returns the number of clusters tested since the
+                statistics were reset
+
+      Returns:  UINT64
+                  Number of clusters tested
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 ClusterCuller::GetNumTestedClusters() const
+    {
+        return m_uNumTestedClusters;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::GetNumCulledClusters
+
+      Summary:  Returns the number of clusters culled since the
+                statistics were reset
+
+      Returns:  UINT64
+                  Number of clusters culled
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 ClusterCuller::GetNumCulledClusters() const
+    {
+        return m_uNumCulledClusters;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::GetNumCulledTriangles
+
+      Summary:  Returns the number of triangles culled since the
+                statistics were reset
+
+      Returns:  UINT64
+                  Number of triangles culled
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 ClusterCuller::GetNumCulledTriangles() const
+    {
+        return m_uNumCulledTriangles;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::ResetStatistics
+
+      Summary:  Zeroes the statistics
+
+      Modifies: [m_uNumTestedClusters, m_uNumCulledClusters,
+                 m_uNumCulledTriangles].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ClusterCuller::ResetStatistics()
+    {
+        m_uNumTestedClusters = 0ull;
+        m_uNumCulledClusters = 0ull;
+        m_uNumCulledTriangles = 0ull;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::LogStatistics
+
+      Summary:  Logs the statistics since they were reset, averaged
+                over the frames, when the statistics are logged
+
+      Args:     PCWSTR pszName
+                  Name of the model in the log
+                UINT uNumFrames
+                  Number of frames since the reset
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ClusterCuller::LogStatistics(_In_ PCWSTR pszName, _In_ UINT uNumFrames) const
+    {
+        if (!Statistics::IsLogging() || m_uNumTestedClusters == 0ull)
+        {
+            return;
+        }
+
+        uNumFrames = std::max(uNumFrames, 1u);
+
+        WCHAR szDebugMessage[256];
+        swprintf_s(
+            szDebugMessage,
+            L"ClusterCuller %s: %llu triangles culled in %llu of %llu clusters per frame\n",
+            pszName,
+            m_uNumCulledTriangles / uNumFrames,
+            m_uNumCulledClusters / uNumFrames,
+            m_uNumTestedClusters / uNumFrames
+        );
+        OutputDebugString(szDebugMessage);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::addCluster
+
+      Summary:  Appends a cluster bounded by the sphere around the box
+                of its vertices. The cone axis is the mean of the
+                triangle normals and opens to the normal furthest from
+                it. A cluster whose normals span a half space or more
+                gets a cutoff of 1 and is never culled by its cone. A
+                skinned cluster appends the bones of its vertices in
+                ascending order
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices of the mesh
+                const AnimationData* pAnimationData
+                  Bone influences of the vertices, nullptr for a mesh
+                  that is not skinned
+                UINT uNumVertices
+                  Number of vertices
+                const UINT* pIndices
+                  Triangles of the cluster
+                UINT uNumIndices
+                  Number of indices of the cluster
+                UINT uBaseIndex
+                  Position of the first index in the index buffer
+                UINT uMeshIndex
+                  Index of the mesh
+                std::vector<MeshCluster>& aOutClusters
+                  The cluster is appended here
+                std::vector<UINT>& aOutClusterBones
+                  The bones of the cluster are appended here
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ClusterCuller::addCluster(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+        _In_ UINT uNumVertices,
+        _In_reads_(uNumIndices) const UINT* pIndices,
+        _In_ UINT uNumIndices,
+        _In_ UINT uBaseIndex,
+        _In_ UINT uMeshIndex,
+        _Inout_ std::vector<MeshCluster>& aOutClusters,
+        _Inout_ std::vector<UINT>& aOutClusterBones
+    )
+    {
+        UNREFERENCED_PARAMETER(uNumVertices);
+
+        XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+        XMVECTOR normalSum = XMVectorZero();
+        for (UINT uIndex = 0u; uIndex < uNumIndices; uIndex += 3u)
+        {
+            XMVECTOR p0 = XMLoadFloat3(&pVertices[pIndices[uIndex]].Position);
+            XMVECTOR p1 = XMLoadFloat3(&pVertices[pIndices[uIndex + 1u]].Position);
+            XMVECTOR p2 = XMLoadFloat3(&pVertices[pIndices[uIndex + 2u]].Position);
+            boundsMin = XMVectorMin(boundsMin, XMVectorMin(p0, XMVectorMin(p1, p2)));
+            boundsMax = XMVectorMax(boundsMax, XMVectorMax(p0, XMVectorMax(p1, p2)));
+            normalSum = XMVectorAdd(normalSum, XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+        }
+
+        const XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+        FLOAT radiusSq = 0.0f;
+        for (UINT uIndex = 0u; uIndex < uNumIndices; ++uIndex)
+        {
+            radiusSq = std::max(radiusSq, XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&pVertices[pIndices[uIndex]].Position), center))));
+        }
+
+        MeshCluster cluster =
+        {
+            .Center = XMFLOAT3(),
+            .radius = sqrtf(radiusSq),
+            .ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f),
+            .coneCutoff = 1.0f,
+            .uBaseIndex = uBaseIndex,
+            .uNumIndices = uNumIndices,
+            .uMeshIndex = uMeshIndex,
+            .uFirstBone = static_cast<UINT>(aOutClusterBones.size()),
+        };
+        XMStoreFloat3(&cluster.Center, center);
+
+        if (pAnimationData)
+        {
+            for (UINT uIndex = 0u; uIndex < uNumIndices; ++uIndex)
+            {
+                const AnimationData& animationData = pAnimationData[pIndices[uIndex]];
+                BOOL bSkinned = FALSE;
+                for (UINT i = 0u; i < MAX_NUM_BONES_PER_VERTEX; ++i)
+                {
+                    if (animationData.aBoneWeights[i] == 0u)
+                    {
+                        continue;
+                    }
+
+                    bSkinned = TRUE;
+                    if (std::find(aOutClusterBones.begin() + cluster.uFirstBone, aOutClusterBones.end(), animationData.aBoneIndices[i]) == aOutClusterBones.end())
+                    {
+                        aOutClusterBones.push_back(animationData.aBoneIndices[i]);
+                    }
+                }
+
+                if (!bSkinned && std::find(aOutClusterBones.begin() + cluster.uFirstBone, aOutClusterBones.end(), ORIGIN_BONE) == aOutClusterBones.end())
+                {
+                    aOutClusterBones.push_back(ORIGIN_BONE);
+                }
+            }
+
+            std::sort(aOutClusterBones.begin() + cluster.uFirstBone, aOutClusterBones.end());
+        }
+
+        if (XMVectorGetX(XMVector3LengthSq(normalSum)) > 0.0f)
+        {
+            const XMVECTOR axis = XMVector3Normalize(normalSum);
+            FLOAT minDot = 1.0f;
+            for (UINT uIndex = 0u; uIndex < uNumIndices; uIndex += 3u)
+            {
+                XMVECTOR p0 = XMLoadFloat3(&pVertices[pIndices[uIndex]].Position);
+                XMVECTOR p1 = XMLoadFloat3(&pVertices[pIndices[uIndex + 1u]].Position);
+                XMVECTOR p2 = XMLoadFloat3(&pVertices[pIndices[uIndex + 2u]].Position);
+                XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+                if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+                {
+                    minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(XMVector3Normalize(normal), axis)));
+                }
+            }
+
+            if (minDot > 0.0f)
+            {
+                XMStoreFloat3(&cluster.ConeAxis, axis);
+                cluster.coneCutoff = sqrtf(1.0f - minDot * minDot);
+            }
+        }
+
+        aOutClusters.push_back(cluster);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::extractPlanes
+
+      Summary:  Extracts the six planes of the frustum from a world
+                view projection matrix, in the space of the model and
+                normalized so the distances compare with the radii
+
+      Args:     const XMMATRIX& worldViewProjection
+                  World, view and projection matrices of the model
+                XMVECTOR* pOutPlanes
+                  The planes are written here
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ClusterCuller::extractPlanes(_In_ const XMMATRIX& worldViewProjection, _Out_writes_(6) XMVECTOR* pOutPlanes)
+    {
+        // Gribb-Hartmann plane extraction for row vectors
+        XMMATRIX columns = XMMatrixTranspose(worldViewProjection);
+        pOutPlanes[0] = XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[0]));
+        pOutPlanes[1] = XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[0]));
+        pOutPlanes[2] = XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[1]));
+        pOutPlanes[3] = XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[1]));
+        pOutPlanes[4] = XMPlaneNormalize(columns.r[2]);
+        pOutPlanes[5] = XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[2]));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::testPlanes
+
+      Summary:  Tests NUM_LANES spheres against the six planes of the
+                frustum
+
+      Args:     const XMVECTOR* pPlanes
+                  Planes of the frustum
+                FXMVECTOR centerX
+                FXMVECTOR centerY
+                FXMVECTOR centerZ
+                  Centers of the spheres, one per lane
+                GXMVECTOR radius
+                  Radii of the spheres, one per lane
+
+      Returns:  XMVECTOR
+                  All bits set in the lanes of the spheres at least
+                  partly inside every plane
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    XMVECTOR ClusterCuller::testPlanes(
+        _In_reads_(6) const XMVECTOR* pPlanes,
+        _In_ FXMVECTOR centerX,
+        _In_ FXMVECTOR centerY,
+        _In_ FXMVECTOR centerZ,
+        _In_ GXMVECTOR radius
+    )
+    {
+        const XMVECTOR negativeRadius = XMVectorNegate(radius);
+
+        XMVECTOR visible = XMVectorTrueInt();
+        for (UINT uPlane = 0u; uPlane < 6u; ++uPlane)
+        {
+            const XMVECTOR& plane = pPlanes[uPlane];
+            XMVECTOR distance = XMVectorMultiplyAdd(centerX, XMVectorSplatX(plane), XMVectorSplatW(plane));
+            distance = XMVectorMultiplyAdd(centerY, XMVectorSplatY(plane), distance);
+            distance = XMVectorMultiplyAdd(centerZ, XMVectorSplatZ(plane), distance);
+            visible = XMVectorAndInt(visible, XMVectorGreaterOrEqual(distance, negativeRadius));
+        }
+
+        return visible;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ClusterCuller::appendRanges
+
+      Summary:  Appends the ranges of the visible clusters of a group,
+                merged with the last range appended since uFirstRange
+                when they touch, and counts the culled ones
+
+      Args:     UINT uGroup
+                  Index of the group
+                FXMVECTOR visible
+                  All bits set in the lanes of the visible clusters
+                SIZE_T uFirstRange
+                  First range appended by this cull
+                std::vector<IndexRange>& aOutRanges
+                  Ranges to draw are appended here
+
+      Modifies: [m_uNumTestedClusters, m_uNumCulledClusters,
+                 m_uNumCulledTriangles].
+
+      Returns:  UINT
+                  Number of triangles culled
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT ClusterCuller::appendRanges(_In_ UINT uGroup, _In_ FXMVECTOR visible, _In_ SIZE_T uFirstRange, _Inout_ std::vector<IndexRange>& aOutRanges)
+    {
+        UINT aVisible[NUM_LANES];
+        XMStoreInt4(aVisible, visible);
+
+        UINT uNumCulledTriangles = 0u;
+        for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+        {
+            const IndexRange& range = m_aClusterRanges[uGroup * NUM_LANES + uLane];
+            if (range.uNumIndices == 0u)
+            {
+                continue;
+            }
+
+            ++m_uNumTestedClusters;
+            if (aVisible[uLane] == 0u)
+            {
+                ++m_uNumCulledClusters;
+                uNumCulledTriangles += range.uNumIndices / 3u;
+                continue;
+            }
+
+            if (aOutRanges.size() > uFirstRange && aOutRanges.back().uBaseIndex + aOutRanges.back().uNumIndices == range.uBaseIndex)
+            {
+                aOutRanges.back().uNumIndices += range.uNumIndices;
+            }
+            else
+            {
+                aOutRanges.push_back(range);
+            }
+        }
+
+        m_uNumCulledTriangles += uNumCulledTriangles;
+
+        return uNumCulledTriangles;
+    }
+}
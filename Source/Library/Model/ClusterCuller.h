@@ -0,0 +1,224 @@
+/*+===================================================================
+  File:      CLUSTERCULLER.H
+
+  Summary:   ClusterCuller header file contains declarations of
+             ClusterCuller class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: ClusterCuller
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    ClusterCuller
+
+      Summary:  Splits the triangles of a mesh into clusters of at most
+                MAX_NUM_CLUSTER_TRIANGLES triangles and
+                MAX_NUM_CLUSTER_VERTICES vertices, each a contiguous
+                range of the index buffer with a bounding sphere and a
+                normal cone. The triangles are split in the order the
+                mesh optimizer left them, which keeps a cluster
+                compact. Every frame the clusters of a mesh are culled
+                against the frustum and, when every triangle of a
+                cluster faces away from the eye, by their cone. The
+                clusters are tested four at a time, stored as one
+                SIMD lane each, and the ranges that survive are merged
+                when they touch, so a mesh is drawn in as few ranges
+                as possible. A cluster of a skinned mesh also keeps
+                the bones its vertices follow, and CullPose bounds it
+                by the boxes of those bones in the current pose
+                instead of its bind pose sphere. Nothing here touches
+                the GPU
+
+      Methods:  Build
+                  Splits the triangles of a mesh into clusters
+                Initialize
+                  Lays the clusters of a model out for culling
+                Cull
+                  Returns the index ranges of the visible clusters of
+                  a mesh
+                CullPose
+                  Returns the index ranges of the visible clusters of
+                  a skinned mesh in its current pose
+                HasClusters
+                  Returns whether a mesh has clusters
+                GetNumTestedClusters
+                  Returns the number of clusters tested since the
+                  statistics were reset
+                GetNumCulledClusters
+                  Returns the number of clusters culled since the
+                  statistics were reset
+                GetNumCulledTriangles
+                  Returns the number of triangles culled since the
+                  statistics were reset
+                ResetStatistics
+                  Zeroes the statistics
+                LogStatistics
+                  Logs the statistics averaged over some frames
+                ClusterCuller
+                  Constructor.
+                ~ClusterCuller
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class ClusterCuller
+    {
+    public:
+        static constexpr const UINT MAX_NUM_CLUSTER_TRIANGLES = 124u;
+        static constexpr const UINT MAX_NUM_CLUSTER_VERTICES = 64u;
+        static constexpr const UINT MIN_NUM_CLUSTER_TRIANGLES = 32u;
+        static constexpr const UINT NUM_LANES = 4u;
+        static constexpr const UINT ORIGIN_BONE = (0xFFFFFFFF);
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   MeshCluster
+
+          Summary:  Cluster as built and cached, in the space of the
+                    model. A cluster is culled by its cone when
+                    dot(Center - eye, ConeAxis) >= coneCutoff *
+                    |Center - eye| + radius. The clusters of a mesh
+                    start at a multiple of NUM_LANES, padded with
+                    empty clusters. The bones of a cluster run from
+                    uFirstBone to the uFirstBone of the next one,
+                    ORIGIN_BONE standing for a vertex without
+                    influences, which the shader moves to the origin
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct MeshCluster
+        {
+            XMFLOAT3 Center;
+            FLOAT radius;
+            XMFLOAT3 ConeAxis;
+            FLOAT coneCutoff;
+            UINT uBaseIndex;
+            UINT uNumIndices;
+            UINT uMeshIndex;
+            UINT uFirstBone;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   BoneBox
+
+          Summary:  Box of the vertices a bone influences in the current
+                    pose, in the space of the model. A bone influencing
+                    no vertex has Min above Max
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct BoneBox
+        {
+            XMFLOAT3 Min;
+            XMFLOAT3 Max;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   IndexRange
+
+          Summary:  Range of the index buffer to draw
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct IndexRange
+        {
+            UINT uBaseIndex;
+            UINT uNumIndices;
+        };
+
+    public:
+        ClusterCuller();
+        ClusterCuller(const ClusterCuller& other) = delete;
+        ClusterCuller(ClusterCuller&& other) = delete;
+        ClusterCuller& operator=(const ClusterCuller& other) = delete;
+        ClusterCuller& operator=(ClusterCuller&& other) = delete;
+        ~ClusterCuller() = default;
+
+        static HRESULT Build(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+            _In_ UINT uNumVertices,
+            _In_reads_(uNumIndices) const UINT* pIndices,
+            _In_ UINT uNumIndices,
+            _In_ UINT uBaseIndex,
+            _In_ UINT uMeshIndex,
+            _Inout_ std::vector<MeshCluster>& aOutClusters,
+            _Inout_ std::vector<UINT>& aOutClusterBones
+        );
+
+        HRESULT Initialize(
+            _In_ const std::vector<MeshCluster>& aClusters,
+            _In_ const std::vector<UINT>& aClusterBones,
+            _In_ UINT uNumMeshes,
+            _In_ UINT uNumBones
+        );
+        UINT Cull(
+            _In_ UINT uMeshIndex,
+            _In_ const XMMATRIX& worldViewProjection,
+            _In_ FXMVECTOR localEyePosition,
+            _Inout_ std::vector<IndexRange>& aOutRanges
+        );
+        UINT CullPose(
+            _In_ UINT uMeshIndex,
+            _In_ const XMMATRIX& worldViewProjection,
+            _In_ const std::vector<BoneBox>& aPoseBoneBoxes,
+            _Inout_ std::vector<IndexRange>& aOutRanges
+        );
+
+        BOOL HasClusters(_In_ UINT uMeshIndex) const;
+        UINT64 GetNumTestedClusters() const;
+        UINT64 GetNumCulledClusters() const;
+        UINT64 GetNumCulledTriangles() const;
+        void ResetStatistics();
+        void LogStatistics(_In_ PCWSTR pszName, _In_ UINT uNumFrames) const;
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   ClusterGroup
+
+          Summary:  NUM_LANES clusters, one per lane of each vector
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct ClusterGroup
+        {
+            XMVECTOR CenterX;
+            XMVECTOR CenterY;
+            XMVECTOR CenterZ;
+            XMVECTOR Radius;
+            XMVECTOR ConeAxisX;
+            XMVECTOR ConeAxisY;
+            XMVECTOR ConeAxisZ;
+            XMVECTOR ConeCutoff;
+        };
+
+        static void addCluster(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+            _In_ UINT uNumVertices,
+            _In_reads_(uNumIndices) const UINT* pIndices,
+            _In_ UINT uNumIndices,
+            _In_ UINT uBaseIndex,
+            _In_ UINT uMeshIndex,
+            _Inout_ std::vector<MeshCluster>& aOutClusters,
+            _Inout_ std::vector<UINT>& aOutClusterBones
+        );
+        static void extractPlanes(_In_ const XMMATRIX& worldViewProjection, _Out_writes_(6) XMVECTOR* pOutPlanes);
+        static XMVECTOR testPlanes(
+            _In_reads_(6) const XMVECTOR* pPlanes,
+            _In_ FXMVECTOR centerX,
+            _In_ FXMVECTOR centerY,
+            _In_ FXMVECTOR centerZ,
+            _In_ GXMVECTOR radius
+        );
+        UINT appendRanges(_In_ UINT uGroup, _In_ FXMVECTOR visible, _In_ SIZE_T uFirstRange, _Inout_ std::vector<IndexRange>& aOutRanges);
+
+    private:
+        std::vector<ClusterGroup> m_aGroups;
+        std::vector<IndexRange> m_aClusterRanges;
+        std::vector<UINT> m_aFirstGroups;
+        std::vector<UINT> m_aClusterBones;
+        std::vector<UINT> m_aFirstClusterBones;
+        UINT64 m_uNumTestedClusters;
+        UINT64 m_uNumCulledClusters;
+        UINT64 m_uNumCulledTriangles;
+    };
+}
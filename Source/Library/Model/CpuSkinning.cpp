@@ -0,0 +1,257 @@
+#include "Model/CpuSkinning.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::CpuSkinning
+
+      Summary:  Constructor of an empty skinning
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    CpuSkinning::CpuSkinning()
+        : m_aPositions()
+        , m_aNormals()
+        , m_skinTime(0.0f)
+        , m_uNumThreads(0u)
+    { }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::Skin
+
+      Summary:  Poses every vertex of the model with the bone transforms
+                of its last update, splitting the vertices into jobs
+                taken by the threads
+
+      Args:     Model& model
+                  Skinned model, initialized
+                UINT uNumThreads
+                  Number of threads, 0 uses every hardware thread
+
+      Modifies: [m_aPositions, m_aNormals, m_skinTime, m_uNumThreads].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT CpuSkinning::Skin(_In_ Model& model, _In_opt_ UINT uNumThreads)
+    {
+        const std::vector<SimpleVertex>& aVertices = model.GetBindPoseVertices();
+        const std::vector<AnimationData>& aAnimationData = model.GetAnimationData();
+        if (aVertices.empty() || aAnimationData.size() != aVertices.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        LARGE_INTEGER frequency, startingTime, endingTime;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        const UINT uNumVertices = static_cast<UINT>(aVertices.size());
+        const UINT uNumJobs = (uNumVertices + NUM_VERTICES_PER_JOB - 1u) / NUM_VERTICES_PER_JOB;
+        m_aPositions.resize(uNumVertices);
+        m_aNormals.resize(uNumVertices);
+
+        const std::vector<XMMATRIX>& aBoneTransforms = model.GetBoneTransforms();
+        m_uNumThreads = ParallelFor(uNumJobs, uNumThreads,
+            [&](UINT uJob, UINT)
+            {
+                UINT uBegin = uJob * NUM_VERTICES_PER_JOB;
+                skinRange(aVertices.data(), aAnimationData.data(), aBoneTransforms, uBegin, std::min(uBegin + NUM_VERTICES_PER_JOB, uNumVertices));
+            }
+        );
+
+        QueryPerformanceCounter(&endingTime);
+        m_skinTime = static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart));
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::Benchmark
+
+      Summary:  Skins the model uNumIterations times on one thread and
+                on every hardware thread, and logs the vertices skinned
+                per second of both
+
+      Args:     Model& model
+                  Skinned model, initialized and updated
+                PCSTR pszName
+                  Name of the model in the log
+                UINT uNumIterations
+                  Number of skinnings timed per thread count
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT CpuSkinning::Benchmark(_In_ Model& model, _In_ PCSTR pszName, _In_ UINT uNumIterations)
+    {
+        CpuSkinning skinning;
+
+        // The first run touches the output once, so allocation is not timed
+        HRESULT hr = skinning.Skin(model);
+        if (FAILED(hr))
+            return hr;
+
+        const UINT aNumThreads[2] = { 1u, 0u };
+        DOUBLE aVerticesPerSecond[2] = { 0.0, 0.0 };
+        for (UINT i = 0u; i < ARRAYSIZE(aNumThreads); ++i)
+        {
+            DOUBLE totalTime = 0.0;
+            for (UINT uIteration = 0u; uIteration < std::max(uNumIterations, 1u); ++uIteration)
+            {
+                hr = skinning.Skin(model, aNumThreads[i]);
+                if (FAILED(hr))
+                    return hr;
+
+                totalTime += static_cast<DOUBLE>(skinning.GetSkinTime());
+            }
+
+            aVerticesPerSecond[i] = static_cast<DOUBLE>(skinning.GetPositions().size()) * std::max(uNumIterations, 1u) * 1000.0 / std::max(totalTime, 1e-6);
+        }
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "CPU skinning %s: %zu vertices, %zu bones, %.2f M vertices/s on 1 thread, %.2f M vertices/s on %u threads\n",
+            pszName,
+            skinning.GetPositions().size(),
+            model.GetBoneTransforms().size(),
+            aVerticesPerSecond[0] / 1000000.0,
+            aVerticesPerSecond[1] / 1000000.0,
+            skinning.GetNumThreads()
+        );
+        OutputDebugStringA(szDebugMessage);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::GetPositions
+
+      Summary:  Returns the posed positions in model space
+
+      Returns:  const std::vector<XMFLOAT3>&
+                  Positions, one per vertex of the model
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<XMFLOAT3>& CpuSkinning::GetPositions() const
+    {
+        return m_aPositions;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::GetNormals
+
+      Summary:  Returns the posed normals in model space
+
+      Returns:  const std::vector<XMFLOAT3>&
+                  Unit normals, one per vertex of the model
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<XMFLOAT3>& CpuSkinning::GetNormals() const
+    {
+        return m_aNormals;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::GetSkinTime
+
+      Summary:  Returns the time the last skinning took
+
+      Returns:  FLOAT
+                  Skinning time in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT CpuSkinning::GetSkinTime() const
+    {
+        return m_skinTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::GetVerticesPerSecond
+
+      Summary:  Returns the throughput of the last skinning
+
+      Returns:  FLOAT
+                  Vertices skinned per second
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT CpuSkinning::GetVerticesPerSecond() const
+    {
+        return m_skinTime > 0.0f ? static_cast<FLOAT>(m_aPositions.size()) * 1000.0f / m_skinTime : 0.0f;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::GetNumThreads
+
+      Summary:  Returns the number of threads of the last skinning
+
+      Returns:  UINT
+                  Number of threads
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT CpuSkinning::GetNumThreads() const
+    {
+        return m_uNumThreads;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   CpuSkinning::skinRange
+
+      Summary:  Blends the bone transforms of each vertex with its UNORM8
+                weights and transforms its position and normal. Like
+                the shader, the index is clamped to the last bone, and
+                the fourth column of the transforms is never used
+
+      Args:     const SimpleVertex* pVertices
+                  Bind pose vertices
+                const AnimationData* pAnimationData
+                  Bone influences of the vertices
+                const std::vector<XMMATRIX>& aBoneTransforms
+                  Bone palette of the model
+                UINT uBegin
+                UINT uEnd
+                  Range of vertices to skin
+
+      Modifies: [m_aPositions, m_aNormals].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void CpuSkinning::skinRange(
+        _In_ const SimpleVertex* pVertices,
+        _In_ const AnimationData* pAnimationData,
+        _In_ const std::vector<XMMATRIX>& aBoneTransforms,
+        _In_ UINT uBegin,
+        _In_ UINT uEnd
+    )
+    {
+        const UINT uNumBones = static_cast<UINT>(aBoneTransforms.size());
+        const XMVECTOR zero = XMVectorZero();
+
+        for (UINT uVertex = uBegin; uVertex < uEnd; ++uVertex)
+        {
+            const AnimationData& animationData = pAnimationData[uVertex];
+
+            XMMATRIX skinTransform(zero, zero, zero, zero);
+            for (UINT i = 0u; i < MAX_NUM_BONES_PER_VERTEX && uNumBones > 0u; ++i)
+            {
+                if (animationData.aBoneWeights[i] == 0u)
+                {
+                    continue;
+                }
+
+                const XMMATRIX& bone = aBoneTransforms[std::min(static_cast<UINT>(animationData.aBoneIndices[i]), uNumBones - 1u)];
+                const XMVECTOR weight = XMVectorReplicate(static_cast<FLOAT>(animationData.aBoneWeights[i]) * (1.0f / 255.0f));
+                skinTransform.r[0] = XMVectorMultiplyAdd(bone.r[0], weight, skinTransform.r[0]);
+                skinTransform.r[1] = XMVectorMultiplyAdd(bone.r[1], weight, skinTransform.r[1]);
+                skinTransform.r[2] = XMVectorMultiplyAdd(bone.r[2], weight, skinTransform.r[2]);
+                skinTransform.r[3] = XMVectorMultiplyAdd(bone.r[3], weight, skinTransform.r[3]);
+            }
+
+            XMStoreFloat3(&m_aPositions[uVertex], XMVector3Transform(XMLoadFloat3(&pVertices[uVertex].Position), skinTransform));
+            XMStoreFloat3(&m_aNormals[uVertex], XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&pVertices[uVertex].Normal), skinTransform)));
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*+===================================================================
+  File:      CPUSKINNING.H
+
+  Summary:   CpuSkinning header file contains declarations of
+             CpuSkinning class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: CpuSkinning
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Model/Model.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    CpuSkinning
+
+      Summary:  Posed positions and normals of a skinned model computed
+                on the CPU, for picking, bounds, shadow-only passes and
+                headless checks. Each vertex blends the bone transforms
+                of its four influences with the same 8-bit weights and
+                the same index clamping as the skinning vertex shader.
+                The vertices are split into jobs of
+                NUM_VERTICES_PER_JOB and taken by worker threads
+
+      Methods:  Skin
+                  Poses the vertices of a model with its current bone
+                  transforms
+                Benchmark
+                  Skins a model repeatedly on one thread and on every
+                  hardware thread and logs the throughput
+                GetPositions
+                  Returns the posed positions in model space
+                GetNormals
+                  Returns the posed normals in model space
+                GetSkinTime
+                  Returns the time the last skinning took
+                GetVerticesPerSecond
+                  Returns the throughput of the last skinning
+                GetNumThreads
+                  Returns the number of threads of the last skinning
+                CpuSkinning
+                  Constructor.
+                ~CpuSkinning
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class CpuSkinning
+    {
+    public:
+        static constexpr const UINT NUM_VERTICES_PER_JOB = 4096u;
+
+    public:
+        CpuSkinning();
+        CpuSkinning(const CpuSkinning& other) = delete;
+        CpuSkinning(CpuSkinning&& other) = delete;
+        CpuSkinning& operator=(const CpuSkinning& other) = delete;
+        CpuSkinning& operator=(CpuSkinning&& other) = delete;
+        ~CpuSkinning() = default;
+
+        HRESULT Skin(_In_ Model& model, _In_opt_ UINT uNumThreads = 0u);
+        static HRESULT Benchmark(_In_ Model& model, _In_ PCSTR pszName, _In_ UINT uNumIterations);
+
+        const std::vector<XMFLOAT3>& GetPositions() const;
+        const std::vector<XMFLOAT3>& GetNormals() const;
+
+        FLOAT GetSkinTime() const;
+        FLOAT GetVerticesPerSecond() const;
+        UINT GetNumThreads() const;
+
+    private:
+        void skinRange(
+            _In_ const SimpleVertex* pVertices,
+            _In_ const AnimationData* pAnimationData,
+            _In_ const std::vector<XMMATRIX>& aBoneTransforms,
+            _In_ UINT uBegin,
+            _In_ UINT uEnd
+        );
+
+    private:
+        std::vector<XMFLOAT3> m_aPositions;
+        std::vector<XMFLOAT3> m_aNormals;
+        FLOAT m_skinTime;
+        UINT m_uNumThreads;
+    };
+}
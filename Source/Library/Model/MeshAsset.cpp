@@ -0,0 +1,37 @@
+#include "Model/MeshAsset.h"
+
+namespace library
+{
+    std::unordered_map<std::string, std::weak_ptr<MeshAsset>> MeshAsset::sm_library;
+    std::mutex MeshAsset::sm_libraryMutex;
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshAsset::Acquire
+
+      Summary:  Finds the mesh asset of a key, or adds an empty one to
+                be imported. The library holds the assets weakly, so
+                an asset goes with its last model
+
+      Args:     const std::string& szKey
+                  Key of the asset, the class and the file of the
+                  model
+
+      Modifies: [sm_library].
+
+      Returns:  std::shared_ptr<MeshAsset>
+                  Mesh asset of the key
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::shared_ptr<MeshAsset> MeshAsset::Acquire(_In_ const std::string& szKey)
+    {
+        std::lock_guard<std::mutex> lock(sm_libraryMutex);
+        std::weak_ptr<MeshAsset>& entry = sm_library[szKey];
+        std::shared_ptr<MeshAsset> asset = entry.lock();
+        if (!asset)
+        {
+            asset = std::make_shared<MeshAsset>();
+            entry = asset;
+        }
+
+        return asset;
+    }
+}
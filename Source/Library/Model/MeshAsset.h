@@ -0,0 +1,179 @@
+/*+===================================================================
+  File:      MESHASSET.H
+
+  Summary:   MeshAsset header file contains declarations of the
+             imported data models share, used for the lab samples of
+             Game Graphics Programming course.
+
+  Structs: SkeletonNode, BoneBounds, MaterialTextures, BoneInfo,
+           MeshAsset
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Model/AnimationClip.h"
+#include "Model/ClusterCuller.h"
+#include "Renderer/DataTypes.h"
+#include "Renderer/Renderable.h"
+#include "Renderer/TriangleBvh.h"
+#include "Texture/Material.h"
+
+#include <mutex>
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   SkeletonNode
+
+      Summary:  Node of the flattened hierarchy. Nodes are stored in
+                depth first order, so a parent always comes before its
+                children and the skeleton is evaluated in one pass
+                over the array
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct SkeletonNode
+    {
+        XMMATRIX OffsetMatrix;
+        UINT uParentIndex;
+        UINT uBoneIndex;
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   BoneBounds
+
+      Summary:  Box of the bind pose vertices a bone influences, as
+                center and half extents. A bone influencing no vertex
+                has negative extents
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct BoneBounds
+    {
+        XMFLOAT3 Center;
+        XMFLOAT3 Extents;
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   MaterialTextures
+
+      Summary:  Texture paths of a material relative to the model,
+                empty when the material has no such texture
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct MaterialTextures
+    {
+        std::string szDiffusePath;
+        std::string szSpecularPath;
+        std::string szNormalPath;
+    };
+
+    struct BoneInfo
+    {
+        BoneInfo() = default;
+        BoneInfo(const XMMATRIX& Offset)
+            : OffsetMatrix(Offset)
+        {
+        }
+
+        XMMATRIX OffsetMatrix;
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   MeshAsset
+
+      Summary:  What a model file imports to, shared by the models
+                placed from it. The first Load fills it holding
+                loadMutex, and it is only read once bIsLoaded is set.
+                The buffers and materials are created by the first
+                Initialize and taken by the later ones, which create
+                only their constant buffer and bone palette. Acquire
+                keeps the assets weakly by key, so an asset goes with
+                its last model
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct MeshAsset
+    {
+        MeshAsset()
+            : loadMutex()
+            , bIsLoaded(FALSE)
+            , aVertices()
+            , aNormalData()
+            , aAnimationData()
+            , aIndices()
+            , aMeshes()
+            , aLodMeshes()
+            , uNumMeshIndices(0u)
+            , aClusters()
+            , aClusterBones()
+            , indexFormat(DXGI_FORMAT_R16_UINT)
+            , rayBvh()
+            , aMaterialTextures()
+            , aBoneInfo()
+            , boneNameToIndexMap()
+            , aBoneBounds()
+            , bHasUnskinnedVertices(FALSE)
+            , aSkeleton()
+            , aNodeChannels()
+            , bindPose()
+            , aAnimationClips()
+            , animationNameToIndexMap()
+            , GlobalInverseTransform(XMMatrixIdentity())
+            , vertexBuffer(nullptr)
+            , normalBuffer(nullptr)
+            , indexBuffer(nullptr)
+            , animationBuffer(nullptr)
+            , skinningConstantBuffer(nullptr)
+            , aMaterials()
+            , bHasNormalMap(FALSE)
+            , bCompressVertices(FALSE)
+            , PositionScale(1.0f, 1.0f, 1.0f, 0.0f)
+            , PositionOffset(0.0f, 0.0f, 0.0f, 0.0f)
+            , BoundsMin()
+            , BoundsMax()
+        {
+        }
+
+        static std::shared_ptr<MeshAsset> Acquire(_In_ const std::string& szKey);
+
+        std::mutex loadMutex;
+        BOOL bIsLoaded;
+
+        std::vector<SimpleVertex> aVertices;
+        std::vector<NormalData> aNormalData;
+        std::vector<AnimationData> aAnimationData;
+        std::vector<UINT> aIndices;
+        std::vector<Renderable::BasicMeshEntry> aMeshes;
+        std::vector<Renderable::BasicMeshEntry> aLodMeshes;
+        UINT uNumMeshIndices;
+        std::vector<ClusterCuller::MeshCluster> aClusters;
+        std::vector<UINT> aClusterBones;
+        DXGI_FORMAT indexFormat;
+        TriangleBvh rayBvh;
+        std::vector<MaterialTextures> aMaterialTextures;
+        std::vector<BoneInfo> aBoneInfo;
+        std::unordered_map<std::string, UINT> boneNameToIndexMap;
+        std::vector<BoneBounds> aBoneBounds;
+        BOOL bHasUnskinnedVertices;
+        std::vector<SkeletonNode> aSkeleton;
+        std::vector<UINT> aNodeChannels;
+        AnimationPose bindPose;
+        std::vector<std::shared_ptr<AnimationClip>> aAnimationClips;
+        std::unordered_map<std::string, UINT> animationNameToIndexMap;
+        XMMATRIX GlobalInverseTransform;
+
+        ComPtr<ID3D11Buffer> vertexBuffer;
+        ComPtr<ID3D11Buffer> normalBuffer;
+        ComPtr<ID3D11Buffer> indexBuffer;
+        ComPtr<ID3D11Buffer> animationBuffer;
+        ComPtr<ID3D11Buffer> skinningConstantBuffer;
+        std::vector<std::shared_ptr<Material>> aMaterials;
+        BOOL bHasNormalMap;
+        BOOL bCompressVertices;
+        XMFLOAT4 PositionScale;
+        XMFLOAT4 PositionOffset;
+        XMFLOAT3 BoundsMin;
+        XMFLOAT3 BoundsMax;
+
+    private:
+        static std::unordered_map<std::string, std::weak_ptr<MeshAsset>> sm_library;
+        static std::mutex sm_libraryMutex;
+    };
+}
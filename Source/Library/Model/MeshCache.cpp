@@ -0,0 +1,462 @@
+#include "Model/MeshCache.h"
+
+#include <fstream>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const UINT64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+        constexpr const UINT64 FNV_PRIME = 1099511628211ull;
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: alignOffset
+
+          Summary:  Rounds an offset up to the alignment of the arrays
+
+          Args:     UINT64 uOffset
+                      Offset in bytes
+
+          Returns:  UINT64
+                      Next multiple of MeshCache::ALIGNMENT
+        -----------------------------------------------------------------F-F*/
+        constexpr UINT64 alignOffset(_In_ UINT64 uOffset)
+        {
+            return (uOffset + MeshCache::ALIGNMENT - 1ull) & ~(MeshCache::ALIGNMENT - 1ull);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::MeshCache
+
+      Summary:  Constructor of a cache with no file mapped and nothing
+                written
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    MeshCache::MeshCache()
+        : m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+        , m_pView(nullptr)
+        , m_uViewSize(0ull)
+        , m_uReadOffset(0ull)
+        , m_aWriteBuffer()
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::~MeshCache
+
+      Summary:  Destructor, unmaps the file
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    MeshCache::~MeshCache()
+    {
+        close();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::Open
+
+      Summary:  Maps a cache file and checks its header against the
+                source it should have been written from
+
+      Args:     const std::filesystem::path& cachePath
+                  Path to the cache file
+                UINT64 uSourceHash
+                  Hash of the source file, from HashFile
+                UINT uImportFlags
+                  Flags the source is imported with
+
+      Modifies: [m_file, m_mapping, m_pView, m_uViewSize,
+                 m_uReadOffset].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the cache is missing, stale or
+                  of another version
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshCache::Open(_In_ const std::filesystem::path& cachePath, _In_ UINT64 uSourceHash, _In_ UINT uImportFlags)
+    {
+        close();
+
+        HRESULT hr = mapFile(cachePath, m_file, m_mapping, m_pView, m_uViewSize);
+        if (FAILED(hr))
+            return hr;
+
+        if (m_uViewSize < sizeof(Header))
+        {
+            close();
+            return E_FAIL;
+        }
+
+        const Header* pHeader = reinterpret_cast<const Header*>(m_pView);
+        if (pHeader->uMagic != MAGIC ||
+            pHeader->uVersion != VERSION ||
+            pHeader->uImportFlags != uImportFlags ||
+            pHeader->uSourceHash != uSourceHash ||
+            pHeader->uFileSize != m_uViewSize)
+        {
+            close();
+            return E_FAIL;
+        }
+
+        m_uReadOffset = alignOffset(sizeof(Header));
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::ReadString
+
+      Summary:  Reads a string written as an array of characters
+
+      Args:     std::string& outString
+                  String
+
+      Modifies: [m_uReadOffset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshCache::ReadString(_Out_ std::string& outString)
+    {
+        const CHAR* pszString = nullptr;
+        UINT uLength = 0u;
+        HRESULT hr = ReadView(pszString, uLength);
+        if (FAILED(hr))
+            return hr;
+
+        outString.assign(pszString, uLength);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::WriteString
+
+      Summary:  Appends a string as an array of characters, without
+                its terminator
+
+      Args:     const std::string& string
+                  String
+
+      Modifies: [m_aWriteBuffer].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshCache::WriteString(_In_ const std::string& string)
+    {
+        Write(string.data(), static_cast<UINT>(string.size()));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::Save
+
+      Summary:  Writes the header and the arrays appended so far. The
+                file is written under a temporary name and renamed, so
+                a reader never maps a half written cache
+
+      Args:     const std::filesystem::path& cachePath
+                  Path to the cache file
+                UINT64 uSourceHash
+                  Hash of the source file, from HashFile
+                UINT uImportFlags
+                  Flags the source was imported with
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshCache::Save(_In_ const std::filesystem::path& cachePath, _In_ UINT64 uSourceHash, _In_ UINT uImportFlags) const
+    {
+        const UINT64 uHeaderSize = alignOffset(sizeof(Header));
+
+        Header header =
+        {
+            .uMagic = MAGIC,
+            .uVersion = VERSION,
+            .uImportFlags = uImportFlags,
+            .uReserved = 0u,
+            .uSourceHash = uSourceHash,
+            .uFileSize = uHeaderSize + m_aWriteBuffer.size(),
+        };
+
+        BYTE aHeaderBytes[alignOffset(sizeof(Header))] = {};
+        memcpy(aHeaderBytes, &header, sizeof(header));
+
+        // Models of the same file may be saved by two loading threads at once, each writes its own file
+        std::filesystem::path temporaryPath = cachePath;
+        temporaryPath += L"." + std::to_wstring(GetCurrentThreadId()) + L".tmp";
+
+        {
+            std::ofstream outputFile(temporaryPath, std::ios::binary | std::ios::trunc);
+            outputFile.write(reinterpret_cast<const CHAR*>(aHeaderBytes), static_cast<std::streamsize>(uHeaderSize));
+            outputFile.write(reinterpret_cast<const CHAR*>(m_aWriteBuffer.data()), static_cast<std::streamsize>(m_aWriteBuffer.size()));
+            if (!outputFile)
+            {
+                outputFile.close();
+                std::error_code error;
+                std::filesystem::remove(temporaryPath, error);
+
+                return E_FAIL;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, cachePath, error);
+        if (error)
+        {
+            std::filesystem::remove(temporaryPath, error);
+
+            return E_FAIL;
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::HashFile
+
+      Summary:  Hashes every byte of a file with 64-bit FNV-1a, so an
+                edited source invalidates its cache whatever its time
+                stamp says
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the file
+                UINT64& uOutHash
+                  Hash of the contents
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshCache::HashFile(_In_ const std::filesystem::path& filePath, _Out_ UINT64& uOutHash)
+    {
+        uOutHash = FNV_OFFSET_BASIS;
+
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        const BYTE* pView = nullptr;
+        UINT64 uSize = 0ull;
+        HRESULT hr = mapFile(filePath, file, mapping, pView, uSize);
+        if (FAILED(hr))
+            return hr;
+
+        for (UINT64 i = 0ull; i < uSize; ++i)
+        {
+            uOutHash = (uOutHash ^ pView[i]) * FNV_PRIME;
+        }
+
+        UnmapViewOfFile(pView);
+        CloseHandle(mapping);
+        CloseHandle(file);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::GetCachePath
+
+      Summary:  Returns the path of the cache of an asset, next to it
+
+      Args:     const std::filesystem::path& assetPath
+                  Path to the asset
+
+      Returns:  std::filesystem::path
+                  Path of the asset with ".meshcache" appended
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::filesystem::path MeshCache::GetCachePath(_In_ const std::filesystem::path& assetPath)
+    {
+        std::filesystem::path cachePath = assetPath;
+        cachePath += L".meshcache";
+
+        return cachePath;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::readArray
+
+      Summary:  Checks the next array header against the element size
+                and the end of the view, and steps over the array
+
+      Args:     UINT uElementSize
+                  Size of the elements expected
+                const BYTE*& pOutData
+                  First element inside the view
+                UINT& uOutNumElements
+                  Number of elements
+
+      Modifies: [m_uReadOffset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshCache::readArray(_In_ UINT uElementSize, _Out_ const BYTE*& pOutData, _Out_ UINT& uOutNumElements)
+    {
+        pOutData = nullptr;
+        uOutNumElements = 0u;
+
+        if (m_pView == nullptr || m_uReadOffset + sizeof(ArrayHeader) > m_uViewSize)
+        {
+            return E_FAIL;
+        }
+
+        const ArrayHeader* pArrayHeader = reinterpret_cast<const ArrayHeader*>(m_pView + m_uReadOffset);
+        const UINT64 uDataOffset = m_uReadOffset + sizeof(ArrayHeader);
+        const UINT64 uDataSize = static_cast<UINT64>(pArrayHeader->uElementSize) * pArrayHeader->uNumElements;
+        if (pArrayHeader->uElementSize != uElementSize || uDataOffset + uDataSize > m_uViewSize)
+        {
+            return E_FAIL;
+        }
+
+        pOutData = m_pView + uDataOffset;
+        uOutNumElements = pArrayHeader->uNumElements;
+        m_uReadOffset = alignOffset(uDataOffset + uDataSize);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::writeArray
+
+      Summary:  Appends an array header and the bytes of the array,
+                padded to the alignment
+
+      Args:     const void* pData
+                  Elements of the array
+                UINT uElementSize
+                  Size of an element
+                UINT uNumElements
+                  Number of elements
+
+      Modifies: [m_aWriteBuffer].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshCache::writeArray(_In_reads_bytes_(uElementSize * uNumElements) const void* pData, _In_ UINT uElementSize, _In_ UINT uNumElements)
+    {
+        const ArrayHeader arrayHeader =
+        {
+            .uElementSize = uElementSize,
+            .uNumElements = uNumElements,
+            .uReserved = 0ull,
+        };
+
+        // Offsets in the buffer are offsets in the file minus the aligned header, so alignment carries over
+        const SIZE_T uHeaderOffset = m_aWriteBuffer.size();
+        const SIZE_T uDataSize = static_cast<SIZE_T>(uElementSize) * uNumElements;
+        m_aWriteBuffer.resize(static_cast<SIZE_T>(alignOffset(uHeaderOffset + sizeof(ArrayHeader) + uDataSize)), 0u);
+
+        memcpy(m_aWriteBuffer.data() + uHeaderOffset, &arrayHeader, sizeof(arrayHeader));
+        if (uDataSize > 0u)
+        {
+            memcpy(m_aWriteBuffer.data() + uHeaderOffset + sizeof(ArrayHeader), pData, uDataSize);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::close
+
+      Summary:  Unmaps the file, if one is mapped
+
+      Modifies: [m_file, m_mapping, m_pView, m_uViewSize,
+                 m_uReadOffset].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshCache::close()
+    {
+        if (m_pView != nullptr)
+        {
+            UnmapViewOfFile(m_pView);
+            m_pView = nullptr;
+        }
+
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+
+        m_uViewSize = 0ull;
+        m_uReadOffset = 0ull;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::mapFile
+
+      Summary:  Maps a whole file read-only. An empty file cannot be
+                mapped and fails like a missing one
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the file
+                HANDLE& outFile
+                  Opened file
+                HANDLE& outMapping
+                  Mapping of the file
+                const BYTE*& pOutView
+                  First byte of the view
+                UINT64& uOutSize
+                  Size of the file in bytes
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshCache::mapFile(
+        _In_ const std::filesystem::path& filePath,
+        _Out_ HANDLE& outFile,
+        _Out_ HANDLE& outMapping,
+        _Out_ const BYTE*& pOutView,
+        _Out_ UINT64& uOutSize
+    )
+    {
+        outFile = INVALID_HANDLE_VALUE;
+        outMapping = nullptr;
+        pOutView = nullptr;
+        uOutSize = 0ull;
+
+        HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        LARGE_INTEGER fileSize = {};
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+        {
+            CloseHandle(file);
+            return E_FAIL;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+        if (mapping == nullptr)
+        {
+            HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+            CloseHandle(file);
+            return hr;
+        }
+
+        const BYTE* pView = static_cast<const BYTE*>(MapViewOfFile(mapping, FILE_MAP_READ, 0u, 0u, 0u));
+        if (pView == nullptr)
+        {
+            HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return hr;
+        }
+
+        outFile = file;
+        outMapping = mapping;
+        pOutView = pView;
+        uOutSize = static_cast<UINT64>(fileSize.QuadPart);
+
+        return S_OK;
+    }
+}
@@ -0,0 +1,292 @@
+/*+===================================================================
+  File:      MESHCACHE.H
+
+  Summary:   MeshCache header file contains declarations of MeshCache
+             class used for the lab samples of Game Graphics
+             Programming course.
+
+  Classes: MeshCache
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <type_traits>
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    MeshCache
+
+      Summary:  Versioned binary file written next to an asset after its
+                first import, holding the arrays the import produced.
+                The file is a header followed by arrays, each prefixed
+                by its element size and count and aligned to 16 bytes.
+                Arrays are written and read back in the same order, so
+                the file needs no table of contents. A cache is valid
+                only for the source bytes and import flags it was
+                written from, and for the current VERSION. Reading maps
+                the file, so arrays are used from the view without
+                parsing
+
+      Methods:  Open
+                  Maps a cache file and checks it matches the source
+                Read
+                  Reads the next array, or value, from the view
+                ReadView
+                  Returns the next array inside the view, uncopied
+                ReadString
+                  Reads the next string from the view
+                Write
+                  Appends an array, or value, to the file being built
+                WriteString
+                  Appends a string to the file being built
+                Save
+                  Writes the built file to disk
+                HashFile
+                  Hashes the bytes of a source file
+                GetCachePath
+                  Returns the path of the cache of an asset
+                MeshCache
+                  Constructor.
+                ~MeshCache
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class MeshCache
+    {
+    public:
+        static constexpr const UINT MAGIC = 0x48534D47u;    // "GMSH"
+        static constexpr const UINT VERSION = 6u;
+        static constexpr const UINT64 ALIGNMENT = 16ull;
+
+    public:
+        MeshCache();
+        MeshCache(const MeshCache& other) = delete;
+        MeshCache(MeshCache&& other) = delete;
+        MeshCache& operator=(const MeshCache& other) = delete;
+        MeshCache& operator=(MeshCache&& other) = delete;
+        ~MeshCache();
+
+        HRESULT Open(_In_ const std::filesystem::path& cachePath, _In_ UINT64 uSourceHash, _In_ UINT uImportFlags);
+
+        template <typename T>
+        HRESULT ReadView(_Out_ const T*& pOutData, _Out_ UINT& uOutNumElements);
+        template <typename T>
+        HRESULT Read(_Out_ std::vector<T>& outData);
+        template <typename T>
+        HRESULT Read(_Out_ T& outValue);
+        HRESULT ReadString(_Out_ std::string& outString);
+
+        template <typename T>
+        void Write(_In_reads_(uNumElements) const T* pData, _In_ UINT uNumElements);
+        template <typename T>
+        void Write(_In_ const std::vector<T>& data);
+        template <typename T>
+        void Write(_In_ const T& value);
+        void WriteString(_In_ const std::string& string);
+        HRESULT Save(_In_ const std::filesystem::path& cachePath, _In_ UINT64 uSourceHash, _In_ UINT uImportFlags) const;
+
+        static HRESULT HashFile(_In_ const std::filesystem::path& filePath, _Out_ UINT64& uOutHash);
+        static std::filesystem::path GetCachePath(_In_ const std::filesystem::path& assetPath);
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Header
+
+          Summary:  Start of the file. uFileSize catches a truncated
+                    file before any array is read
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Header
+        {
+            UINT uMagic;
+            UINT uVersion;
+            UINT uImportFlags;
+            UINT uReserved;
+            UINT64 uSourceHash;
+            UINT64 uFileSize;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   ArrayHeader
+
+          Summary:  Prefix of an array. The element size is checked
+                    against the type read, so a layout change that
+                    missed a VERSION bump is a miss and not garbage
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct ArrayHeader
+        {
+            UINT uElementSize;
+            UINT uNumElements;
+            UINT64 uReserved;
+        };
+
+        HRESULT readArray(_In_ UINT uElementSize, _Out_ const BYTE*& pOutData, _Out_ UINT& uOutNumElements);
+        void writeArray(_In_reads_bytes_(uElementSize * uNumElements) const void* pData, _In_ UINT uElementSize, _In_ UINT uNumElements);
+        void close();
+
+        static HRESULT mapFile(
+            _In_ const std::filesystem::path& filePath,
+            _Out_ HANDLE& outFile,
+            _Out_ HANDLE& outMapping,
+            _Out_ const BYTE*& pOutView,
+            _Out_ UINT64& uOutSize
+        );
+
+    private:
+        HANDLE m_file;
+        HANDLE m_mapping;
+        const BYTE* m_pView;
+        UINT64 m_uViewSize;
+        UINT64 m_uReadOffset;
+
+        std::vector<BYTE> m_aWriteBuffer;
+    };
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::ReadView
+
+      Summary:  Returns the next array where it lies in the mapped file.
+                The pointer is 16-byte aligned and stays valid until
+                the cache is destroyed
+
+      Args:     const T*& pOutData
+                  Elements of the array
+                UINT& uOutNumElements
+                  Number of elements
+
+      Modifies: [m_uReadOffset].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the next array is not of T
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <typename T>
+    HRESULT MeshCache::ReadView(_Out_ const T*& pOutData, _Out_ UINT& uOutNumElements)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "cached elements are copied as bytes");
+
+        const BYTE* pData = nullptr;
+        HRESULT hr = readArray(static_cast<UINT>(sizeof(T)), pData, uOutNumElements);
+        pOutData = reinterpret_cast<const T*>(pData);
+
+        return hr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::Read
+
+      Summary:  Copies the next array out of the mapped file
+
+      Args:     std::vector<T>& outData
+                  Elements of the array
+
+      Modifies: [m_uReadOffset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <typename T>
+    HRESULT MeshCache::Read(_Out_ std::vector<T>& outData)
+    {
+        const T* pData = nullptr;
+        UINT uNumElements = 0u;
+        HRESULT hr = ReadView(pData, uNumElements);
+        if (FAILED(hr))
+            return hr;
+
+        outData.assign(pData, pData + uNumElements);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::Read
+
+      Summary:  Reads a value written as an array of one element
+
+      Args:     T& outValue
+                  Value
+
+      Modifies: [m_uReadOffset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <typename T>
+    HRESULT MeshCache::Read(_Out_ T& outValue)
+    {
+        const T* pData = nullptr;
+        UINT uNumElements = 0u;
+        HRESULT hr = ReadView(pData, uNumElements);
+        if (FAILED(hr))
+            return hr;
+
+        if (uNumElements != 1u)
+        {
+            return E_FAIL;
+        }
+
+        outValue = *pData;
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::Write
+
+      Summary:  Appends an array to the file being built
+
+      Args:     const T* pData
+                  Elements of the array
+                UINT uNumElements
+                  Number of elements
+
+      Modifies: [m_aWriteBuffer].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <typename T>
+    void MeshCache::Write(_In_reads_(uNumElements) const T* pData, _In_ UINT uNumElements)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "cached elements are copied as bytes");
+
+        writeArray(pData, static_cast<UINT>(sizeof(T)), uNumElements);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::Write
+
+      Summary:  Appends the elements of a vector to the file being built
+
+      Args:     const std::vector<T>& data
+                  Elements of the array
+
+      Modifies: [m_aWriteBuffer].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <typename T>
+    void MeshCache::Write(_In_ const std::vector<T>& data)
+    {
+        Write(data.data(), static_cast<UINT>(data.size()));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshCache::Write
+
+      Summary:  Appends a value as an array of one element
+
+      Args:     const T& value
+                  Value
+
+      Modifies: [m_aWriteBuffer].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <typename T>
+    void MeshCache::Write(_In_ const T& value)
+    {
+        Write(&value, 1u);
+    }
+}
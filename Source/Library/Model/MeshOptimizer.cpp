@@ -0,0 +1,667 @@
+#include "Model/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const UINT64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+        constexpr const UINT64 FNV_PRIME = 1099511628211ull;
+
+        // Scoring of Forsyth, "Linear-Speed Vertex Cache Optimisation"
+        constexpr const FLOAT CACHE_DECAY_POWER = 1.5f;
+        constexpr const FLOAT LAST_TRIANGLE_SCORE = 0.75f;
+        constexpr const FLOAT VALENCE_BOOST_SCALE = 2.0f;
+        constexpr const FLOAT VALENCE_BOOST_POWER = 0.5f;
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: hashBytes
+
+          Summary:  Folds bytes into a 64-bit FNV-1a hash
+
+          Args:     const void* pData
+                      Bytes to hash
+                    SIZE_T uSize
+                      Number of bytes
+                    UINT64 uHash
+                      Hash of the bytes before
+
+          Returns:  UINT64
+                      Hash including the bytes
+        -----------------------------------------------------------------F-F*/
+        UINT64 hashBytes(_In_reads_bytes_(uSize) const void* pData, _In_ SIZE_T uSize, _In_ UINT64 uHash)
+        {
+            const BYTE* pBytes = static_cast<const BYTE*>(pData);
+            for (SIZE_T i = 0u; i < uSize; ++i)
+            {
+                uHash = (uHash ^ pBytes[i]) * FNV_PRIME;
+            }
+
+            return uHash;
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: getVertexScore
+
+          Summary:  Scores a vertex by its position in the modelled
+                    cache and by the triangles still using it, so the
+                    triangles of lonely vertices are drawn early
+
+          Args:     INT iCachePosition
+                      Position in the cache, -1 when not cached
+                    UINT uNumLiveTriangles
+                      Number of triangles not drawn yet using the vertex
+
+          Returns:  FLOAT
+                      Score, -1 when no triangle uses the vertex
+        -----------------------------------------------------------------F-F*/
+        FLOAT getVertexScore(_In_ INT iCachePosition, _In_ UINT uNumLiveTriangles)
+        {
+            if (uNumLiveTriangles == 0u)
+            {
+                return -1.0f;
+            }
+
+            FLOAT score = 0.0f;
+            if (iCachePosition >= 0)
+            {
+                if (iCachePosition < 3)
+                {
+                    // The vertices of the last triangle score the same, so no winding is favored
+                    score = LAST_TRIANGLE_SCORE;
+                }
+                else
+                {
+                    const FLOAT scale = 1.0f / static_cast<FLOAT>(MeshOptimizer::VERTEX_CACHE_SIZE - 3u);
+                    score = powf(1.0f - static_cast<FLOAT>(iCachePosition - 3) * scale, CACHE_DECAY_POWER);
+                }
+            }
+
+            return score + VALENCE_BOOST_SCALE * powf(static_cast<FLOAT>(uNumLiveTriangles), -VALENCE_BOOST_POWER);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::MeshOptimizer
+
+      Summary:  Constructor of an optimizer with no mesh
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    MeshOptimizer::MeshOptimizer()
+        : m_aVertexOrder()
+        , m_acmrBefore(0.0f)
+        , m_acmrAfter(0.0f)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::Optimize
+
+      Summary:  Welds the identical vertices of a mesh, then orders its
+                triangles for the vertex cache and overdraw and its
+                vertices for fetch. The triangles keep their winding,
+                and triangles left with a repeated vertex by the
+                welding are removed
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices of the mesh
+                const NormalData* pNormalData
+                  Tangent frames of the vertices, optional
+                const AnimationData* pAnimationData
+                  Bone influences of the vertices, optional
+                UINT uNumVertices
+                  Number of vertices
+                std::vector<UINT>& aIndices
+                  Triangle list into the vertices, replaced by the
+                  optimized list into the vertices of GetVertexOrder
+
+      Modifies: [m_aVertexOrder, m_acmrBefore, m_acmrAfter].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if an index is out of range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshOptimizer::Optimize(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_reads_opt_(uNumVertices) const NormalData* pNormalData,
+        _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+        _In_ UINT uNumVertices,
+        _Inout_ std::vector<UINT>& aIndices
+    )
+    {
+        m_aVertexOrder.clear();
+        m_acmrBefore = 0.0f;
+        m_acmrAfter = 0.0f;
+
+        if (aIndices.size() % 3u != 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        for (UINT uIndex : aIndices)
+        {
+            if (uIndex >= uNumVertices)
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        m_acmrBefore = ComputeAcmr(aIndices.data(), static_cast<UINT>(aIndices.size()), uNumVertices);
+
+        weld(pVertices, pNormalData, pAnimationData, uNumVertices, aIndices);
+        optimizeVertexCache(aIndices, uNumVertices);
+        optimizeOverdraw(aIndices, pVertices, uNumVertices);
+        optimizeVertexFetch(aIndices, uNumVertices);
+
+        m_acmrAfter = ComputeAcmr(aIndices.data(), static_cast<UINT>(aIndices.size()), static_cast<UINT>(m_aVertexOrder.size()));
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::ComputeAcmr
+
+      Summary:  Counts the vertices a FIFO post-transform cache misses
+                while drawing a triangle list
+
+      Args:     const UINT* pIndices
+                  Triangle list
+                UINT uNumIndices
+                  Number of indices
+                UINT uNumVertices
+                  Number of vertices the indices refer to
+                UINT uCacheSize
+                  Number of vertices the cache holds
+
+      Returns:  FLOAT
+                  Misses per triangle, from 0.5 at best to 3 at worst
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT MeshOptimizer::ComputeAcmr(
+        _In_reads_(uNumIndices) const UINT* pIndices,
+        _In_ UINT uNumIndices,
+        _In_ UINT uNumVertices,
+        _In_opt_ UINT uCacheSize
+    )
+    {
+        const UINT uNumTriangles = uNumIndices / 3u;
+        if (uNumTriangles == 0u)
+        {
+            return 0.0f;
+        }
+
+        // A vertex is cached while fewer than uCacheSize misses happened since its own
+        std::vector<UINT> aTimestamps(uNumVertices, 0u);
+        UINT uTime = uCacheSize + 1u;
+        UINT uNumMisses = 0u;
+        for (UINT i = 0u; i < uNumTriangles * 3u; ++i)
+        {
+            const UINT uVertex = pIndices[i];
+            if (uTime - aTimestamps[uVertex] > uCacheSize)
+            {
+                aTimestamps[uVertex] = uTime++;
+                ++uNumMisses;
+            }
+        }
+
+        return static_cast<FLOAT>(uNumMisses) / static_cast<FLOAT>(uNumTriangles);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::GetVertexOrder
+
+      Summary:  Returns the source vertex of each optimized vertex, to
+                gather every vertex stream with
+
+      Returns:  const std::vector<UINT>&
+                  Index into the source vertices, one per vertex used
+                  by the optimized triangles
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<UINT>& MeshOptimizer::GetVertexOrder() const
+    {
+        return m_aVertexOrder;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::GetAcmrBefore
+
+      Summary:  Returns the ACMR of the last mesh as it was given
+
+      Returns:  FLOAT
+                  Average cache misses per triangle
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT MeshOptimizer::GetAcmrBefore() const
+    {
+        return m_acmrBefore;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::GetAcmrAfter
+
+      Summary:  Returns the ACMR of the last mesh once optimized
+
+      Returns:  FLOAT
+                  Average cache misses per triangle
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT MeshOptimizer::GetAcmrAfter() const
+    {
+        return m_acmrAfter;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::weld
+
+      Summary:  Points every index at the first vertex with the same
+                bytes in all the streams, found through an open
+                addressing table of the vertex hashes, and removes the
+                triangles that end up with a repeated vertex
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices of the mesh
+                const NormalData* pNormalData
+                  Tangent frames of the vertices, optional
+                const AnimationData* pAnimationData
+                  Bone influences of the vertices, optional
+                UINT uNumVertices
+                  Number of vertices
+                std::vector<UINT>& aIndices
+                  Triangle list into the vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshOptimizer::weld(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_reads_opt_(uNumVertices) const NormalData* pNormalData,
+        _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+        _In_ UINT uNumVertices,
+        _Inout_ std::vector<UINT>& aIndices
+    )
+    {
+        auto hashVertex = [&](UINT uVertex)
+        {
+            UINT64 uHash = hashBytes(&pVertices[uVertex], sizeof(SimpleVertex), FNV_OFFSET_BASIS);
+            if (pNormalData != nullptr)
+            {
+                uHash = hashBytes(&pNormalData[uVertex], sizeof(NormalData), uHash);
+            }
+            if (pAnimationData != nullptr)
+            {
+                uHash = hashBytes(&pAnimationData[uVertex], sizeof(AnimationData), uHash);
+            }
+
+            return uHash;
+        };
+
+        auto isEqual = [&](UINT uVertex, UINT uOtherVertex)
+        {
+            return memcmp(&pVertices[uVertex], &pVertices[uOtherVertex], sizeof(SimpleVertex)) == 0 &&
+                (pNormalData == nullptr || memcmp(&pNormalData[uVertex], &pNormalData[uOtherVertex], sizeof(NormalData)) == 0) &&
+                (pAnimationData == nullptr || memcmp(&pAnimationData[uVertex], &pAnimationData[uOtherVertex], sizeof(AnimationData)) == 0);
+        };
+
+        // At most half full, so probes stay short
+        UINT uTableSize = 1u;
+        while (uTableSize < uNumVertices * 2u)
+        {
+            uTableSize <<= 1u;
+        }
+
+        std::vector<UINT> aTable(uTableSize, INVALID_INDEX);
+        std::vector<UINT> aRemap(uNumVertices, INVALID_INDEX);
+        for (UINT uVertex = 0u; uVertex < uNumVertices; ++uVertex)
+        {
+            for (UINT uSlot = static_cast<UINT>(hashVertex(uVertex)) & (uTableSize - 1u); ; uSlot = (uSlot + 1u) & (uTableSize - 1u))
+            {
+                if (aTable[uSlot] == INVALID_INDEX)
+                {
+                    aTable[uSlot] = uVertex;
+                    aRemap[uVertex] = uVertex;
+                    break;
+                }
+
+                if (isEqual(aTable[uSlot], uVertex))
+                {
+                    aRemap[uVertex] = aTable[uSlot];
+                    break;
+                }
+            }
+        }
+
+        SIZE_T uNumIndices = 0u;
+        for (SIZE_T i = 0u; i < aIndices.size(); i += 3u)
+        {
+            const UINT a = aRemap[aIndices[i]];
+            const UINT b = aRemap[aIndices[i + 1u]];
+            const UINT c = aRemap[aIndices[i + 2u]];
+            if (a == b || b == c || c == a)
+            {
+                continue;
+            }
+
+            aIndices[uNumIndices++] = a;
+            aIndices[uNumIndices++] = b;
+            aIndices[uNumIndices++] = c;
+        }
+
+        aIndices.resize(uNumIndices);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::optimizeVertexCache
+
+      Summary:  Orders the triangles greedily for an LRU cache of
+                VERTEX_CACHE_SIZE. Each step draws the best scored
+                triangle among those using a vertex that was just in
+                the cache, and only rescores those. When none is left,
+                the next triangle not drawn in the given order starts
+                a new run
+
+      Args:     std::vector<UINT>& aIndices
+                  Triangle list, reordered
+                UINT uNumVertices
+                  Number of vertices the indices refer to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshOptimizer::optimizeVertexCache(_Inout_ std::vector<UINT>& aIndices, _In_ UINT uNumVertices)
+    {
+        const UINT uNumTriangles = static_cast<UINT>(aIndices.size() / 3u);
+        if (uNumTriangles == 0u)
+        {
+            return;
+        }
+
+        // Triangles using each vertex, the live ones first
+        std::vector<UINT> aNumLiveTriangles(uNumVertices, 0u);
+        for (UINT uIndex : aIndices)
+        {
+            ++aNumLiveTriangles[uIndex];
+        }
+
+        std::vector<UINT> aTriangleOffsets(uNumVertices + 1u, 0u);
+        for (UINT uVertex = 0u; uVertex < uNumVertices; ++uVertex)
+        {
+            aTriangleOffsets[uVertex + 1u] = aTriangleOffsets[uVertex] + aNumLiveTriangles[uVertex];
+        }
+
+        std::vector<UINT> aVertexTriangles(aIndices.size());
+        {
+            std::vector<UINT> aCursors(aTriangleOffsets.begin(), aTriangleOffsets.end() - 1);
+            for (UINT uTriangle = 0u; uTriangle < uNumTriangles; ++uTriangle)
+            {
+                for (UINT k = 0u; k < 3u; ++k)
+                {
+                    aVertexTriangles[aCursors[aIndices[uTriangle * 3u + k]]++] = uTriangle;
+                }
+            }
+        }
+
+        std::vector<INT> aCachePositions(uNumVertices, -1);
+        std::vector<FLOAT> aVertexScores(uNumVertices);
+        for (UINT uVertex = 0u; uVertex < uNumVertices; ++uVertex)
+        {
+            aVertexScores[uVertex] = getVertexScore(-1, aNumLiveTriangles[uVertex]);
+        }
+
+        std::vector<FLOAT> aTriangleScores(uNumTriangles);
+        std::vector<BYTE> aIsDrawn(uNumTriangles, 0u);
+        UINT uBestTriangle = 0u;
+        for (UINT uTriangle = 0u; uTriangle < uNumTriangles; ++uTriangle)
+        {
+            const UINT* pTriangle = &aIndices[uTriangle * 3u];
+            aTriangleScores[uTriangle] = aVertexScores[pTriangle[0]] + aVertexScores[pTriangle[1]] + aVertexScores[pTriangle[2]];
+            if (aTriangleScores[uTriangle] > aTriangleScores[uBestTriangle])
+            {
+                uBestTriangle = uTriangle;
+            }
+        }
+
+        std::vector<UINT> aOutput;
+        aOutput.reserve(aIndices.size());
+
+        UINT aCache[VERTEX_CACHE_SIZE + 3u];
+        UINT aNewCache[VERTEX_CACHE_SIZE + 3u];
+        UINT uCacheSize = 0u;
+        UINT uNextUndrawn = 0u;
+
+        for (UINT uNumDrawn = 0u; uNumDrawn < uNumTriangles; ++uNumDrawn)
+        {
+            if (uBestTriangle == INVALID_INDEX)
+            {
+                while (aIsDrawn[uNextUndrawn])
+                {
+                    ++uNextUndrawn;
+                }
+                uBestTriangle = uNextUndrawn;
+            }
+
+            const UINT* pTriangle = &aIndices[uBestTriangle * 3u];
+            aIsDrawn[uBestTriangle] = 1u;
+            aOutput.insert(aOutput.end(), pTriangle, pTriangle + 3);
+
+            // The drawn triangle moves to the front of the cache and leaves the live lists of its vertices
+            UINT uNewCacheSize = 0u;
+            for (UINT k = 0u; k < 3u; ++k)
+            {
+                const UINT uVertex = pTriangle[k];
+                aNewCache[uNewCacheSize++] = uVertex;
+
+                UINT* pLiveTriangles = &aVertexTriangles[aTriangleOffsets[uVertex]];
+                UINT& uNumLive = aNumLiveTriangles[uVertex];
+                for (UINT i = 0u; i < uNumLive; ++i)
+                {
+                    if (pLiveTriangles[i] == uBestTriangle)
+                    {
+                        std::swap(pLiveTriangles[i], pLiveTriangles[uNumLive - 1u]);
+                        --uNumLive;
+                        break;
+                    }
+                }
+            }
+
+            for (UINT i = 0u; i < uCacheSize; ++i)
+            {
+                const UINT uVertex = aCache[i];
+                if (uVertex != pTriangle[0] && uVertex != pTriangle[1] && uVertex != pTriangle[2])
+                {
+                    aNewCache[uNewCacheSize++] = uVertex;
+                }
+            }
+
+            for (UINT i = 0u; i < uNewCacheSize; ++i)
+            {
+                const UINT uVertex = aNewCache[i];
+                aCachePositions[uVertex] = i < VERTEX_CACHE_SIZE ? static_cast<INT>(i) : -1;
+                aVertexScores[uVertex] = getVertexScore(aCachePositions[uVertex], aNumLiveTriangles[uVertex]);
+            }
+
+            uCacheSize = std::min(uNewCacheSize, VERTEX_CACHE_SIZE);
+            std::copy(aNewCache, aNewCache + uCacheSize, aCache);
+
+            // Only the triangles of the vertices whose score changed can be the next best
+            uBestTriangle = INVALID_INDEX;
+            FLOAT bestScore = -FLT_MAX;
+            for (UINT i = 0u; i < uNewCacheSize; ++i)
+            {
+                const UINT uVertex = aNewCache[i];
+                const UINT* pLiveTriangles = &aVertexTriangles[aTriangleOffsets[uVertex]];
+                for (UINT j = 0u; j < aNumLiveTriangles[uVertex]; ++j)
+                {
+                    const UINT uTriangle = pLiveTriangles[j];
+                    const UINT* pLiveTriangle = &aIndices[uTriangle * 3u];
+                    aTriangleScores[uTriangle] = aVertexScores[pLiveTriangle[0]] + aVertexScores[pLiveTriangle[1]] + aVertexScores[pLiveTriangle[2]];
+                    if (aTriangleScores[uTriangle] > bestScore)
+                    {
+                        bestScore = aTriangleScores[uTriangle];
+                        uBestTriangle = uTriangle;
+                    }
+                }
+            }
+        }
+
+        aIndices.swap(aOutput);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::optimizeOverdraw
+
+      Summary:  Splits the cache ordered triangles into clusters at the
+                triangles missing all their vertices, where reordering
+                costs the cache little, and sorts the clusters by how
+                much they face away from the center of the mesh. The
+                outer surfaces are drawn first and hide what is behind
+                them from every side. The order is kept as it was when
+                the ACMR would grow by more than OVERDRAW_THRESHOLD
+
+      Args:     std::vector<UINT>& aIndices
+                  Triangle list ordered for the vertex cache, reordered
+                const SimpleVertex* pVertices
+                  Vertices the indices refer to
+                UINT uNumVertices
+                  Number of vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshOptimizer::optimizeOverdraw(_Inout_ std::vector<UINT>& aIndices, _In_reads_(uNumVertices) const SimpleVertex* pVertices, _In_ UINT uNumVertices)
+    {
+        const UINT uNumTriangles = static_cast<UINT>(aIndices.size() / 3u);
+
+        std::vector<UINT> aClusterStarts;
+        {
+            std::vector<UINT> aTimestamps(uNumVertices, 0u);
+            UINT uTime = FIFO_CACHE_SIZE + 1u;
+            for (UINT uTriangle = 0u; uTriangle < uNumTriangles; ++uTriangle)
+            {
+                UINT uNumMisses = 0u;
+                for (UINT k = 0u; k < 3u; ++k)
+                {
+                    const UINT uVertex = aIndices[uTriangle * 3u + k];
+                    if (uTime - aTimestamps[uVertex] > FIFO_CACHE_SIZE)
+                    {
+                        aTimestamps[uVertex] = uTime++;
+                        ++uNumMisses;
+                    }
+                }
+
+                if (uNumMisses == 3u)
+                {
+                    aClusterStarts.push_back(uTriangle);
+                }
+            }
+        }
+
+        const UINT uNumClusters = static_cast<UINT>(aClusterStarts.size());
+        if (uNumClusters < 2u)
+        {
+            return;
+        }
+
+        // Area weighted centroid and summed face normal of each cluster, and centroid of the mesh
+        std::vector<XMFLOAT3> aCentroids(uNumClusters);
+        std::vector<XMFLOAT3> aNormals(uNumClusters);
+        XMVECTOR meshCentroid = XMVectorZero();
+        FLOAT meshArea = 0.0f;
+        for (UINT uCluster = 0u; uCluster < uNumClusters; ++uCluster)
+        {
+            const UINT uEnd = uCluster + 1u < uNumClusters ? aClusterStarts[uCluster + 1u] : uNumTriangles;
+
+            XMVECTOR centroid = XMVectorZero();
+            XMVECTOR normal = XMVectorZero();
+            FLOAT area = 0.0f;
+            for (UINT uTriangle = aClusterStarts[uCluster]; uTriangle < uEnd; ++uTriangle)
+            {
+                const XMVECTOR p0 = XMLoadFloat3(&pVertices[aIndices[uTriangle * 3u]].Position);
+                const XMVECTOR p1 = XMLoadFloat3(&pVertices[aIndices[uTriangle * 3u + 1u]].Position);
+                const XMVECTOR p2 = XMLoadFloat3(&pVertices[aIndices[uTriangle * 3u + 2u]].Position);
+
+                // Clockwise front faces in left-handed space, the cross product points out of the surface
+                const XMVECTOR faceNormal = XMVector3Cross(p1 - p0, p2 - p0);
+                const FLOAT faceArea = XMVectorGetX(XMVector3Length(faceNormal));
+
+                centroid += (p0 + p1 + p2) * (faceArea / 3.0f);
+                normal += faceNormal;
+                area += faceArea;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+
+            XMStoreFloat3(&aCentroids[uCluster], area > 0.0f ? centroid / area : centroid);
+            XMStoreFloat3(&aNormals[uCluster], XMVector3Normalize(normal));
+        }
+
+        if (meshArea <= 0.0f)
+        {
+            return;
+        }
+        meshCentroid = XMVectorScale(meshCentroid, 1.0f / meshArea);
+
+        std::vector<FLOAT> aSortKeys(uNumClusters);
+        std::vector<UINT> aClusterOrder(uNumClusters);
+        for (UINT uCluster = 0u; uCluster < uNumClusters; ++uCluster)
+        {
+            aSortKeys[uCluster] = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&aCentroids[uCluster]) - meshCentroid, XMLoadFloat3(&aNormals[uCluster])));
+            aClusterOrder[uCluster] = uCluster;
+        }
+
+        std::stable_sort(
+            aClusterOrder.begin(),
+            aClusterOrder.end(),
+            [&](UINT uA, UINT uB)
+            {
+                return aSortKeys[uA] > aSortKeys[uB];
+            }
+        );
+
+        std::vector<UINT> aSorted;
+        aSorted.reserve(aIndices.size());
+        for (UINT uCluster : aClusterOrder)
+        {
+            const UINT uEnd = uCluster + 1u < uNumClusters ? aClusterStarts[uCluster + 1u] : uNumTriangles;
+            aSorted.insert(aSorted.end(), aIndices.begin() + aClusterStarts[uCluster] * 3u, aIndices.begin() + uEnd * 3u);
+        }
+
+        const FLOAT acmr = ComputeAcmr(aIndices.data(), static_cast<UINT>(aIndices.size()), uNumVertices);
+        const FLOAT sortedAcmr = ComputeAcmr(aSorted.data(), static_cast<UINT>(aSorted.size()), uNumVertices);
+        if (sortedAcmr <= acmr * OVERDRAW_THRESHOLD)
+        {
+            aIndices.swap(aSorted);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshOptimizer::optimizeVertexFetch
+
+      Summary:  Renumbers the vertices in the order the triangles first
+                use them, so the vertex fetches walk the buffers
+                forward. Vertices no triangle uses, the welded ones
+                among them, are dropped
+
+      Args:     std::vector<UINT>& aIndices
+                  Triangle list, renumbered
+                UINT uNumVertices
+                  Number of vertices the indices refer to
+
+      Modifies: [m_aVertexOrder].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshOptimizer::optimizeVertexFetch(_Inout_ std::vector<UINT>& aIndices, _In_ UINT uNumVertices)
+    {
+        std::vector<UINT> aNewIndices(uNumVertices, INVALID_INDEX);
+        m_aVertexOrder.clear();
+
+        for (UINT& uIndex : aIndices)
+        {
+            if (aNewIndices[uIndex] == INVALID_INDEX)
+            {
+                aNewIndices[uIndex] = static_cast<UINT>(m_aVertexOrder.size());
+                m_aVertexOrder.push_back(uIndex);
+            }
+
+            uIndex = aNewIndices[uIndex];
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*+===================================================================
+  File:      MESHOPTIMIZER.H
+
+  Summary:   MeshOptimizer header file contains declarations of
+             MeshOptimizer class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: MeshOptimizer
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    MeshOptimizer
+
+      Summary:  Reorders the triangles and vertices of a mesh at load
+                time for the post-transform cache, overdraw and vertex
+                fetch. Vertices identical in every stream are welded
+                through a hash table first. Triangles are then ordered
+                with Forsyth's linear-speed vertex cache algorithm, and
+                split into clusters where the cache starts over, which
+                are drawn outward facing first as long as the cache
+                misses grow by at most OVERDRAW_THRESHOLD. Vertices
+                are finally renumbered in the order they are first
+                used. ACMR, the average cache misses per triangle, is
+                measured with a FIFO cache of FIFO_CACHE_SIZE before
+                and after
+
+      Methods:  Optimize
+                  Welds and reorders a mesh
+                ComputeAcmr
+                  Returns the average cache misses per triangle of a
+                  triangle list
+                GetVertexOrder
+                  Returns the source vertex of each optimized vertex
+                GetAcmrBefore
+                  Returns the ACMR of the mesh as it was given
+                GetAcmrAfter
+                  Returns the ACMR of the optimized mesh
+                MeshOptimizer
+                  Constructor.
+                ~MeshOptimizer
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class MeshOptimizer
+    {
+    public:
+        static constexpr const UINT VERTEX_CACHE_SIZE = 32u;
+        static constexpr const UINT FIFO_CACHE_SIZE = 16u;
+        static constexpr const FLOAT OVERDRAW_THRESHOLD = 1.05f;
+
+    public:
+        MeshOptimizer();
+        MeshOptimizer(const MeshOptimizer& other) = delete;
+        MeshOptimizer(MeshOptimizer&& other) = delete;
+        MeshOptimizer& operator=(const MeshOptimizer& other) = delete;
+        MeshOptimizer& operator=(MeshOptimizer&& other) = delete;
+        ~MeshOptimizer() = default;
+
+        HRESULT Optimize(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_reads_opt_(uNumVertices) const NormalData* pNormalData,
+            _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+            _In_ UINT uNumVertices,
+            _Inout_ std::vector<UINT>& aIndices
+        );
+        static FLOAT ComputeAcmr(
+            _In_reads_(uNumIndices) const UINT* pIndices,
+            _In_ UINT uNumIndices,
+            _In_ UINT uNumVertices,
+            _In_opt_ UINT uCacheSize = FIFO_CACHE_SIZE
+        );
+
+        const std::vector<UINT>& GetVertexOrder() const;
+        FLOAT GetAcmrBefore() const;
+        FLOAT GetAcmrAfter() const;
+
+    private:
+        static constexpr const UINT INVALID_INDEX = (0xFFFFFFFF);
+
+        void weld(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_reads_opt_(uNumVertices) const NormalData* pNormalData,
+            _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+            _In_ UINT uNumVertices,
+            _Inout_ std::vector<UINT>& aIndices
+        );
+        void optimizeVertexCache(_Inout_ std::vector<UINT>& aIndices, _In_ UINT uNumVertices);
+        void optimizeOverdraw(_Inout_ std::vector<UINT>& aIndices, _In_reads_(uNumVertices) const SimpleVertex* pVertices, _In_ UINT uNumVertices);
+        void optimizeVertexFetch(_Inout_ std::vector<UINT>& aIndices, _In_ UINT uNumVertices);
+
+    private:
+        std::vector<UINT> m_aVertexOrder;
+        FLOAT m_acmrBefore;
+        FLOAT m_acmrAfter;
+    };
+}
@@ -0,0 +1,506 @@
+#include "Model/MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <unordered_set>
+
+namespace library
+{
+    namespace
+    {
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: getStrongestBone
+
+          Summary:  Returns the bone with the largest weight on a vertex
+
+          Args:     const AnimationData& animationData
+                      Bone influences of the vertex
+
+          Returns:  UINT
+                      Bone index, MAX_NUM_BONES for an unskinned vertex
+        -----------------------------------------------------------------F-F*/
+        UINT getStrongestBone(_In_ const AnimationData& animationData)
+        {
+            UINT uStrongest = 0u;
+            for (UINT i = 1u; i < MAX_NUM_BONES_PER_VERTEX; ++i)
+            {
+                if (animationData.aBoneWeights[i] > animationData.aBoneWeights[uStrongest])
+                {
+                    uStrongest = i;
+                }
+            }
+
+            return animationData.aBoneWeights[uStrongest] > 0u ? animationData.aBoneIndices[uStrongest] : MAX_NUM_BONES;
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: getTriangleNormal
+
+          Summary:  Returns the cross product of two edges of a triangle,
+                    as long as twice the area of the triangle
+
+          Args:     const XMFLOAT3& p0
+                    const XMFLOAT3& p1
+                    const XMFLOAT3& p2
+                      Corners of the triangle
+
+          Returns:  XMVECTOR
+                      Unnormalized normal
+        -----------------------------------------------------------------F-F*/
+        XMVECTOR getTriangleNormal(_In_ const XMFLOAT3& p0, _In_ const XMFLOAT3& p1, _In_ const XMFLOAT3& p2)
+        {
+            XMVECTOR v0 = XMLoadFloat3(&p0);
+            return XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&p1), v0), XMVectorSubtract(XMLoadFloat3(&p2), v0));
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::MeshSimplifier
+
+      Summary:  Constructor
+
+      Modifies: [m_aPositions, m_aQuadrics, m_aStrongestBones,
+                 m_abLocked, m_aTriangleOffsets, m_aVertexTriangles,
+                 m_error].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    MeshSimplifier::MeshSimplifier()
+        : m_aPositions(std::vector<XMFLOAT3>())
+        , m_aQuadrics(std::vector<Quadric>())
+        , m_aStrongestBones(std::vector<UINT>())
+        , m_abLocked(std::vector<BYTE>())
+        , m_aTriangleOffsets(std::vector<UINT>())
+        , m_aVertexTriangles(std::vector<UINT>())
+        , m_error(0.0f)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::Simplify
+
+      Summary:  Reduces the triangles of a mesh. Positions are scaled
+                into the unit box first, so the error bound is a
+                fraction of the size of the mesh whatever its units
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices of the mesh
+                const AnimationData* pAnimationData
+                  Bone influences of the vertices, or nullptr
+                UINT uNumVertices
+                  Number of vertices
+                const UINT* pIndices
+                  Triangle list
+                UINT uNumIndices
+                  Number of indices
+                UINT uTargetNumIndices
+                  Number of indices to reduce the mesh to
+                FLOAT maxError
+                  Largest distance a collapse may move the surface,
+                  relative to the largest extent of the mesh
+                std::vector<UINT>& outIndices
+                  Simplified triangle list
+
+      Modifies: [m_aPositions, m_aQuadrics, m_aStrongestBones,
+                 m_abLocked, m_aTriangleOffsets, m_aVertexTriangles,
+                 m_error].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if an index is out of range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT MeshSimplifier::Simplify(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+        _In_ UINT uNumVertices,
+        _In_reads_(uNumIndices) const UINT* pIndices,
+        _In_ UINT uNumIndices,
+        _In_ UINT uTargetNumIndices,
+        _In_ FLOAT maxError,
+        _Out_ std::vector<UINT>& outIndices
+    )
+    {
+        m_error = 0.0f;
+        outIndices.assign(pIndices, pIndices + uNumIndices - uNumIndices % 3u);
+
+        for (UINT uIndex : outIndices)
+        {
+            if (uIndex >= uNumVertices)
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        if (outIndices.size() <= uTargetNumIndices)
+        {
+            return S_OK;
+        }
+
+        XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+        for (UINT i = 0u; i < uNumVertices; ++i)
+        {
+            XMVECTOR position = XMLoadFloat3(&pVertices[i].Position);
+            boundsMin = XMVectorMin(boundsMin, position);
+            boundsMax = XMVectorMax(boundsMax, position);
+        }
+
+        XMFLOAT3 extent;
+        XMStoreFloat3(&extent, XMVectorSubtract(boundsMax, boundsMin));
+        const FLOAT maxExtent = std::max({ extent.x, extent.y, extent.z });
+        const FLOAT scale = maxExtent > 0.0f ? 1.0f / maxExtent : 1.0f;
+
+        m_aPositions.resize(uNumVertices);
+        m_aStrongestBones.resize(uNumVertices);
+        for (UINT i = 0u; i < uNumVertices; ++i)
+        {
+            XMStoreFloat3(&m_aPositions[i], XMVectorScale(XMVectorSubtract(XMLoadFloat3(&pVertices[i].Position), boundsMin), scale));
+            m_aStrongestBones[i] = pAnimationData != nullptr ? getStrongestBone(pAnimationData[i]) : MAX_NUM_BONES;
+        }
+
+        lockOpenEdges(outIndices);
+        computeQuadrics(outIndices);
+
+        const FLOAT maxSquaredError = maxError * maxError;
+
+        std::vector<Collapse> aCollapses;
+        std::vector<UINT> aRemap(uNumVertices);
+        std::vector<BYTE> abTouched(uNumVertices);
+        for (UINT uPass = 0u; uPass < MAX_NUM_PASSES && outIndices.size() > uTargetNumIndices; ++uPass)
+        {
+            buildAdjacency(outIndices);
+
+            // Every edge once, from the triangle that has it in increasing order, collapsed in the cheaper direction
+            aCollapses.clear();
+            for (SIZE_T i = 0u; i < outIndices.size(); i += 3u)
+            {
+                for (UINT uEdge = 0u; uEdge < 3u; ++uEdge)
+                {
+                    const UINT uA = outIndices[i + uEdge];
+                    const UINT uB = outIndices[i + (uEdge + 1u) % 3u];
+                    if (uA >= uB)
+                    {
+                        continue;
+                    }
+
+                    const FLOAT errorAB = canCollapse(uA, uB) ? evaluate(uA, uB) : FLT_MAX;
+                    const FLOAT errorBA = canCollapse(uB, uA) ? evaluate(uB, uA) : FLT_MAX;
+                    if (std::min(errorAB, errorBA) <= maxSquaredError)
+                    {
+                        aCollapses.push_back(errorAB <= errorBA ? Collapse{ uA, uB, errorAB } : Collapse{ uB, uA, errorBA });
+                    }
+                }
+            }
+
+            if (aCollapses.empty())
+            {
+                break;
+            }
+
+            std::sort(aCollapses.begin(), aCollapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            for (UINT i = 0u; i < uNumVertices; ++i)
+            {
+                aRemap[i] = i;
+            }
+            std::fill(abTouched.begin(), abTouched.end(), static_cast<BYTE>(0u));
+
+            // A collapse removes the two triangles of its edge, the pass stops once the target is reached
+            const SIZE_T uNumTrianglesToRemove = (outIndices.size() - uTargetNumIndices) / 3u;
+            SIZE_T uNumTrianglesRemoved = 0u;
+            for (const Collapse& collapse : aCollapses)
+            {
+                if (uNumTrianglesRemoved >= uNumTrianglesToRemove)
+                {
+                    break;
+                }
+
+                if (abTouched[collapse.uSource] || abTouched[collapse.uTarget] || flipsTriangle(outIndices, collapse.uSource, collapse.uTarget))
+                {
+                    continue;
+                }
+
+                aRemap[collapse.uSource] = collapse.uTarget;
+
+                Quadric& target = m_aQuadrics[collapse.uTarget];
+                const Quadric& source = m_aQuadrics[collapse.uSource];
+                target.a00 += source.a00; target.a11 += source.a11; target.a22 += source.a22;
+                target.a01 += source.a01; target.a02 += source.a02; target.a12 += source.a12;
+                target.b0 += source.b0; target.b1 += source.b1; target.b2 += source.b2;
+                target.c += source.c;
+                target.weight += source.weight;
+
+                m_error = std::max(m_error, collapse.error);
+
+                // The ring of the source changes shape, so none of it moves again in this pass
+                for (UINT t = m_aTriangleOffsets[collapse.uSource]; t < m_aTriangleOffsets[collapse.uSource + 1u]; ++t)
+                {
+                    const UINT* pTriangle = &outIndices[m_aVertexTriangles[t] * 3u];
+                    abTouched[pTriangle[0]] = abTouched[pTriangle[1]] = abTouched[pTriangle[2]] = 1u;
+                    if (pTriangle[0] == collapse.uTarget || pTriangle[1] == collapse.uTarget || pTriangle[2] == collapse.uTarget)
+                    {
+                        ++uNumTrianglesRemoved;
+                    }
+                }
+            }
+
+            if (uNumTrianglesRemoved == 0u)
+            {
+                break;
+            }
+
+            // Apply the collapses and drop the triangles that lost an edge
+            SIZE_T uNumKept = 0u;
+            for (SIZE_T i = 0u; i < outIndices.size(); i += 3u)
+            {
+                const UINT uA = aRemap[outIndices[i]];
+                const UINT uB = aRemap[outIndices[i + 1u]];
+                const UINT uC = aRemap[outIndices[i + 2u]];
+                if (uA != uB && uB != uC && uC != uA)
+                {
+                    outIndices[uNumKept++] = uA;
+                    outIndices[uNumKept++] = uB;
+                    outIndices[uNumKept++] = uC;
+                }
+            }
+            outIndices.resize(uNumKept);
+        }
+
+        m_error = sqrtf(m_error);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::GetError
+
+      Summary:  Returns the largest distance a collapse of the last
+                simplification moved the surface
+
+      Returns:  FLOAT
+                  Error relative to the largest extent of the mesh
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT MeshSimplifier::GetError() const
+    {
+        return m_error;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::buildAdjacency
+
+      Summary:  Lists the triangles around every vertex, by a counting
+                sort of the corners
+
+      Args:     const std::vector<UINT>& aIndices
+                  Triangle list
+
+      Modifies: [m_aTriangleOffsets, m_aVertexTriangles].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshSimplifier::buildAdjacency(_In_ const std::vector<UINT>& aIndices)
+    {
+        m_aTriangleOffsets.assign(m_aPositions.size() + 1u, 0u);
+        for (UINT uIndex : aIndices)
+        {
+            ++m_aTriangleOffsets[uIndex + 1u];
+        }
+
+        for (SIZE_T i = 1u; i < m_aTriangleOffsets.size(); ++i)
+        {
+            m_aTriangleOffsets[i] += m_aTriangleOffsets[i - 1u];
+        }
+
+        std::vector<UINT> aFill(m_aTriangleOffsets.begin(), m_aTriangleOffsets.end() - 1);
+        m_aVertexTriangles.resize(aIndices.size());
+        for (SIZE_T i = 0u; i < aIndices.size(); ++i)
+        {
+            m_aVertexTriangles[aFill[aIndices[i]]++] = static_cast<UINT>(i / 3u);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::canCollapse
+
+      Summary:  Returns whether a vertex may move onto another, which
+                it may unless it is on an open edge or the two are led
+                by different bones
+
+      Args:     UINT uSource
+                  Vertex that moves
+                UINT uTarget
+                  Vertex it moves onto
+
+      Returns:  BOOL
+                  TRUE if the collapse is allowed
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL MeshSimplifier::canCollapse(_In_ UINT uSource, _In_ UINT uTarget) const
+    {
+        return !m_abLocked[uSource] && m_aStrongestBones[uSource] == m_aStrongestBones[uTarget];
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::computeQuadrics
+
+      Summary:  Adds the plane of every triangle, weighted by its area,
+                to the quadrics of its corners
+
+      Args:     const std::vector<UINT>& aIndices
+                  Triangle list
+
+      Modifies: [m_aQuadrics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshSimplifier::computeQuadrics(_In_ const std::vector<UINT>& aIndices)
+    {
+        m_aQuadrics.assign(m_aPositions.size(), Quadric{});
+
+        for (SIZE_T i = 0u; i < aIndices.size(); i += 3u)
+        {
+            const XMFLOAT3& p0 = m_aPositions[aIndices[i]];
+            XMVECTOR normal = getTriangleNormal(p0, m_aPositions[aIndices[i + 1u]], m_aPositions[aIndices[i + 2u]]);
+            const FLOAT area = XMVectorGetX(XMVector3Length(normal)) * 0.5f;
+            if (area <= 0.0f)
+            {
+                continue;
+            }
+
+            XMFLOAT3 n;
+            XMStoreFloat3(&n, XMVector3Normalize(normal));
+            const FLOAT d = -(n.x * p0.x + n.y * p0.y + n.z * p0.z);
+
+            const Quadric plane =
+            {
+                .a00 = area * n.x * n.x, .a11 = area * n.y * n.y, .a22 = area * n.z * n.z,
+                .a01 = area * n.x * n.y, .a02 = area * n.x * n.z, .a12 = area * n.y * n.z,
+                .b0 = area * n.x * d, .b1 = area * n.y * d, .b2 = area * n.z * d,
+                .c = area * d * d,
+                .weight = area,
+            };
+
+            for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+            {
+                Quadric& quadric = m_aQuadrics[aIndices[i + uCorner]];
+                quadric.a00 += plane.a00; quadric.a11 += plane.a11; quadric.a22 += plane.a22;
+                quadric.a01 += plane.a01; quadric.a02 += plane.a02; quadric.a12 += plane.a12;
+                quadric.b0 += plane.b0; quadric.b1 += plane.b1; quadric.b2 += plane.b2;
+                quadric.c += plane.c;
+                quadric.weight += plane.weight;
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::evaluate
+
+      Summary:  Returns the error of moving a vertex onto another, the
+                quadric of the moving vertex at the other position
+                over the area of its triangles
+
+      Args:     UINT uSource
+                  Vertex that moves
+                UINT uTarget
+                  Vertex it moves onto
+
+      Returns:  FLOAT
+                  Mean squared distance to the planes of the source
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT MeshSimplifier::evaluate(_In_ UINT uSource, _In_ UINT uTarget) const
+    {
+        const Quadric& q = m_aQuadrics[uSource];
+        const XMFLOAT3& p = m_aPositions[uTarget];
+
+        const FLOAT error =
+            q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z +
+            2.0f * (q.a01 * p.x * p.y + q.a02 * p.x * p.z + q.a12 * p.y * p.z) +
+            2.0f * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) +
+            q.c;
+
+        return q.weight > 0.0f ? std::max(error, 0.0f) / q.weight : 0.0f;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::flipsTriangle
+
+      Summary:  Returns whether moving a vertex onto another turns one
+                of the triangles it keeps upside down or flat
+
+      Args:     const std::vector<UINT>& aIndices
+                  Triangle list the adjacency was built from
+                UINT uSource
+                  Vertex that moves
+                UINT uTarget
+                  Vertex it moves onto
+
+      Returns:  BOOL
+                  TRUE if a triangle would flip
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL MeshSimplifier::flipsTriangle(_In_ const std::vector<UINT>& aIndices, _In_ UINT uSource, _In_ UINT uTarget) const
+    {
+        for (UINT t = m_aTriangleOffsets[uSource]; t < m_aTriangleOffsets[uSource + 1u]; ++t)
+        {
+            const UINT* pTriangle = &aIndices[m_aVertexTriangles[t] * 3u];
+            if (pTriangle[0] == uTarget || pTriangle[1] == uTarget || pTriangle[2] == uTarget)
+            {
+                continue;
+            }
+
+            XMFLOAT3 aCorners[3];
+            for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+            {
+                aCorners[uCorner] = m_aPositions[pTriangle[uCorner] == uSource ? uTarget : pTriangle[uCorner]];
+            }
+
+            XMVECTOR before = getTriangleNormal(m_aPositions[pTriangle[0]], m_aPositions[pTriangle[1]], m_aPositions[pTriangle[2]]);
+            XMVECTOR after = getTriangleNormal(aCorners[0], aCorners[1], aCorners[2]);
+            if (XMVectorGetX(XMVector3Dot(before, after)) <= 0.0f)
+            {
+                return TRUE;
+            }
+        }
+
+        return FALSE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   MeshSimplifier::lockOpenEdges
+
+      Summary:  Locks the vertices of the edges no other triangle runs
+                the other way, the borders and attribute seams
+
+      Args:     const std::vector<UINT>& aIndices
+                  Triangle list
+
+      Modifies: [m_abLocked].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void MeshSimplifier::lockOpenEdges(_In_ const std::vector<UINT>& aIndices)
+    {
+        std::unordered_set<UINT64> edges;
+        edges.reserve(aIndices.size());
+        for (SIZE_T i = 0u; i < aIndices.size(); i += 3u)
+        {
+            for (UINT uEdge = 0u; uEdge < 3u; ++uEdge)
+            {
+                edges.insert(static_cast<UINT64>(aIndices[i + uEdge]) << 32u | aIndices[i + (uEdge + 1u) % 3u]);
+            }
+        }
+
+        m_abLocked.assign(m_aPositions.size(), 0u);
+        for (SIZE_T i = 0u; i < aIndices.size(); i += 3u)
+        {
+            for (UINT uEdge = 0u; uEdge < 3u; ++uEdge)
+            {
+                const UINT uA = aIndices[i + uEdge];
+                const UINT uB = aIndices[i + (uEdge + 1u) % 3u];
+                if (edges.find(static_cast<UINT64>(uB) << 32u | uA) == edges.end())
+                {
+                    m_abLocked[uA] = m_abLocked[uB] = 1u;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*+===================================================================
+  File:      MESHSIMPLIFIER.H
+
+  Summary:   MeshSimplifier header file contains declarations of
+             MeshSimplifier class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: MeshSimplifier
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    MeshSimplifier
+
+      Summary:  Reduces the triangles of a mesh by edge collapses,
+                cheapest first by the quadric error of Garland and
+                Heckbert. A collapse moves a vertex onto a neighbour,
+                so the simplified indices still point into the
+                vertices of the mesh and a level of detail is only a
+                new index range. Vertices on an open edge, which are
+                the borders and the UV and normal seams of a mesh
+                split by attributes, never move, and a vertex only
+                collapses onto one led by the same bone. Collapses are
+                made in passes that each touch a vertex once, and stop
+                at the target triangle count, at the error bound or
+                when a collapse would flip a triangle
+
+      Methods:  Simplify
+                  Reduces the triangles of a mesh
+                GetError
+                  Returns the largest error of the collapses made
+                MeshSimplifier
+                  Constructor.
+                ~MeshSimplifier
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class MeshSimplifier
+    {
+    public:
+        static constexpr const UINT MAX_NUM_PASSES = 64u;
+
+    public:
+        MeshSimplifier();
+        MeshSimplifier(const MeshSimplifier& other) = delete;
+        MeshSimplifier(MeshSimplifier&& other) = delete;
+        MeshSimplifier& operator=(const MeshSimplifier& other) = delete;
+        MeshSimplifier& operator=(MeshSimplifier&& other) = delete;
+        ~MeshSimplifier() = default;
+
+        HRESULT Simplify(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_reads_opt_(uNumVertices) const AnimationData* pAnimationData,
+            _In_ UINT uNumVertices,
+            _In_reads_(uNumIndices) const UINT* pIndices,
+            _In_ UINT uNumIndices,
+            _In_ UINT uTargetNumIndices,
+            _In_ FLOAT maxError,
+            _Out_ std::vector<UINT>& outIndices
+        );
+
+        FLOAT GetError() const;
+
+    private:
+        static constexpr const UINT INVALID_INDEX = (0xFFFFFFFF);
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Quadric
+
+          Summary:  Sum of the squared distances to the planes of the
+                    triangles around a vertex, weighted by their areas.
+                    A is symmetric, so only its upper half is kept
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Quadric
+        {
+            FLOAT a00, a11, a22, a01, a02, a12;
+            FLOAT b0, b1, b2;
+            FLOAT c;
+            FLOAT weight;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Collapse
+
+          Summary:  Move of uSource onto uTarget and its squared error
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Collapse
+        {
+            UINT uSource;
+            UINT uTarget;
+            FLOAT error;
+        };
+
+        void buildAdjacency(_In_ const std::vector<UINT>& aIndices);
+        BOOL canCollapse(_In_ UINT uSource, _In_ UINT uTarget) const;
+        void computeQuadrics(_In_ const std::vector<UINT>& aIndices);
+        FLOAT evaluate(_In_ UINT uSource, _In_ UINT uTarget) const;
+        BOOL flipsTriangle(_In_ const std::vector<UINT>& aIndices, _In_ UINT uSource, _In_ UINT uTarget) const;
+        void lockOpenEdges(_In_ const std::vector<UINT>& aIndices);
+
+    private:
+        std::vector<XMFLOAT3> m_aPositions;
+        std::vector<Quadric> m_aQuadrics;
+        std::vector<UINT> m_aStrongestBones;
+        std::vector<BYTE> m_abLocked;
+        std::vector<UINT> m_aTriangleOffsets;
+        std::vector<UINT> m_aVertexTriangles;
+        FLOAT m_error;
+    };
+}
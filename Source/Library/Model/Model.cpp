@@ -1,9 +1,19 @@
 #include "Model/Model.h"
+#include "Model/ClusterCuller.h"
+#include "Model/MeshOptimizer.h"
+#include "Model/MeshSimplifier.h"
+#include "Model/VertexQuantizer.h"
+#include "ParallelFor.h"
+#include "Statistics.h"
 
 #include "assimp/Importer.hpp"	// C++ importer interface
 #include "assimp/scene.h"		    // output data structure
 #include "assimp/postprocess.h"	// post processing flags
 
+#include <algorithm>
+#include <cfloat>
+#include <typeinfo>
+
 namespace library
 {
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -44,17 +54,34 @@ namespace library
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   ConvertQuaternionToVector
-      Summary:  Convert aiQuaternion to XMVECTOR
-      Returns:  XMVECTOR
+      Method:   GetTexturePath
+      Summary:  Returns the path of the first texture of the given type,
+                relative to the model, without a leading ".\"
+      Returns:  std::string
+                  Relative path, empty if the material has none
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    XMVECTOR ConvertQuaternionToVector(_In_ const aiQuaternion& quaternion)
+    std::string GetTexturePath(_In_ const aiMaterial* pMaterial, _In_ aiTextureType textureType)
     {
-        XMFLOAT4 float4 = XMFLOAT4(quaternion.x, quaternion.y, quaternion.z, quaternion.w);
-        return XMLoadFloat4(&float4);
+        aiString aiPath;
+        if (pMaterial->GetTextureCount(textureType) == 0u ||
+            pMaterial->GetTexture(textureType, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) != AI_SUCCESS)
+        {
+            return std::string();
+        }
+
+        std::string szPath(aiPath.data);
+
+        if (szPath.substr(0ull, 2ull) == ".\\")
+        {
+            szPath = szPath.substr(2ull, szPath.size() - 2ull);
+        }
+
+        return szPath;
     }
 
-    std::unique_ptr<Assimp::Importer> Model::sm_pImporter = std::make_unique<Assimp::Importer>();
+    std::unordered_map<std::string, std::vector<std::shared_ptr<AnimationClip>>> Model::sm_animationClipLibrary;
+    std::mutex Model::sm_animationClipLibraryMutex;
+    AnimationPoseCache Model::sm_poseCache;
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Model::Model
@@ -62,105 +89,336 @@ namespace library
       Args:     const std::filesystem::path& filePath
                   Path to the model to load
       Modifies: [m_filePath, m_animationBuffer, m_skinningConstantBuffer,
-                 m_skinningConstantBuffer, m_aVertices, m_aAnimationData,
-                 m_aIndices, m_aBoneData, m_aBoneInfo, m_aTransforms,
-                 m_aBoneInfo, m_aTransforms, m_boneNameToIndexMap,
-                 m_pScene, m_timeSinceLoaded, m_globalInverseTransform].
+                 m_bonePaletteBuffer, m_bonePaletteView, m_asset,
+                 m_posedRayBvh, m_clusterCuller, m_aPackedIndices,
+                 m_bCompressVertices, m_aQuantizedVertices,
+                 m_aQuantizedNormalData, m_positionScale,
+                 m_positionOffset, m_aBoneData, m_aTransforms,
+                 m_aGlobalTransforms, m_aPoseBoneBoxes, m_pose,
+                 m_blendPose, m_referencePose, m_currentPlayback,
+                 m_previousPlayback,
+                 m_fadeTime, m_fadeDuration, m_aAdditiveLayers,
+                 m_bIsLoaded].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     Model::Model(_In_ const std::filesystem::path& filePath)
         : Renderable(XMFLOAT4(1.0, 1.0, 1.0, 1.0))
         , m_filePath(filePath)
         , m_animationBuffer(nullptr)
         , m_skinningConstantBuffer(nullptr)
-        , m_aVertices(std::vector<SimpleVertex>())
-        , m_aAnimationData(std::vector<AnimationData>())
-        , m_aIndices(std::vector<WORD>())
+        , m_bonePaletteBuffer(nullptr)
+        , m_bonePaletteView(nullptr)
+        , m_asset(std::make_shared<MeshAsset>())
+        , m_posedRayBvh(nullptr)
+        , m_clusterCuller()
+        , m_aPackedIndices(std::vector<WORD>())
+        , m_bCompressVertices(FALSE)
+        , m_aQuantizedVertices(std::vector<QuantizedVertex>())
+        , m_aQuantizedNormalData(std::vector<QuantizedNormalData>())
+        , m_positionScale(1.0f, 1.0f, 1.0f, 0.0f)
+        , m_positionOffset(0.0f, 0.0f, 0.0f, 0.0f)
         , m_aBoneData(std::vector<VertexBoneData>())
-        , m_aBoneInfo(std::vector<BoneInfo>())
         , m_aTransforms(std::vector<XMMATRIX>())
-        , m_boneNameToIndexMap(std::unordered_map<std::string, UINT>())
-        , m_pScene()
-        , m_timeSinceLoaded(0.0f)
-        , m_globalInverseTransform()
+        , m_aGlobalTransforms(std::vector<XMMATRIX>())
+        , m_aPoseBoneBoxes(std::vector<ClusterCuller::BoneBox>())
+        , m_pose()
+        , m_blendPose()
+        , m_referencePose()
+        , m_currentPlayback{ INVALID_INDEX, 0.0f, 1.0f }
+        , m_previousPlayback{ INVALID_INDEX, 0.0f, 1.0f }
+        , m_fadeTime(0.0f)
+        , m_fadeDuration(0.0f)
+        , m_aAdditiveLayers(std::vector<AnimationPlayback>())
+        , m_bIsLoaded(FALSE)
     { }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Model::Initialize
-      Summary:  Load and initialize the 3d model and create buffers
+      Summary:  Load the 3d model, unless Load already ran, and create
+                its materials and buffers. The first model of a mesh
+                asset creates them and keeps them in the asset, later
+                ones take them and create only their constant buffer
+                and bone palette
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
-      Modifies: [m_pScene, m_globalInverseTransform, m_animationBuffer,
-                 m_skinningConstantBuffer].
+      Modifies: [m_aMaterials, m_bHasNormalMap, m_aPackedIndices,
+                 m_aNormalData, m_vertexBuffer, m_normalBuffer,
+                 m_indexBuffer, m_constantBuffer, m_boundsMin,
+                 m_boundsMax, m_positionScale, m_positionOffset,
+                 m_animationBuffer, m_skinningConstantBuffer,
+                 m_bonePaletteBuffer, m_bonePaletteView, m_asset].
       Returns:  HRESULT
                   Status code
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     HRESULT Model::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
     {
-        HRESULT hr = S_OK;
+        HRESULT hr = Load();
+        if (FAILED(hr))
+            return hr;
 
-        // Read the 3d model file using Assimp importer(m_importer), store thre read scene into m_pScene
-        //m_pScene = sm_pImporter->ReadFile(
-        //    m_filePath.string().c_str(),
-        //    ASSIMP_LOAD_FLAGS
-        //);
+        // Materials are per asset, a model that changes one, as the skybox does, copies it first
+        if (m_asset->aMaterials.empty())
+        {
+            hr = initMaterialTextures(pDevice, pImmediateContext, m_filePath);
+            if (FAILED(hr))
+                return hr;
 
-        // With Assimp, we can calculate T and B vectors easily when importing the model
-        m_pScene = sm_pImporter->ReadFile(
-            m_filePath.string().c_str(),
-            aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-            aiProcess_CalcTangentSpace | aiProcess_ConvertToLeftHanded
-        );
-        
-        if (m_pScene != nullptr)
+            m_asset->aMaterials = m_aMaterials;
+            m_asset->bHasNormalMap = m_bHasNormalMap;
+        }
+        else
         {
-            // set m_globalInverseTransform as matrix from world space to model space
-            m_globalInverseTransform = ConvertMatrix(m_pScene->mRootNode->mTransformation);
-            XMVECTOR det = XMMatrixDeterminant(m_globalInverseTransform);
-            m_globalInverseTransform = XMMatrixInverse(&det, m_globalInverseTransform);
+            m_aMaterials = m_asset->aMaterials;
+            m_bHasNormalMap = m_asset->bHasNormalMap;
+        }
 
-            // Initialize the model
-            hr = initFromScene(pDevice, pImmediateContext, m_pScene, m_filePath);
+        D3D11_BUFFER_DESC bd = {};
+        D3D11_SUBRESOURCE_DATA InitData = {};
+        if (m_asset->vertexBuffer != nullptr && m_asset->bCompressVertices == m_bCompressVertices)
+        {
+            // The buffers of the asset are never written again, so they are shared as they are
+            m_vertexBuffer = m_asset->vertexBuffer;
+            m_normalBuffer = m_asset->normalBuffer;
+            m_indexBuffer = m_asset->indexBuffer;
+            m_animationBuffer = m_asset->animationBuffer;
+            m_skinningConstantBuffer = m_asset->skinningConstantBuffer;
+            m_positionScale = m_asset->PositionScale;
+            m_positionOffset = m_asset->PositionOffset;
+            m_boundsMin = m_asset->BoundsMin;
+            m_boundsMax = m_asset->BoundsMax;
+
+            bd.Usage = D3D11_USAGE_DEFAULT;
+            bd.ByteWidth = sizeof(CBChangesEveryFrame);
+            bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+            bd.CPUAccessFlags = 0;
+            hr = pDevice->CreateBuffer(&bd, nullptr, m_constantBuffer.GetAddressOf());
             if (FAILED(hr))
                 return hr;
         }
         else
         {
-            hr = E_FAIL;
-            OutputDebugString(L"Error parsing ");
-            OutputDebugString(m_filePath.c_str());
-            OutputDebugString(L": ");
-            OutputDebugStringA(sm_pImporter->GetErrorString());
-            OutputDebugString(L"\n");
+            // 16-bit indices are packed for the upload only, the model keeps the 32-bit ones
+            if (m_asset->indexFormat == DXGI_FORMAT_R16_UINT)
+            {
+                m_aPackedIndices.resize(m_asset->aIndices.size());
+                std::transform(m_asset->aIndices.begin(), m_asset->aIndices.end(), m_aPackedIndices.begin(), [](UINT uIndex) { return static_cast<WORD>(uIndex); });
+            }
 
-            return hr;
+            // Compressed vertices are built for the upload only too, the CPU skinning and the bounds read the float ones
+            if (m_bCompressVertices)
+            {
+                VertexQuantizer quantizer;
+                hr = quantizer.Quantize(
+                    m_asset->aVertices.data(),
+                    m_asset->aNormalData.size() == m_asset->aVertices.size() ? m_asset->aNormalData.data() : nullptr,
+                    GetNumVertices(),
+                    m_aQuantizedVertices,
+                    m_aQuantizedNormalData
+                );
+                if (FAILED(hr))
+                    return hr;
+
+                m_positionScale = quantizer.GetPositionScale();
+                m_positionOffset = quantizer.GetPositionOffset();
+
+                if (Statistics::IsLogging())
+                {
+                    CHAR szDebugMessage[256];
+                    sprintf_s(
+                        szDebugMessage,
+                        "Model %s: %u vertices compressed from %zu to %zu bytes\n",
+                        m_filePath.filename().string().c_str(),
+                        GetNumVertices(),
+                        (sizeof(SimpleVertex) + sizeof(NormalData)) * m_asset->aVertices.size(),
+                        (sizeof(QuantizedVertex) + sizeof(QuantizedNormalData)) * m_asset->aVertices.size()
+                    );
+                    OutputDebugStringA(szDebugMessage);
+                }
+            }
+
+            // The tangent frames are copied for the upload only as well, the asset keeps them
+            m_aNormalData = m_asset->aNormalData;
+
+            // Initialize the buffers(initialize)
+            hr = initialize(pDevice, pImmediateContext);
+            std::vector<WORD>().swap(m_aPackedIndices);
+            std::vector<QuantizedVertex>().swap(m_aQuantizedVertices);
+            std::vector<QuantizedNormalData>().swap(m_aQuantizedNormalData);
+            std::vector<NormalData>().swap(m_aNormalData);
+            if (FAILED(hr))
+                return hr;
+
+            // Create the vertex buffer, m_animationBuffer 
+            bd.Usage = D3D11_USAGE_DEFAULT;
+            bd.ByteWidth = sizeof(AnimationData) * (UINT)m_asset->aAnimationData.size();
+            bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            bd.CPUAccessFlags = 0;
+            InitData.pSysMem = m_asset->aAnimationData.data(); 
+            hr = pDevice->CreateBuffer(&bd, &InitData, m_animationBuffer.GetAddressOf());
+            if (FAILED(hr))
+                return hr;
+
+            // Create the constant buffer, m_skinningConstantBuffer, holding the number of bones of the palette
+            CBSkinning cbSkinning =
+            {
+                .NumBones = static_cast<UINT>(m_asset->aBoneInfo.size()),
+            };
+            bd.Usage = D3D11_USAGE_IMMUTABLE;
+            bd.ByteWidth = sizeof(CBSkinning);
+            bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+            bd.CPUAccessFlags = 0;
+            bd.MiscFlags = 0;
+            bd.StructureByteStride = 0;
+            InitData.pSysMem = &cbSkinning;
+            hr = pDevice->CreateBuffer(&bd, &InitData, m_skinningConstantBuffer.GetAddressOf());
+            if (FAILED(hr))
+                return hr;
+
+            // A model compressed unlike the asset keeps its buffers to itself
+            if (m_asset->vertexBuffer == nullptr)
+            {
+                m_asset->vertexBuffer = m_vertexBuffer;
+                m_asset->normalBuffer = m_normalBuffer;
+                m_asset->indexBuffer = m_indexBuffer;
+                m_asset->animationBuffer = m_animationBuffer;
+                m_asset->skinningConstantBuffer = m_skinningConstantBuffer;
+                m_asset->bCompressVertices = m_bCompressVertices;
+                m_asset->PositionScale = m_positionScale;
+                m_asset->PositionOffset = m_positionOffset;
+                m_asset->BoundsMin = m_boundsMin;
+                m_asset->BoundsMax = m_boundsMax;
+            }
         }
 
-        // Create the vertex buffer, m_animationBuffer 
-        D3D11_BUFFER_DESC bd = {};
-        bd.Usage = D3D11_USAGE_DEFAULT;
-        bd.ByteWidth = sizeof(AnimationData) * (UINT)m_aAnimationData.size();
-        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        bd.CPUAccessFlags = 0;
-        D3D11_SUBRESOURCE_DATA InitData = {}; // with initial data m_aAnimationData
-        InitData.pSysMem = m_aAnimationData.data(); 
-        hr = pDevice->CreateBuffer(&bd, &InitData, m_animationBuffer.GetAddressOf());
+        // Create the bone palette, m_bonePaletteBuffer, sized to the bones of the model and rewritten each frame
+        const UINT uNumPaletteRows = std::max(static_cast<UINT>(m_asset->aBoneInfo.size()), 1u) * BONE_PALETTE_ROWS;
+        std::vector<XMFLOAT4> aZeroRows(uNumPaletteRows, XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+        bd.Usage = D3D11_USAGE_DYNAMIC;
+        bd.ByteWidth = sizeof(XMFLOAT4) * uNumPaletteRows;
+        bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        bd.MiscFlags = 0;
+        bd.StructureByteStride = 0;
+        InitData.pSysMem = aZeroRows.data();
+        hr = pDevice->CreateBuffer(&bd, &InitData, m_bonePaletteBuffer.GetAddressOf());
         if (FAILED(hr))
             return hr;
 
-        // Create the constant buffer, m_skinningConstantBuffer
-        bd.Usage = D3D11_USAGE_DEFAULT;
-        bd.ByteWidth = sizeof(CBSkinning);
-        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        bd.CPUAccessFlags = 0;
-        bd.MiscFlags = 0;
-        bd.StructureByteStride = 0;
-        hr = pDevice->CreateBuffer(&bd, nullptr, m_skinningConstantBuffer.GetAddressOf());
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc =
+        {
+            .Format = DXGI_FORMAT_R32G32B32A32_FLOAT,
+            .ViewDimension = D3D11_SRV_DIMENSION_BUFFER,
+            .Buffer =
+            {
+                .FirstElement = 0u,
+                .NumElements = uNumPaletteRows,
+            },
+        };
+        hr = pDevice->CreateShaderResourceView(m_bonePaletteBuffer.Get(), &srvDesc, m_bonePaletteView.GetAddressOf());
+        if (FAILED(hr))
+            return hr;
+
+        return hr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::Load
+      Summary:  Builds the geometry, skeleton and clips of the model on
+                the CPU. Models of the same class and file share one
+                mesh asset: the first Load imports it with
+                importMeshAsset, and Loads of the same file on other
+                threads wait for it and share the result. Only the
+                playback, the bone transforms, the meshes with their
+                materials and the cluster culler are set up per model
+      Modifies: [m_asset, m_aMeshes, m_aGlobalTransforms, m_aTransforms,
+                 m_aPoseBoneBoxes, m_currentPlayback, m_clusterCuller,
+                 m_bIsLoaded].
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::Load()
+    {
+        if (m_bIsLoaded)
+        {
+            return S_OK;
+        }
+
+        HRESULT hr = S_OK;
+
+        LARGE_INTEGER startingTime;
+        LARGE_INTEGER endingTime;
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        // Subclasses such as the skybox import the same file differently, so the class is part of the key
+        m_asset = MeshAsset::Acquire(std::string(typeid(*this).name()) + '|' + m_filePath.lexically_normal().string());
+
+        BOOL bShared = FALSE;
+        BOOL bLoadedFromCache = FALSE;
+        {
+            std::lock_guard<std::mutex> lock(m_asset->loadMutex);
+            bShared = m_asset->bIsLoaded;
+            if (!bShared)
+            {
+                hr = importMeshAsset(bLoadedFromCache);
+                if (FAILED(hr))
+                {
+                    // The next model of the file imports it again from a clean asset
+                    clearMeshData();
+                    return hr;
+                }
+
+                m_asset->bIsLoaded = TRUE;
+            }
+        }
+
+        if (!m_asset->aAnimationClips.empty())
+        {
+            m_aGlobalTransforms.resize(m_asset->aSkeleton.size());
+            m_aTransforms.assign(m_asset->aBoneInfo.size(), XMMatrixIdentity());
+            updatePoseBoneBoxes();
+
+            // Play the first animation, as the model always did
+            m_currentPlayback = { 0u, 0.0f, 1.0f };
+        }
+
+        // The meshes are copied, so a model can pick other materials for them
+        m_aMeshes = m_asset->aMeshes;
+
+        hr = m_clusterCuller.Initialize(
+            m_asset->aClusters,
+            m_asset->aClusterBones,
+            static_cast<UINT>(m_asset->aMeshes.size() + m_asset->aLodMeshes.size()),
+            static_cast<UINT>(m_asset->aBoneInfo.size())
+        );
         if (FAILED(hr))
             return hr;
 
+        m_bIsLoaded = TRUE;
+
+        QueryPerformanceCounter(&endingTime);
+        if (Statistics::IsLogging())
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Model %s: %s in %.2f ms, %zu vertices, %zu %u-bit indices, %zu clips, %ld models share the asset\n",
+                m_filePath.filename().string().c_str(),
+                bShared ? "shared" : bLoadedFromCache ? "read from the mesh cache" : "imported",
+                static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart)),
+                m_asset->aVertices.size(),
+                m_asset->aIndices.size(),
+                m_asset->indexFormat == DXGI_FORMAT_R32_UINT ? 32u : 16u,
+                m_asset->aAnimationClips.size(),
+                m_asset.use_count()
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+
         return hr;
     }
 
@@ -170,38 +428,100 @@ namespace library
       Summary:  Update bone transformations
       Args:     FLOAT deltaTime
                   Time difference of a frame
-      Modifies: [m_aTransforms].
+      Modifies: [m_currentPlayback, m_previousPlayback, m_fadeTime,
+                 m_aAdditiveLayers, m_pose, m_blendPose, m_referencePose,
+                 m_aGlobalTransforms, m_aTransforms, m_aPoseBoneBoxes].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     void Model::Update(_In_ FLOAT deltaTime)
     {
-        // Update m_timeSinceLoaded by adding delta time
-        m_timeSinceLoaded += deltaTime;
-
-        // If m_pScene has animations
-        if (m_pScene->HasAnimations())
+        // If the model plays an animation
+        if (m_currentPlayback.uClipIndex != INVALID_INDEX)
         {
-            // Calculate the current animation time to play, using ticks per second and duration of animation
-            XMMATRIX identity = XMMatrixIdentity();
-            FLOAT ticksPerSecond = static_cast<FLOAT>(m_pScene->mAnimations[0]->mTicksPerSecond != 0.0 ? m_pScene->mAnimations[0]->mTicksPerSecond : 25.0f);
-            FLOAT timeInTicks = m_timeSinceLoaded * ticksPerSecond;
-            FLOAT animationTimeTicks = fmod(timeInTicks, static_cast<FLOAT>(m_pScene->mAnimations[0]->mDuration));
+            // Base layer, crossfaded from the previous clip
+            advancePlayback(m_currentPlayback, deltaTime);
+            sampleClip(m_currentPlayback.uClipIndex, m_currentPlayback.time, m_pose);
 
-            // If root node of m_pScene is valid
-            if (m_pScene->mRootNode != NULL)
+            if (m_previousPlayback.uClipIndex != INVALID_INDEX)
             {
-                // Calculate the bone transform matrices
-                readNodeHierarchy(animationTimeTicks, m_pScene->mRootNode, identity);
-
-                // Resize m_aTransforms same as m_aBoneInfo
-                m_aTransforms.resize(m_aBoneInfo.size());
-
-                // Store each final transformations in the bone information to the m_aTransforms
-                for (UINT i = 0; i < m_aBoneInfo.size(); ++i)
+                m_fadeTime += deltaTime;
+                if (m_fadeTime >= m_fadeDuration)
+                {
+                    m_previousPlayback.uClipIndex = INVALID_INDEX;
+                }
+                else
                 {
-                    m_aTransforms[i] = m_aBoneInfo[i].FinalTransformation;
+                    advancePlayback(m_previousPlayback, deltaTime);
+                    sampleClip(m_previousPlayback.uClipIndex, m_previousPlayback.time, m_blendPose);
+                    blendPoses(m_pose, m_blendPose, 1.0f - m_fadeTime / m_fadeDuration);
                 }
             }
+
+            // Additive layers add their motion relative to the first pose of their clip
+            for (AnimationPlayback& layer : m_aAdditiveLayers)
+            {
+                advancePlayback(layer, deltaTime);
+                sampleClip(layer.uClipIndex, 0.0f, m_referencePose);
+                sampleClip(layer.uClipIndex, layer.time, m_blendPose);
+                addPose(m_pose, m_blendPose, m_referencePose, layer.weight);
+            }
+
+            composeBoneTransforms(m_pose, m_aTransforms);
+            updatePoseBoneBoxes();
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::BenchmarkUpdate
+      Summary:  Plays the animation for uNumUpdates steps of 60 Hz and
+                logs the average time of an update
+      Args:     PCSTR pszName
+                  Name of the model in the log
+                UINT uNumUpdates
+                  Number of updates timed
+      Modifies: [m_currentPlayback, m_previousPlayback, m_fadeTime,
+                 m_aAdditiveLayers, m_pose, m_blendPose, m_referencePose,
+                 m_aGlobalTransforms, m_aTransforms, m_aPoseBoneBoxes].
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::BenchmarkUpdate(_In_ PCSTR pszName, _In_ UINT uNumUpdates)
+    {
+        if (m_currentPlayback.uClipIndex == INVALID_INDEX)
+        {
+            return E_FAIL;
+        }
+
+        LARGE_INTEGER startingTime;
+        LARGE_INTEGER endingTime;
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        uNumUpdates = std::max(uNumUpdates, 1u);
+        for (UINT i = 0u; i < uNumUpdates; ++i)
+        {
+            Update(1.0f / 60.0f);
         }
+
+        QueryPerformanceCounter(&endingTime);
+        DOUBLE updateTime = static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000000.0 / static_cast<DOUBLE>(frequency.QuadPart);
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "Model update %s: %.2f us per update over %u updates, %zu nodes, %zu additive layers, pose cache %u hits %u misses\n",
+            pszName,
+            updateTime / static_cast<DOUBLE>(uNumUpdates),
+            uNumUpdates,
+            m_asset->aSkeleton.size(),
+            m_aAdditiveLayers.size(),
+            sm_poseCache.GetNumHits(),
+            sm_poseCache.GetNumMisses()
+        );
+        OutputDebugStringA(szDebugMessage);
+
+        return S_OK;
     }
 
 
@@ -227,6 +547,72 @@ namespace library
     }
 
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::UploadBonePalette
+      Summary:  Writes the bone transforms of the frame into the bone
+                palette as three rows each, the fourth row of an
+                affine transform being implicit
+      Args:     ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to map the palette
+      Modifies: [m_bonePaletteBuffer].
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::UploadBonePalette(_In_ ID3D11DeviceContext* pImmediateContext)
+    {
+        // A model without animation keeps the palette it was created with
+        if (m_aTransforms.empty() || !m_bonePaletteBuffer)
+        {
+            return S_OK;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mappedPalette = {};
+        HRESULT hr = pImmediateContext->Map(m_bonePaletteBuffer.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mappedPalette);
+        if (FAILED(hr))
+            return hr;
+
+        // Mapped buffers are 16-byte aligned, so the rows are stored with aligned stores
+        packBonePalette(m_aTransforms.data(), static_cast<UINT>(m_aTransforms.size()), static_cast<XMFLOAT4A*>(mappedPalette.pData));
+
+        pImmediateContext->Unmap(m_bonePaletteBuffer.Get(), 0u);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetBonePaletteView
+      Summary:  Returns the shader resource view of the bone palette
+      Returns:  ComPtr<ID3D11ShaderResourceView>&
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11ShaderResourceView>& Model::GetBonePaletteView()
+    {
+        return m_bonePaletteView;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetBindPoseVertices
+      Summary:  Returns the vertices of the model before skinning
+      Returns:  const std::vector<SimpleVertex>&
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<SimpleVertex>& Model::GetBindPoseVertices() const
+    {
+        return m_asset->aVertices;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetAnimationData
+      Summary:  Returns the packed bone influences, one per vertex
+      Returns:  const std::vector<AnimationData>&
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<AnimationData>& Model::GetAnimationData() const
+    {
+        return m_asset->aAnimationData;
+    }
+
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Model::GetNumVertices
 
@@ -237,655 +623,1817 @@ namespace library
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     UINT Model::GetNumVertices() const
     {
-        return static_cast<UINT>(m_aVertices.size());
+        return static_cast<UINT>(m_asset->aVertices.size());
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Model::GetNumIndices
 
-      Summary:  Returns the number of indices
+      Summary:  Returns the number of indices of the meshes, without
+                the levels of detail after them
 
       Returns:  UINT
                   Number of indices
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     UINT Model::GetNumIndices() const
     {
-        return static_cast<UINT>(m_aIndices.size());
+        return m_asset->uNumMeshIndices;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-       Method:   Model::GetBoneTransforms
-       Summary:  Returns the vector containing bone transforms
-       Returns:  std::vector<XMMATRIX>&
-     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    std::vector<XMMATRIX>& Model::GetBoneTransforms()
+      Method:   Model::GetIndexFormat
+
+      Summary:  Returns the format of the index buffer, chosen when the
+                model is loaded
+
+      Returns:  DXGI_FORMAT
+                  DXGI_FORMAT_R32_UINT when a mesh has more vertices
+                  than WORD indices reach, DXGI_FORMAT_R16_UINT
+                  otherwise
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    DXGI_FORMAT Model::GetIndexFormat() const
     {
-        return m_aTransforms;
+        return m_asset->indexFormat;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::GetBoneNameToIndexMap
-        Summary:  Returns the bone name to index map
-        Returns:  std::unordered_map<std::string, UINT>&
-     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    const std::unordered_map<std::string, UINT>& Model::GetBoneNameToIndexMap() const
+      Method:   Model::GetNumLods
+
+      Summary:  Returns the number of levels of detail, counting the
+                meshes themselves as level 0
+
+      Returns:  UINT
+                  NUM_LODS, or 1 when the model has no simplified
+                  levels
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Model::GetNumLods() const
     {
-        return m_boneNameToIndexMap;
+        return m_asset->aLodMeshes.empty() ? 1u : NUM_LODS;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::countVerticesAndIndices
+      Method:   Model::GetLodMesh
 
-      Summary:  Fill the BasicMeshEntry information
+      Summary:  Returns the index range of a mesh at a level of detail.
+                A level the simplifier could not reduce has the range
+                of the level before it
 
-      Args:     UINT& uOutNumVertices
-                  Total number of vertices
-                UINT& uOutNumIndices
-                  Total number of indices
-                const aiScene* pScene
-                  Pointer to an assimp scene object that contains the
-                  mesh information
+      Args:     UINT uMeshIndex
+                  Index of the mesh
+                UINT uLod
+                  Level of detail, 0 for the mesh itself
+
+      Returns:  const BasicMeshEntry&
+                  Index range, base vertex and material of the level
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::countVerticesAndIndices(
-        _Inout_ UINT& uOutNumVertices,
-        _Inout_ UINT& uOutNumIndices,
-        _In_ const aiScene* pScene)
+    const Renderable::BasicMeshEntry& Model::GetLodMesh(_In_ UINT uMeshIndex, _In_ UINT uLod) const
     {
-        // Based on the scene's meshes, load the information per mesh
-        for (UINT i = 0u; i < m_aMeshes.size(); ++i)
+        if (uLod == 0u || uLod >= GetNumLods())
         {
-            // Material Index
-            m_aMeshes[i].uMaterialIndex = pScene->mMeshes[i]->mMaterialIndex;
-            // Number of indices
-            m_aMeshes[i].uNumIndices = pScene->mMeshes[i]->mNumFaces * 3u;
-            // Base Vertex
-            m_aMeshes[i].uBaseVertex = uOutNumVertices;
-            // Base Index
-            m_aMeshes[i].uBaseIndex = uOutNumIndices;
-
-            // Count the total number of vertices and indices
-            uOutNumVertices += pScene->mMeshes[i]->mNumVertices;
-            uOutNumIndices += m_aMeshes[i].uNumIndices;
+            return m_aMeshes[uMeshIndex];
         }
+
+        return m_asset->aLodMeshes[uMeshIndex * (NUM_LODS - 1u) + uLod - 1u];
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::findNodeAnimOrNull
-        Summary:  Find the aiNodeAnim with the givne node name in the given animation
-        Args:     const aiAnimation* pAnimation
-                    Pointer to an assimp animation object
-                  PCSTR pszNodeName
-                    Node name to find
+      Method:   Model::SelectLod
 
-        Returns:  aiNodeAnim* or nullptr
-     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    const aiNodeAnim* Model::findNodeAnimOrNull(_In_ const aiAnimation* pAnimation, _In_ PCSTR pszNodeName)
+      Summary:  Picks the level of detail from the size of the model on
+                screen, the radius of its world box over its distance
+                to the eye. Every LOD_SCREEN_SIZES threshold the size
+                falls below is one level coarser
+
+      Args:     const XMFLOAT3& worldMin
+                  Lower corner of the world box of the model
+                const XMFLOAT3& worldMax
+                  Upper corner of the world box of the model
+                FXMVECTOR eyePosition
+                  Position of the camera
+
+      Returns:  UINT
+                  Level of detail to draw
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Model::SelectLod(_In_ const XMFLOAT3& worldMin, _In_ const XMFLOAT3& worldMax, _In_ FXMVECTOR eyePosition) const
     {
-        for (UINT i = 0u; i < pAnimation->mNumChannels; ++i)
+        const UINT uNumLods = GetNumLods();
+        if (uNumLods == 1u)
         {
-            const aiNodeAnim* pNodeAnim = pAnimation->mChannels[i];
+            return 0u;
+        }
 
-            if (strncmp(pNodeAnim->mNodeName.data, pszNodeName, pNodeAnim->mNodeName.length) == 0)
-            {
-                return pNodeAnim;
-            }
+        XMVECTOR lower = XMLoadFloat3(&worldMin);
+        XMVECTOR upper = XMLoadFloat3(&worldMax);
+        FLOAT radius = XMVectorGetX(XMVector3Length(upper - lower)) * 0.5f;
+        FLOAT distance = XMVectorGetX(XMVector3Length((lower + upper) * 0.5f - eyePosition));
+        if (distance <= radius)
+        {
+            return 0u;
         }
 
-        return nullptr;
+        const FLOAT screenSize = radius / distance;
+        UINT uLod = 0u;
+        while (uLod + 1u < uNumLods && screenSize < LOD_SCREEN_SIZES[uLod])
+        {
+            ++uLod;
+        }
+
+        return uLod;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::findPosition
-        Summary:  Find the index of the position key right before the given animation time
-        Args:     FLOAT animationTimeTicks
-                    Animation time
-                  const aiNodeAnim* pNodeAnim
-                     Pointer to an assimp node anim object
-        Returns:  UINT
-                    Index of the key
-     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    UINT Model::findPosition(_In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim)
+      Method:   Model::CullClusters
+
+      Summary:  Culls the clusters of a mesh at a level of detail
+                against the frustum and the eye, in the space of the
+                model, and appends the index ranges to draw. The
+                clusters of an animated model are bounded by the boxes
+                of their bones in the current pose. A mesh without
+                clusters gets its whole range
+
+      Args:     UINT uMeshIndex
+                  Index of the mesh
+                UINT uLod
+                  Level of detail, 0 for the mesh itself
+                const XMMATRIX& viewProjection
+                  View matrix times projection matrix of the camera
+                FXMVECTOR eyePosition
+                  Position of the camera
+                std::vector<ClusterCuller::IndexRange>& aOutRanges
+                  Ranges to draw, with the base vertex of the mesh,
+                  are appended here
+
+      Modifies: [m_clusterCuller].
+
+      Returns:  UINT
+                  Number of triangles culled
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Model::CullClusters(
+        _In_ UINT uMeshIndex,
+        _In_ UINT uLod,
+        _In_ const XMMATRIX& viewProjection,
+        _In_ FXMVECTOR eyePosition,
+        _Inout_ std::vector<ClusterCuller::IndexRange>& aOutRanges
+    )
     {
-        assert(pNodeAnim->mNumPositionKeys > 0);
+        // Level l of mesh m is culled as the clusters after those of the meshes, in the order of the levels
+        const UINT uClusterMeshIndex = uLod == 0u || uLod >= GetNumLods()
+            ? uMeshIndex
+            : static_cast<UINT>(m_asset->aMeshes.size()) + uMeshIndex * (NUM_LODS - 1u) + uLod - 1u;
 
-        for (UINT i = 0; i < pNodeAnim->mNumPositionKeys - 1; ++i)
+        const BasicMeshEntry& mesh = GetLodMesh(uMeshIndex, uLod);
+        if (!m_clusterCuller.HasClusters(uClusterMeshIndex) || (!m_asset->aAnimationClips.empty() && m_aPoseBoneBoxes.empty()))
         {
-            FLOAT t = static_cast<FLOAT>(pNodeAnim->mPositionKeys[i + 1].mTime);
+            aOutRanges.push_back({ mesh.uBaseIndex, mesh.uNumIndices });
+            return 0u;
+        }
 
-            if (animationTimeTicks < t)
-            {
-                return i;
-            }
+        const XMMATRIX& world = GetWorldMatrix();
+        if (!m_asset->aAnimationClips.empty())
+        {
+            return m_clusterCuller.CullPose(uClusterMeshIndex, world * viewProjection, m_aPoseBoneBoxes, aOutRanges);
         }
 
-        return 0u;
+        XMVECTOR det = XMMatrixDeterminant(world);
+        const XMVECTOR localEyePosition = XMVector3Transform(eyePosition, XMMatrixInverse(&det, world));
+
+        return m_clusterCuller.Cull(uClusterMeshIndex, world * viewProjection, localEyePosition, aOutRanges);
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::findRotation
-        Summary:  Find the index of the rotation key right before the given animation time
-        Args:     FLOAT animationTimeTicks
-                    Animation time
-                  const aiNodeAnim* pNodeAnim
-                     Pointer to an assimp node anim object
-        Returns:  UINT
-                    Index of the key
-     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    UINT Model::findRotation(_In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim)
-    {
-        assert(pNodeAnim->mNumRotationKeys > 0);
-
-        for (UINT i = 0u; i < pNodeAnim->mNumRotationKeys - 1; ++i)
-        {
-            FLOAT t = static_cast<FLOAT>(pNodeAnim->mRotationKeys[i + 1].mTime);
+      Method:   Model::GetClusterCuller
 
-            if (animationTimeTicks < t)
-            {
-                return i;
-            }
-        }
+      Summary:  Returns the cluster culler of the model
 
-        return 0u;
+      Returns:  ClusterCuller&
+                  Cluster culler, with the statistics of its culls
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ClusterCuller& Model::GetClusterCuller()
+    {
+        return m_clusterCuller;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::findScaling
-        Summary:  Find the index of the scaling key right before the given animation time
-        Args:     FLOAT animationTimeTicks
-                    Animation time
-                  const aiNodeAnim* pNodeAnim
-                     Pointer to an assimp node anim object
-        Returns:  UINT
-                    Index of the key
-     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    UINT Model::findScaling(_In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim)
-    {
-        assert(pNodeAnim->mNumScalingKeys > 0);
+      Method:   Model::RefitRayBvh
 
-        for (UINT i = 0u; i < pNodeAnim->mNumScalingKeys - 1; ++i)
+      Summary:  Refits the triangle BVH to the vertices of a pose, such
+                as the ones CpuSkinning writes, so rays hit the model as
+                it is drawn. The BVH of the mesh asset stays in the
+                bind pose for the other models, so the first refit
+                copies it for this model
+
+      Args:     const std::vector<XMFLOAT3>& aPosedPositions
+                  Posed position of every vertex
+
+      Modifies: [m_posedRayBvh].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if the number of positions
+                  is not the number of vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::RefitRayBvh(_In_ const std::vector<XMFLOAT3>& aPosedPositions)
+    {
+        if (!m_posedRayBvh)
         {
-            FLOAT t = static_cast<FLOAT>(pNodeAnim->mScalingKeys[i + 1].mTime);
+            std::vector<TriangleBvh::Node> aNodes = m_asset->rayBvh.GetNodes();
+            std::vector<TriangleBvh::Triangle> aTriangles = m_asset->rayBvh.GetTriangles();
+            std::vector<TriangleBvh::MeshRoot> aMeshRoots = m_asset->rayBvh.GetMeshRoots();
 
-            if (animationTimeTicks < t)
-            {
-                return i;
-            }
+            std::unique_ptr<TriangleBvh> posedRayBvh = std::make_unique<TriangleBvh>();
+            HRESULT hr = posedRayBvh->Restore(m_asset->aVertices.data(), static_cast<UINT>(m_asset->aVertices.size()), aNodes, aTriangles, aMeshRoots);
+            if (FAILED(hr))
+                return hr;
+
+            m_posedRayBvh = std::move(posedRayBvh);
         }
 
-        return 0u;
+        return m_posedRayBvh->Refit(aPosedPositions.data(), static_cast<UINT>(aPosedPositions.size()));
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::getBoneId
-        Summary:  Find the the index of the bone
-        Args:      const aiBone* pBone
-                     Pointer to an assimp bone object
-        Modifies: [m_boneNameToIndexMap].
-        Returns:  UINT
-                    Index of the bone
-     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    UINT Model::getBoneId(_In_ const aiBone* pBone)
+      Method:   Model::GetRayBvh
+
+      Summary:  Returns the triangle BVH of the model, its own posed
+                copy once RefitRayBvh ran and the one of the mesh asset
+                before
+
+      Returns:  const TriangleBvh&
+                  Triangle BVH
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const TriangleBvh& Model::GetRayBvh() const
     {
-        UINT uBoneIndex = 0u;
-        PCSTR pszBoneName = pBone->mName.C_Str();
-        if (!m_boneNameToIndexMap.contains(pszBoneName))
+        if (m_posedRayBvh)
         {
-            uBoneIndex = static_cast<UINT>(m_boneNameToIndexMap.size());
-            m_boneNameToIndexMap[pszBoneName] = uBoneIndex;
-        }
-        else
-        {
-            uBoneIndex = m_boneNameToIndexMap[pszBoneName];
+            return *m_posedRayBvh;
         }
 
-        return uBoneIndex;
+        return m_asset->rayBvh;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::getVertices
+      Method:   Model::SetVertexCompression
 
-      Summary:  Returns the vertices data
+      Summary:  Chooses between the float and the compressed vertex
+                buffers. The layout of the buffers is fixed once they
+                are created, and a QuantizedVertexShader must be set
+                on a compressed model
 
-      Returns:  const SimpleVertex*
-                  Array of vertices
+      Args:     BOOL bCompressVertices
+                  Whether the vertex buffers are compressed
+
+      Modifies: [m_bCompressVertices].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL after Initialize
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    const SimpleVertex* Model::getVertices() const
+    HRESULT Model::SetVertexCompression(_In_ BOOL bCompressVertices)
     {
-        return m_aVertices.data();
+        if (m_vertexBuffer != nullptr)
+        {
+            return E_FAIL;
+        }
+
+        m_bCompressVertices = bCompressVertices;
+
+        return S_OK;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::getIndices
+      Method:   Model::IsVertexCompressed
 
-      Summary:  Returns the indices data
+      Summary:  Returns whether the vertex buffers hold QuantizedVertex
+                and QuantizedNormalData
 
-      Returns:  const WORD*
-                  Array of indices
+      Returns:  BOOL
+                  TRUE if the vertex buffers are compressed
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    const WORD* Model::getIndices() const
+    BOOL Model::IsVertexCompressed() const
     {
-        return m_aIndices.data();
+        return m_bCompressVertices;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::getIndices
+      Method:   Model::GetVertexStride
 
-      Summary:  Initialize all meshes in a given assimp scene
+      Summary:  Returns the size of a vertex in the vertex buffer
 
-      Args:     const aiScene* pScene
-                  Assimp scene
+      Returns:  UINT
+                  sizeof(QuantizedVertex) when compressed,
+                  sizeof(SimpleVertex) otherwise
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::initAllMeshes(_In_ const aiScene* pScene)
+    UINT Model::GetVertexStride() const
     {
-        // Initialize all meshes in the scene
-        for (UINT i = 0u; i < m_aMeshes.size(); ++i)
-        {
-            const aiMesh* pMesh = pScene->mMeshes[i];
-            initSingleMesh(i, pMesh);
-        }
+        return static_cast<UINT>(m_bCompressVertices ? sizeof(QuantizedVertex) : sizeof(SimpleVertex));
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::initFromScene
+      Method:   Model::GetNormalStride
 
-      Summary:  Initialize all meshes in a given assimp scene
-
-      Args:     ID3D11Device* pDevice
-                  The Direct3D device to create the buffers
-                ID3D11DeviceContext* pImmediateContext
-                  The Direct3D context to set buffers
-                const aiScene* pScene
-                  Assimp scene
-                const std::filesystem::path& filePath
-                  Path to the model
+      Summary:  Returns the size of a tangent frame in the normal
+                buffer
 
-      Returns:  HRESULT
-                  Status code
+      Returns:  UINT
+                  sizeof(QuantizedNormalData) when compressed,
+                  sizeof(NormalData) otherwise
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    HRESULT Model::initFromScene(
-        _In_ ID3D11Device* pDevice,
-        _In_ ID3D11DeviceContext* pImmediateContext,
-        _In_ const aiScene* pScene,
-        _In_ const std::filesystem::path& filePath
-    )
+    UINT Model::GetNormalStride() const
     {
-        // Based on the number of meshes and materials, resize the meshes vector and materials vector accordingly
-        m_aMeshes.resize(pScene->mNumMeshes);
-        // m_aMaterials.resize(pScene->mNumMaterials);
+        return static_cast<UINT>(m_bCompressVertices ? sizeof(QuantizedNormalData) : sizeof(NormalData));
+    }
 
-        UINT uNumVertices = 0u;
-        UINT uNumIndices = 0u;
-        HRESULT hr = S_OK;
 
-        // Load the mesh information to get the total number of vertices / indices(countVerticesAndIndices) 
-        countVerticesAndIndices(uNumVertices, uNumIndices, pScene);
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetPositionScale
 
-        // Reserve spaces for the verticesand indices data(reserveSpace)
-        reserveSpace(uNumVertices, uNumIndices);
+      Summary:  Returns the extent of the box of the model, the scale
+                of the UNORM16 positions of the compressed vertices
 
-        // Initialize the meshes(initAllMeshes)
-        initAllMeshes(pScene);
+      Returns:  const XMFLOAT4&
+                  Scale of the compressed positions
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const XMFLOAT4& Model::GetPositionScale() const
+    {
+        return m_positionScale;
+    }
 
-        // Initialize the materials(initMaterials)
-        hr = initMaterials(pDevice, pImmediateContext, pScene, filePath);
-        if (FAILED(hr))
-            return hr;
 
-        for (UINT i = 0; i < m_aBoneData.size(); ++i)
-        {
-            // Create AnimationData for the vertex and add it to m_aAnimationData
-            m_aAnimationData.push_back(
-                AnimationData
-                {
-                    .aBoneIndices = (XMUINT4)m_aBoneData[i].aBoneIds,
-                    .aBoneWeights = (XMFLOAT4)m_aBoneData[i].aWeights
-                }
-            );
-        }
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetPositionOffset
 
-        // Initialize the buffers(initialize)
-        hr = initialize(pDevice, pImmediateContext);
-        if (FAILED(hr))
-            return hr;
+      Summary:  Returns the minimum corner of the box of the model,
+                the offset of the positions of the compressed vertices
 
-        return hr;
+      Returns:  const XMFLOAT4&
+                  Offset of the compressed positions
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const XMFLOAT4& Model::GetPositionOffset() const
+    {
+        return m_positionOffset;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::initMaterials
+      Method:   Model::GetWorldBounds
 
-      Summary:  Initialize all materials in a given assimp scene
-
-      Args:     ID3D11Device* pDevice
-                  The Direct3D device to create the buffers
-                ID3D11DeviceContext* pImmediateContext
-                  The Direct3D context to set buffers
-                const aiScene* pScene
-                  Assimp scene
-                const std::filesystem::path& filePath
-                  Path to the model
+      Summary:  Returns the world box of the current pose. A skinned
+                vertex is a weighted average of its positions moved by
+                each of its bones, so it stays inside the union of the
+                bone boxes of the pose. Models without bone transforms
+                return the box of the bind pose
 
-      Returns:  HRESULT
-                  Status code
+      Args:     XMFLOAT3& outMin
+                XMFLOAT3& outMax
+                  Corners of the world box
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    HRESULT Model::initMaterials(
-        _In_ ID3D11Device* pDevice,
-        _In_ ID3D11DeviceContext* pImmediateContext,
-        _In_ const aiScene* pScene,
-        _In_ const std::filesystem::path& filePath
-    )
+    void Model::GetWorldBounds(_Out_ XMFLOAT3& outMin, _Out_ XMFLOAT3& outMax) const
     {
-        HRESULT hr = S_OK;
+        if (m_aPoseBoneBoxes.empty())
+        {
+            Renderable::GetWorldBounds(outMin, outMax);
+            return;
+        }
 
-        // Extract the directory part from the file name
-        std::filesystem::path parentDirectory = filePath.parent_path();
+        // Box of the pose in model space
+        XMVECTOR poseMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR poseMax = XMVectorReplicate(-FLT_MAX);
+        if (m_asset->bHasUnskinnedVertices)
+        {
+            poseMin = XMVectorZero();
+            poseMax = XMVectorZero();
+        }
 
-        // Initialize the materials
-        for (UINT i = 0u; i < pScene->mNumMaterials; ++i)
+        for (const ClusterCuller::BoneBox& boneBox : m_aPoseBoneBoxes)
         {
-            const aiMaterial* pMaterial = pScene->mMaterials[i];
+            if (boneBox.Min.x > boneBox.Max.x)
+            {
+                continue;
+            }
 
-            std::string szName = filePath.string() + std::to_string(i);
-            std::wstring pwszName(szName.length(), L' ');
-            std::copy(szName.begin(), szName.end(), pwszName.begin());
-            m_aMaterials.push_back(std::make_shared<Material>(pwszName));
+            poseMin = XMVectorMin(poseMin, XMLoadFloat3(&boneBox.Min));
+            poseMax = XMVectorMax(poseMax, XMLoadFloat3(&boneBox.Max));
+        }
 
-            loadTextures(pDevice, pImmediateContext, parentDirectory, pMaterial, i);
+        if (XMVectorGetX(poseMin) > XMVectorGetX(poseMax))
+        {
+            Renderable::GetWorldBounds(outMin, outMax);
+            return;
         }
 
-        return hr;
+        // Move the box of the pose to world space the same way
+        const XMMATRIX& world = GetWorldMatrix();
+        XMVECTOR center = XMVector3Transform((poseMin + poseMax) * 0.5f, world);
+        XMVECTOR halfExtents = (poseMax - poseMin) * 0.5f;
+        XMVECTOR extents = XMVectorAbs(world.r[0]) * XMVectorGetX(halfExtents)
+            + XMVectorAbs(world.r[1]) * XMVectorGetY(halfExtents)
+            + XMVectorAbs(world.r[2]) * XMVectorGetZ(halfExtents);
+        XMStoreFloat3(&outMin, center - extents);
+        XMStoreFloat3(&outMax, center + extents);
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::initMeshBones
-        Summary:  Initialize all bones in a given aiMesh
-        Args:     const aiScene* pScene
-                    Assimp scene
+      Method:   Model::PlayAnimation
+
+      Summary:  Plays the named clip from its start. With a fade
+                duration, the clip played so far keeps playing and
+                fades out over that time
+
+      Args:     PCSTR pszClipName
+                  Name of the clip
+                FLOAT fadeDuration
+                  Crossfade duration in seconds, 0 to switch at once
+
+      Modifies: [m_currentPlayback, m_previousPlayback, m_fadeTime,
+                 m_fadeDuration].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG for an unknown clip
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::initMeshBones(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh)
+    HRESULT Model::PlayAnimation(_In_ PCSTR pszClipName, _In_opt_ FLOAT fadeDuration)
     {
-        // For each bone of the given mesh
-        for (UINT i = 0; i < pMesh->mNumBones; ++i)
+        auto clip = m_asset->animationNameToIndexMap.find(pszClipName);
+        if (clip == m_asset->animationNameToIndexMap.end())
         {
-            // const aiBone* pBone = pMesh[uMeshIndex].mBones[i];
-            // Call initMeshSingleBone
-            initMeshSingleBone(uMeshIndex, pMesh->mBones[i]);
+            return E_INVALIDARG;
+        }
+
+        if (fadeDuration > 0.0f && m_currentPlayback.uClipIndex != INVALID_INDEX)
+        {
+            m_previousPlayback = m_currentPlayback;
+            m_fadeTime = 0.0f;
+            m_fadeDuration = fadeDuration;
+        }
+        else
+        {
+            m_previousPlayback.uClipIndex = INVALID_INDEX;
         }
+
+        m_currentPlayback = { clip->second, 0.0f, 1.0f };
+
+        return S_OK;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-        Method:   Model::initMeshSingleBone
-        Summary:  Initialize a single bone of the mesh
-        Args:     const aiScene* pScene
-                    Assimp scene
+      Method:   Model::AddAdditiveAnimation
+
+      Summary:  Layers the named clip on top of the played one. The
+                layer adds the difference between its current pose and
+                the first pose of its clip, scaled by the weight
+
+      Args:     PCSTR pszClipName
+                  Name of the clip
+                FLOAT weight
+                  Weight of the layer
+
+      Modifies: [m_aAdditiveLayers].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG for an unknown clip
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::initMeshSingleBone(_In_ UINT uMeshIndex, _In_ const aiBone* pBone)
+    HRESULT Model::AddAdditiveAnimation(_In_ PCSTR pszClipName, _In_ FLOAT weight)
     {
-        UINT uBoneId = getBoneId(pBone);
-
-        if (uBoneId == m_aBoneInfo.size())
+        auto clip = m_asset->animationNameToIndexMap.find(pszClipName);
+        if (clip == m_asset->animationNameToIndexMap.end())
         {
-            BoneInfo boneInfo(ConvertMatrix(pBone->mOffsetMatrix));
-            m_aBoneInfo.push_back(boneInfo);
+            return E_INVALIDARG;
         }
 
-        for (UINT i = 0u; i < pBone->mNumWeights; ++i)
-        {
-            const aiVertexWeight& vertexWeight = pBone->mWeights[i];
-            UINT uGlobalVertexId = m_aMeshes[uMeshIndex].uBaseVertex + vertexWeight.mVertexId;
-            m_aBoneData[uGlobalVertexId].AddBoneData(uBoneId, vertexWeight.mWeight);
-        }
+        m_aAdditiveLayers.push_back({ clip->second, 0.0f, weight });
+
+        return S_OK;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::initSingleMesh
+      Method:   Model::ClearAdditiveAnimations
 
-      Summary:  Initialize single mesh from a given assimp mesh
+      Summary:  Removes the additive layers
 
-      Args:     const aiMesh* pMesh
-                  Point to an assimp mesh object
+      Modifies: [m_aAdditiveLayers].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh)
+    void Model::ClearAdditiveAnimations()
     {
-        const aiVector3D zero3d(0.0f, 0.0f, 0.0f);
+        m_aAdditiveLayers.clear();
+    }
 
-        // Populate the vertex attribute vectors
-        for (UINT i = 0u; i < pMesh->mNumVertices; ++i) // For each vertex in the mesh
-        {
-            const aiVector3D& position = pMesh->mVertices[i];
-            const aiVector3D& normal = pMesh->mNormals[i];
-            const aiVector3D& texCoord = pMesh->HasTextureCoords(0u) ? pMesh->mTextureCoords[0][i] : zero3d;
 
-            m_aVertices.push_back(
-                SimpleVertex
-                {
-                    .Position = XMFLOAT3(position.x, position.y, position.z),
-                    .TexCoord = XMFLOAT2(texCoord.x, texCoord.y),
-                    .Normal = XMFLOAT3(normal.x, normal.y, normal.z)
-                }
-            );
-            
-            const aiVector3D& tangent = pMesh->HasTangentsAndBitangents() ? pMesh->mTangents[i] : zero3d;
-            const aiVector3D& bitangent = pMesh->HasTangentsAndBitangents() ? pMesh->mBitangents[i] : zero3d;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetAnimationNameToIndexMap
 
-            m_aNormalData.push_back(
-                NormalData
-                {
-                    .Tangent = XMFLOAT3(tangent.x, tangent.y, tangent.z),
-                    .Bitangent = XMFLOAT3(bitangent.x, bitangent.y, bitangent.z)
-                }
-            );
+      Summary:  Returns the clips of the model by name
 
-        }
+      Returns:  const std::unordered_map<std::string, UINT>&
+                  Clip indices by name
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::unordered_map<std::string, UINT>& Model::GetAnimationNameToIndexMap() const
+    {
+        return m_asset->animationNameToIndexMap;
+    }
 
-        // call initMeshBones
-        initMeshBones(uMeshIndex, pMesh);
 
-        // For each face in the mesh, Populate the index buffer
-        for (UINT i = 0u; i < pMesh->mNumFaces; ++i)
-        {
-            const aiFace& face = pMesh->mFaces[i];
-            assert(face.mNumIndices == 3u);
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetAnimationClips
 
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[0]));
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[1]));
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[2]));
-        }
+      Summary:  Returns the clips of the model
+
+      Returns:  const std::vector<std::shared_ptr<AnimationClip>>&
+                  Clips, in the order of their indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<std::shared_ptr<AnimationClip>>& Model::GetAnimationClips() const
+    {
+        return m_asset->aAnimationClips;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::interpolatePosition
-      Summary:  Interpolate two keyframes to find translate vector
-      Args:     XMFLOAT3& outTranslate
-                  Translate vector
-                FLOAT animationTimeTicks
-                  Animation time
-                const aiNodeAnim* pNodeAnim
-                  Pointer to an assimp node anim object
+      Method:   Model::EvaluateClip
+
+      Summary:  Computes the bone transforms of a clip at the given
+                time, sampling the clip directly rather than through
+                the pose cache. The playback of the model is left
+                untouched
+
+      Args:     UINT uClipIndex
+                  Index of the clip
+                FLOAT time
+                  Time in seconds
+                std::vector<XMMATRIX>& outBoneTransforms
+                  Bone transforms, as GetBoneTransforms returns them
+
+      Modifies: [m_referencePose, m_blendPose, m_aGlobalTransforms].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG for an unknown clip
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::interpolatePosition(_Inout_ XMFLOAT3& outTranslate, _In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim)
+    HRESULT Model::EvaluateClip(_In_ UINT uClipIndex, _In_ FLOAT time, _Out_ std::vector<XMMATRIX>& outBoneTransforms)
     {
-        if (pNodeAnim->mNumPositionKeys == 1)
+        if (uClipIndex >= m_asset->aAnimationClips.size())
         {
-            outTranslate = ConvertVector3dToFloat3(pNodeAnim->mPositionKeys[0].mValue);
-            return;
+            return E_INVALIDARG;
         }
 
-        UINT uPositionIndex = findPosition(animationTimeTicks, pNodeAnim);
-        UINT uNextPositionIndex = uPositionIndex + 1u;
-        assert(uNextPositionIndex < pNodeAnim->mNumPositionKeys);
+        m_asset->aAnimationClips[uClipIndex]->SamplePose(time, m_referencePose);
+        scatterPose(uClipIndex, m_referencePose, m_blendPose);
 
-        FLOAT t1 = static_cast<FLOAT>(pNodeAnim->mPositionKeys[uPositionIndex].mTime);
-        FLOAT t2 = static_cast<FLOAT>(pNodeAnim->mPositionKeys[uNextPositionIndex].mTime);
-        FLOAT deltaTime = t2 - t1;
-        FLOAT factor = (animationTimeTicks - t1) / deltaTime;
-        assert(factor >= 0.0f && factor <= 1.0f);
-        const aiVector3D& start = pNodeAnim->mPositionKeys[uPositionIndex].mValue;
-        const aiVector3D& end = pNodeAnim->mPositionKeys[uNextPositionIndex].mValue;
-        aiVector3D delta = end - start;
-        outTranslate = ConvertVector3dToFloat3(start + factor * delta);
+        outBoneTransforms.assign(m_asset->aBoneInfo.size(), XMMatrixIdentity());
+        composeBoneTransforms(m_blendPose, outBoneTransforms);
+
+        return S_OK;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::interpolateRotation
-      Summary:  Interpolate two keyframes to find rotation vector
-      Args:     XMVECTOR& outQuaternion
-                  Quaternion vector
-                FLOAT animationTimeTicks
-                  Animation time
-                const aiNodeAnim* pNodeAnim
-                  Pointer to an assimp node anim object
-    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::interpolateRotation(_Inout_ XMVECTOR& outQuaternion, _In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim)
+       Method:   Model::GetBoneTransforms
+       Summary:  Returns the vector containing bone transforms
+       Returns:  std::vector<XMMATRIX>&
+     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::vector<XMMATRIX>& Model::GetBoneTransforms()
     {
-        if (pNodeAnim->mNumRotationKeys == 1)
-        {
-            outQuaternion = ConvertQuaternionToVector(pNodeAnim->mRotationKeys[0].mValue);
-            return;
-        }
+        return m_aTransforms;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+        Method:   Model::GetBoneNameToIndexMap
+        Summary:  Returns the bone name to index map
+        Returns:  std::unordered_map<std::string, UINT>&
+     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::unordered_map<std::string, UINT>& Model::GetBoneNameToIndexMap() const
+    {
+        return m_asset->boneNameToIndexMap;
+    }
 
-        // This function finds rotation vector by interpolating the two keyframes
-        UINT uRotationIndex = findRotation(animationTimeTicks,pNodeAnim);
-        UINT uNextRotationIndex = uRotationIndex + 1u;
-        assert(uNextRotationIndex < pNodeAnim->mNumRotationKeys);
 
-        FLOAT t1 = static_cast<FLOAT>(pNodeAnim->mRotationKeys[uRotationIndex].mTime);
-        FLOAT t2 = static_cast<FLOAT>(pNodeAnim->mRotationKeys[uNextRotationIndex].mTime);
-        FLOAT deltaTime = t2 - t1;
-        FLOAT factor = (animationTimeTicks - t1) / deltaTime;
-        assert(factor >= 0.0f && factor <= 1.0f);
-        const aiQuaternion& start = pNodeAnim->mRotationKeys[uRotationIndex].mValue;
-        const aiQuaternion& end = pNodeAnim->mRotationKeys[uNextRotationIndex].mValue;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::GetPoseCache
+
+      Summary:  Returns the pose cache shared by all models
 
-        aiQuaternion ret;
-        aiQuaternion::Interpolate(ret, start, end, factor);
-        ret = start;
-        ret.Normalize();
-        outQuaternion = ConvertQuaternionToVector(ret);
+      Returns:  AnimationPoseCache&
+                  Pose cache
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AnimationPoseCache& Model::GetPoseCache()
+    {
+        return sm_poseCache;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::interpolateScaling
-      Summary:  Interpolate two keyframes to find rotation vector
-      Args:     XMFLOAT3& outScale
-                  Scaling vector
-                FLOAT animationTimeTicks
-                  Animation time
-                const aiNodeAnim* pNodeAnim
-                  Pointer to an assimp node anim object
+      Method:   Model::addPose
+
+      Summary:  Adds the motion of an additive pose relative to its
+                reference pose, scaled by the weight
+
+      Args:     AnimationPose& pose
+                  Pose to add to
+                const AnimationPose& additivePose
+                  Pose of the additive clip
+                const AnimationPose& referencePose
+                  First pose of the additive clip
+                FLOAT weight
+                  Weight of the layer
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::interpolateScaling(_Inout_ XMFLOAT3& outScale, _In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim)
+    void Model::addPose(_Inout_ AnimationPose& pose, _In_ const AnimationPose& additivePose, _In_ const AnimationPose& referencePose, _In_ FLOAT weight)
     {
-        if (pNodeAnim->mNumScalingKeys == 1)
+        const XMVECTOR identity = XMQuaternionIdentity();
+
+        for (SIZE_T i = 0u; i < pose.aRotations.size(); ++i)
         {
-            outScale = ConvertVector3dToFloat3(pNodeAnim->mScalingKeys[0].mValue);
-            return;
-        }
-        // This function finds scaling vector by interpolating the two keyframes
-        UINT uScalingIndex = findScaling(animationTimeTicks, pNodeAnim);
-        UINT uNextScalingIndex = uScalingIndex + 1u;
-        assert(uNextScalingIndex < pNodeAnim->mNumScalingKeys);
+            pose.aScalings[i] = XMVectorMultiplyAdd(additivePose.aScalings[i] - referencePose.aScalings[i], XMVectorReplicate(weight), pose.aScalings[i]);
+            pose.aTranslations[i] = XMVectorMultiplyAdd(additivePose.aTranslations[i] - referencePose.aTranslations[i], XMVectorReplicate(weight), pose.aTranslations[i]);
+
+            // Rotation from the reference to the additive pose, scaled toward identity along the shorter arc
+            XMVECTOR delta = XMQuaternionMultiply(XMQuaternionConjugate(referencePose.aRotations[i]), additivePose.aRotations[i]);
+            delta = XMVectorSelect(delta, XMVectorNegate(delta), XMVectorLess(XMVector4Dot(delta, identity), XMVectorZero()));
+            delta = XMQuaternionNormalize(XMVectorLerp(identity, delta, weight));
 
-        FLOAT t1 = static_cast<FLOAT>(pNodeAnim->mScalingKeys[uScalingIndex].mTime);
-        FLOAT t2 = static_cast<FLOAT>(pNodeAnim->mScalingKeys[uNextScalingIndex].mTime);
-        FLOAT deltaTime = t2 - t1;
-        FLOAT factor = (animationTimeTicks - t1) / deltaTime;
-        assert(factor >= 0.0f && factor <= 1.0f);
-        const aiVector3D& start = pNodeAnim->mScalingKeys[uScalingIndex].mValue;
-        const aiVector3D& end = pNodeAnim->mScalingKeys[uNextScalingIndex].mValue;
-        aiVector3D delta = end - start;
-        outScale = ConvertVector3dToFloat3(start + factor * delta);
+            pose.aRotations[i] = XMQuaternionMultiply(pose.aRotations[i], delta);
+        }
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::loadDiffuseTexture
+      Method:   Model::advancePlayback
 
-      Summary:  Load a diffuse texture from given path
+      Summary:  Advances the time of a layer, looping over its clip
 
-      Args:     ID3D11Device* pDevice
+      Args:     AnimationPlayback& playback
+                  Layer to advance
+                FLOAT deltaTime
+                  Time difference of a frame
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::advancePlayback(_Inout_ AnimationPlayback& playback, _In_ FLOAT deltaTime)
+    {
+        FLOAT duration = m_asset->aAnimationClips[playback.uClipIndex]->GetDuration();
+        playback.time = duration > 0.0f ? fmod(playback.time + deltaTime, duration) : 0.0f;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::blendPoses
+
+      Summary:  Moves a pose toward another one. Scalings and
+                translations are interpolated linearly, rotations
+                along the shorter arc and renormalized
+
+      Args:     AnimationPose& pose
+                  Pose to blend into
+                const AnimationPose& otherPose
+                  Pose to blend toward
+                FLOAT weight
+                  0 keeps the pose, 1 takes the other pose
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::blendPoses(_Inout_ AnimationPose& pose, _In_ const AnimationPose& otherPose, _In_ FLOAT weight)
+    {
+        for (SIZE_T i = 0u; i < pose.aRotations.size(); ++i)
+        {
+            pose.aScalings[i] = XMVectorLerp(pose.aScalings[i], otherPose.aScalings[i], weight);
+            pose.aTranslations[i] = XMVectorLerp(pose.aTranslations[i], otherPose.aTranslations[i], weight);
+
+            XMVECTOR rotation = otherPose.aRotations[i];
+            rotation = XMVectorSelect(rotation, XMVectorNegate(rotation), XMVectorLess(XMVector4Dot(pose.aRotations[i], rotation), XMVectorZero()));
+            pose.aRotations[i] = XMQuaternionNormalize(XMVectorLerp(pose.aRotations[i], rotation, weight));
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::buildClusters
+
+      Summary:  Splits the triangles of every mesh, then of every
+                level of detail, into clusters with the cluster
+                culler. The clusters of a skinned model keep the bones
+                of their vertices
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the model
+
+      Modifies: [m_asset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::buildClusters(_In_ const std::filesystem::path& filePath)
+    {
+        m_asset->aClusters.clear();
+        m_asset->aClusterBones.clear();
+
+        const UINT uNumMeshes = static_cast<UINT>(m_asset->aMeshes.size());
+        const BOOL bIsSkinned = !m_asset->aBoneInfo.empty() && m_asset->aAnimationData.size() == m_asset->aVertices.size();
+
+        UINT uNumTriangles = 0u;
+        for (UINT uClusterMesh = 0u; uClusterMesh < uNumMeshes + m_asset->aLodMeshes.size(); ++uClusterMesh)
+        {
+            // A level of detail indexes the vertices of its mesh
+            const UINT uMesh = uClusterMesh < uNumMeshes ? uClusterMesh : (uClusterMesh - uNumMeshes) / (NUM_LODS - 1u);
+            const BasicMeshEntry& mesh = uClusterMesh < uNumMeshes ? m_asset->aMeshes[uMesh] : m_asset->aLodMeshes[uClusterMesh - uNumMeshes];
+            uNumTriangles += mesh.uNumIndices / 3u;
+            const UINT uNumVertices = (uMesh + 1u < uNumMeshes ? m_asset->aMeshes[uMesh + 1u].uBaseVertex : static_cast<UINT>(m_asset->aVertices.size())) - mesh.uBaseVertex;
+
+            HRESULT hr = ClusterCuller::Build(
+                m_asset->aVertices.data() + mesh.uBaseVertex,
+                bIsSkinned ? m_asset->aAnimationData.data() + mesh.uBaseVertex : nullptr,
+                uNumVertices,
+                m_asset->aIndices.data() + mesh.uBaseIndex,
+                mesh.uNumIndices,
+                mesh.uBaseIndex,
+                uClusterMesh,
+                m_asset->aClusters,
+                m_asset->aClusterBones
+            );
+            if (FAILED(hr))
+                return hr;
+        }
+
+        const SIZE_T uNumClusters = std::count_if(m_asset->aClusters.begin(), m_asset->aClusters.end(), [](const ClusterCuller::MeshCluster& cluster) { return cluster.uNumIndices > 0u; });
+
+        if (Statistics::IsLogging())
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Model %s: %u triangles split into %zu clusters\n",
+                filePath.filename().string().c_str(),
+                uNumTriangles,
+                uNumClusters
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::buildLods
+
+      Summary:  Simplifies every mesh into NUM_LODS - 1 levels of
+                detail, each from the level before it with
+                LOD_TRIANGLE_RATIO of its triangles and twice its error
+                bound. Meshes are simplified in parallel, one job per
+                mesh, and the levels are appended after the indices of
+                every mesh in mesh order. A mesh under
+                LOD_MIN_NUM_TRIANGLES, or a level that barely reduces,
+                ends the chain and the coarser levels repeat the last
+                range
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the model
+
+      Modifies: [m_asset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::buildLods(_In_ const std::filesystem::path& filePath)
+    {
+        m_asset->aLodMeshes.clear();
+        if (m_asset->aMeshes.empty())
+        {
+            return S_OK;
+        }
+
+        LARGE_INTEGER startingTime;
+        LARGE_INTEGER endingTime;
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        const UINT uNumMeshes = static_cast<UINT>(m_asset->aMeshes.size());
+        const UINT uNumLevels = NUM_LODS - 1u;
+        const UINT uNumThreads = GetNumParallelThreads(uNumMeshes);
+
+        // Jobs only read the meshes and write their own levels, the index buffer grows once they are done
+        std::vector<std::vector<UINT>> aLodIndices(uNumMeshes * uNumLevels);
+        std::vector<HRESULT> aResults(uNumMeshes, S_OK);
+        std::vector<MeshSimplifier> aSimplifiers(uNumThreads);
+        ParallelFor(uNumMeshes, uNumThreads,
+            [&](UINT uJob, UINT uThread)
+            {
+                MeshSimplifier& simplifier = aSimplifiers[uThread];
+
+                const BasicMeshEntry& mesh = m_asset->aMeshes[uJob];
+                const UINT uNumVertices = (uJob + 1u < uNumMeshes ? m_asset->aMeshes[uJob + 1u].uBaseVertex : static_cast<UINT>(m_asset->aVertices.size())) - mesh.uBaseVertex;
+
+                const UINT* pIndices = m_asset->aIndices.data() + mesh.uBaseIndex;
+                UINT uNumIndices = mesh.uNumIndices;
+                FLOAT maxError = LOD_MAX_ERROR;
+                for (UINT uLevel = 0u; uLevel < uNumLevels && uNumIndices / 3u >= LOD_MIN_NUM_TRIANGLES; ++uLevel)
+                {
+                    std::vector<UINT>& aIndices = aLodIndices[uJob * uNumLevels + uLevel];
+                    aResults[uJob] = simplifier.Simplify(
+                        m_asset->aVertices.data() + mesh.uBaseVertex,
+                        m_asset->aAnimationData.data() + mesh.uBaseVertex,
+                        uNumVertices,
+                        pIndices,
+                        uNumIndices,
+                        static_cast<UINT>(static_cast<FLOAT>(uNumIndices / 3u) * LOD_TRIANGLE_RATIO) * 3u,
+                        maxError,
+                        aIndices
+                    );
+                    if (FAILED(aResults[uJob]))
+                    {
+                        break;
+                    }
+
+                    // A level that keeps most of the triangles costs index memory and draws no faster
+                    if (aIndices.size() * 8u > static_cast<SIZE_T>(uNumIndices) * 7u)
+                    {
+                        aIndices.clear();
+                        break;
+                    }
+
+                    pIndices = aIndices.data();
+                    uNumIndices = static_cast<UINT>(aIndices.size());
+                    maxError *= 2.0f;
+                }
+            }
+        );
+
+        for (HRESULT hr : aResults)
+        {
+            if (FAILED(hr))
+                return hr;
+        }
+
+        UINT uNumMeshTriangles = 0u;
+        UINT uNumLodTriangles = 0u;
+        m_asset->aLodMeshes.reserve(uNumMeshes * uNumLevels);
+        for (UINT uMesh = 0u; uMesh < uNumMeshes; ++uMesh)
+        {
+            BasicMeshEntry lodMesh = m_asset->aMeshes[uMesh];
+            for (UINT uLevel = 0u; uLevel < uNumLevels; ++uLevel)
+            {
+                const std::vector<UINT>& aIndices = aLodIndices[uMesh * uNumLevels + uLevel];
+                if (!aIndices.empty())
+                {
+                    lodMesh.uBaseIndex = static_cast<UINT>(m_asset->aIndices.size());
+                    lodMesh.uNumIndices = static_cast<UINT>(aIndices.size());
+                    m_asset->aIndices.insert(m_asset->aIndices.end(), aIndices.begin(), aIndices.end());
+                }
+
+                m_asset->aLodMeshes.push_back(lodMesh);
+            }
+
+            uNumMeshTriangles += m_asset->aMeshes[uMesh].uNumIndices / 3u;
+            uNumLodTriangles += lodMesh.uNumIndices / 3u;
+        }
+
+        QueryPerformanceCounter(&endingTime);
+        if (Statistics::IsLogging())
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Model %s: %u levels of detail built in %.2f ms on %u threads, from %u down to %u triangles\n",
+                filePath.filename().string().c_str(),
+                NUM_LODS,
+                static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart)),
+                uNumThreads,
+                uNumMeshTriangles,
+                uNumLodTriangles
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::buildRayBvh
+
+      Summary:  Builds the triangle BVH of the meshes for ray casts.
+                Only the meshes are built, rays hit the full detail
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the model
+
+      Modifies: [m_asset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::buildRayBvh(_In_ const std::filesystem::path& filePath)
+    {
+        std::vector<TriangleBvh::MeshRange> aMeshRanges;
+        aMeshRanges.reserve(m_asset->aMeshes.size());
+        for (const BasicMeshEntry& mesh : m_asset->aMeshes)
+        {
+            aMeshRanges.push_back({ mesh.uBaseIndex, mesh.uNumIndices, mesh.uBaseVertex });
+        }
+
+        // The indices are packed to 16 bits only at the end of Load
+        HRESULT hr = m_asset->rayBvh.Build(m_asset->aVertices.data(), static_cast<UINT>(m_asset->aVertices.size()), m_asset->aIndices.data(), DXGI_FORMAT_R32_UINT, aMeshRanges);
+        if (FAILED(hr))
+            return hr;
+
+        if (Statistics::IsLogging())
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Model %s: ray BVH of %zu triangles in %zu nodes, %.1f KB, built in %.2f ms on %u threads\n",
+                filePath.filename().string().c_str(),
+                m_asset->rayBvh.GetTriangles().size(),
+                m_asset->rayBvh.GetNodes().size(),
+                static_cast<FLOAT>(m_asset->rayBvh.GetMemorySize()) / 1024.0f,
+                m_asset->rayBvh.GetBuildTime(),
+                m_asset->rayBvh.GetNumThreads()
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::clearMeshData
+
+      Summary:  Empties everything readCache fills, so a model whose
+                cache failed half way is imported from a clean state
+
+      Modifies: [m_asset].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::clearMeshData()
+    {
+        m_asset->aVertices.clear();
+        m_asset->aNormalData.clear();
+        m_asset->aAnimationData.clear();
+        m_asset->aIndices.clear();
+        m_asset->aMeshes.clear();
+        m_asset->aLodMeshes.clear();
+        m_asset->aClusters.clear();
+        m_asset->aClusterBones.clear();
+        m_asset->aMaterialTextures.clear();
+        m_asset->aBoneInfo.clear();
+        m_asset->boneNameToIndexMap.clear();
+        m_asset->aBoneBounds.clear();
+        m_asset->bHasUnskinnedVertices = FALSE;
+        m_asset->aSkeleton.clear();
+        m_asset->aNodeChannels.clear();
+        m_asset->bindPose = AnimationPose();
+        m_asset->aAnimationClips.clear();
+        m_asset->animationNameToIndexMap.clear();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::composeBoneTransforms
+
+      Summary:  Turns a pose into bone transforms. Parents come before
+                their children, so their global transforms are ready
+
+      Args:     const AnimationPose& pose
+                  Pose indexed by skeleton node
+                std::vector<XMMATRIX>& outTransforms
+                  Bone transforms
+
+      Modifies: [m_aGlobalTransforms].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::composeBoneTransforms(_In_ const AnimationPose& pose, _Inout_ std::vector<XMMATRIX>& outTransforms)
+    {
+        for (UINT i = 0u; i < m_asset->aSkeleton.size(); ++i)
+        {
+            const SkeletonNode& node = m_asset->aSkeleton[i];
+
+            // Scaling, then rotation, then translation
+            XMMATRIX localTransform = XMMatrixAffineTransformation(pose.aScalings[i], XMVectorZero(), pose.aRotations[i], pose.aTranslations[i]);
+
+            m_aGlobalTransforms[i] = node.uParentIndex == INVALID_INDEX ? localTransform : localTransform * m_aGlobalTransforms[node.uParentIndex];
+
+            if (node.uBoneIndex != INVALID_INDEX)
+            {
+                outTransforms[node.uBoneIndex] = node.OffsetMatrix * m_aGlobalTransforms[i] * m_asset->GlobalInverseTransform;
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::countVerticesAndIndices
+
+      Summary:  Fill the BasicMeshEntry information
+
+      Args:     UINT& uOutNumVertices
+                  Total number of vertices
+                UINT& uOutNumIndices
+                  Total number of indices
+                const aiScene* pScene
+                  Pointer to an assimp scene object that contains the
+                  mesh information
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::countVerticesAndIndices(
+        _Inout_ UINT& uOutNumVertices,
+        _Inout_ UINT& uOutNumIndices,
+        _In_ const aiScene* pScene)
+    {
+        // Based on the scene's meshes, load the information per mesh
+        for (UINT i = 0u; i < m_asset->aMeshes.size(); ++i)
+        {
+            // Material Index
+            m_asset->aMeshes[i].uMaterialIndex = pScene->mMeshes[i]->mMaterialIndex;
+            // Number of indices
+            m_asset->aMeshes[i].uNumIndices = pScene->mMeshes[i]->mNumFaces * 3u;
+            // Base Vertex
+            m_asset->aMeshes[i].uBaseVertex = uOutNumVertices;
+            // Base Index
+            m_asset->aMeshes[i].uBaseIndex = uOutNumIndices;
+
+            // Count the total number of vertices and indices
+            uOutNumVertices += pScene->mMeshes[i]->mNumVertices;
+            uOutNumIndices += m_asset->aMeshes[i].uNumIndices;
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+        Method:   Model::findNodeAnimOrNull
+        Summary:  Find the aiNodeAnim with the givne node name in the given animation
+        Args:     const aiAnimation* pAnimation
+                    Pointer to an assimp animation object
+                  PCSTR pszNodeName
+                    Node name to find
+
+        Returns:  aiNodeAnim* or nullptr
+     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const aiNodeAnim* Model::findNodeAnimOrNull(_In_ const aiAnimation* pAnimation, _In_ PCSTR pszNodeName)
+    {
+        for (UINT i = 0u; i < pAnimation->mNumChannels; ++i)
+        {
+            const aiNodeAnim* pNodeAnim = pAnimation->mChannels[i];
+
+            if (strncmp(pNodeAnim->mNodeName.data, pszNodeName, pNodeAnim->mNodeName.length) == 0)
+            {
+                return pNodeAnim;
+            }
+        }
+
+        return nullptr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+        Method:   Model::getBoneId
+        Summary:  Find the the index of the bone
+        Args:      const aiBone* pBone
+                     Pointer to an assimp bone object
+        Modifies: [m_asset].
+        Returns:  UINT
+                    Index of the bone
+     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Model::getBoneId(_In_ const aiBone* pBone)
+    {
+        UINT uBoneIndex = 0u;
+        PCSTR pszBoneName = pBone->mName.C_Str();
+        if (!m_asset->boneNameToIndexMap.contains(pszBoneName))
+        {
+            uBoneIndex = static_cast<UINT>(m_asset->boneNameToIndexMap.size());
+            m_asset->boneNameToIndexMap[pszBoneName] = uBoneIndex;
+        }
+        else
+        {
+            uBoneIndex = m_asset->boneNameToIndexMap[pszBoneName];
+        }
+
+        return uBoneIndex;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::getVertices
+
+      Summary:  Returns the vertices data
+
+      Returns:  const SimpleVertex*
+                  Array of vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const SimpleVertex* Model::getVertices() const
+    {
+        return m_asset->aVertices.data();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::getIndices
+
+      Summary:  Returns the 16-bit indices, packed only while the
+                index buffer is created
+
+      Returns:  const WORD*
+                  Array of indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const WORD* Model::getIndices() const
+    {
+        return m_aPackedIndices.data();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::getIndexData
+
+      Summary:  Returns the indices in the format of the index buffer
+
+      Returns:  const void*
+                  Array of indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Model::getIndexData() const
+    {
+        if (m_asset->indexFormat == DXGI_FORMAT_R32_UINT)
+        {
+            return m_asset->aIndices.data();
+        }
+
+        return m_aPackedIndices.data();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::getNumIndexData
+
+      Summary:  Returns the number of indices in the index buffer, the
+                levels of detail included
+
+      Returns:  UINT
+                  Number of indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Model::getNumIndexData() const
+    {
+        return static_cast<UINT>(m_asset->aIndices.size());
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::getNormalData
+
+      Summary:  Returns the tangent frames in the layout of the normal
+                buffer
+
+      Returns:  const void*
+                  Array of QuantizedNormalData or NormalData
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Model::getNormalData() const
+    {
+        if (m_bCompressVertices)
+        {
+            return m_aQuantizedNormalData.data();
+        }
+
+        return m_aNormalData.data();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::getVertexData
+
+      Summary:  Returns the vertices in the layout of the vertex buffer
+
+      Returns:  const void*
+                  Array of QuantizedVertex or SimpleVertex
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Model::getVertexData() const
+    {
+        if (m_bCompressVertices)
+        {
+            return m_aQuantizedVertices.data();
+        }
+
+        return m_asset->aVertices.data();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::importMeshAsset
+
+      Summary:  Fills the mesh asset of the model. The asset is read
+                from its mesh cache when the cache matches the file,
+                and imported with assimp otherwise, writing the cache
+                for the next load. Each call imports with its own
+                importer and frees the scene before returning, so
+                models load on worker threads and keep no assimp data.
+                Load holds the lock of the asset meanwhile
+
+      Args:     BOOL& bOutLoadedFromCache
+                  Whether the asset was read from the mesh cache
+
+      Modifies: [m_asset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::importMeshAsset(_Out_ BOOL& bOutLoadedFromCache)
+    {
+        HRESULT hr = S_OK;
+        bOutLoadedFromCache = FALSE;
+
+        // With Assimp, we can calculate T and B vectors easily when importing the model
+        const UINT uImportFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals |
+            aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded;
+
+        // The cache holds for the exact bytes of the file, whatever its time stamp says
+        const std::filesystem::path cachePath = MeshCache::GetCachePath(m_filePath);
+        UINT64 uSourceHash = 0ull;
+        const BOOL bUseCache = usesMeshCache() && SUCCEEDED(MeshCache::HashFile(m_filePath, uSourceHash));
+
+        if (bUseCache)
+        {
+            MeshCache cache;
+            if (SUCCEEDED(cache.Open(cachePath, uSourceHash, uImportFlags)))
+            {
+                bOutLoadedFromCache = SUCCEEDED(readCache(cache));
+                if (!bOutLoadedFromCache)
+                {
+                    clearMeshData();
+
+                    CHAR szDebugMessage[256];
+                    sprintf_s(szDebugMessage, "Model %s: mesh cache is malformed, importing the model again\n", m_filePath.filename().string().c_str());
+                    OutputDebugStringA(szDebugMessage);
+                }
+            }
+        }
+
+        if (!bOutLoadedFromCache)
+        {
+            // Importers are not shared between threads, and the scene goes with the importer at the end of the scope
+            Assimp::Importer importer;
+            const aiScene* pScene = importer.ReadFile(m_filePath.string().c_str(), uImportFlags);
+
+            if (pScene == nullptr)
+            {
+                hr = E_FAIL;
+                OutputDebugString(L"Error parsing ");
+                OutputDebugString(m_filePath.c_str());
+                OutputDebugString(L": ");
+                OutputDebugStringA(importer.GetErrorString());
+                OutputDebugString(L"\n");
+
+                return hr;
+            }
+
+            // set GlobalInverseTransform as matrix from world space to model space
+            m_asset->GlobalInverseTransform = ConvertMatrix(pScene->mRootNode->mTransformation);
+            XMVECTOR det = XMMatrixDeterminant(m_asset->GlobalInverseTransform);
+            m_asset->GlobalInverseTransform = XMMatrixInverse(&det, m_asset->GlobalInverseTransform);
+
+            // Initialize the model
+            hr = initFromScene(pScene, m_filePath);
+            if (FAILED(hr))
+                return hr;
+
+            // Compress the animations and flatten the hierarchy, so updates no longer read the assimp scene
+            if (pScene->HasAnimations())
+            {
+                hr = initAnimations(pScene);
+                if (FAILED(hr))
+                    return hr;
+
+                m_asset->aSkeleton.clear();
+                m_asset->aNodeChannels.clear();
+                initSkeleton(pScene, pScene->mRootNode, INVALID_INDEX);
+            }
+
+            // A cache that cannot be written only costs the next load an import
+            if (bUseCache && FAILED(writeCache(cachePath, uSourceHash, uImportFlags)))
+            {
+                CHAR szDebugMessage[256];
+                sprintf_s(szDebugMessage, "Model %s: could not write the mesh cache\n", m_filePath.filename().string().c_str());
+                OutputDebugStringA(szDebugMessage);
+            }
+        }
+
+        // The levels of detail follow the indices of every mesh, which are drawn as one range when the meshes are not
+        m_asset->uNumMeshIndices = m_asset->aMeshes.empty() ? static_cast<UINT>(m_asset->aIndices.size()) : 0u;
+        for (const BasicMeshEntry& mesh : m_asset->aMeshes)
+        {
+            m_asset->uNumMeshIndices = std::max(m_asset->uNumMeshIndices, mesh.uBaseIndex + mesh.uNumIndices);
+        }
+
+        // One index buffer serves every mesh, so it is 32-bit as soon as one mesh needs it
+        m_asset->indexFormat = DXGI_FORMAT_R16_UINT;
+        if (!m_asset->aIndices.empty() && *std::max_element(m_asset->aIndices.begin(), m_asset->aIndices.end()) >= 0xFFFFu)
+        {
+            m_asset->indexFormat = DXGI_FORMAT_R32_UINT;
+        }
+
+        return hr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::getIndices
+
+      Summary:  Initialize all meshes in a given assimp scene
+
+      Args:     const aiScene* pScene
+                  Assimp scene
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::initAllMeshes(_In_ const aiScene* pScene)
+    {
+        // Initialize all meshes in the scene
+        for (UINT i = 0u; i < m_asset->aMeshes.size(); ++i)
+        {
+            const aiMesh* pMesh = pScene->mMeshes[i];
+            initSingleMesh(i, pMesh);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::initAnimations
+
+      Summary:  Compresses every animation of the scene into a clip.
+                Models loaded from the same file share their clips, so
+                the pose cache also serves crowds of the same model
+
+      Args:     const aiScene* pScene
+                  Pointer to an assimp scene object
+
+      Modifies: [m_asset, sm_animationClipLibrary].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::initAnimations(_In_ const aiScene* pScene)
+    {
+        HRESULT hr = S_OK;
+
+        std::string filePath = m_filePath.string();
+        {
+            std::lock_guard<std::mutex> lock(sm_animationClipLibraryMutex);
+            auto library = sm_animationClipLibrary.find(filePath);
+            m_asset->aAnimationClips = library != sm_animationClipLibrary.end() ? library->second : std::vector<std::shared_ptr<AnimationClip>>();
+        }
+
+        if (m_asset->aAnimationClips.empty())
+        {
+            for (UINT i = 0u; i < pScene->mNumAnimations; ++i)
+            {
+                const aiAnimation* pAnimation = pScene->mAnimations[i];
+                std::string name = pAnimation->mName.length > 0u ? pAnimation->mName.C_Str() : std::to_string(i);
+
+                std::shared_ptr<AnimationClip> clip = std::make_shared<AnimationClip>();
+                hr = clip->Initialize(pAnimation, name.c_str());
+                if (FAILED(hr))
+                    return hr;
+
+                if (Statistics::IsLogging())
+                {
+                    CHAR szDebugMessage[256];
+                    sprintf_s(
+                        szDebugMessage,
+                        "Model %s: clip %s of %u channels at %.0f Hz takes %zu bytes (%zu in assimp), max error %.5f units, %.5f rad, %.5f scale\n",
+                        m_filePath.filename().string().c_str(),
+                        name.c_str(),
+                        clip->GetNumChannels(),
+                        clip->GetSampleRate(),
+                        clip->GetMemorySize(),
+                        clip->GetSourceMemorySize(),
+                        clip->GetMaxTranslationError(),
+                        clip->GetMaxRotationError(),
+                        clip->GetMaxScalingError()
+                    );
+                    OutputDebugStringA(szDebugMessage);
+                }
+
+                m_asset->aAnimationClips.push_back(clip);
+            }
+
+            // A model of the same file loaded on another thread may have got there first, its clips are kept
+            std::lock_guard<std::mutex> lock(sm_animationClipLibraryMutex);
+            m_asset->aAnimationClips = sm_animationClipLibrary.emplace(filePath, m_asset->aAnimationClips).first->second;
+        }
+
+        m_asset->animationNameToIndexMap.clear();
+        for (UINT i = 0u; i < m_asset->aAnimationClips.size(); ++i)
+        {
+            m_asset->animationNameToIndexMap.emplace(m_asset->aAnimationClips[i]->GetName(), i);
+        }
+
+        return hr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::initBoneBounds
+
+      Summary:  Grows the box of every bone around the bind pose
+                vertices it influences, reading the packed influences
+                the shader skins with
+
+      Modifies: [m_asset].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::initBoneBounds()
+    {
+        std::vector<XMVECTOR> aBoundsMin(m_asset->aBoneInfo.size(), XMVectorReplicate(FLT_MAX));
+        std::vector<XMVECTOR> aBoundsMax(m_asset->aBoneInfo.size(), XMVectorReplicate(-FLT_MAX));
+        m_asset->bHasUnskinnedVertices = FALSE;
+
+        for (size_t uVertex = 0u; uVertex < m_asset->aAnimationData.size() && uVertex < m_asset->aVertices.size(); ++uVertex)
+        {
+            const AnimationData& animationData = m_asset->aAnimationData[uVertex];
+            XMVECTOR position = XMLoadFloat3(&m_asset->aVertices[uVertex].Position);
+
+            BOOL bSkinned = FALSE;
+            for (UINT i = 0u; i < MAX_NUM_BONES_PER_VERTEX; ++i)
+            {
+                UINT uBoneIndex = animationData.aBoneIndices[i];
+                if (animationData.aBoneWeights[i] == 0u || uBoneIndex >= aBoundsMin.size())
+                {
+                    continue;
+                }
+
+                aBoundsMin[uBoneIndex] = XMVectorMin(aBoundsMin[uBoneIndex], position);
+                aBoundsMax[uBoneIndex] = XMVectorMax(aBoundsMax[uBoneIndex], position);
+                bSkinned = TRUE;
+            }
+
+            // The shader collapses a vertex without influences to the origin
+            if (!bSkinned)
+            {
+                m_asset->bHasUnskinnedVertices = TRUE;
+            }
+        }
+
+        m_asset->aBoneBounds.resize(m_asset->aBoneInfo.size());
+        for (size_t uBone = 0u; uBone < m_asset->aBoneBounds.size(); ++uBone)
+        {
+            if (XMVectorGetX(aBoundsMin[uBone]) > XMVectorGetX(aBoundsMax[uBone]))
+            {
+                m_asset->aBoneBounds[uBone] = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, -1.0f, -1.0f) };
+                continue;
+            }
+
+            XMStoreFloat3(&m_asset->aBoneBounds[uBone].Center, (aBoundsMin[uBone] + aBoundsMax[uBone]) * 0.5f);
+            XMStoreFloat3(&m_asset->aBoneBounds[uBone].Extents, (aBoundsMax[uBone] - aBoundsMin[uBone]) * 0.5f);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::initFromScene
+
+      Summary:  Initialize all meshes in a given assimp scene, on the
+                CPU only
+
+      Args:     const aiScene* pScene
+                  Assimp scene
+                const std::filesystem::path& filePath
+                  Path to the model
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::initFromScene(_In_ const aiScene* pScene, _In_ const std::filesystem::path& filePath)
+    {
+        // Based on the number of meshes and materials, resize the meshes vector and materials vector accordingly
+        m_asset->aMeshes.resize(pScene->mNumMeshes);
+        // m_aMaterials.resize(pScene->mNumMaterials);
+
+        UINT uNumVertices = 0u;
+        UINT uNumIndices = 0u;
+        HRESULT hr = S_OK;
+
+        // Load the mesh information to get the total number of vertices / indices(countVerticesAndIndices) 
+        countVerticesAndIndices(uNumVertices, uNumIndices, pScene);
+
+        // Reserve spaces for the verticesand indices data(reserveSpace)
+        reserveSpace(uNumVertices, uNumIndices);
+
+        // Initialize the meshes(initAllMeshes)
+        initAllMeshes(pScene);
+
+        // Initialize the materials(initMaterials)
+        hr = initMaterials(pScene);
+        if (FAILED(hr))
+            return hr;
+
+        // Bone indices are stored in a byte
+        if (m_asset->aBoneInfo.size() > MAX_NUM_BONES)
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(szDebugMessage, "Model %s: %zu bones, at most %d are supported\n", filePath.filename().string().c_str(), m_asset->aBoneInfo.size(), MAX_NUM_BONES);
+            OutputDebugStringA(szDebugMessage);
+
+            return E_FAIL;
+        }
+
+        // Create AnimationData for each vertex from its four strongest influences
+        UINT uNumTruncatedVertices = 0u;
+        m_asset->aAnimationData.reserve(m_aBoneData.size());
+        for (const VertexBoneData& boneData : m_aBoneData)
+        {
+            m_asset->aAnimationData.push_back(boneData.Pack());
+            if (boneData.uNumBones > MAX_NUM_BONES_PER_VERTEX)
+            {
+                ++uNumTruncatedVertices;
+            }
+        }
+
+        if (uNumTruncatedVertices > 0u)
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Model %s: %u of %zu vertices had more than %d bone influences, the strongest were kept\n",
+                filePath.filename().string().c_str(),
+                uNumTruncatedVertices,
+                m_aBoneData.size(),
+                MAX_NUM_BONES_PER_VERTEX
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+
+        initBoneBounds();
+
+        // The influences are packed, the unpacked ones are only needed while importing
+        std::vector<VertexBoneData>().swap(m_aBoneData);
+
+        // Welding and reordering keep the vertices in their boxes, so the bone bounds hold
+        hr = optimizeMeshes(filePath);
+        if (FAILED(hr))
+            return hr;
+
+        // The levels of detail index the optimized vertices, so they are built last
+        if (usesLods())
+        {
+            hr = buildLods(filePath);
+            if (FAILED(hr))
+                return hr;
+        }
+
+        // Clusters are cut from the optimized triangle order, whose neighbours are close on the surface
+        hr = buildClusters(filePath);
+        if (FAILED(hr))
+            return hr;
+
+        if (usesRayBvh())
+        {
+            hr = buildRayBvh(filePath);
+            if (FAILED(hr))
+                return hr;
+        }
+
+        return hr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::initMaterials
+
+      Summary:  Collect the texture paths of all materials in a given
+                assimp scene. The materials themselves are created by
+                initMaterialTextures on the render thread
+
+      Args:     const aiScene* pScene
+                  Assimp scene
+
+      Modifies: [m_asset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::initMaterials(_In_ const aiScene* pScene)
+    {
+        // Keep the texture paths alone, they are all the mesh cache needs of the materials
+        m_asset->aMaterialTextures.resize(pScene->mNumMaterials);
+        for (UINT i = 0u; i < pScene->mNumMaterials; ++i)
+        {
+            const aiMaterial* pMaterial = pScene->mMaterials[i];
+
+            m_asset->aMaterialTextures[i] =
+            {
+                .szDiffusePath = GetTexturePath(pMaterial, aiTextureType_DIFFUSE),
+                .szSpecularPath = GetTexturePath(pMaterial, aiTextureType_SHININESS),
+                .szNormalPath = GetTexturePath(pMaterial, aiTextureType_HEIGHT),
+            };
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::initMaterialTextures
+
+      Summary:  Create a material for every entry of the texture paths
+                and load its textures
+
+      Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
-                const std::filesystem::path& parentDirectory
-                  Parent path to the model
-                const aiMaterial* pMaterial
-                  Pointer to an assimp material object
-                UINT uIndex
-                  Index to a material
+                const std::filesystem::path& filePath
+                  Path to the model
+
+      Modifies: [m_aMaterials].
+
+      Returns:  HRESULT
+                  Status code
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    HRESULT Model::loadDiffuseTexture(
+    HRESULT Model::initMaterialTextures(
         _In_ ID3D11Device* pDevice,
         _In_ ID3D11DeviceContext* pImmediateContext,
-        _In_ const std::filesystem::path& parentDirectory,
-        _In_ const aiMaterial* pMaterial,
-        _In_ UINT uIndex
+        _In_ const std::filesystem::path& filePath
     )
     {
         HRESULT hr = S_OK;
-        m_aMaterials[uIndex]->pDiffuse = nullptr;
 
-        if (pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)
+        // Extract the directory part from the file name
+        std::filesystem::path parentDirectory = filePath.parent_path();
+
+        // Initialize the materials
+        for (UINT i = 0u; i < m_asset->aMaterialTextures.size(); ++i)
         {
-            aiString aiPath;
+            std::string szName = filePath.string() + std::to_string(i);
+            std::wstring pwszName(szName.length(), L' ');
+            std::copy(szName.begin(), szName.end(), pwszName.begin());
+            m_aMaterials.push_back(std::make_shared<Material>(pwszName));
 
-            if (pMaterial->GetTexture(aiTextureType_DIFFUSE, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) == AI_SUCCESS)
-            {
-                std::string szPath(aiPath.data);
+            loadTextures(pDevice, pImmediateContext, parentDirectory, m_asset->aMaterialTextures[i], i);
+        }
 
-                if (szPath.substr(0ull, 2ull) == ".\\")
-                {
-                    szPath = szPath.substr(2ull, szPath.size() - 2ull);
-                }
+        return hr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+        Method:   Model::initMeshBones
+        Summary:  Initialize all bones in a given aiMesh
+        Args:     const aiScene* pScene
+                    Assimp scene
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::initMeshBones(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh)
+    {
+        // For each bone of the given mesh
+        for (UINT i = 0; i < pMesh->mNumBones; ++i)
+        {
+            // const aiBone* pBone = pMesh[uMeshIndex].mBones[i];
+            // Call initMeshSingleBone
+            initMeshSingleBone(uMeshIndex, pMesh->mBones[i]);
+        }
+    }
 
-                std::filesystem::path fullPath = parentDirectory / szPath;
 
-                m_aMaterials[uIndex]->pDiffuse = std::make_shared<Texture>(fullPath);
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+        Method:   Model::initMeshSingleBone
+        Summary:  Initialize a single bone of the mesh
+        Args:     const aiScene* pScene
+                    Assimp scene
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::initMeshSingleBone(_In_ UINT uMeshIndex, _In_ const aiBone* pBone)
+    {
+        UINT uBoneId = getBoneId(pBone);
 
-                hr = m_aMaterials[uIndex]->pDiffuse->Initialize(pDevice, pImmediateContext);
-                if (FAILED(hr))
+        if (uBoneId == m_asset->aBoneInfo.size())
+        {
+            BoneInfo boneInfo(ConvertMatrix(pBone->mOffsetMatrix));
+            m_asset->aBoneInfo.push_back(boneInfo);
+        }
+
+        for (UINT i = 0u; i < pBone->mNumWeights; ++i)
+        {
+            const aiVertexWeight& vertexWeight = pBone->mWeights[i];
+            UINT uGlobalVertexId = m_asset->aMeshes[uMeshIndex].uBaseVertex + vertexWeight.mVertexId;
+            m_aBoneData[uGlobalVertexId].AddBoneData(uBoneId, vertexWeight.mWeight);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::initSingleMesh
+
+      Summary:  Initialize single mesh from a given assimp mesh
+
+      Args:     const aiMesh* pMesh
+                  Point to an assimp mesh object
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh)
+    {
+        const aiVector3D zero3d(0.0f, 0.0f, 0.0f);
+
+        // Populate the vertex attribute vectors
+        for (UINT i = 0u; i < pMesh->mNumVertices; ++i) // For each vertex in the mesh
+        {
+            const aiVector3D& position = pMesh->mVertices[i];
+            const aiVector3D& normal = pMesh->mNormals[i];
+            const aiVector3D& texCoord = pMesh->HasTextureCoords(0u) ? pMesh->mTextureCoords[0][i] : zero3d;
+
+            m_asset->aVertices.push_back(
+                SimpleVertex
                 {
-                    OutputDebugString(L"Error loading diffuse texture \"");
-                    OutputDebugString(fullPath.c_str());
-                    OutputDebugString(L"\"\n");
+                    .Position = XMFLOAT3(position.x, position.y, position.z),
+                    .TexCoord = XMFLOAT2(texCoord.x, texCoord.y),
+                    .Normal = XMFLOAT3(normal.x, normal.y, normal.z)
+                }
+            );
+            
+            const aiVector3D& tangent = pMesh->HasTangentsAndBitangents() ? pMesh->mTangents[i] : zero3d;
+            const aiVector3D& bitangent = pMesh->HasTangentsAndBitangents() ? pMesh->mBitangents[i] : zero3d;
 
-                    return hr;
+            m_asset->aNormalData.push_back(
+                NormalData
+                {
+                    .Tangent = XMFLOAT3(tangent.x, tangent.y, tangent.z),
+                    .Bitangent = XMFLOAT3(bitangent.x, bitangent.y, bitangent.z)
                 }
+            );
 
-                OutputDebugString(L"Loaded diffuse texture \"");
-                OutputDebugString(fullPath.c_str());
-                OutputDebugString(L"\"\n");
-            }
         }
 
-        return hr;
+        // call initMeshBones
+        initMeshBones(uMeshIndex, pMesh);
+
+        // For each face in the mesh, Populate the index buffer
+        for (UINT i = 0u; i < pMesh->mNumFaces; ++i)
+        {
+            const aiFace& face = pMesh->mFaces[i];
+            assert(face.mNumIndices == 3u);
+
+            m_asset->aIndices.push_back(face.mIndices[0]);
+            m_asset->aIndices.push_back(face.mIndices[1]);
+            m_asset->aIndices.push_back(face.mIndices[2]);
+        }
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::loadSpecularTexture
+      Method:   Model::initSkeleton
 
-      Summary:  Load a specular texture from given path
+      Summary:  Append the given node and its subtree to the flattened
+                skeleton in depth first order, resolving the channel
+                of each node in every clip and its bone by name once
+
+      Args:     const aiScene* pScene
+                  Assimp scene holding the animations
+                const aiNode* pNode
+                  Pointer to an assimp node object
+                UINT uParentIndex
+                  Index of the parent in the skeleton, INVALID_INDEX
+                  for the root
+
+      Modifies: [m_asset].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::initSkeleton(_In_ const aiScene* pScene, _In_ const aiNode* pNode, _In_ UINT uParentIndex)
+    {
+        PCSTR pszNodeName = pNode->mName.C_Str();
+
+        SkeletonNode node = { XMMatrixIdentity(), uParentIndex, INVALID_INDEX };
+
+        auto bone = m_asset->boneNameToIndexMap.find(pszNodeName);
+        if (bone != m_asset->boneNameToIndexMap.end())
+        {
+            node.uBoneIndex = bone->second;
+            node.OffsetMatrix = m_asset->aBoneInfo[bone->second].OffsetMatrix;
+        }
+
+        // Channels of the node, clip by clip
+        for (UINT i = 0u; i < pScene->mNumAnimations; ++i)
+        {
+            const aiAnimation* pAnimation = pScene->mAnimations[i];
+            const aiNodeAnim* pNodeAnim = findNodeAnimOrNull(pAnimation, pszNodeName);
+            m_asset->aNodeChannels.push_back(pNodeAnim != nullptr
+                ? static_cast<UINT>(std::find(pAnimation->mChannels, pAnimation->mChannels + pAnimation->mNumChannels, pNodeAnim) - pAnimation->mChannels)
+                : INVALID_INDEX);
+        }
+
+        // Nodes without a channel keep their bind pose
+        XMVECTOR scaling;
+        XMVECTOR rotation;
+        XMVECTOR translation;
+        XMMatrixDecompose(&scaling, &rotation, &translation, ConvertMatrix(pNode->mTransformation));
+        m_asset->bindPose.aScalings.push_back(scaling);
+        m_asset->bindPose.aRotations.push_back(rotation);
+        m_asset->bindPose.aTranslations.push_back(translation);
+
+        UINT uNodeIndex = static_cast<UINT>(m_asset->aSkeleton.size());
+        m_asset->aSkeleton.push_back(node);
+
+        for (UINT i = 0u; i < pNode->mNumChildren; ++i)
+        {
+            initSkeleton(pScene, pNode->mChildren[i], uNodeIndex);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::loadDiffuseTexture
+
+      Summary:  Load a diffuse texture from given path
 
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
@@ -893,108 +2441,139 @@ namespace library
                   The Direct3D context to set buffers
                 const std::filesystem::path& parentDirectory
                   Parent path to the model
-                const aiMaterial* pMaterial
-                  Pointer to an assimp material object
+                const std::string& szPath
+                  Path to the texture relative to the model, empty
+                  if the material has none
                 UINT uIndex
                   Index to a material
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    HRESULT Model::loadSpecularTexture(
+    HRESULT Model::loadDiffuseTexture(
         _In_ ID3D11Device* pDevice,
         _In_ ID3D11DeviceContext* pImmediateContext,
         _In_ const std::filesystem::path& parentDirectory,
-        _In_ const aiMaterial* pMaterial,
+        _In_ const std::string& szPath,
         _In_ UINT uIndex
     )
     {
         HRESULT hr = S_OK;
-        m_aMaterials[uIndex]->pSpecularExponent = nullptr;
+        m_aMaterials[uIndex]->pDiffuse = nullptr;
 
-        if (pMaterial->GetTextureCount(aiTextureType_SHININESS) > 0)
+        if (!szPath.empty())
         {
-            aiString aiPath;
-
-            if (pMaterial->GetTexture(aiTextureType_SHININESS, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) == AI_SUCCESS)
-            {
-                std::string szPath(aiPath.data);
-
-                if (szPath.substr(0ull, 2ull) == ".\\")
-                {
-                    szPath = szPath.substr(2ull, szPath.size() - 2ull);
-                }
-
-                std::filesystem::path fullPath = parentDirectory / szPath;
+            std::filesystem::path fullPath = parentDirectory / szPath;
 
-                m_aMaterials[uIndex]->pSpecularExponent = std::make_shared<Texture>(fullPath);
+            m_aMaterials[uIndex]->pDiffuse = std::make_shared<Texture>(fullPath);
 
-                hr = m_aMaterials[uIndex]->pSpecularExponent->Initialize(pDevice, pImmediateContext);
-                if (FAILED(hr))
-                {
-                    OutputDebugString(L"Error loading specular texture \"");
-                    OutputDebugString(fullPath.c_str());
-                    OutputDebugString(L"\"\n");
-
-                    return hr;
-                }
-
-                OutputDebugString(L"Loaded specular texture \"");
+            hr = m_aMaterials[uIndex]->pDiffuse->Initialize(pDevice, pImmediateContext);
+            if (FAILED(hr))
+            {
+                OutputDebugString(L"Error loading diffuse texture \"");
                 OutputDebugString(fullPath.c_str());
                 OutputDebugString(L"\"\n");
+
+                return hr;
             }
+
+            OutputDebugString(L"Loaded diffuse texture \"");
+            OutputDebugString(fullPath.c_str());
+            OutputDebugString(L"\"\n");
         }
 
         return hr;
     }
 
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::loadNormalTexture
-      Summary:  Load a normal texture from given path
+      Method:   Model::loadSpecularTexture
+
+      Summary:  Load a specular texture from given path
+
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
                 const std::filesystem::path& parentDirectory
                   Parent path to the model
-                const aiMaterial* pMaterial
-                  Pointer to an assimp material object
+                const std::string& szPath
+                  Path to the texture relative to the model, empty
+                  if the material has none
                 UINT uIndex
                   Index to a material
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    HRESULT Model::loadNormalTexture(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_ const std::filesystem::path& parentDirectory, _In_ const aiMaterial* pMaterial, _In_ UINT uIndex)
+    HRESULT Model::loadSpecularTexture(
+        _In_ ID3D11Device* pDevice,
+        _In_ ID3D11DeviceContext* pImmediateContext,
+        _In_ const std::filesystem::path& parentDirectory,
+        _In_ const std::string& szPath,
+        _In_ UINT uIndex
+    )
     {
         HRESULT hr = S_OK;
-        m_aMaterials[uIndex]->pNormal = nullptr;
+        m_aMaterials[uIndex]->pSpecularExponent = nullptr;
 
-        if (pMaterial->GetTextureCount(aiTextureType_HEIGHT) > 0)
+        if (!szPath.empty())
         {
-            aiString aiPath;
+            std::filesystem::path fullPath = parentDirectory / szPath;
 
-            if (pMaterial->GetTexture(aiTextureType_HEIGHT, 0u, &aiPath, nullptr, nullptr, nullptr, nullptr, nullptr) == AI_SUCCESS)
+            m_aMaterials[uIndex]->pSpecularExponent = std::make_shared<Texture>(fullPath);
+
+            hr = m_aMaterials[uIndex]->pSpecularExponent->Initialize(pDevice, pImmediateContext);
+            if (FAILED(hr))
             {
-                std::string szPath(aiPath.data);
+                OutputDebugString(L"Error loading specular texture \"");
+                OutputDebugString(fullPath.c_str());
+                OutputDebugString(L"\"\n");
 
-                if (szPath.substr(0ull, 2ull) == ".\\")
-                {
-                    szPath = szPath.substr(2ull, szPath.size() - 2ull);
-                }
+                return hr;
+            }
+
+            OutputDebugString(L"Loaded specular texture \"");
+            OutputDebugString(fullPath.c_str());
+            OutputDebugString(L"\"\n");
+        }
 
-                std::filesystem::path fullPath = parentDirectory / szPath;
+        return hr;
+    }
 
-                m_aMaterials[uIndex]->pNormal = std::make_shared<Texture>(fullPath);
-                m_bHasNormalMap = true;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::loadNormalTexture
+      Summary:  Load a normal texture from given path
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffers
+                ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to set buffers
+                const std::filesystem::path& parentDirectory
+                  Parent path to the model
+                const std::string& szPath
+                  Path to the texture relative to the model, empty
+                  if the material has none
+                UINT uIndex
+                  Index to a material
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::loadNormalTexture(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_ const std::filesystem::path& parentDirectory, _In_ const std::string& szPath, _In_ UINT uIndex)
+    {
+        HRESULT hr = S_OK;
+        m_aMaterials[uIndex]->pNormal = nullptr;
 
-                if (FAILED(hr))
-                {
-                    OutputDebugString(L"Error loading normal texture \"");
-                    OutputDebugString(fullPath.c_str());
-                    OutputDebugString(L"\"\n");
+        if (!szPath.empty())
+        {
+            std::filesystem::path fullPath = parentDirectory / szPath;
 
-                    return hr;
-                }
+            m_aMaterials[uIndex]->pNormal = std::make_shared<Texture>(fullPath);
+            m_bHasNormalMap = true;
 
-                OutputDebugString(L"Loaded normal texture \"");
+            if (FAILED(hr))
+            {
+                OutputDebugString(L"Error loading normal texture \"");
                 OutputDebugString(fullPath.c_str());
                 OutputDebugString(L"\"\n");
+
+                return hr;
             }
+
+            OutputDebugString(L"Loaded normal texture \"");
+            OutputDebugString(fullPath.c_str());
+            OutputDebugString(L"\"\n");
         }
 
         return hr;
@@ -1004,7 +2583,8 @@ namespace library
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Model::loadTextures
 
-      Summary:  Load a specular texture from given path
+      Summary:  Load the diffuse, specular and normal textures of a
+                material
 
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
@@ -1012,8 +2592,8 @@ namespace library
                   The Direct3D context to set buffers
                 const std::filesystem::path& parentDirectory
                   Parent path to the model
-                const aiMaterial* pMaterial
-                  Pointer to an assimp material object
+                const MaterialTextures& textures
+                  Texture paths of the material
                 UINT uIndex
                   Index to a material
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
@@ -1021,23 +2601,23 @@ namespace library
         _In_ ID3D11Device* pDevice,
         _In_ ID3D11DeviceContext* pImmediateContext,
         _In_ const std::filesystem::path& parentDirectory,
-        _In_ const aiMaterial* pMaterial,
+        _In_ const MaterialTextures& textures,
         _In_ UINT uIndex
     )
     {
-        HRESULT hr = loadDiffuseTexture(pDevice, pImmediateContext, parentDirectory, pMaterial, uIndex);
+        HRESULT hr = loadDiffuseTexture(pDevice, pImmediateContext, parentDirectory, textures.szDiffusePath, uIndex);
         if (FAILED(hr))
         {
             return hr;
         }
 
-        hr = loadSpecularTexture(pDevice, pImmediateContext, parentDirectory, pMaterial, uIndex);
+        hr = loadSpecularTexture(pDevice, pImmediateContext, parentDirectory, textures.szSpecularPath, uIndex);
         if (FAILED(hr))
         {
             return hr;
         }
 
-        hr = loadNormalTexture(pDevice, pImmediateContext, parentDirectory, pMaterial, uIndex);
+        hr = loadNormalTexture(pDevice, pImmediateContext, parentDirectory, textures.szNormalPath, uIndex);
         if (FAILED(hr))
         {
             return hr;
@@ -1048,64 +2628,358 @@ namespace library
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Model::readNodeHierarchy
-      Summary:  Calculate bone transformation of the given assimp node
-      Args:     FLOAT animationTimeTicks
-                  Animation time
-               const aiNode* pNode
-                  Pointer to an assimp node object
-                const XMMATRIX& parentTransform
-                  Parent transform in hierarchy
+      Method:   Model::optimizeMeshes
+
+      Summary:  Welds and reorders every mesh with the mesh optimizer,
+                gathering the vertex streams in the new vertex order
+                and logging the ACMR of each mesh before and after
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the model
+
+      Modifies: [m_asset].
+
+      Returns:  HRESULT
+                  Status code
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Model::readNodeHierarchy(_In_ FLOAT animationTimeTicks, _In_ const aiNode* pNode, _In_ const XMMATRIX& parentTransform)
+    HRESULT Model::optimizeMeshes(_In_ const std::filesystem::path& filePath)
     {
-        // This function is a recursive function, We will play the 0th animation of the animations that aiScene has
+        if (m_asset->aNormalData.size() != m_asset->aVertices.size() || m_asset->aAnimationData.size() != m_asset->aVertices.size())
+        {
+            return E_FAIL;
+        }
 
-        PCSTR pszNodeName = pNode->mName.C_Str();
-        XMMATRIX NodeTransform = ConvertMatrix(pNode->mTransformation);
+        std::vector<SimpleVertex> aVertices;
+        std::vector<NormalData> aNormalData;
+        std::vector<AnimationData> aAnimationData;
+        std::vector<UINT> aIndices;
+        aVertices.reserve(m_asset->aVertices.size());
+        aNormalData.reserve(m_asset->aNormalData.size());
+        aAnimationData.reserve(m_asset->aAnimationData.size());
+        aIndices.reserve(m_asset->aIndices.size());
+
+        MeshOptimizer optimizer;
+        std::vector<UINT> aMeshIndices;
+        for (UINT uMesh = 0u; uMesh < m_asset->aMeshes.size(); ++uMesh)
+        {
+            BasicMeshEntry& mesh = m_asset->aMeshes[uMesh];
+            const UINT uBaseVertex = mesh.uBaseVertex;
+            const UINT uNumVertices = (uMesh + 1u < m_asset->aMeshes.size() ? m_asset->aMeshes[uMesh + 1u].uBaseVertex : static_cast<UINT>(m_asset->aVertices.size())) - uBaseVertex;
+
+            aMeshIndices.assign(m_asset->aIndices.begin() + mesh.uBaseIndex, m_asset->aIndices.begin() + mesh.uBaseIndex + mesh.uNumIndices);
+            HRESULT hr = optimizer.Optimize(
+                m_asset->aVertices.data() + uBaseVertex,
+                m_asset->aNormalData.data() + uBaseVertex,
+                m_asset->aAnimationData.data() + uBaseVertex,
+                uNumVertices,
+                aMeshIndices
+            );
+            if (FAILED(hr))
+                return hr;
 
-        // Find current aiNodeAnim
-        const aiNodeAnim* pNodeAnim = findNodeAnimOrNull(m_pScene->mAnimations[0], pszNodeName);
-        
-        if (pNodeAnim != nullptr)
+            mesh.uBaseVertex = static_cast<UINT>(aVertices.size());
+            mesh.uBaseIndex = static_cast<UINT>(aIndices.size());
+            mesh.uNumIndices = static_cast<UINT>(aMeshIndices.size());
+
+            for (UINT uVertex : optimizer.GetVertexOrder())
+            {
+                aVertices.push_back(m_asset->aVertices[uBaseVertex + uVertex]);
+                aNormalData.push_back(m_asset->aNormalData[uBaseVertex + uVertex]);
+                aAnimationData.push_back(m_asset->aAnimationData[uBaseVertex + uVertex]);
+            }
+            aIndices.insert(aIndices.end(), aMeshIndices.begin(), aMeshIndices.end());
+
+            if (Statistics::IsLogging())
+            {
+                CHAR szDebugMessage[256];
+                sprintf_s(
+                    szDebugMessage,
+                    "Model %s: mesh %u welded from %u to %zu vertices, ACMR %.3f before and %.3f after optimizing\n",
+                    filePath.filename().string().c_str(),
+                    uMesh,
+                    uNumVertices,
+                    optimizer.GetVertexOrder().size(),
+                    optimizer.GetAcmrBefore(),
+                    optimizer.GetAcmrAfter()
+                );
+                OutputDebugStringA(szDebugMessage);
+            }
+        }
+
+        m_asset->aVertices.swap(aVertices);
+        m_asset->aNormalData.swap(aNormalData);
+        m_asset->aAnimationData.swap(aAnimationData);
+        m_asset->aIndices.swap(aIndices);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::packBonePalette
+      Summary:  Transposes the bone transforms and stores the first
+                three rows of each, so the shader multiplies a column
+                vector with a float3x4
+      Args:     const XMMATRIX* pTransforms
+                  Bone transforms, row vector convention
+                UINT uNumBones
+                  Number of bone transforms
+                XMFLOAT4A* pOutRows
+                  16-byte aligned destination of
+                  uNumBones * BONE_PALETTE_ROWS rows
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::packBonePalette(_In_reads_(uNumBones) const XMMATRIX* pTransforms, _In_ UINT uNumBones, _Out_ XMFLOAT4A* pOutRows)
+    {
+        for (UINT uBone = 0u; uBone < uNumBones; ++uBone)
         {
-            // Calculate scaling matrix, rotation matrix, translation matrix
-            XMFLOAT3 outTranslate = { 0.f, 0.f, 0.f};
-            XMVECTOR outQuaternion = { 0.f, 0.f, 0.f, 0.f };
-            XMFLOAT3 outScale = { 0.f, 0.f, 0.f };
+            // The transpose stays in SIMD registers, the translation row is dropped
+            const XMMATRIX transposed = XMMatrixTranspose(pTransforms[uBone]);
+            XMStoreFloat4A(&pOutRows[0], transposed.r[0]);
+            XMStoreFloat4A(&pOutRows[1], transposed.r[1]);
+            XMStoreFloat4A(&pOutRows[2], transposed.r[2]);
+            pOutRows += BONE_PALETTE_ROWS;
+        }
+    }
 
-            interpolatePosition(outTranslate, animationTimeTicks, pNodeAnim);
-            interpolateRotation(outQuaternion, animationTimeTicks, pNodeAnim);
-            interpolateScaling(outScale, animationTimeTicks, pNodeAnim);
 
-            XMMATRIX translationMatrix = XMMatrixTranslation(outTranslate.x, outTranslate.y, outTranslate.z);
-            XMMATRIX rotationMatrix = XMMatrixRotationQuaternion(outQuaternion);
-            XMMATRIX scalingMatrix = XMMatrixScaling(outScale.x, outScale.y, outScale.z);
-            
-            // Replace NodeTransform with final transformation matrix
-            NodeTransform = scalingMatrix  * rotationMatrix * translationMatrix;      
-            // NodeTransform = translationMatrix * rotationMatrix * scalingMatrix;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::readCache
+
+      Summary:  Reads back what writeCache stored, in the same order.
+                Arrays whose sizes or indices disagree fail the read,
+                so nothing downstream indexes past them. Clips already
+                in the clip library are shared instead of read
+
+      Args:     MeshCache& cache
+                  Opened cache of the model
+
+      Modifies: [m_asset, sm_animationClipLibrary].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the cache is malformed
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::readCache(_Inout_ MeshCache& cache)
+    {
+        HRESULT hr = S_OK;
+
+        // Geometry, one array per vertex stream
+        hr = cache.Read(m_asset->aVertices);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aNormalData);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aAnimationData);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aIndices);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aMeshes);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aLodMeshes);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aClusters);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aClusterBones);
+        if (FAILED(hr))
+            return hr;
+
+        // The ray BVH is taken last, once everything else has been read
+        std::vector<TriangleBvh::Node> aRayBvhNodes;
+        std::vector<TriangleBvh::Triangle> aRayBvhTriangles;
+        std::vector<TriangleBvh::MeshRoot> aRayBvhMeshRoots;
+        if (FAILED(hr = cache.Read(aRayBvhNodes)) ||
+            FAILED(hr = cache.Read(aRayBvhTriangles)) ||
+            FAILED(hr = cache.Read(aRayBvhMeshRoots)))
+        {
+            return hr;
+        }
+
+        if (m_asset->aNormalData.size() != m_asset->aVertices.size() || m_asset->aAnimationData.size() != m_asset->aVertices.size())
+        {
+            return E_FAIL;
+        }
+
+        if (!m_asset->aLodMeshes.empty() && m_asset->aLodMeshes.size() != m_asset->aMeshes.size() * (NUM_LODS - 1u))
+        {
+            return E_FAIL;
+        }
+
+        for (const std::vector<BasicMeshEntry>* paMeshes : { &m_asset->aMeshes, &m_asset->aLodMeshes })
+        {
+            for (const BasicMeshEntry& mesh : *paMeshes)
+            {
+                if (static_cast<SIZE_T>(mesh.uBaseIndex) + mesh.uNumIndices > m_asset->aIndices.size() || mesh.uBaseVertex > m_asset->aVertices.size())
+                {
+                    return E_FAIL;
+                }
+            }
+        }
+
+        for (const ClusterCuller::MeshCluster& cluster : m_asset->aClusters)
+        {
+            if (static_cast<SIZE_T>(cluster.uBaseIndex) + cluster.uNumIndices > m_asset->aIndices.size() || cluster.uMeshIndex >= m_asset->aMeshes.size() + m_asset->aLodMeshes.size())
+            {
+                return E_FAIL;
+            }
+        }
+
+        // Materials, as texture paths relative to the model
+        UINT uNumMaterials = 0u;
+        hr = cache.Read(uNumMaterials);
+        if (FAILED(hr))
+            return hr;
+
+        m_asset->aMaterialTextures.resize(uNumMaterials);
+        for (MaterialTextures& textures : m_asset->aMaterialTextures)
+        {
+            if (FAILED(hr = cache.ReadString(textures.szDiffusePath)) ||
+                FAILED(hr = cache.ReadString(textures.szSpecularPath)) ||
+                FAILED(hr = cache.ReadString(textures.szNormalPath)))
+            {
+                return hr;
+            }
+        }
+
+        // Bones, their names in index order and their bind pose boxes
+        hr = cache.Read(m_asset->aBoneInfo);
+        if (FAILED(hr))
+            return hr;
+
+        m_asset->boneNameToIndexMap.clear();
+        for (UINT i = 0u; i < m_asset->aBoneInfo.size(); ++i)
+        {
+            std::string boneName;
+            hr = cache.ReadString(boneName);
+            if (FAILED(hr))
+                return hr;
+
+            m_asset->boneNameToIndexMap.emplace(std::move(boneName), i);
+        }
+
+        hr = cache.Read(m_asset->aBoneBounds);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->bHasUnskinnedVertices);
+        if (FAILED(hr))
+            return hr;
+
+        if (m_asset->aBoneBounds.size() != m_asset->aBoneInfo.size() || m_asset->aBoneInfo.size() > MAX_NUM_BONES)
+        {
+            return E_FAIL;
+        }
+
+        // Skeleton, flattened in depth first order, and the channel of every node in every clip
+        hr = cache.Read(m_asset->GlobalInverseTransform);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aSkeleton);
+        if (FAILED(hr))
+            return hr;
+
+        hr = cache.Read(m_asset->aNodeChannels);
+        if (FAILED(hr))
+            return hr;
+
+        if (FAILED(hr = cache.Read(m_asset->bindPose.aScalings)) ||
+            FAILED(hr = cache.Read(m_asset->bindPose.aRotations)) ||
+            FAILED(hr = cache.Read(m_asset->bindPose.aTranslations)))
+        {
+            return hr;
+        }
+
+        if (m_asset->bindPose.aScalings.size() != m_asset->aSkeleton.size() ||
+            m_asset->bindPose.aRotations.size() != m_asset->aSkeleton.size() ||
+            m_asset->bindPose.aTranslations.size() != m_asset->aSkeleton.size())
+        {
+            return E_FAIL;
+        }
+
+        for (UINT i = 0u; i < m_asset->aSkeleton.size(); ++i)
+        {
+            const SkeletonNode& node = m_asset->aSkeleton[i];
+            if ((node.uParentIndex != INVALID_INDEX && node.uParentIndex >= i) ||
+                (node.uBoneIndex != INVALID_INDEX && node.uBoneIndex >= m_asset->aBoneInfo.size()))
+            {
+                return E_FAIL;
+            }
+        }
+
+        // Clips, shared with the models already loaded from the same file
+        UINT uNumClips = 0u;
+        hr = cache.Read(uNumClips);
+        if (FAILED(hr))
+            return hr;
+
+        if (m_asset->aNodeChannels.size() != m_asset->aSkeleton.size() * uNumClips)
+        {
+            return E_FAIL;
+        }
+
+        std::string filePath = m_filePath.string();
+        {
+            std::lock_guard<std::mutex> lock(sm_animationClipLibraryMutex);
+            auto library = sm_animationClipLibrary.find(filePath);
+            m_asset->aAnimationClips = library != sm_animationClipLibrary.end() ? library->second : std::vector<std::shared_ptr<AnimationClip>>();
         }
 
-        XMMATRIX globalTransformation = NodeTransform * parentTransform;
-        // XMMATRIX globalTransformation = parentTransform * NodeTransform;
-        
-        // If m_boneNameToIndexMap has the key that matches the name of the given node
-        if (m_boneNameToIndexMap.find(pszNodeName) != m_boneNameToIndexMap.end())
+        if (m_asset->aAnimationClips.size() != uNumClips)
         {
-            // Get the bone index and retrieve the boneInfo in m_aBoneInfo
-            UINT boneIndex = m_boneNameToIndexMap[pszNodeName];
+            m_asset->aAnimationClips.clear();
+            for (UINT i = 0u; i < uNumClips; ++i)
+            {
+                std::shared_ptr<AnimationClip> clip = std::make_shared<AnimationClip>();
+                hr = clip->Initialize(cache);
+                if (FAILED(hr))
+                    return hr;
+
+                m_asset->aAnimationClips.push_back(clip);
+            }
+
+            if (uNumClips > 0u)
+            {
+                std::lock_guard<std::mutex> lock(sm_animationClipLibraryMutex);
+                auto library = sm_animationClipLibrary.emplace(filePath, m_asset->aAnimationClips).first;
+                if (library->second.size() == uNumClips)
+                {
+                    m_asset->aAnimationClips = library->second;
+                }
+            }
+        }
 
-            // Set the FinalTransformation of boneInfo properly
-            m_aBoneInfo[boneIndex].FinalTransformation = m_aBoneInfo[boneIndex].OffsetMatrix * globalTransformation * m_globalInverseTransform;
-            // m_aBoneInfo[boneIndex].FinalTransformation =m_globalInverseTransform  * globalTransformation * m_aBoneInfo[boneIndex].OffsetMatrix;
+        for (UINT i = 0u; i < m_asset->aNodeChannels.size(); ++i)
+        {
+            UINT uChannelIndex = m_asset->aNodeChannels[i];
+            if (uChannelIndex != INVALID_INDEX && uChannelIndex >= m_asset->aAnimationClips[i % uNumClips]->GetNumChannels())
+            {
+                return E_FAIL;
+            }
         }
 
-        // For each child of current node
-        for (UINT i = 0; i < pNode->mNumChildren; i++)
+        m_asset->animationNameToIndexMap.clear();
+        for (UINT i = 0u; i < m_asset->aAnimationClips.size(); ++i)
         {
-            readNodeHierarchy(animationTimeTicks, pNode->mChildren[i], globalTransformation); 
+            m_asset->animationNameToIndexMap.emplace(m_asset->aAnimationClips[i]->GetName(), i);
         }
+
+        hr = m_asset->rayBvh.Restore(m_asset->aVertices.data(), static_cast<UINT>(m_asset->aVertices.size()), aRayBvhNodes, aRayBvhTriangles, aRayBvhMeshRoots);
+        if (FAILED(hr))
+            return E_FAIL;
+
+        return S_OK;
     }
 
 
@@ -1122,9 +2996,202 @@ namespace library
     void Model::reserveSpace(_In_ UINT uNumVertices, _In_ UINT uNumIndices)
     {
         // Reserve spaces of the vertices / indices vector according to the number of vertices and indices
-        m_aVertices.reserve(uNumVertices);
-        m_aIndices.reserve(uNumIndices);
+        m_asset->aVertices.reserve(uNumVertices);
+        m_asset->aIndices.reserve(uNumIndices);
         m_aBoneData.resize(uNumVertices);
     }
 
-}
\ No newline at end of file
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::sampleClip
+
+      Summary:  Fetches the pose of a clip from the shared cache and
+                spreads it over the skeleton
+
+      Args:     UINT uClipIndex
+                  Index of the clip
+                FLOAT time
+                  Time in seconds
+                AnimationPose& outPose
+                  Pose indexed by skeleton node
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::sampleClip(_In_ UINT uClipIndex, _In_ FLOAT time, _Inout_ AnimationPose& outPose)
+    {
+        scatterPose(uClipIndex, sm_poseCache.GetPose(*m_asset->aAnimationClips[uClipIndex], time), outPose);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::scatterPose
+
+      Summary:  Spreads the pose of a clip over the skeleton, the nodes
+                the clip does not animate taking their bind pose
+
+      Args:     UINT uClipIndex
+                  Index of the clip
+                const AnimationPose& clipPose
+                  Pose indexed by the channels of the clip
+                AnimationPose& outPose
+                  Pose indexed by skeleton node
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::scatterPose(_In_ UINT uClipIndex, _In_ const AnimationPose& clipPose, _Inout_ AnimationPose& outPose)
+    {
+        const UINT uNumClips = static_cast<UINT>(m_asset->aAnimationClips.size());
+
+        outPose = m_asset->bindPose;
+        for (UINT i = 0u; i < m_asset->aSkeleton.size(); ++i)
+        {
+            UINT uChannelIndex = m_asset->aNodeChannels[i * uNumClips + uClipIndex];
+            if (uChannelIndex != INVALID_INDEX)
+            {
+                outPose.aScalings[i] = clipPose.aScalings[uChannelIndex];
+                outPose.aRotations[i] = clipPose.aRotations[uChannelIndex];
+                outPose.aTranslations[i] = clipPose.aTranslations[uChannelIndex];
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::updatePoseBoneBoxes
+
+      Summary:  Moves the box of every bone by its transform, in the
+                space of the model. Each box is moved as center and
+                extents, the extents going through the absolute value
+                of the transform
+
+      Modifies: [m_aPoseBoneBoxes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Model::updatePoseBoneBoxes()
+    {
+        if (m_aTransforms.size() != m_asset->aBoneBounds.size())
+        {
+            m_aPoseBoneBoxes.clear();
+            return;
+        }
+
+        m_aPoseBoneBoxes.resize(m_aTransforms.size());
+        for (size_t uBone = 0u; uBone < m_aTransforms.size(); ++uBone)
+        {
+            const BoneBounds& boneBounds = m_asset->aBoneBounds[uBone];
+            ClusterCuller::BoneBox& boneBox = m_aPoseBoneBoxes[uBone];
+            if (boneBounds.Extents.x < 0.0f)
+            {
+                boneBox = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, -1.0f, -1.0f) };
+                continue;
+            }
+
+            const XMMATRIX& transform = m_aTransforms[uBone];
+            XMVECTOR center = XMVector3Transform(XMLoadFloat3(&boneBounds.Center), transform);
+            XMVECTOR extents = XMVectorAbs(transform.r[0]) * boneBounds.Extents.x
+                + XMVectorAbs(transform.r[1]) * boneBounds.Extents.y
+                + XMVectorAbs(transform.r[2]) * boneBounds.Extents.z;
+            XMStoreFloat3(&boneBox.Min, center - extents);
+            XMStoreFloat3(&boneBox.Max, center + extents);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::usesLods
+
+      Summary:  Returns whether the meshes get levels of detail at
+                import. A model always drawn whole returns FALSE
+
+      Returns:  BOOL
+                  TRUE if the levels of detail are built
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Model::usesLods() const
+    {
+        return TRUE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::usesMeshCache
+
+      Summary:  Returns whether the model reads and writes a mesh
+                cache. A model whose mesh initialization differs from
+                this class returns FALSE, since the cache of a file
+                holds what Model builds from it
+
+      Returns:  BOOL
+                  TRUE if the model is cached
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Model::usesMeshCache() const
+    {
+        return TRUE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Model::writeCache
+
+      Summary:  Writes the imported arrays, texture paths, skeleton and
+                compressed clips to the mesh cache of the model
+
+      Args:     const std::filesystem::path& cachePath
+                  Path to the cache file
+                UINT64 uSourceHash
+                  Hash of the model file
+                UINT uImportFlags
+                  Flags the model was imported with
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Model::writeCache(_In_ const std::filesystem::path& cachePath, _In_ UINT64 uSourceHash, _In_ UINT uImportFlags) const
+    {
+        MeshCache cache;
+
+        cache.Write(m_asset->aVertices);
+        cache.Write(m_asset->aNormalData);
+        cache.Write(m_asset->aAnimationData);
+        cache.Write(m_asset->aIndices);
+        cache.Write(m_asset->aMeshes);
+        cache.Write(m_asset->aLodMeshes);
+        cache.Write(m_asset->aClusters);
+        cache.Write(m_asset->aClusterBones);
+        cache.Write(m_asset->rayBvh.GetNodes());
+        cache.Write(m_asset->rayBvh.GetTriangles());
+        cache.Write(m_asset->rayBvh.GetMeshRoots());
+
+        cache.Write(static_cast<UINT>(m_asset->aMaterialTextures.size()));
+        for (const MaterialTextures& textures : m_asset->aMaterialTextures)
+        {
+            cache.WriteString(textures.szDiffusePath);
+            cache.WriteString(textures.szSpecularPath);
+            cache.WriteString(textures.szNormalPath);
+        }
+
+        cache.Write(m_asset->aBoneInfo);
+
+        std::vector<std::string> aBoneNames(m_asset->aBoneInfo.size());
+        for (const auto& [boneName, uBoneIndex] : m_asset->boneNameToIndexMap)
+        {
+            aBoneNames[uBoneIndex] = boneName;
+        }
+        for (const std::string& boneName : aBoneNames)
+        {
+            cache.WriteString(boneName);
+        }
+
+        cache.Write(m_asset->aBoneBounds);
+        cache.Write(m_asset->bHasUnskinnedVertices);
+
+        cache.Write(m_asset->GlobalInverseTransform);
+        cache.Write(m_asset->aSkeleton);
+        cache.Write(m_asset->aNodeChannels);
+        cache.Write(m_asset->bindPose.aScalings);
+        cache.Write(m_asset->bindPose.aRotations);
+        cache.Write(m_asset->bindPose.aTranslations);
+
+        cache.Write(static_cast<UINT>(m_asset->aAnimationClips.size()));
+        for (const std::shared_ptr<AnimationClip>& clip : m_asset->aAnimationClips)
+        {
+            clip->WriteToCache(cache);
+        }
+
+        return cache.Save(cachePath, uSourceHash, uImportFlags);
+    }
+}
@@ -12,12 +12,19 @@
 #pragma once
 
 #include "Common.h"
+#include "Model/AnimationClip.h"
+#include "Model/AnimationPoseCache.h"
+#include "Model/ClusterCuller.h"
+#include "Model/MeshAsset.h"
+#include "Model/MeshCache.h"
 #include "Renderer/DataTypes.h"
 #include "Renderer/Renderable.h"
 #include "Shader/PixelShader.h"
 #include "Shader/VertexShader.h"
 #include "Texture/Material.h"
 
+#include <mutex>
+
 struct aiScene;
 struct aiMesh;
 struct aiMaterial;
@@ -26,23 +33,27 @@ struct aiBone;
 struct aiNode;
 struct aiNodeAnim;
 
-namespace Assimp
-{
-    class Importer;
-}
-
 namespace library
 {
     /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
       Class:    Model
 
-      Summary:  Model class is a renderable from model files
+      Summary:  Model class is a renderable from model files. Load
+                imports a file, or reads its mesh cache, on the CPU,
+                and Initialize creates the GPU resources. Models of
+                the same class placed from the same file share one
+                MeshAsset
 
-      Methods:  Initialize
+      Methods:  Load
+                  Builds the geometry, skeleton and clips on the CPU,
+                  safe to call on a worker thread
+                Initialize
                   Pure virtual function that initializes the object
                 Update
                   Pure virtual function that updates the object each
                   frame
+                BenchmarkUpdate
+                  Times the updates of the played animation
                 GetVertexBuffer
                   Returns the vertex buffer
                 GetIndexBuffer
@@ -57,6 +68,68 @@ namespace library
                 GetNumIndices
                   Pure virtual function that returns the number of
                   indices
+                GetIndexFormat
+                  Returns the 16 or 32-bit format of the index buffer
+                GetNumLods
+                  Returns the number of levels of detail of the meshes
+                GetLodMesh
+                  Returns the index range of a mesh at a level of
+                  detail
+                SelectLod
+                  Picks the level of detail for the size of the model
+                  on screen
+                CullClusters
+                  Returns the index ranges of a mesh at a level of
+                  detail left after culling its clusters
+                GetClusterCuller
+                  Returns the cluster culler and its statistics
+                RefitRayBvh
+                  Refits a triangle BVH of the model of its own to
+                  posed vertices
+                GetRayBvh
+                  Returns the triangle BVH, posed if it was refit
+                SetVertexCompression
+                  Chooses the compressed vertex buffers, before
+                  Initialize
+                IsVertexCompressed
+                  Returns whether the vertex buffers are compressed
+                GetVertexStride
+                  Returns the size of a vertex in the vertex buffer
+                GetNormalStride
+                  Returns the size of a tangent frame in the normal
+                  buffer
+                GetPositionScale
+                  Returns the scale of the compressed positions
+                GetPositionOffset
+                  Returns the offset of the compressed positions
+                UploadBonePalette
+                  Packs the bone transforms of the frame into the
+                  bone palette
+                GetBonePaletteView
+                  Returns the bone palette
+                GetBindPoseVertices
+                  Returns the vertices before skinning
+                GetAnimationData
+                  Returns the bone influences of the vertices
+                GetWorldBounds
+                  Returns the world box of the current pose, built
+                  from the boxes of the bones
+                PlayAnimation
+                  Plays the named clip, crossfading from the current
+                  one
+                AddAdditiveAnimation
+                  Layers the named clip on top of the played one
+                ClearAdditiveAnimations
+                  Removes the additive layers
+                GetAnimationNameToIndexMap
+                  Returns the clips of the model by name
+                GetAnimationClips
+                  Returns the clips of the model
+                EvaluateClip
+                  Computes the bone transforms of a clip at the given
+                  time, outside of the playback
+                GetPoseCache
+                  Returns the pose cache shared by all models
                 Model
                   Constructor.
                 ~Model
@@ -64,6 +137,13 @@ namespace library
     C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
     class Model : public Renderable
     {
+    public:
+        static constexpr const UINT NUM_LODS = 4u;
+        static constexpr const FLOAT LOD_SCREEN_SIZES[NUM_LODS - 1u] = { 0.25f, 0.125f, 0.0625f };
+        static constexpr const FLOAT LOD_TRIANGLE_RATIO = 0.5f;
+        static constexpr const FLOAT LOD_MAX_ERROR = 0.01f;
+        static constexpr const UINT LOD_MIN_NUM_TRIANGLES = 64u;
+
     public:
         Model() = delete;
         Model(_In_ const std::filesystem::path& filePath);
@@ -73,19 +153,64 @@ namespace library
         Model& operator=(Model&& other) = delete;
         virtual ~Model() = default;
 
+        HRESULT Load();
         virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext);
         virtual void Update(_In_ FLOAT deltaTime) override;
+        HRESULT BenchmarkUpdate(_In_ PCSTR pszName, _In_ UINT uNumUpdates);
 
         ComPtr<ID3D11Buffer>& GetAnimationBuffer();
         ComPtr<ID3D11Buffer>& GetSkinningConstantBuffer();
+        HRESULT UploadBonePalette(_In_ ID3D11DeviceContext* pImmediateContext);
+        ComPtr<ID3D11ShaderResourceView>& GetBonePaletteView();
+        const std::vector<SimpleVertex>& GetBindPoseVertices() const;
+        const std::vector<AnimationData>& GetAnimationData() const;
 
         virtual UINT GetNumVertices() const override;
         virtual UINT GetNumIndices() const override;
+        virtual DXGI_FORMAT GetIndexFormat() const override;
+        UINT GetNumLods() const;
+        const BasicMeshEntry& GetLodMesh(_In_ UINT uMeshIndex, _In_ UINT uLod) const;
+        UINT SelectLod(_In_ const XMFLOAT3& worldMin, _In_ const XMFLOAT3& worldMax, _In_ FXMVECTOR eyePosition) const;
+        UINT CullClusters(
+            _In_ UINT uMeshIndex,
+            _In_ UINT uLod,
+            _In_ const XMMATRIX& viewProjection,
+            _In_ FXMVECTOR eyePosition,
+            _Inout_ std::vector<ClusterCuller::IndexRange>& aOutRanges
+        );
+        ClusterCuller& GetClusterCuller();
+        HRESULT RefitRayBvh(_In_ const std::vector<XMFLOAT3>& aPosedPositions);
+        virtual const TriangleBvh& GetRayBvh() const override;
+        HRESULT SetVertexCompression(_In_ BOOL bCompressVertices);
+        BOOL IsVertexCompressed() const;
+        virtual UINT GetVertexStride() const override;
+        virtual UINT GetNormalStride() const override;
+        const XMFLOAT4& GetPositionScale() const;
+        const XMFLOAT4& GetPositionOffset() const;
+
+        virtual void GetWorldBounds(_Out_ XMFLOAT3& outMin, _Out_ XMFLOAT3& outMax) const override;
+
+        HRESULT PlayAnimation(_In_ PCSTR pszClipName, _In_opt_ FLOAT fadeDuration = 0.0f);
+        HRESULT AddAdditiveAnimation(_In_ PCSTR pszClipName, _In_ FLOAT weight);
+        void ClearAdditiveAnimations();
+        const std::unordered_map<std::string, UINT>& GetAnimationNameToIndexMap() const;
+        const std::vector<std::shared_ptr<AnimationClip>>& GetAnimationClips() const;
+        HRESULT EvaluateClip(_In_ UINT uClipIndex, _In_ FLOAT time, _Out_ std::vector<XMMATRIX>& outBoneTransforms);
 
         std::vector<XMMATRIX>& GetBoneTransforms();
         const std::unordered_map<std::string, UINT>& GetBoneNameToIndexMap() const;
 
+        static AnimationPoseCache& GetPoseCache();
+
     protected:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   VertexBoneData
+
+          Summary:  Strongest bone influences of a vertex. Once the slots
+                    are full, a new influence replaces the weakest one
+                    if it is stronger. uNumBones counts every influence
+                    added, kept or not
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
         struct VertexBoneData
         {
             VertexBoneData()
@@ -99,16 +224,63 @@ namespace library
 
             void AddBoneData(_In_ UINT uBoneId, _In_ FLOAT weight)
             {
-                assert(uNumBones < ARRAYSIZE(aBoneIds));
+                UINT uSlot = uNumBones;
+                ++uNumBones;
 
-                aBoneIds[uNumBones] = uBoneId;
-                aWeights[uNumBones] = weight;
+                if (uSlot >= ARRAYSIZE(aBoneIds))
+                {
+                    uSlot = 0u;
+                    for (UINT i = 1u; i < ARRAYSIZE(aWeights); ++i)
+                    {
+                        if (aWeights[i] < aWeights[uSlot])
+                        {
+                            uSlot = i;
+                        }
+                    }
 
-                static CHAR szDebugMessage[256];
-                sprintf_s(szDebugMessage, "\t\t\tBone %d, weight: %f, index %u\n", uBoneId, weight, uNumBones);
-                OutputDebugStringA(szDebugMessage);
+                    if (weight <= aWeights[uSlot])
+                    {
+                        return;
+                    }
+                }
 
-                ++uNumBones;
+                aBoneIds[uSlot] = uBoneId;
+                aWeights[uSlot] = weight;
+            }
+
+            // Renormalizes the kept weights and quantizes them so they sum to exactly 255
+            AnimationData Pack() const
+            {
+                AnimationData data = {};
+
+                FLOAT sum = 0.0f;
+                for (UINT i = 0u; i < ARRAYSIZE(aWeights); ++i)
+                {
+                    sum += aWeights[i];
+                }
+
+                if (sum <= 0.0f)
+                {
+                    return data;
+                }
+
+                INT iTotal = 0;
+                UINT uStrongest = 0u;
+                for (UINT i = 0u; i < ARRAYSIZE(aWeights); ++i)
+                {
+                    data.aBoneIndices[i] = static_cast<UINT8>(aBoneIds[i]);
+                    data.aBoneWeights[i] = static_cast<UINT8>(aWeights[i] / sum * 255.0f + 0.5f);
+                    iTotal += data.aBoneWeights[i];
+                    if (aWeights[i] > aWeights[uStrongest])
+                    {
+                        uStrongest = i;
+                    }
+                }
+
+                // Rounding can miss 255 by a step or two, the strongest weight takes the difference
+                data.aBoneWeights[uStrongest] = static_cast<UINT8>(data.aBoneWeights[uStrongest] + 255 - iTotal);
+
+                return data;
             }
 
             UINT aBoneIds[MAX_NUM_BONES_PER_VERTEX];
@@ -116,99 +288,131 @@ namespace library
             UINT uNumBones;
         };
 
-        struct BoneInfo
-        {
-            BoneInfo() = default;
-            BoneInfo(const XMMATRIX& Offset)
-                : OffsetMatrix(Offset)
-                , FinalTransformation()
-            {
-            }
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   AnimationPlayback
 
-            XMMATRIX OffsetMatrix;
-            XMMATRIX FinalTransformation;
+          Summary:  Clip played by a layer, its time in seconds and its
+                    weight
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct AnimationPlayback
+        {
+            UINT uClipIndex;
+            FLOAT time;
+            FLOAT weight;
         };
 
+        void addPose(_Inout_ AnimationPose& pose, _In_ const AnimationPose& additivePose, _In_ const AnimationPose& referencePose, _In_ FLOAT weight);
+        void advancePlayback(_Inout_ AnimationPlayback& playback, _In_ FLOAT deltaTime);
+        HRESULT buildClusters(_In_ const std::filesystem::path& filePath);
+        HRESULT buildLods(_In_ const std::filesystem::path& filePath);
+        HRESULT buildRayBvh(_In_ const std::filesystem::path& filePath);
+        void blendPoses(_Inout_ AnimationPose& pose, _In_ const AnimationPose& otherPose, _In_ FLOAT weight);
+        void clearMeshData();
+        void composeBoneTransforms(_In_ const AnimationPose& pose, _Inout_ std::vector<XMMATRIX>& outTransforms);
         void countVerticesAndIndices(_Inout_ UINT& uOutNumVertices, _Inout_ UINT& uOutNumIndices, _In_ const aiScene* pScene);
         const aiNodeAnim* findNodeAnimOrNull(_In_ const aiAnimation* pAnimation, _In_ PCSTR pszNodeName);
-        UINT findPosition(_In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim);
-        UINT findRotation(_In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim);
-        UINT findScaling(_In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim);
         UINT getBoneId(_In_ const aiBone* pBone);
         const virtual SimpleVertex* getVertices() const override;
         virtual const WORD* getIndices() const override;
+        virtual const void* getIndexData() const override;
+        virtual UINT getNumIndexData() const override;
+        virtual const void* getNormalData() const override;
+        virtual const void* getVertexData() const override;
+        HRESULT importMeshAsset(_Out_ BOOL& bOutLoadedFromCache);
         void initAllMeshes(_In_ const aiScene* pScene);
-        HRESULT initFromScene(
+        HRESULT initAnimations(_In_ const aiScene* pScene);
+        void initBoneBounds();
+        HRESULT initFromScene(_In_ const aiScene* pScene, _In_ const std::filesystem::path& filePath);
+        HRESULT initMaterials(_In_ const aiScene* pScene);
+        HRESULT initMaterialTextures(
             _In_ ID3D11Device* pDevice,
             _In_ ID3D11DeviceContext* pImmediateContext,
-            _In_ const aiScene* pScene,
-            _In_ const std::filesystem::path& filePath
-        );
-        HRESULT initMaterials(
-            _In_ ID3D11Device* pDevice,
-            _In_ ID3D11DeviceContext* pImmediateContext,
-            _In_ const aiScene* pScene,
             _In_ const std::filesystem::path& filePath
         );
         void initMeshBones(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh);
         void initMeshSingleBone(_In_ UINT uBoneIndex, _In_ const aiBone* pBone);
+        void initSkeleton(_In_ const aiScene* pScene, _In_ const aiNode* pNode, _In_ UINT uParentIndex);
         virtual void initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh);
-        void interpolatePosition(_Inout_ XMFLOAT3& outTranslate, _In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim);
-        void interpolateRotation(_Inout_ XMVECTOR& outQuaternion, _In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim);
-        void interpolateScaling(_Inout_ XMFLOAT3& outScale, _In_ FLOAT animationTimeTicks, _In_ const aiNodeAnim* pNodeAnim);
         HRESULT loadDiffuseTexture(
             _In_ ID3D11Device* pDevice,
             _In_ ID3D11DeviceContext* pImmediateContext,
             _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
+            _In_ const std::string& szPath,
             _In_ UINT uIndex
         );
         HRESULT loadSpecularTexture(
             _In_ ID3D11Device* pDevice,
             _In_ ID3D11DeviceContext* pImmediateContext,
             _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
+            _In_ const std::string& szPath,
             _In_ UINT uIndex
         );
         HRESULT loadNormalTexture(
             _In_ ID3D11Device* pDevice,
             _In_ ID3D11DeviceContext* pImmediateContext,
             _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
+            _In_ const std::string& szPath,
             _In_ UINT uIndex
         );
         HRESULT loadTextures(
             _In_ ID3D11Device* pDevice,
             _In_ ID3D11DeviceContext* pImmediateContext,
             _In_ const std::filesystem::path& parentDirectory,
-            _In_ const aiMaterial* pMaterial,
+            _In_ const MaterialTextures& textures,
             _In_ UINT uIndex
         );
-        void readNodeHierarchy(_In_ FLOAT animationTimeTicks, _In_ const aiNode* pNode, _In_ const XMMATRIX& parentTransform);
+        HRESULT optimizeMeshes(_In_ const std::filesystem::path& filePath);
+        static void packBonePalette(_In_reads_(uNumBones) const XMMATRIX* pTransforms, _In_ UINT uNumBones, _Out_ XMFLOAT4A* pOutRows);
+        HRESULT readCache(_Inout_ MeshCache& cache);
         void reserveSpace(_In_ UINT uNumVertices, _In_ UINT uNumIndices);
+        void sampleClip(_In_ UINT uClipIndex, _In_ FLOAT time, _Inout_ AnimationPose& outPose);
+        void scatterPose(_In_ UINT uClipIndex, _In_ const AnimationPose& clipPose, _Inout_ AnimationPose& outPose);
+        void updatePoseBoneBoxes();
+        virtual BOOL usesLods() const;
+        virtual BOOL usesMeshCache() const;
+        HRESULT writeCache(_In_ const std::filesystem::path& cachePath, _In_ UINT64 uSourceHash, _In_ UINT uImportFlags) const;
 
     protected:
-        static std::unique_ptr<Assimp::Importer> sm_pImporter;
+        static constexpr const UINT INVALID_INDEX = (0xFFFFFFFF);
+        static constexpr const UINT BONE_PALETTE_ROWS = 3u;
+
+        static std::unordered_map<std::string, std::vector<std::shared_ptr<AnimationClip>>> sm_animationClipLibrary;
+        static std::mutex sm_animationClipLibraryMutex;
+        static AnimationPoseCache sm_poseCache;
 
     protected:
         std::filesystem::path m_filePath;
 
         ComPtr<ID3D11Buffer> m_animationBuffer;
         ComPtr<ID3D11Buffer> m_skinningConstantBuffer;
+        ComPtr<ID3D11Buffer> m_bonePaletteBuffer;
+        ComPtr<ID3D11ShaderResourceView> m_bonePaletteView;
 
-        std::vector<SimpleVertex> m_aVertices;
-        std::vector<AnimationData> m_aAnimationData;
-        std::vector<WORD> m_aIndices;
+        std::shared_ptr<MeshAsset> m_asset;
+        std::unique_ptr<TriangleBvh> m_posedRayBvh;
+        ClusterCuller m_clusterCuller;
+        std::vector<WORD> m_aPackedIndices;
+        BOOL m_bCompressVertices;
+        std::vector<QuantizedVertex> m_aQuantizedVertices;
+        std::vector<QuantizedNormalData> m_aQuantizedNormalData;
+        XMFLOAT4 m_positionScale;
+        XMFLOAT4 m_positionOffset;
         std::vector<VertexBoneData> m_aBoneData;
-        std::vector<BoneInfo> m_aBoneInfo;
         std::vector<XMMATRIX> m_aTransforms;
-        std::unordered_map<std::string, UINT> m_boneNameToIndexMap;
+        std::vector<XMMATRIX> m_aGlobalTransforms;
+        std::vector<ClusterCuller::BoneBox> m_aPoseBoneBoxes;
 
-        const aiScene* m_pScene;
+        AnimationPose m_pose;
+        AnimationPose m_blendPose;
+        AnimationPose m_referencePose;
 
-        float m_timeSinceLoaded;
+        AnimationPlayback m_currentPlayback;
+        AnimationPlayback m_previousPlayback;
+        FLOAT m_fadeTime;
+        FLOAT m_fadeDuration;
+        std::vector<AnimationPlayback> m_aAdditiveLayers;
 
-        XMMATRIX m_globalInverseTransform;
+        BOOL m_bIsLoaded;
 
         //BYTE m_padding[8];
     };
@@ -0,0 +1,392 @@
+#include "Model/SkinnedCrowd.h"
+#include "Statistics.h"
+
+#include <cmath>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::SkinnedCrowd
+
+      Summary:  Constructor
+
+      Args:     const std::shared_ptr<Model>& model
+                  Skinned model every instance draws
+                const XMFLOAT4& outputColor
+                  Default color of the renderable
+
+      Modifies: [m_model, m_bakedAnimation, m_aInstanceClipNames,
+                 m_aAnimationInstanceData, m_animationInstanceBuffer,
+                 m_crowdConstantBuffer, m_time].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    SkinnedCrowd::SkinnedCrowd(_In_ const std::shared_ptr<Model>& model, _In_ const XMFLOAT4& outputColor)
+        : InstancedRenderable(outputColor)
+        , m_model(model)
+        , m_bakedAnimation()
+        , m_aInstanceClipNames()
+        , m_aAnimationInstanceData()
+        , m_animationInstanceBuffer()
+        , m_crowdConstantBuffer()
+        , m_time(0.0f)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::Initialize
+
+      Summary:  Initializes the model unless the scene did, bakes its
+                clips, shares its buffers and materials, and creates
+                the instance buffers
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffers
+                ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to set buffers
+
+      Modifies: [m_vertexBuffer, m_indexBuffer, m_normalBuffer,
+                 m_constantBuffer, m_aMeshes, m_aMaterials,
+                 m_bHasNormalMap, m_bakedAnimation,
+                 m_aAnimationInstanceData, m_instanceBuffer,
+                 m_animationInstanceBuffer, m_crowdConstantBuffer].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG for an unknown clip name
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT SkinnedCrowd::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+    {
+        if (m_model == nullptr || m_aInstanceData.empty())
+        {
+            return E_FAIL;
+        }
+
+        // The crowd vertex shader reads the float vertex layout
+        if (m_model->IsVertexCompressed())
+        {
+            return E_INVALIDARG;
+        }
+
+        // The model need not be drawn on its own
+        HRESULT hr = S_OK;
+        if (m_model->GetVertexBuffer() == nullptr)
+        {
+            hr = m_model->Initialize(pDevice, pImmediateContext);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        hr = m_bakedAnimation.Bake(*m_model);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = m_bakedAnimation.Initialize(pDevice);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (Statistics::IsLogging())
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "SkinnedCrowd: %u clips of %u bones baked into %u frames, %zu bytes in %.2f ms, max error %.5f\n",
+                m_bakedAnimation.GetNumClips(),
+                m_bakedAnimation.GetNumBones(),
+                m_bakedAnimation.GetNumFrames(),
+                m_bakedAnimation.GetMemorySize(),
+                m_bakedAnimation.GetBakeTime(),
+                m_bakedAnimation.GetMaxError()
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+
+        // Share the geometry and the materials of the model
+        m_vertexBuffer = m_model->GetVertexBuffer();
+        m_indexBuffer = m_model->GetIndexBuffer();
+        m_normalBuffer = m_model->GetNormalBuffer();
+        m_bHasNormalMap = m_model->HasNormalMap();
+
+        m_aMeshes.clear();
+        for (UINT i = 0u; i < m_model->GetNumMeshes(); ++i)
+        {
+            m_aMeshes.push_back(m_model->GetMesh(i));
+        }
+
+        m_aMaterials.clear();
+        for (UINT i = 0u; i < m_model->GetNumMaterials(); ++i)
+        {
+            AddMaterial(m_model->GetMaterial(i));
+        }
+
+        // Resolve the clip of every instance into its rows of the baked texture
+        const std::unordered_map<std::string, UINT>& animationNameToIndexMap = m_model->GetAnimationNameToIndexMap();
+        for (SIZE_T i = 0u; i < m_aInstanceClipNames.size(); ++i)
+        {
+            auto clip = animationNameToIndexMap.find(m_aInstanceClipNames[i]);
+            if (clip == animationNameToIndexMap.end())
+            {
+                return E_INVALIDARG;
+            }
+
+            const BakedClip& bakedClip = m_bakedAnimation.GetClip(clip->second);
+            FLOAT timeOffset = bakedClip.duration > 0.0f ? std::fmod(m_aAnimationInstanceData[i].timeOffset, bakedClip.duration) : 0.0f;
+
+            m_aAnimationInstanceData[i] =
+            {
+                .uFrameOffset = bakedClip.uFrameOffset,
+                .uNumFrames = bakedClip.uNumFrames,
+                .frameRate = bakedClip.frameRate,
+                .timeOffset = timeOffset < 0.0f ? timeOffset + bakedClip.duration : timeOffset
+            };
+        }
+
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(CBChangesEveryFrame),
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = 0u
+        };
+        hr = pDevice->CreateBuffer(&bd, nullptr, m_constantBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        bd.ByteWidth = sizeof(CBCrowd);
+        hr = pDevice->CreateBuffer(&bd, nullptr, m_crowdConstantBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = initializeInstance(pDevice);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        // The clips of the instances never change, only the crowd time does
+        bd =
+        {
+            .ByteWidth = static_cast<UINT>(sizeof(CrowdInstanceData) * m_aAnimationInstanceData.size()),
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+            .CPUAccessFlags = 0u
+        };
+        D3D11_SUBRESOURCE_DATA initData =
+        {
+            .pSysMem = m_aAnimationInstanceData.data(),
+            .SysMemPitch = 0u,
+            .SysMemSlicePitch = 0u
+        };
+        hr = pDevice->CreateBuffer(&bd, &initData, m_animationInstanceBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::Update
+
+      Summary:  Advances the crowd time, the instances add their own
+                offsets on the GPU
+
+      Args:     FLOAT deltaTime
+                  Time difference of a frame
+
+      Modifies: [m_time].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void SkinnedCrowd::Update(_In_ FLOAT deltaTime)
+    {
+        m_time += deltaTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::AddInstance
+
+      Summary:  Adds an instance playing the named clip, before
+                Initialize
+
+      Args:     const XMMATRIX& transformation
+                  Transform of the instance
+                PCSTR pszClipName
+                  Name of the clip the instance loops
+                FLOAT timeOffset
+                  Time of the clip at the start, in seconds
+
+      Modifies: [m_aInstanceData, m_aInstanceClipNames,
+                 m_aAnimationInstanceData].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void SkinnedCrowd::AddInstance(_In_ const XMMATRIX& transformation, _In_ PCSTR pszClipName, _In_ FLOAT timeOffset)
+    {
+        m_aInstanceData.push_back({ .Transformation = transformation });
+        m_aInstanceClipNames.push_back(pszClipName);
+        m_aAnimationInstanceData.push_back({ 0u, 0u, 0.0f, timeOffset });
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetModel
+
+      Summary:  Returns the model the crowd is made of
+
+      Returns:  std::shared_ptr<Model>&
+                  Model
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::shared_ptr<Model>& SkinnedCrowd::GetModel()
+    {
+        return m_model;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetAnimationBuffer
+
+      Summary:  Returns the bone indices and weights of the model
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Animation buffer of the model
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& SkinnedCrowd::GetAnimationBuffer()
+    {
+        return m_model->GetAnimationBuffer();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetAnimationInstanceBuffer
+
+      Summary:  Returns the clip rows and time offsets of the instances
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Per-instance animation buffer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& SkinnedCrowd::GetAnimationInstanceBuffer()
+    {
+        return m_animationInstanceBuffer;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetCrowdConstantBuffer
+
+      Summary:  Returns the constant buffer of the crowd time
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Crowd constant buffer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& SkinnedCrowd::GetCrowdConstantBuffer()
+    {
+        return m_crowdConstantBuffer;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetBakedAnimation
+
+      Summary:  Returns the baked clips
+
+      Returns:  const BakedAnimation&
+                  Baked clips
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const BakedAnimation& SkinnedCrowd::GetBakedAnimation() const
+    {
+        return m_bakedAnimation;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetTime
+
+      Summary:  Returns the crowd time
+
+      Returns:  FLOAT
+                  Time in seconds since the crowd started
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT SkinnedCrowd::GetTime() const
+    {
+        return m_time;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetNumVertices
+
+      Summary:  Returns the number of vertices of the model
+
+      Returns:  UINT
+                  Number of vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT SkinnedCrowd::GetNumVertices() const
+    {
+        return m_model->GetNumVertices();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetNumIndices
+
+      Summary:  Returns the number of indices of the model
+
+      Returns:  UINT
+                  Number of indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT SkinnedCrowd::GetNumIndices() const
+    {
+        return m_model->GetNumIndices();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::GetIndexFormat
+
+      Summary:  Returns the format of the index buffer of the model,
+                which the crowd draws with
+
+      Returns:  DXGI_FORMAT
+                  Format of the indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    DXGI_FORMAT SkinnedCrowd::GetIndexFormat() const
+    {
+        return m_model->GetIndexFormat();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::getVertices
+
+      Summary:  The vertices stay in the buffer of the model
+
+      Returns:  const SimpleVertex*
+                  nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const SimpleVertex* SkinnedCrowd::getVertices() const
+    {
+        return nullptr;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   SkinnedCrowd::getIndices
+
+      Summary:  The indices stay in the buffer of the model
+
+      Returns:  const WORD*
+                  nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const WORD* SkinnedCrowd::getIndices() const
+    {
+        return nullptr;
+    }
+}
@@ -0,0 +1,107 @@
+/*+===================================================================
+  File:      SKINNEDCROWD.H
+
+  Summary:   SkinnedCrowd header file contains declarations of
+             SkinnedCrowd class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: SkinnedCrowd
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Model/BakedAnimation.h"
+#include "Model/Model.h"
+#include "Renderer/DataTypes.h"
+#include "Renderer/InstancedRenderable.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    SkinnedCrowd
+
+      Summary:  Instances of a skinned model animated on the GPU. The
+                clips of the model are baked into a texture once, and
+                every instance carries its transform, the rows of its
+                clip and a time offset, so the whole crowd is drawn
+                with one instanced draw per mesh and only the crowd
+                time is uploaded each frame. The geometry, the bone
+                weights and the materials are shared with the model,
+                which the crowd initializes unless it is also part of
+                the scene
+
+      Methods:  Initialize
+                  Bakes the clips and creates the buffers
+                Update
+                  Advances the crowd time
+                AddInstance
+                  Adds an instance playing the named clip
+                GetModel
+                  Returns the model the crowd is made of
+                GetAnimationBuffer
+                  Returns the bone weights of the model
+                GetAnimationInstanceBuffer
+                  Returns the per-instance clip rows and time offsets
+                GetCrowdConstantBuffer
+                  Returns the constant buffer of the crowd time
+                GetBakedAnimation
+                  Returns the baked clips
+                GetTime
+                  Returns the crowd time
+                GetNumVertices
+                  Returns the number of vertices of the model
+                GetNumIndices
+                  Returns the number of indices of the model
+                GetIndexFormat
+                  Returns the format of the index buffer of the model
+                SkinnedCrowd
+                  Constructor.
+                ~SkinnedCrowd
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class SkinnedCrowd : public InstancedRenderable
+    {
+    public:
+        SkinnedCrowd() = delete;
+        SkinnedCrowd(_In_ const std::shared_ptr<Model>& model, _In_ const XMFLOAT4& outputColor);
+        SkinnedCrowd(const SkinnedCrowd& other) = delete;
+        SkinnedCrowd(SkinnedCrowd&& other) = delete;
+        SkinnedCrowd& operator=(const SkinnedCrowd& other) = delete;
+        SkinnedCrowd& operator=(SkinnedCrowd&& other) = delete;
+        ~SkinnedCrowd() = default;
+
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) override;
+        virtual void Update(_In_ FLOAT deltaTime) override;
+
+        void AddInstance(_In_ const XMMATRIX& transformation, _In_ PCSTR pszClipName, _In_ FLOAT timeOffset);
+
+        std::shared_ptr<Model>& GetModel();
+        ComPtr<ID3D11Buffer>& GetAnimationBuffer();
+        ComPtr<ID3D11Buffer>& GetAnimationInstanceBuffer();
+        ComPtr<ID3D11Buffer>& GetCrowdConstantBuffer();
+        const BakedAnimation& GetBakedAnimation() const;
+        FLOAT GetTime() const;
+
+        virtual UINT GetNumVertices() const override;
+        virtual UINT GetNumIndices() const override;
+        virtual DXGI_FORMAT GetIndexFormat() const override;
+
+    protected:
+        const virtual SimpleVertex* getVertices() const override;
+        virtual const WORD* getIndices() const override;
+
+    private:
+        std::shared_ptr<Model> m_model;
+        BakedAnimation m_bakedAnimation;
+
+        std::vector<std::string> m_aInstanceClipNames;
+        std::vector<CrowdInstanceData> m_aAnimationInstanceData;
+        ComPtr<ID3D11Buffer> m_animationInstanceBuffer;
+        ComPtr<ID3D11Buffer> m_crowdConstantBuffer;
+
+        FLOAT m_time;
+    };
+}
@@ -0,0 +1,229 @@
+#include "Model/VertexQuantizer.h"
+
+#include <DirectXPackedVector.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace library
+{
+    namespace
+    {
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: encodeOctahedral
+
+          Summary:  Projects a direction onto the octahedron and unfolds
+                    the lower half over the upper one, so it is two
+                    coordinates in [-1, 1]. A zero direction, a vertex
+                    without tangent, maps to the center
+
+          Args:     const XMFLOAT3& direction
+                      Direction to encode, need not be unit length
+
+          Returns:  XMFLOAT2
+                      Octahedral coordinates
+        -----------------------------------------------------------------F-F*/
+        XMFLOAT2 encodeOctahedral(_In_ const XMFLOAT3& direction)
+        {
+            const FLOAT length = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+            if (length <= FLT_EPSILON)
+            {
+                return XMFLOAT2(0.0f, 0.0f);
+            }
+
+            XMFLOAT2 encoded(direction.x / length, direction.y / length);
+            if (direction.z < 0.0f)
+            {
+                const XMFLOAT2 folded = encoded;
+                encoded.x = (1.0f - fabsf(folded.y)) * (folded.x >= 0.0f ? 1.0f : -1.0f);
+                encoded.y = (1.0f - fabsf(folded.x)) * (folded.y >= 0.0f ? 1.0f : -1.0f);
+            }
+
+            return encoded;
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: packSnorm16
+
+          Summary:  Rounds a value in [-1, 1] to SNORM16
+
+          Args:     FLOAT value
+                      Value to pack
+
+          Returns:  INT16
+                      Packed value
+        -----------------------------------------------------------------F-F*/
+        INT16 packSnorm16(_In_ FLOAT value)
+        {
+            return static_cast<INT16>(lroundf(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: packUnorm
+
+          Summary:  Rounds a value in [0, 1] to an unsigned normalized
+                    integer of uMaxValue steps
+
+          Args:     FLOAT value
+                      Value to pack
+                    UINT uMaxValue
+                      Largest packed value, 2^bits - 1
+
+          Returns:  UINT
+                      Packed value
+        -----------------------------------------------------------------F-F*/
+        UINT packUnorm(_In_ FLOAT value, _In_ UINT uMaxValue)
+        {
+            return static_cast<UINT>(lroundf(std::clamp(value, 0.0f, 1.0f) * static_cast<FLOAT>(uMaxValue)));
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VertexQuantizer::VertexQuantizer
+
+      Summary:  Constructor
+
+      Modifies: [m_positionScale, m_positionOffset].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VertexQuantizer::VertexQuantizer()
+        : m_positionScale(1.0f, 1.0f, 1.0f, 0.0f)
+        , m_positionOffset(0.0f, 0.0f, 0.0f, 0.0f)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VertexQuantizer::Quantize
+
+      Summary:  Compresses the vertices and the tangent frames. The
+                box of the positions is measured first, so every
+                position uses the 16 bits over the extent of the model
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices
+                const NormalData* pNormalData
+                  Tangents and bitangents of the vertices, or nullptr
+                UINT uNumVertices
+                  Number of vertices
+                std::vector<QuantizedVertex>& outVertices
+                  Compressed vertices
+                std::vector<QuantizedNormalData>& outNormalData
+                  Compressed tangent frames
+
+      Modifies: [m_positionScale, m_positionOffset].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG without vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VertexQuantizer::Quantize(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_reads_opt_(uNumVertices) const NormalData* pNormalData,
+        _In_ UINT uNumVertices,
+        _Out_ std::vector<QuantizedVertex>& outVertices,
+        _Out_ std::vector<QuantizedNormalData>& outNormalData
+    )
+    {
+        outVertices.clear();
+        outNormalData.clear();
+
+        if (pVertices == nullptr || uNumVertices == 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        XMVECTOR boundsMin = XMLoadFloat3(&pVertices[0].Position);
+        XMVECTOR boundsMax = boundsMin;
+        for (UINT i = 1u; i < uNumVertices; ++i)
+        {
+            XMVECTOR position = XMLoadFloat3(&pVertices[i].Position);
+            boundsMin = XMVectorMin(boundsMin, position);
+            boundsMax = XMVectorMax(boundsMax, position);
+        }
+
+        XMFLOAT3 offset, extent;
+        XMStoreFloat3(&offset, boundsMin);
+        XMStoreFloat3(&extent, XMVectorSubtract(boundsMax, boundsMin));
+        m_positionOffset = XMFLOAT4(offset.x, offset.y, offset.z, 0.0f);
+        m_positionScale = XMFLOAT4(extent.x, extent.y, extent.z, 0.0f);
+
+        // A flat axis keeps every position at the offset
+        const XMFLOAT3 inverseExtent(
+            extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 1.0f / extent.z : 0.0f
+        );
+
+        outVertices.resize(uNumVertices);
+        outNormalData.resize(uNumVertices);
+        for (UINT i = 0u; i < uNumVertices; ++i)
+        {
+            const SimpleVertex& vertex = pVertices[i];
+            QuantizedVertex& quantized = outVertices[i];
+
+            quantized.aPosition[0] = static_cast<UINT16>(packUnorm((vertex.Position.x - offset.x) * inverseExtent.x, 0xFFFFu));
+            quantized.aPosition[1] = static_cast<UINT16>(packUnorm((vertex.Position.y - offset.y) * inverseExtent.y, 0xFFFFu));
+            quantized.aPosition[2] = static_cast<UINT16>(packUnorm((vertex.Position.z - offset.z) * inverseExtent.z, 0xFFFFu));
+            quantized.aPosition[3] = 0xFFFFu;
+
+            quantized.aTexCoord[0] = PackedVector::XMConvertFloatToHalf(vertex.TexCoord.x);
+            quantized.aTexCoord[1] = PackedVector::XMConvertFloatToHalf(vertex.TexCoord.y);
+
+            const XMFLOAT2 normal = encodeOctahedral(vertex.Normal);
+            quantized.aNormal[0] = packSnorm16(normal.x);
+            quantized.aNormal[1] = packSnorm16(normal.y);
+
+            if (pNormalData == nullptr)
+            {
+                outNormalData[i].uTangentFrame = 0u;
+                continue;
+            }
+
+            // The bitangent is rebuilt from the normal and the tangent, only its handedness is kept
+            const NormalData& normalData = pNormalData[i];
+            const XMFLOAT2 tangent = encodeOctahedral(normalData.Tangent);
+            const FLOAT handedness = XMVectorGetX(XMVector3Dot(
+                XMVector3Cross(XMLoadFloat3(&vertex.Normal), XMLoadFloat3(&normalData.Tangent)),
+                XMLoadFloat3(&normalData.Bitangent)
+            ));
+
+            outNormalData[i].uTangentFrame =
+                packUnorm(tangent.x * 0.5f + 0.5f, 0x3FFu) |
+                (packUnorm(tangent.y * 0.5f + 0.5f, 0x3FFu) << 10u) |
+                ((handedness < 0.0f ? 0u : 3u) << 30u);
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VertexQuantizer::GetPositionScale
+
+      Summary:  Returns the extent of the box of the positions, a
+                UNORM16 position times the scale plus the offset is the
+                position in model space
+
+      Returns:  const XMFLOAT4&
+                  Extent of the box, w is 0
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const XMFLOAT4& VertexQuantizer::GetPositionScale() const
+    {
+        return m_positionScale;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VertexQuantizer::GetPositionOffset
+
+      Summary:  Returns the minimum corner of the box of the positions
+
+      Returns:  const XMFLOAT4&
+                  Minimum corner of the box, w is 0
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const XMFLOAT4& VertexQuantizer::GetPositionOffset() const
+    {
+        return m_positionOffset;
+    }
+}
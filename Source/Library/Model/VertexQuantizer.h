@@ -0,0 +1,70 @@
+/*+===================================================================
+  File:      VERTEXQUANTIZER.H
+
+  Summary:   VertexQuantizer header file contains declarations of
+             VertexQuantizer class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: VertexQuantizer
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VertexQuantizer
+
+      Summary:  Compresses the SimpleVertex and NormalData streams of a
+                model into QuantizedVertex and QuantizedNormalData,
+                56 bytes of a vertex into 20. Positions are UNORM16 in
+                the box of the vertices, which the vertex shader undoes
+                with the position scale and offset. Texture
+                coordinates are halves. The normal and the tangent are
+                folded onto the octahedron, and the bitangent is
+                rebuilt in the shader from the cross product and the
+                sign kept with the tangent
+
+      Methods:  Quantize
+                  Compresses the vertices and the tangent frames
+                GetPositionScale
+                  Returns the extent of the box of the positions
+                GetPositionOffset
+                  Returns the minimum corner of the box of the
+                  positions
+                VertexQuantizer
+                  Constructor.
+                ~VertexQuantizer
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VertexQuantizer
+    {
+    public:
+        VertexQuantizer();
+        VertexQuantizer(const VertexQuantizer& other) = delete;
+        VertexQuantizer(VertexQuantizer&& other) = delete;
+        VertexQuantizer& operator=(const VertexQuantizer& other) = delete;
+        VertexQuantizer& operator=(VertexQuantizer&& other) = delete;
+        ~VertexQuantizer() = default;
+
+        HRESULT Quantize(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_reads_opt_(uNumVertices) const NormalData* pNormalData,
+            _In_ UINT uNumVertices,
+            _Out_ std::vector<QuantizedVertex>& outVertices,
+            _Out_ std::vector<QuantizedNormalData>& outNormalData
+        );
+
+        const XMFLOAT4& GetPositionScale() const;
+        const XMFLOAT4& GetPositionOffset() const;
+
+    private:
+        XMFLOAT4 m_positionScale;
+        XMFLOAT4 m_positionOffset;
+    };
+}
@@ -0,0 +1,97 @@
+/*+===================================================================
+  File:      PARALLELFOR.H
+
+  Summary:   ParallelFor header file contains the thread helpers the
+             library builds and updates its data with, used for the
+             lab samples of Game Graphics Programming course.
+
+  Functions: GetNumParallelThreads, ParallelFor
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace library
+{
+    /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+      Function: GetNumParallelThreads
+
+      Summary:  Returns the number of threads a ParallelFor over some
+                jobs runs on, never more than the jobs
+
+      Args:     UINT uNumJobs
+                  Number of jobs
+                UINT uNumThreads
+                  Number of threads asked for, 0 for the hardware
+                  concurrency
+
+      Returns:  UINT
+                  Number of threads, at least 1
+    F---F---F---F---F---F---F---F---F---F---F---F---F---F---F---F---F-F*/
+    inline UINT GetNumParallelThreads(_In_ UINT uNumJobs, _In_opt_ UINT uNumThreads = 0u)
+    {
+        const UINT uMaxNumThreads = uNumThreads > 0u ? uNumThreads : std::max(std::thread::hardware_concurrency(), 1u);
+
+        return std::min(uMaxNumThreads, std::max(uNumJobs, 1u));
+    }
+
+
+    /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+      Function: ParallelFor
+
+      Summary:  Runs job(uJob, uThread) for every job on the calling
+                thread and GetNumParallelThreads - 1 worker threads,
+                and waits for all of them. The threads take the jobs
+                in order from a shared counter, so uneven jobs balance
+                out, and uThread lets a job keep scratch memory of its
+                thread
+
+      Args:     UINT uNumJobs
+                  Number of jobs
+                UINT uNumThreads
+                  Number of threads asked for, 0 for the hardware
+                  concurrency
+                const Job& job
+                  Callable taking the index of the job and of the
+                  thread
+
+      Returns:  UINT
+                  Number of threads the jobs ran on
+    F---F---F---F---F---F---F---F---F---F---F---F---F---F---F---F---F-F*/
+    template <class Job>
+    UINT ParallelFor(_In_ UINT uNumJobs, _In_ UINT uNumThreads, _In_ const Job& job)
+    {
+        const UINT uNumJobThreads = GetNumParallelThreads(uNumJobs, uNumThreads);
+
+        std::atomic<UINT> uNextJob = 0u;
+        auto run = [&](UINT uThread)
+        {
+            for (UINT uJob = uNextJob++; uJob < uNumJobs; uJob = uNextJob++)
+            {
+                job(uJob, uThread);
+            }
+        };
+
+        std::vector<std::thread> aThreads;
+        aThreads.reserve(uNumJobThreads - 1u);
+        for (UINT i = 1u; i < uNumJobThreads; ++i)
+        {
+            aThreads.emplace_back(run, i);
+        }
+
+        run(0u);
+
+        for (std::thread& thread : aThreads)
+        {
+            thread.join();
+        }
+
+        return uNumJobThreads;
+    }
+}
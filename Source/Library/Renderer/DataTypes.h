@@ -6,7 +6,7 @@ namespace library
 {
 #define NUM_LIGHTS (1)
 #define MAX_NUM_BONES (256)
-#define MAX_NUM_BONES_PER_VERTEX (16)
+#define MAX_NUM_BONES_PER_VERTEX (4)
 
 	struct SimpleVertex
 	{
@@ -20,11 +20,27 @@ namespace library
 		XMMATRIX Transformation;
 	};
 
+	struct CrowdInstanceData
+	{
+		UINT uFrameOffset;
+		UINT uNumFrames;
+		FLOAT frameRate;
+		FLOAT timeOffset;
+	};
+
+	struct TerrainInstanceData
+	{
+		XMFLOAT4 OffsetScale;
+		XMFLOAT4 MorphConstants;
+	};
+
+	// Bone indices fit in a byte as a model has at most MAX_NUM_BONES bones, weights are UNORM8 summing to 255
 	struct AnimationData
 	{
-		XMUINT4 aBoneIndices;
-		XMFLOAT4 aBoneWeights;
+		UINT8 aBoneIndices[MAX_NUM_BONES_PER_VERTEX];
+		UINT8 aBoneWeights[MAX_NUM_BONES_PER_VERTEX];
 	};
+	static_assert(sizeof(AnimationData) == 8, "AnimationData must stay an 8-byte vertex stream");
 
 	struct NormalData
 	{
@@ -32,6 +48,22 @@ namespace library
 		XMFLOAT3 Bitangent;
 	};
 
+	// Compressed SimpleVertex, the position is UNORM16 in the box of the model with w at 1, the texture coordinate is half and the normal is octahedral in SNORM16
+	struct QuantizedVertex
+	{
+		UINT16 aPosition[4];
+		UINT16 aTexCoord[2];
+		INT16 aNormal[2];
+	};
+	static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must stay a 16-byte vertex stream");
+
+	// Compressed NormalData, an octahedral tangent in the R10G10 bits and the sign of the bitangent in the A2 bits
+	struct QuantizedNormalData
+	{
+		UINT uTangentFrame;
+	};
+	static_assert(sizeof(QuantizedNormalData) == 4, "QuantizedNormalData must stay a 4-byte vertex stream");
+
 	struct CBChangeOnCameraMovement
 	{
 		XMMATRIX View;
@@ -48,11 +80,20 @@ namespace library
 		XMMATRIX World;
 		XMFLOAT4 OutputColor;
 		BOOL HasNormalMap;
+		UINT aPadding[3];
+		XMFLOAT4 PositionScale;
+		XMFLOAT4 PositionOffset;
 	};
 
 	struct CBSkinning
 	{
-		XMMATRIX BoneTransforms[MAX_NUM_BONES];
+		UINT NumBones;
+		UINT aPadding[3];
+	};
+
+	struct CBCrowd
+	{
+		XMFLOAT4 Time;
 	};
 
 	struct CBLights
@@ -75,4 +116,16 @@ namespace library
 		XMMATRIX Projection;
 		BOOL IsVoxel;
 	};
+
+	struct CBTerrain
+	{
+		XMFLOAT4 GridOrigin;
+		XMFLOAT4 GridDimensions;
+	};
+
+	struct CBHorizonMap
+	{
+		XMFLOAT4 GridOrigin;
+		XMFLOAT4 GridDimensions;
+	};
 } 
\ No newline at end of file
@@ -120,4 +120,20 @@ namespace library
         return hr;
     }
 
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   InstancedRenderable::usesRayBvh
+
+      Summary:  A BVH of the base geometry placed by the world matrix
+                would miss every instance transform, so instanced
+                renderables have none and IntersectRays reports no hits
+
+      Returns:  BOOL
+                  FALSE
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL InstancedRenderable::usesRayBvh() const
+    {
+        return FALSE;
+    }
+
 }
\ No newline at end of file
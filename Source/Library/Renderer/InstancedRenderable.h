@@ -31,6 +31,8 @@ namespace library
                   Returns the number of instance data
                 initializeInstance
                   Initialize the instance buffer
+                usesRayBvh
+                  Returns FALSE, rays are not traced per instance
                 InstancedRenderable
                   Constructor.
                 ~InstancedRenderable
@@ -63,6 +65,7 @@ namespace library
         const WORD* getIndices() const override = 0;
 
         virtual HRESULT initializeInstance(_In_ ID3D11Device* pDevice);
+        virtual BOOL usesRayBvh() const override;
 
     protected:
         ComPtr<ID3D11Buffer> m_instanceBuffer;
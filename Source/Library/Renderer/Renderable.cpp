@@ -1,4 +1,8 @@
 #include "Renderer/Renderable.h"
+#include "Renderer/TangentGenerator.h"
+#include "Statistics.h"
+
+#include <cfloat>
 
 #include "assimp/Importer.hpp"	// C++ importer interface
 #include "assimp/scene.h"		// output data structure
@@ -6,37 +10,82 @@
 
 namespace library
 {
+    namespace
+    {
+        constexpr const UINT64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+        constexpr const UINT64 FNV_PRIME = 1099511628211ull;
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: hashBytes
+
+          Summary:  Folds bytes into a 64-bit FNV-1a hash one by one,
+                    as MeshCache::HashFile does, so every bit reaches
+                    the whole hash
+
+          Args:     const void* pData
+                      Bytes to hash
+                    SIZE_T uSize
+                      Number of bytes
+                    UINT64 uHash
+                      Hash so far
+
+          Returns:  UINT64
+                      Hash with the bytes
+        F---F---F---F---F---F---F---F---F---F---F---F---F---F---F---F---F-F*/
+        UINT64 hashBytes(_In_reads_bytes_(uSize) const void* pData, _In_ SIZE_T uSize, _In_ UINT64 uHash)
+        {
+            const BYTE* pBytes = static_cast<const BYTE*>(pData);
+            for (SIZE_T i = 0u; i < uSize; ++i)
+            {
+                uHash = (uHash ^ pBytes[i]) * FNV_PRIME;
+            }
+
+            return uHash;
+        }
+    }
+
+    std::unordered_map<UINT64, std::weak_ptr<Renderable::SharedGeometry>> Renderable::sm_geometryLibrary;
+    std::mutex Renderable::sm_geometryLibraryMutex;
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::Renderable
       Summary:  Constructor
       Args:     const XMFLOAT4& outputColor
                   Default color to shader the renderable
       Modifies: [m_vertexBuffer, m_indexBuffer, m_constantBuffer,
-                 m_normalBuffer, m_aMeshes, m_aMaterials, m_vertexShader,
+                 m_normalBuffer, m_geometry, m_aMeshes, m_aMaterials, m_vertexShader,
                  m_pixelShader, m_outputColor, m_world, m_bHasNormalMap
-                 m_aNormalData].
+                 m_aNormalData, m_rayBvh, m_boundsMin, m_boundsMax].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     Renderable::Renderable(_In_ const XMFLOAT4& outputColor)
         : m_vertexBuffer(nullptr)
         , m_indexBuffer(nullptr)
         , m_constantBuffer(nullptr)
         , m_normalBuffer(nullptr)
+        , m_geometry(nullptr)
         , m_aMeshes(std::vector<BasicMeshEntry>())
         , m_aMaterials(std::vector<std::shared_ptr<Material>>())
         , m_aNormalData(std::vector<NormalData>())
+        , m_rayBvh()
         , m_vertexShader(nullptr)
         , m_pixelShader(nullptr)
         , m_outputColor(outputColor)
         , m_padding()
         , m_world(XMMatrixIdentity())
         , m_bHasNormalMap()
+        , m_boundsMin()
+        , m_boundsMax()
     {
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::initialize
-      Summary:  Initializes the buffers and the world matrix
+      Summary:  Initializes the buffers and the world matrix. The
+                vertex, normal and index buffers are taken from the
+                geometry library when a renderable with the same data
+                made them before, and made immutable and added to it
+                otherwise
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
@@ -44,51 +93,130 @@ namespace library
                 PCWSTR pszTextureFileName
                   File name of the texture to usen
       Modifies: [m_vertexBuffer, m_normalBuffer, m_indexBuffer
-                 m_constantBuffer].
+                 m_geometry, m_aNormalData, m_constantBuffer,
+                 m_boundsMin, m_boundsMax, m_rayBvh,
+                 sm_geometryLibrary].
       Returns:  HRESULT
                   Status code
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     HRESULT Renderable::initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
     { 
         HRESULT hr = S_OK;
-        
-        // Create vertex buffer
-        D3D11_BUFFER_DESC bufferDesc = {};
-        bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        bufferDesc.ByteWidth = sizeof(SimpleVertex) * GetNumVertices();
-        bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        bufferDesc.CPUAccessFlags = 0;
 
-        D3D11_SUBRESOURCE_DATA InitData = {};
-        InitData.pSysMem = getVertices();
-        hr = pDevice->CreateBuffer(&bufferDesc, &InitData, m_vertexBuffer.GetAddressOf());
-        if (FAILED(hr))
-            return hr;
+        const UINT64 uGeometryHash = hashGeometry();
+        {
+            std::lock_guard<std::mutex> lock(sm_geometryLibraryMutex);
+            auto geometry = sm_geometryLibrary.find(uGeometryHash);
+            m_geometry = geometry != sm_geometryLibrary.end() ? geometry->second.lock() : nullptr;
+        }
 
-        // Create vertex buffer (m_normalBuffer)
-        // if (HasTexture() && m_aNormalData.empty()) TODO?
-        if (m_aNormalData.empty())
+        // The hash only finds the candidate, the data decides
+        if (m_geometry && !isSameGeometry(*m_geometry))
         {
-            // compute tangent/bitangent vectors manually
-            calculateNormalMapVectors();
+            m_geometry.reset();
         }
-        bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        bufferDesc.ByteWidth = sizeof(NormalData) * GetNumVertices();
-        bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        bufferDesc.CPUAccessFlags = 0;
-        hr = pDevice->CreateBuffer(&bufferDesc, &InitData, m_normalBuffer.GetAddressOf());
-        if (FAILED(hr))
-            return hr;
 
-        // Create index buffer;
-        bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        bufferDesc.ByteWidth = sizeof(WORD) * GetNumIndices(); 
-        bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-        bufferDesc.CPUAccessFlags = 0;
-        InitData.pSysMem = getIndices();
-        hr = pDevice->CreateBuffer(&bufferDesc, &InitData, m_indexBuffer.GetAddressOf());
-        if (FAILED(hr))
-            return hr;
+        D3D11_BUFFER_DESC bufferDesc = {};
+        if (m_geometry)
+        {
+            m_vertexBuffer = m_geometry->vertexBuffer;
+            m_normalBuffer = m_geometry->normalBuffer;
+            m_indexBuffer = m_geometry->indexBuffer;
+            m_boundsMin = m_geometry->BoundsMin;
+            m_boundsMax = m_geometry->BoundsMax;
+        }
+        else
+        {
+            // Given tangent frames are part of the data to compare, generated ones follow from the rest
+            const BOOL bHasNormalData = !m_aNormalData.empty();
+
+            // Create vertex buffer, immutable as other renderables may share it
+            bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+            bufferDesc.ByteWidth = GetVertexStride() * GetNumVertices();
+            bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            bufferDesc.CPUAccessFlags = 0;
+
+            D3D11_SUBRESOURCE_DATA InitData = {};
+            InitData.pSysMem = getVertexData();
+            hr = pDevice->CreateBuffer(&bufferDesc, &InitData, m_vertexBuffer.GetAddressOf());
+            if (FAILED(hr))
+                return hr;
+
+            // Create vertex buffer (m_normalBuffer)
+            // if (HasTexture() && m_aNormalData.empty()) TODO?
+            if (m_aNormalData.empty())
+            {
+                // compute tangent/bitangent vectors manually
+                hr = calculateNormalMapVectors();
+                if (FAILED(hr))
+                    return hr;
+            }
+            bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+            bufferDesc.ByteWidth = GetNormalStride() * GetNumVertices();
+            bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            bufferDesc.CPUAccessFlags = 0;
+            InitData.pSysMem = getNormalData();
+            hr = pDevice->CreateBuffer(&bufferDesc, &InitData, m_normalBuffer.GetAddressOf());
+            if (FAILED(hr))
+                return hr;
+
+            // Create index buffer;
+            bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+            bufferDesc.ByteWidth = (GetIndexFormat() == DXGI_FORMAT_R32_UINT ? sizeof(UINT) : sizeof(WORD)) * getNumIndexData();
+            bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+            bufferDesc.CPUAccessFlags = 0;
+            InitData.pSysMem = getIndexData();
+            hr = pDevice->CreateBuffer(&bufferDesc, &InitData, m_indexBuffer.GetAddressOf());
+            if (FAILED(hr))
+                return hr;
+
+            // Local bounds of the vertices for the occlusion culling
+            const SimpleVertex* aVertices = getVertices();
+            if (GetNumVertices() > 0u)
+            {
+                XMVECTOR boundsMin = XMLoadFloat3(&aVertices[0].Position);
+                XMVECTOR boundsMax = boundsMin;
+                for (UINT i = 1u; i < GetNumVertices(); ++i)
+                {
+                    XMVECTOR position = XMLoadFloat3(&aVertices[i].Position);
+                    boundsMin = XMVectorMin(boundsMin, position);
+                    boundsMax = XMVectorMax(boundsMax, position);
+                }
+                XMStoreFloat3(&m_boundsMin, boundsMin);
+                XMStoreFloat3(&m_boundsMax, boundsMax);
+            }
+
+            const BYTE* pVertexBytes = static_cast<const BYTE*>(getVertexData());
+            const BYTE* pNormalBytes = static_cast<const BYTE*>(getNormalData());
+            const BYTE* pIndexBytes = static_cast<const BYTE*>(getIndexData());
+            const SIZE_T uNumVertexBytes = static_cast<SIZE_T>(GetVertexStride()) * GetNumVertices();
+            const SIZE_T uNumNormalBytes = bHasNormalData ? static_cast<SIZE_T>(GetNormalStride()) * GetNumVertices() : 0u;
+            const SIZE_T uNumIndexBytes = static_cast<SIZE_T>(GetIndexFormat() == DXGI_FORMAT_R32_UINT ? sizeof(UINT) : sizeof(WORD)) * getNumIndexData();
+            m_geometry = std::make_shared<SharedGeometry>(
+                SharedGeometry
+                {
+                    .vertexBuffer = m_vertexBuffer,
+                    .normalBuffer = m_normalBuffer,
+                    .indexBuffer = m_indexBuffer,
+                    .BoundsMin = m_boundsMin,
+                    .BoundsMax = m_boundsMax,
+                    .uVertexStride = GetVertexStride(),
+                    .uNormalStride = GetNormalStride(),
+                    .indexFormat = GetIndexFormat(),
+                    .aVertexBytes = std::vector<BYTE>(pVertexBytes, pVertexBytes + uNumVertexBytes),
+                    .aNormalBytes = std::vector<BYTE>(pNormalBytes, pNormalBytes + uNumNormalBytes),
+                    .aIndexBytes = std::vector<BYTE>(pIndexBytes, pIndexBytes + uNumIndexBytes),
+                }
+            );
+
+            // Geometry added under the hash meanwhile, by the same data or by other data, keeps its entry
+            std::lock_guard<std::mutex> lock(sm_geometryLibraryMutex);
+            std::weak_ptr<SharedGeometry>& entry = sm_geometryLibrary[uGeometryHash];
+            if (entry.expired())
+            {
+                entry = m_geometry;
+            }
+        }
 
         // Create the constant buffer
         bufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -101,112 +229,183 @@ namespace library
         if (FAILED(hr))
             return hr;
 
+        // Models build theirs at import or take it from the mesh cache
+        if (usesRayBvh() && GetRayBvh().IsEmpty())
+        {
+            hr = BuildRayBvh();
+            if (FAILED(hr))
+                return hr;
+        }
+
         return hr;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
      Method:   Renderable::calculateNormalMapVectors
-     Summary:  Calculate tangent and bitangent vectors of every vertex
+     Summary:  Calculate tangent and bitangent vectors of every vertex,
+               summing the angle weighted frames of all the faces
+               around it
      Modifies: [m_aNormalData].
+     Returns:  HRESULT
+                 Status code
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Renderable::calculateNormalMapVectors()
+    HRESULT Renderable::calculateNormalMapVectors()
     {
-        // Go through all the faces and calculate the T and B vectors
+        LARGE_INTEGER startingTime;
+        LARGE_INTEGER endingTime;
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        TangentGenerator tangentGenerator;
+        HRESULT hr = tangentGenerator.Generate(getVertices(), GetNumVertices(), getIndexData(), GetIndexFormat(), GetNumIndices(), m_aNormalData);
+        if (FAILED(hr))
+            return hr;
 
-        UINT uNumFaces = GetNumIndices() / 3;
-        const SimpleVertex* aVertices = getVertices();
-        const WORD* aIndices = getIndices();
+        QueryPerformanceCounter(&endingTime);
+        const DOUBLE elapsedMilliseconds = static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart);
+        if (Statistics::IsLogging())
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Renderable: tangent frames of %u vertices from %u faces in %.2f ms on %u threads (%.1f faces per microsecond)\n",
+                GetNumVertices(),
+                GetNumIndices() / 3u,
+                static_cast<FLOAT>(elapsedMilliseconds),
+                tangentGenerator.GetNumThreads(),
+                elapsedMilliseconds > 0.0 ? static_cast<FLOAT>(static_cast<DOUBLE>(GetNumIndices() / 3u) / (elapsedMilliseconds * 1000.0)) : 0.0f
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
 
-        m_aNormalData.resize(GetNumVertices(), NormalData());
+        return S_OK;
+    }
 
-        XMFLOAT3 tangent, bitangent;
 
-        // For every face
-        for (int i = 0; i < uNumFaces; ++i)
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+     Method:   Renderable::hashGeometry
+     Summary:  Hashes the layout and the bytes of the vertices, the
+               tangent frames and the indices. Tangent frames not made
+               yet follow from the vertices and the indices, so only
+               given ones are hashed
+     Returns:  UINT64
+                 Key of the geometry in the geometry library
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 Renderable::hashGeometry() const
+    {
+        const UINT uIndexSize = GetIndexFormat() == DXGI_FORMAT_R32_UINT ? sizeof(UINT) : sizeof(WORD);
+        const UINT aLayout[] =
         {
-            // Calculate tangent/bitangent vectors of vertices in the face
-            calculateTangentBitangent(
-                aVertices[aIndices[i * 3]],
-                aVertices[aIndices[i * 3 + 1]],
-                aVertices[aIndices[i * 3 + 2]],
-                tangent,
-                bitangent);
-
-            // Store tangent/bitangent vectors of each vertex
-            m_aNormalData[aIndices[i * 3]].Tangent = tangent;
-            m_aNormalData[aIndices[i * 3]].Bitangent = bitangent;
-            m_aNormalData[aIndices[i * 3 + 1]].Tangent = tangent;
-            m_aNormalData[aIndices[i * 3 + 1]].Bitangent = bitangent;
-            m_aNormalData[aIndices[i * 3 + 2]].Tangent = tangent;
-            m_aNormalData[aIndices[i * 3 + 2]].Bitangent = bitangent;
+            GetVertexStride(),
+            GetNormalStride(),
+            GetNumVertices(),
+            static_cast<UINT>(GetIndexFormat()),
+            getNumIndexData(),
+            static_cast<UINT>(!m_aNormalData.empty()),
+        };
+
+        UINT64 uHash = hashBytes(aLayout, sizeof(aLayout), FNV_OFFSET_BASIS);
+        uHash = hashBytes(getVertexData(), static_cast<SIZE_T>(GetVertexStride()) * GetNumVertices(), uHash);
+        if (!m_aNormalData.empty())
+        {
+            uHash = hashBytes(getNormalData(), static_cast<SIZE_T>(GetNormalStride()) * GetNumVertices(), uHash);
         }
+        uHash = hashBytes(getIndexData(), static_cast<SIZE_T>(uIndexSize) * getNumIndexData(), uHash);
 
+        return uHash;
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-     Method:   Renderable::calculateTangentBitangent
-     Summary:  Calculate tangent/bitangent vectors of the given face
-     Args:     SimpleVertex& v1
-                 The first vertex of the face
-               SimpleVertex& v2
-                 The second vertex of the face
-               SimpleVertex& v3
-                 The third vertex of the face
-               XMFLOAT3& tangent
-                 Calculated tangent vector
-               XMFLOAT3& bitangent
-                 Calculated bitangent vector
+     Method:   Renderable::isSameGeometry
+     Summary:  Compares the layout and the bytes of the vertices, the
+               tangent frames and the indices with the data shared
+               geometry was made from
+     Args:     const SharedGeometry& geometry
+                 Geometry found under the same hash
+     Returns:  BOOL
+                 TRUE if the geometry was made from the same data
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    void Renderable::calculateTangentBitangent(_In_ const SimpleVertex& v1, _In_ const SimpleVertex& v2, _In_ const SimpleVertex& v3, _Out_ XMFLOAT3& tangent, _Out_ XMFLOAT3& bitangent)
+    BOOL Renderable::isSameGeometry(_In_ const SharedGeometry& geometry) const
     {
-        XMFLOAT3 vector1, vector2;
-        XMFLOAT2 tuVector, tvVector;
-
-        // Calculate the two vectors for this face.
-        vector1.x = v2.Position.x - v1.Position.x;
-        vector1.y = v2.Position.y - v1.Position.y;
-        vector1.z = v2.Position.z - v1.Position.z;
+        const SIZE_T uNumVertexBytes = static_cast<SIZE_T>(GetVertexStride()) * GetNumVertices();
+        const SIZE_T uNumNormalBytes = m_aNormalData.empty() ? 0u : static_cast<SIZE_T>(GetNormalStride()) * GetNumVertices();
+        const SIZE_T uNumIndexBytes = static_cast<SIZE_T>(GetIndexFormat() == DXGI_FORMAT_R32_UINT ? sizeof(UINT) : sizeof(WORD)) * getNumIndexData();
+
+        return geometry.uVertexStride == GetVertexStride() &&
+            geometry.uNormalStride == GetNormalStride() &&
+            geometry.indexFormat == GetIndexFormat() &&
+            geometry.aVertexBytes.size() == uNumVertexBytes &&
+            geometry.aNormalBytes.size() == uNumNormalBytes &&
+            geometry.aIndexBytes.size() == uNumIndexBytes &&
+            memcmp(geometry.aVertexBytes.data(), getVertexData(), uNumVertexBytes) == 0 &&
+            (uNumNormalBytes == 0u || memcmp(geometry.aNormalBytes.data(), getNormalData(), uNumNormalBytes) == 0) &&
+            memcmp(geometry.aIndexBytes.data(), getIndexData(), uNumIndexBytes) == 0;
+    }
 
-        vector2.x = v3.Position.x - v1.Position.x;
-        vector2.y = v3.Position.y - v1.Position.y;
-        vector2.z = v3.Position.z - v1.Position.z;
 
-        // Calculate the tu and tv texture space vectors.
-        tuVector.x = v2.TexCoord.x - v1.TexCoord.x;
-        tvVector.x = v2.TexCoord.y - v1.TexCoord.y;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+     Method:   Renderable::usesRayBvh
+     Summary:  Returns whether the renderable builds a triangle BVH for
+               ray casts
+     Returns:  BOOL
+                 TRUE
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderable::usesRayBvh() const
+    {
+        return TRUE;
+    }
 
-        tuVector.y = v3.TexCoord.x - v1.TexCoord.x;
-        tvVector.y = v3.TexCoord.y - v1.TexCoord.y;
 
-        // Calculate the denominator of the tangent/binormal equation.
-        float den = 1.0f / (tuVector.x * tvVector.y - tuVector.y * tvVector.x);
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+     Method:   Renderable::getIndexData
+     Summary:  Returns the indices in the format of GetIndexFormat
+     Returns:  const void*
+                 The WORD indices of getIndices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Renderable::getIndexData() const
+    {
+        return getIndices();
+    }
 
-        // Calculate the cross products and multiply by the coefficient to get the tangent and binormal.
-        tangent.x = (tvVector.y * vector1.x - tvVector.x * vector2.x) * den;
-        tangent.y = (tvVector.y * vector1.y - tvVector.x * vector2.y) * den;
-        tangent.z = (tvVector.y * vector1.z - tvVector.x * vector2.z) * den;
 
-        bitangent.x = (tuVector.x * vector2.x - tuVector.y * vector1.x) * den;
-        bitangent.y = (tuVector.x * vector2.y - tuVector.y * vector1.y) * den;
-        bitangent.z = (tuVector.x * vector2.z - tuVector.y * vector1.z) * den;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+     Method:   Renderable::getNumIndexData
+     Summary:  Returns the number of indices in getIndexData, which
+               may hold more than the GetNumIndices drawn at once
+     Returns:  UINT
+                 Size of the index buffer in indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Renderable::getNumIndexData() const
+    {
+        return GetNumIndices();
+    }
 
-        // Calculate the length of this normal.
-        float length = sqrt((tangent.x * tangent.x) + (tangent.y * tangent.y) + (tangent.z * tangent.z));
 
-        // Normalize the normal and then store it
-        tangent.x = tangent.x / length;
-        tangent.y = tangent.y / length;
-        tangent.z = tangent.z / length;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+     Method:   Renderable::getVertexData
+     Summary:  Returns the vertices in the layout of GetVertexStride
+     Returns:  const void*
+                 The SimpleVertex vertices of getVertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Renderable::getVertexData() const
+    {
+        return getVertices();
+    }
 
-        // Calculate the length of this normal.
-        length = sqrt((bitangent.x * bitangent.x) + (bitangent.y * bitangent.y) + (bitangent.z * bitangent.z));
 
-        // Normalize the normal and then store it
-        bitangent.x = bitangent.x / length;
-        bitangent.y = bitangent.y / length;
-        bitangent.z = bitangent.z / length;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+     Method:   Renderable::getNormalData
+     Summary:  Returns the tangent frames in the layout of
+               GetNormalStride
+     Returns:  const void*
+                 The NormalData of the vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Renderable::getNormalData() const
+    {
+        return m_aNormalData.data();
     }
 
 
@@ -313,6 +512,50 @@ namespace library
     }
 
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetIndexFormat
+
+      Summary:  Returns the format of the index buffer, 16-bit unless
+                a renderable has more vertices than WORD indices reach
+
+      Returns:  DXGI_FORMAT
+                  DXGI_FORMAT_R16_UINT
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    DXGI_FORMAT Renderable::GetIndexFormat() const
+    {
+        return DXGI_FORMAT_R16_UINT;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetVertexStride
+
+      Summary:  Returns the size of a vertex in the vertex buffer
+
+      Returns:  UINT
+                  sizeof(SimpleVertex)
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Renderable::GetVertexStride() const
+    {
+        return static_cast<UINT>(sizeof(SimpleVertex));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetNormalStride
+
+      Summary:  Returns the size of a tangent frame in the normal
+                buffer
+
+      Returns:  UINT
+                  sizeof(NormalData)
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Renderable::GetNormalStride() const
+    {
+        return static_cast<UINT>(sizeof(NormalData));
+    }
+
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::GetConstantBuffer
 
@@ -352,6 +595,35 @@ namespace library
     }
 
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetWorldBounds
+      Summary:  Transforms the corners of the local bounds by the world
+                matrix and returns the box enclosing them
+      Args:     XMFLOAT3& outMin
+                XMFLOAT3& outMax
+                  Corners of the world box
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderable::GetWorldBounds(_Out_ XMFLOAT3& outMin, _Out_ XMFLOAT3& outMax) const
+    {
+        XMVECTOR worldMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR worldMax = XMVectorReplicate(-FLT_MAX);
+        for (UINT uCorner = 0u; uCorner < 8u; ++uCorner)
+        {
+            XMVECTOR corner = XMVectorSet(
+                (uCorner & 1u) ? m_boundsMax.x : m_boundsMin.x,
+                (uCorner & 2u) ? m_boundsMax.y : m_boundsMin.y,
+                (uCorner & 4u) ? m_boundsMax.z : m_boundsMin.z,
+                1.0f
+            );
+            corner = XMVector3TransformCoord(corner, m_world);
+            worldMin = XMVectorMin(worldMin, corner);
+            worldMax = XMVectorMax(worldMax, corner);
+        }
+        XMStoreFloat3(&outMin, worldMin);
+        XMStoreFloat3(&outMax, worldMax);
+    }
+
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::GetOutputColor
       Summary:  Returns the output color
@@ -576,4 +848,68 @@ namespace library
         return m_bHasNormalMap;
     }
 
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::BuildRayBvh
+      Summary:  Builds the triangle BVH of the meshes for ray casts, or
+                of all the indices as one mesh when there are none
+      Modifies: [m_rayBvh].
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Renderable::BuildRayBvh()
+    {
+        std::vector<TriangleBvh::MeshRange> aMeshRanges;
+        aMeshRanges.reserve(m_aMeshes.empty() ? 1u : m_aMeshes.size());
+        for (const BasicMeshEntry& mesh : m_aMeshes)
+        {
+            aMeshRanges.push_back({ mesh.uBaseIndex, mesh.uNumIndices, mesh.uBaseVertex });
+        }
+        if (aMeshRanges.empty())
+        {
+            aMeshRanges.push_back({ 0u, GetNumIndices(), 0u });
+        }
+
+        return m_rayBvh.Build(getVertices(), GetNumVertices(), getIndexData(), GetIndexFormat(), aMeshRanges);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::IntersectRays
+      Summary:  Finds the nearest hit of every ray against the
+                triangles, placed by the current world matrix. A
+                renderable without a BVH, such as an instanced one,
+                reports every ray as a miss
+      Args:     const TriangleBvh::Ray* pRays
+                  Rays in world space
+                UINT uNumRays
+                  Number of rays
+                TriangleBvh::RayHit* pOutHits
+                  Nearest hit of every ray
+                UINT uNumThreads
+                  Number of threads, or 0 for one per hardware thread
+      Returns:  UINT
+                  Number of rays that hit a triangle
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Renderable::IntersectRays(
+        _In_reads_(uNumRays) const TriangleBvh::Ray* pRays,
+        _In_ UINT uNumRays,
+        _Out_writes_(uNumRays) TriangleBvh::RayHit* pOutHits,
+        _In_opt_ UINT uNumThreads
+    ) const
+    {
+        return GetRayBvh().Intersect(pRays, uNumRays, m_world, pOutHits, uNumThreads);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetRayBvh
+      Summary:  Returns the triangle BVH for ray casts
+      Returns:  const TriangleBvh&
+                  Triangle BVH, empty until built
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const TriangleBvh& Renderable::GetRayBvh() const
+    {
+        return m_rayBvh;
+    }
 }
@@ -14,17 +14,23 @@
 #include "Common.h"
 
 #include "Renderer/DataTypes.h"
+#include "Renderer/TriangleBvh.h"
 #include "Shader/PixelShader.h"
 #include "Shader/VertexShader.h"
 #include "Texture/Material.h"
 
+#include <mutex>
+
 namespace library
 {
 
     /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
       Class:    Renderable
 
-      Summary:  Base class for all renderable classes
+      Summary:  Base class for all renderable classes. Renderables
+                with the same vertices, tangent frames and indices, such
+                as the cubes of every voxel type, share one set of
+                buffers through a library keyed by a hash of the data
 
       Methods:  Initialize
                   Pure virtual function that initializes the object
@@ -35,16 +41,33 @@ namespace library
                   Returns the vertex buffer
                 GetIndexBuffer
                   Returns the index buffer
+                GetIndexFormat
+                  Returns the format of the index buffer
+                GetVertexStride
+                  Returns the size of a vertex in the vertex buffer
+                GetNormalStride
+                  Returns the size of a tangent frame in the normal
+                  buffer
                 GetConstantBuffer
                   Returns the constant buffer
                 GetWorldMatrix
                   Returns the world matrix
+                GetWorldBounds
+                  Returns the axis-aligned box of the vertices in world
+                  space
                 GetNumVertices
                   Pure virtual function that returns the number of
                   vertices
                 GetNumIndices
                   Pure virtual function that returns the number of
                   indices
+                BuildRayBvh
+                  Builds the triangle BVH for ray casts
+                IntersectRays
+                  Finds the nearest hit of every ray of a batch in
+                  world space
+                GetRayBvh
+                  Returns the triangle BVH for ray casts
                 Renderable
                   Constructor.
                 ~Renderable
@@ -55,7 +78,6 @@ namespace library
     public:
         static constexpr const UINT INVALID_MATERIAL = (0xFFFFFFFF);
 
-    protected:
         struct BasicMeshEntry
         {
             BasicMeshEntry()
@@ -72,6 +94,32 @@ namespace library
             UINT uMaterialIndex;
         };
 
+    protected:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   SharedGeometry
+
+          Summary:  Immutable buffers and local bounds of geometry that
+                    renderables with the same data share, with a copy
+                    of the data they were made from, so a renderable
+                    whose hash matches compares it before sharing.
+                    aNormalBytes is empty when the tangent frames were
+                    generated from the vertices and the indices
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct SharedGeometry
+        {
+            ComPtr<ID3D11Buffer> vertexBuffer;
+            ComPtr<ID3D11Buffer> normalBuffer;
+            ComPtr<ID3D11Buffer> indexBuffer;
+            XMFLOAT3 BoundsMin;
+            XMFLOAT3 BoundsMax;
+            UINT uVertexStride;
+            UINT uNormalStride;
+            DXGI_FORMAT indexFormat;
+            std::vector<BYTE> aVertexBytes;
+            std::vector<BYTE> aNormalBytes;
+            std::vector<BYTE> aIndexBytes;
+        };
+
     public:
         Renderable(_In_ const XMFLOAT4& outputColor);
         Renderable(const Renderable& other) = delete;
@@ -94,10 +142,14 @@ namespace library
         ComPtr<ID3D11InputLayout>& GetVertexLayout();
         ComPtr<ID3D11Buffer>& GetVertexBuffer();
         ComPtr<ID3D11Buffer>& GetIndexBuffer();
+        virtual DXGI_FORMAT GetIndexFormat() const;
+        virtual UINT GetVertexStride() const;
+        virtual UINT GetNormalStride() const;
         ComPtr<ID3D11Buffer>& GetConstantBuffer();
         ComPtr<ID3D11Buffer>& GetNormalBuffer();
 
         const XMMATRIX& GetWorldMatrix() const;
+        virtual void GetWorldBounds(_Out_ XMFLOAT3& outMin, _Out_ XMFLOAT3& outMax) const;
         const XMFLOAT4& GetOutputColor() const;
         BOOL HasTexture() const;
         const std::shared_ptr<Material>& GetMaterial(UINT uIndex) const;
@@ -117,26 +169,47 @@ namespace library
         UINT GetNumMaterials() const;
         BOOL HasNormalMap() const;
 
+        HRESULT BuildRayBvh();
+        UINT IntersectRays(
+            _In_reads_(uNumRays) const TriangleBvh::Ray* pRays,
+            _In_ UINT uNumRays,
+            _Out_writes_(uNumRays) TriangleBvh::RayHit* pOutHits,
+            _In_opt_ UINT uNumThreads = 0u
+        ) const;
+        virtual const TriangleBvh& GetRayBvh() const;
+
     protected:
         const virtual SimpleVertex* getVertices() const = 0;
         virtual const WORD* getIndices() const = 0;
+        virtual const void* getIndexData() const;
+        virtual UINT getNumIndexData() const;
+        virtual const void* getVertexData() const;
+        virtual const void* getNormalData() const;
         virtual HRESULT initialize(
             _In_ ID3D11Device* pDevice,
             _In_ ID3D11DeviceContext* pImmediateContext
         );
 
-        void calculateNormalMapVectors();
-        void calculateTangentBitangent(_In_ const SimpleVertex& v1, _In_ const SimpleVertex& v2, _In_ const SimpleVertex& v3, _Out_ XMFLOAT3& tangent, _Out_ XMFLOAT3& bitangent);
+        HRESULT calculateNormalMapVectors();
+        UINT64 hashGeometry() const;
+        BOOL isSameGeometry(_In_ const SharedGeometry& geometry) const;
+        virtual BOOL usesRayBvh() const;
+
+    protected:
+        static std::unordered_map<UINT64, std::weak_ptr<SharedGeometry>> sm_geometryLibrary;
+        static std::mutex sm_geometryLibraryMutex;
 
     protected:
         ComPtr<ID3D11Buffer> m_vertexBuffer;
         ComPtr<ID3D11Buffer> m_indexBuffer;
         ComPtr<ID3D11Buffer> m_constantBuffer;
         ComPtr<ID3D11Buffer> m_normalBuffer;
+        std::shared_ptr<SharedGeometry> m_geometry;
 
         std::vector<BasicMeshEntry> m_aMeshes;
         std::vector<std::shared_ptr<Material>> m_aMaterials;
         std::vector<NormalData> m_aNormalData;
+        TriangleBvh m_rayBvh;
 
         std::shared_ptr<VertexShader> m_vertexShader;
         std::shared_ptr<PixelShader> m_pixelShader;
@@ -145,5 +218,7 @@ namespace library
         BYTE m_padding[8];
         XMMATRIX m_world;
         BOOL m_bHasNormalMap;
+        XMFLOAT3 m_boundsMin;
+        XMFLOAT3 m_boundsMax;
     };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Renderer/Renderer.h"
+#include "Statistics.h"
 
 namespace library
 {
@@ -11,7 +12,8 @@ namespace library
                   m_depthStencilView, m_cbChangeOnResize, m_cbShadowMatrix,
                   m_pszMainSceneName, m_camera, m_projection, m_scenes
                   m_invalidTexture, m_shadowMapTexture, m_shadowVertexShader,
-                  m_shadowPixelShader].
+                  m_shadowPixelShader, m_frameTimeSum, m_uNumTimedFrames,
+                  m_uNumModelTriangles].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     /*--------------------------------------------------------------------
       TODO: Renderer::Renderer definition (remove the comment)
@@ -40,6 +42,9 @@ namespace library
         , m_shadowMapTexture(nullptr)
         , m_shadowVertexShader(nullptr)
         , m_shadowPixelShader(nullptr)
+        , m_frameTimeSum(0.0f)
+        , m_uNumTimedFrames(0u)
+        , m_uNumModelTriangles(0ull)
     { }
 
 
@@ -322,6 +327,12 @@ namespace library
             return hr;
         }
 
+        // The terrain LOD ranges depend on the projection and the viewport height
+        if (m_scenes[m_pszMainSceneName]->GetTerrain() != nullptr)
+        {
+            m_scenes[m_pszMainSceneName]->GetTerrain()->SetScreenSpaceError(XM_PIDIV4, static_cast<FLOAT>(uHeight), Terrain::DEFAULT_PIXEL_ERROR);
+        }
+
         hr = m_invalidTexture->Initialize(m_d3dDevice.Get(), m_immediateContext.Get());
         if (FAILED(hr))
         {
@@ -443,18 +454,77 @@ namespace library
       Summary:  Update the renderables each frame
       Args:     FLOAT deltaTime
                   Time difference of a frame
+      Modifies: [m_frameTimeSum, m_uNumTimedFrames, m_uNumModelTriangles].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     void Renderer::Update(_In_ FLOAT deltaTime)
     {
+        // The animation rates follow the eye of the last frame
+        XMFLOAT3 eyePosition;
+        XMStoreFloat3(&eyePosition, m_camera.GetEye());
+        m_scenes[m_pszMainSceneName]->GetAnimationScheduler().SetEyePosition(eyePosition);
+
         m_scenes[m_pszMainSceneName]->Update(deltaTime);
 
         m_camera.Update(deltaTime);
+
+        // Every subsystem reports its own statistics over the same frames
+        m_frameTimeSum += deltaTime;
+        ++m_uNumTimedFrames;
+        if (m_uNumTimedFrames >= FRAME_TIME_LOG_INTERVAL)
+        {
+            if (Statistics::IsLogging())
+            {
+                logStatistics();
+                m_scenes[m_pszMainSceneName]->GetAnimationScheduler().LogStatistics();
+                m_scenes[m_pszMainSceneName]->GetHorizonCuller().LogStatistics();
+                for (auto& model : m_scenes[m_pszMainSceneName]->GetModels())
+                {
+                    model.second->GetClusterCuller().LogStatistics(model.first.c_str(), m_uNumTimedFrames);
+                }
+            }
+
+            for (auto& model : m_scenes[m_pszMainSceneName]->GetModels())
+            {
+                model.second->GetClusterCuller().ResetStatistics();
+            }
+
+            m_frameTimeSum = 0.0f;
+            m_uNumTimedFrames = 0u;
+            m_uNumModelTriangles = 0ull;
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::logStatistics
+      Summary:  Logs the average frame time, the order of the voxel
+                instances it is compared across, and the model
+                triangles drawn at the chosen levels of detail
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::logStatistics() const
+    {
+        static constexpr const PCSTR APSZ_INSTANCE_ORDER_NAMES[] = { "file", "Morton", "Morton, front to back" };
+
+        const std::vector<std::shared_ptr<Voxel>>& voxels = m_scenes.at(m_pszMainSceneName)->GetVoxels();
+        eVoxelInstanceOrder instanceOrder = voxels.empty() ? eVoxelInstanceOrder::FILE : voxels.front()->GetInstanceOrder();
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "Renderer: average frame time %.3f ms over %u frames, voxel instances in %s order, %llu model triangles per frame\n",
+            m_frameTimeSum * 1000.0f / static_cast<FLOAT>(m_uNumTimedFrames),
+            m_uNumTimedFrames,
+            APSZ_INSTANCE_ORDER_NAMES[static_cast<UINT>(instanceOrder)],
+            m_uNumModelTriangles / m_uNumTimedFrames
+        );
+        OutputDebugStringA(szDebugMessage);
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderer::Render
       Summary:  Render the frame
+      Modifies: [m_uNumModelTriangles].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     /*--------------------------------------------------------------------
       TODO: Renderer::Render definition (remove the comment)
@@ -491,6 +561,12 @@ namespace library
 
         auto scene = m_scenes.find(m_pszMainSceneName);
 
+        // Sweep the height map from the eye once, every culled object reads the same horizon
+        HorizonCuller& horizonCuller = (scene->second)->GetHorizonCuller();
+        XMFLOAT3 eyePosition;
+        XMStoreFloat3(&eyePosition, m_camera.GetEye());
+        horizonCuller.Update(eyePosition);
+
         // update lights constant buffer
         // TODO? 
         /*CBLights cbLight = {};
@@ -530,7 +606,7 @@ namespace library
 
             // Set the vertex / index buffers and the input layout
             m_immediateContext->IASetVertexBuffers(0, 2, aBuffers, strides, offsets);
-            m_immediateContext->IASetIndexBuffer((scene->second)->GetSkyBox()->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_immediateContext->IASetIndexBuffer((scene->second)->GetSkyBox()->GetIndexBuffer().Get(), (scene->second)->GetSkyBox()->GetIndexFormat(), 0);
             m_immediateContext->IASetInputLayout((scene->second)->GetSkyBox()->GetVertexLayout().Get());
 
             // Create renderable constant buffer and update
@@ -607,9 +683,21 @@ namespace library
             }
         }
 
+        // Renderables with the same geometry share its buffers, so consecutive ones skip binding them again
+        ID3D11Buffer* aBoundBuffers[2] = { nullptr, nullptr };
+        ID3D11Buffer* pBoundIndexBuffer = nullptr;
+        ID3D11InputLayout* pBoundLayout = nullptr;
+
         // Update variables that change once per frame
         for (auto renderable : (scene->second)->GetRenderables())
         {
+            XMFLOAT3 boundsMin, boundsMax;
+            renderable.second->GetWorldBounds(boundsMin, boundsMax);
+            if (!horizonCuller.IsBoxVisible(boundsMin, boundsMax))
+            {
+                continue;
+            }
+
             UINT strides[2] = { sizeof(SimpleVertex), sizeof(NormalData) };
             UINT offsets[2] = { 0u, 0u };
             ID3D11Buffer* aBuffers[2] =
@@ -619,9 +707,22 @@ namespace library
             };
 
             // Set the vertex buffer, index buffer, and the input layout
-            m_immediateContext->IASetVertexBuffers(0, 2, aBuffers, strides, offsets);
-            m_immediateContext->IASetIndexBuffer(renderable.second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-            m_immediateContext->IASetInputLayout(renderable.second->GetVertexLayout().Get());
+            if (aBuffers[0] != aBoundBuffers[0] || aBuffers[1] != aBoundBuffers[1])
+            {
+                m_immediateContext->IASetVertexBuffers(0, 2, aBuffers, strides, offsets);
+                aBoundBuffers[0] = aBuffers[0];
+                aBoundBuffers[1] = aBuffers[1];
+            }
+            if (renderable.second->GetIndexBuffer().Get() != pBoundIndexBuffer)
+            {
+                m_immediateContext->IASetIndexBuffer(renderable.second->GetIndexBuffer().Get(), renderable.second->GetIndexFormat(), 0);
+                pBoundIndexBuffer = renderable.second->GetIndexBuffer().Get();
+            }
+            if (renderable.second->GetVertexLayout().Get() != pBoundLayout)
+            {
+                m_immediateContext->IASetInputLayout(renderable.second->GetVertexLayout().Get());
+                pBoundLayout = renderable.second->GetVertexLayout().Get();
+            }
 
             // Create renderable constant buffer and update
             CBChangesEveryFrame cbFrame =
@@ -730,8 +831,13 @@ namespace library
         }
 
         // After rendering the renderables, render the voxels of the main scene
+        HorizonMap& horizonMap = (scene->second)->GetHorizonMap();
         for (auto voxel : (scene->second)->GetVoxels())
         {
+            // Drop the buckets outside the potentially visible set or below the horizon,
+            // and order the rest front to back for early depth rejection
+            voxel->UpdateDrawRanges(m_camera.GetEye(), &(scene->second)->GetVoxelPvs(), &horizonCuller);
+
             // Set the vertex buffer, index buffer, instancing buffer and the input layout
             UINT strides[3] = { sizeof(SimpleVertex), sizeof(NormalData), sizeof(InstanceData) };
             UINT offsets[3] = { 0u, 0u, 0u };
@@ -743,7 +849,7 @@ namespace library
             };
 
             m_immediateContext->IASetVertexBuffers(0, 3, vertInstBuffers, strides, offsets);
-            m_immediateContext->IASetIndexBuffer(voxel->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_immediateContext->IASetIndexBuffer(voxel->GetIndexBuffer().Get(), voxel->GetIndexFormat(), 0);
             m_immediateContext->IASetInputLayout(voxel->GetVertexLayout().Get());
 
             // Create renderable constant buffer and update
@@ -769,6 +875,13 @@ namespace library
             m_immediateContext->PSSetConstantBuffers(2u, 1u, voxel->GetConstantBuffer().GetAddressOf());
             m_immediateContext->PSSetConstantBuffers(3u, 1u, m_cbLights.GetAddressOf());
 
+            // The precomputed horizons shadow the terrain in place of the shadow map
+            if (horizonMap.GetTextureView())
+            {
+                m_immediateContext->PSSetConstantBuffers(4u, 1u, horizonMap.GetConstantBuffer().GetAddressOf());
+                m_immediateContext->PSSetShaderResources(2u, 1u, horizonMap.GetTextureView().GetAddressOf());
+            }
+
             if (voxel->HasTexture())
             {
                 for (UINT i = 0u; i < voxel->GetNumMeshes(); ++i)
@@ -805,31 +918,125 @@ namespace library
                     }
 
                     // Draw
-                    m_immediateContext->DrawIndexedInstanced(
-                        voxel->GetMesh(i).uNumIndices,
-                        voxel->GetNumInstances(),
-                        voxel->GetMesh(i).uBaseIndex,
-                        voxel->GetMesh(i).uBaseVertex,
-                        0);
+                    for (const VoxelDrawRange& drawRange : voxel->GetDrawRanges())
+                    {
+                        m_immediateContext->DrawIndexedInstanced(
+                            voxel->GetMesh(i).uNumIndices,
+                            drawRange.uNumInstances,
+                            voxel->GetMesh(i).uBaseIndex,
+                            voxel->GetMesh(i).uBaseVertex,
+                            drawRange.uStartInstance);
+                    }
                 }
             }
             else
             {
+                for (const VoxelDrawRange& drawRange : voxel->GetDrawRanges())
+                {
+                    m_immediateContext->DrawIndexedInstanced(
+                        voxel->GetNumIndices(),
+                        drawRange.uNumInstances,
+                        0,
+                        0,
+                        drawRange.uStartInstance);
+                }
+            }
+
+        }
+
+        // render the terrain, one instanced draw per patch quadrant
+        if ((scene->second)->GetTerrain() != nullptr)
+        {
+            std::shared_ptr<Terrain>& terrain = (scene->second)->GetTerrain();
+            terrain->SelectNodes(m_immediateContext.Get(), m_camera.GetEye(), m_camera.GetView() * m_projection);
+
+            UINT aStrides[2] = { static_cast<UINT>(sizeof(SimpleVertex)), static_cast<UINT>(sizeof(TerrainInstanceData)) };
+            UINT aOffsets[2] = { 0u, 0u };
+            ID3D11Buffer* aBuffers[2] =
+            {
+                terrain->GetVertexBuffer().Get(),
+                terrain->GetInstanceBuffer().Get()
+            };
+
+            m_immediateContext->IASetVertexBuffers(0, 2, aBuffers, aStrides, aOffsets);
+            m_immediateContext->IASetIndexBuffer(terrain->GetIndexBuffer().Get(), terrain->GetIndexFormat(), 0);
+            m_immediateContext->IASetInputLayout(terrain->GetVertexLayout().Get());
+
+            CBChangesEveryFrame cbFrame =
+            {
+                .World = XMMatrixTranspose(terrain->GetWorldMatrix()),
+                .OutputColor = terrain->GetOutputColor(),
+                .HasNormalMap = terrain->HasNormalMap()
+            };
+            m_immediateContext->UpdateSubresource(terrain->GetConstantBuffer().Get(), 0u, nullptr, &cbFrame, 0u, 0u);
+
+            m_immediateContext->VSSetShader(terrain->GetVertexShader().Get(), nullptr, 0u);
+            m_immediateContext->VSSetConstantBuffers(0u, 1u, m_camera.GetConstantBuffer().GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(1u, 1u, m_cbChangeOnResize.GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(2u, 1u, terrain->GetConstantBuffer().GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(3u, 1u, m_cbLights.GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(4u, 1u, terrain->GetTerrainConstantBuffer().GetAddressOf());
+            m_immediateContext->VSSetShaderResources(0u, 1u, terrain->GetHeightTextureView().GetAddressOf());
+            m_immediateContext->VSSetShaderResources(1u, 1u, terrain->GetColorTextureView().GetAddressOf());
+            m_immediateContext->VSSetSamplers(
+                0u,
+                1u,
+                Texture::s_samplers[static_cast<size_t>(eTextureSamplerType::TRILINEAR_CLAMP)].GetAddressOf()
+            );
+
+            m_immediateContext->PSSetShader(terrain->GetPixelShader().Get(), nullptr, 0u);
+            m_immediateContext->PSSetConstantBuffers(0u, 1u, m_camera.GetConstantBuffer().GetAddressOf());
+            m_immediateContext->PSSetConstantBuffers(2u, 1u, terrain->GetConstantBuffer().GetAddressOf());
+            m_immediateContext->PSSetConstantBuffers(3u, 1u, m_cbLights.GetAddressOf());
+
+            for (UINT uQuadrant = 0u; uQuadrant < 4u; ++uQuadrant)
+            {
+                if (terrain->GetNumQuadrantInstances(uQuadrant) == 0u)
+                {
+                    continue;
+                }
+
                 m_immediateContext->DrawIndexedInstanced(
-                    voxel->GetNumIndices(),
-                    voxel->GetNumInstances(),
-                    0,
+                    terrain->GetNumIndicesPerQuadrant(),
+                    terrain->GetNumQuadrantInstances(uQuadrant),
+                    uQuadrant * terrain->GetNumIndicesPerQuadrant(),
                     0,
-                    0);
+                    terrain->GetQuadrantInstanceStart(uQuadrant)
+                );
             }
-
         }
 
         // render the model
+        const XMMATRIX viewProjection = m_camera.GetView() * m_projection;
+        std::vector<ClusterCuller::IndexRange> aRanges;
         for (auto model : (scene->second)->GetModels())
         {
+            XMFLOAT3 boundsMin, boundsMax;
+            model.second->GetWorldBounds(boundsMin, boundsMax);
+            if (!horizonCuller.IsBoxVisible(boundsMin, boundsMax))
+            {
+                continue;
+            }
+
+            // The level of detail follows the size of the model on screen
+            const UINT uLod = model.second->SelectLod(boundsMin, boundsMax, m_camera.GetEye());
+
+            // Every level of detail draws the clusters left after culling
+            auto drawMesh = [&](UINT uMeshIndex)
+            {
+                const auto& lodMesh = model.second->GetLodMesh(uMeshIndex, uLod);
+                aRanges.clear();
+                model.second->CullClusters(uMeshIndex, uLod, viewProjection, m_camera.GetEye(), aRanges);
+
+                for (const ClusterCuller::IndexRange& range : aRanges)
+                {
+                    m_immediateContext->DrawIndexed(range.uNumIndices, range.uBaseIndex, lodMesh.uBaseVertex);
+                    m_uNumModelTriangles += range.uNumIndices / 3u;
+                }
+            };
+
             // Set vertex buffer
-            UINT aStrides[3] = { static_cast<UINT>(sizeof(SimpleVertex)), static_cast <UINT>(sizeof(NormalData)), static_cast<UINT>(sizeof(AnimationData)) };
+            UINT aStrides[3] = { model.second->GetVertexStride(), model.second->GetNormalStride(), static_cast<UINT>(sizeof(AnimationData)) };
             UINT aOffsets[3] = { 0u, 0u, 0u };
 
             ID3D11Buffer* aBuffers[3] =
@@ -841,7 +1048,7 @@ namespace library
 
             // Set the vertex buffer, index buffer, and the input layout
             m_immediateContext->IASetVertexBuffers(0, 3, aBuffers, aStrides, aOffsets);
-            m_immediateContext->IASetIndexBuffer(model.second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_immediateContext->IASetIndexBuffer(model.second->GetIndexBuffer().Get(), model.second->GetIndexFormat(), 0);
             m_immediateContext->IASetInputLayout(model.second->GetVertexLayout().Get());
 
             // Update and bind the constant buffer
@@ -849,16 +1056,17 @@ namespace library
             {
                 .World = XMMatrixTranspose(model.second->GetWorldMatrix()),
                 .OutputColor = model.second->GetOutputColor(),
-                .HasNormalMap = model.second->HasNormalMap()
+                .HasNormalMap = model.second->HasNormalMap(),
+                .PositionScale = model.second->GetPositionScale(),
+                .PositionOffset = model.second->GetPositionOffset()
             };
             m_immediateContext->UpdateSubresource(model.second->GetConstantBuffer().Get(), 0u, nullptr, &cbFrame, 0u, 0u);
 
-            CBSkinning cbSkin = {}; // Set the bone transformations in skinning constant buffer using
-            for (UINT i = 0; i < model.second->GetBoneTransforms().size(); ++i)
+            // Write the bone transformations into the bone palette, sized to the bones of the model
+            if (FAILED(model.second->UploadBonePalette(m_immediateContext.Get())))
             {
-                cbSkin.BoneTransforms[i] = XMMatrixTranspose(model.second->GetBoneTransforms()[i]);
+                continue;
             }
-            m_immediateContext->UpdateSubresource(model.second->GetSkinningConstantBuffer().Get(), 0u, nullptr, &cbSkin, 0u, 0u);
 
             // Set Shaders and constant buffers, shader resources, and samplers
             // Set the vertex shader and constant buffers
@@ -868,6 +1076,7 @@ namespace library
             m_immediateContext->VSSetConstantBuffers(2u, 1u, model.second->GetConstantBuffer().GetAddressOf());
             m_immediateContext->VSSetConstantBuffers(3u, 1u, m_cbLights.GetAddressOf());
             m_immediateContext->VSSetConstantBuffers(4u, 1u, model.second->GetSkinningConstantBuffer().GetAddressOf());
+            m_immediateContext->VSSetShaderResources(4u, 1u, model.second->GetBonePaletteView().GetAddressOf());
             
             // Set the pixel shader and constant buffers
             m_immediateContext->PSSetShader(model.second->GetPixelShader().Get(), nullptr, 0u);
@@ -916,19 +1125,102 @@ namespace library
                    
 
                     // Draw them by their respective indices, base index, and base vertex
-                    m_immediateContext->DrawIndexed(
-                        model.second->GetMesh(i).uNumIndices,
-                        model.second->GetMesh(i).uBaseIndex,
-                        model.second->GetMesh(i).uBaseVertex
-                    );
+                    drawMesh(i);
                 }
             }
             else
             {
-                m_immediateContext->DrawIndexed(
-                    model.second->GetNumIndices(),
-                    0,
-                    0
+                for (UINT i = 0u; i < model.second->GetNumMeshes(); ++i)
+                {
+                    drawMesh(i);
+                }
+            }
+        }
+
+        // render the crowds, every instance skinned from the baked clips in one draw per mesh
+        for (auto crowd : (scene->second)->GetCrowds())
+        {
+            UINT aStrides[5] =
+            {
+                static_cast<UINT>(sizeof(SimpleVertex)),
+                static_cast<UINT>(sizeof(NormalData)),
+                static_cast<UINT>(sizeof(AnimationData)),
+                static_cast<UINT>(sizeof(InstanceData)),
+                static_cast<UINT>(sizeof(CrowdInstanceData))
+            };
+            UINT aOffsets[5] = { 0u, 0u, 0u, 0u, 0u };
+            ID3D11Buffer* aBuffers[5] =
+            {
+                crowd.second->GetVertexBuffer().Get(),
+                crowd.second->GetNormalBuffer().Get(),
+                crowd.second->GetAnimationBuffer().Get(),
+                crowd.second->GetInstanceBuffer().Get(),
+                crowd.second->GetAnimationInstanceBuffer().Get()
+            };
+
+            m_immediateContext->IASetVertexBuffers(0, 5, aBuffers, aStrides, aOffsets);
+            m_immediateContext->IASetIndexBuffer(crowd.second->GetIndexBuffer().Get(), crowd.second->GetIndexFormat(), 0);
+            m_immediateContext->IASetInputLayout(crowd.second->GetVertexLayout().Get());
+
+            CBChangesEveryFrame cbFrame =
+            {
+                .World = XMMatrixTranspose(crowd.second->GetWorldMatrix()),
+                .OutputColor = crowd.second->GetOutputColor(),
+                .HasNormalMap = crowd.second->HasNormalMap()
+            };
+            m_immediateContext->UpdateSubresource(crowd.second->GetConstantBuffer().Get(), 0u, nullptr, &cbFrame, 0u, 0u);
+
+            // The only per-frame upload of the crowd
+            CBCrowd cbCrowd =
+            {
+                .Time = XMFLOAT4(crowd.second->GetTime(), 0.0f, 0.0f, 0.0f)
+            };
+            m_immediateContext->UpdateSubresource(crowd.second->GetCrowdConstantBuffer().Get(), 0u, nullptr, &cbCrowd, 0u, 0u);
+
+            m_immediateContext->VSSetShader(crowd.second->GetVertexShader().Get(), nullptr, 0u);
+            m_immediateContext->VSSetConstantBuffers(0u, 1u, m_camera.GetConstantBuffer().GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(1u, 1u, m_cbChangeOnResize.GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(2u, 1u, crowd.second->GetConstantBuffer().GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(3u, 1u, m_cbLights.GetAddressOf());
+            m_immediateContext->VSSetConstantBuffers(5u, 1u, crowd.second->GetCrowdConstantBuffer().GetAddressOf());
+            m_immediateContext->VSSetShaderResources(3u, 1u, crowd.second->GetBakedAnimation().GetTextureView().GetAddressOf());
+
+            m_immediateContext->PSSetShader(crowd.second->GetPixelShader().Get(), nullptr, 0u);
+            m_immediateContext->PSSetConstantBuffers(0u, 1u, m_camera.GetConstantBuffer().GetAddressOf());
+            m_immediateContext->PSSetConstantBuffers(1u, 1u, m_cbChangeOnResize.GetAddressOf());
+            m_immediateContext->PSSetConstantBuffers(2u, 1u, crowd.second->GetConstantBuffer().GetAddressOf());
+            m_immediateContext->PSSetConstantBuffers(3u, 1u, m_cbLights.GetAddressOf());
+
+            for (UINT i = 0u; i < crowd.second->GetNumMeshes(); ++i)
+            {
+                UINT index = crowd.second->GetMesh(i).uMaterialIndex;
+                if (crowd.second->HasTexture() && crowd.second->GetMaterial(index)->pDiffuse)
+                {
+                    eTextureSamplerType textureSamplerType = crowd.second->GetMaterial(index)->pDiffuse->GetSamplerType();
+                    m_immediateContext->PSSetShaderResources(0u, 1u, crowd.second->GetMaterial(index)->pDiffuse->GetTextureResourceView().GetAddressOf());
+                    m_immediateContext->PSSetSamplers(
+                        0u,
+                        1u,
+                        Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf()
+                    );
+                }
+                if (crowd.second->HasTexture() && crowd.second->GetMaterial(index)->pNormal)
+                {
+                    eTextureSamplerType textureSamplerType = crowd.second->GetMaterial(index)->pNormal->GetSamplerType();
+                    m_immediateContext->PSSetShaderResources(1u, 1u, crowd.second->GetMaterial(index)->pNormal->GetTextureResourceView().GetAddressOf());
+                    m_immediateContext->PSSetSamplers(
+                        1u,
+                        1u,
+                        Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf()
+                    );
+                }
+
+                m_immediateContext->DrawIndexedInstanced(
+                    crowd.second->GetMesh(i).uNumIndices,
+                    crowd.second->GetNumInstances(),
+                    crowd.second->GetMesh(i).uBaseIndex,
+                    crowd.second->GetMesh(i).uBaseVertex,
+                    0u
                 );
             }
         }
@@ -975,7 +1267,7 @@ namespace library
             UINT uStride = sizeof(SimpleVertex);
             UINT uOffset = 0;
             m_immediateContext->IASetVertexBuffers(0u, 1u, it->second->GetVertexBuffer().GetAddressOf(), &uStride, &uOffset);
-            m_immediateContext->IASetIndexBuffer(it->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_immediateContext->IASetIndexBuffer(it->second->GetIndexBuffer().Get(), it->second->GetIndexFormat(), 0);
             m_immediateContext->IASetInputLayout(m_shadowVertexShader->GetVertexLayout().Get());
 
             // Update and bind CBShadowMatrix constant buffer
@@ -1004,25 +1296,31 @@ namespace library
             );
         }
 
-        // Render voxels with shadow map shaders
-        for (auto it = (scene->second)->GetVoxels().begin(); it != (scene->second)->GetVoxels().end(); ++it)
+        // Render voxels with shadow map shaders, so the terrain still shadows the models
+        // and renderables. The voxels themselves are shadowed by the horizon map.
+        for (auto voxel : (scene->second)->GetVoxels())
         {
-            // Bind vertex buffer, index buffer, input layout
-            UINT uStride = sizeof(SimpleVertex);
-            UINT uOffset = 0;
-            m_immediateContext->IASetVertexBuffers(0, 2, it->get()->GetVertexBuffer().GetAddressOf(), &uStride, &uOffset);
-            m_immediateContext->IASetIndexBuffer(it->get()->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-            m_immediateContext->IASetInputLayout(it->get()->GetVertexLayout().Get());
+            // Bind vertex buffer, index buffer, instancing buffer and input layout
+            UINT strides[3] = { sizeof(SimpleVertex), sizeof(NormalData), sizeof(InstanceData) };
+            UINT offsets[3] = { 0u, 0u, 0u };
+            ID3D11Buffer* vertInstBuffers[3] =
+            {
+                voxel->GetVertexBuffer().Get(),
+                voxel->GetNormalBuffer().Get(),
+                voxel->GetInstanceBuffer().Get()
+            };
+            m_immediateContext->IASetVertexBuffers(0, 3, vertInstBuffers, strides, offsets);
+            m_immediateContext->IASetIndexBuffer(voxel->GetIndexBuffer().Get(), voxel->GetIndexFormat(), 0);
+            m_immediateContext->IASetInputLayout(voxel->GetVertexLayout().Get());
 
             // Update and bind CBShadowMatrix constant buffer
             CBShadowMatrix cbShadow = {};
             for (int i = 0u; i < NUM_LIGHTS; ++i)
             {
-
-                cbShadow.World = XMMatrixTranspose(it->get()->GetWorldMatrix());
+                cbShadow.World = XMMatrixTranspose(voxel->GetWorldMatrix());
                 cbShadow.View = XMMatrixTranspose((scene->second)->GetPointLight(i)->GetViewMatrix());
                 cbShadow.Projection = XMMatrixTranspose((scene->second)->GetPointLight(i)->GetProjectionMatrix());
-                cbShadow.IsVoxel = true; // TODO?
+                cbShadow.IsVoxel = true;
             }
             m_immediateContext->UpdateSubresource(m_cbShadowMatrix.Get(), 0u, nullptr, &cbShadow, 0u, 0u);
 
@@ -1033,9 +1331,11 @@ namespace library
             m_immediateContext->PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0u);
             m_immediateContext->PSSetConstantBuffers(0u, 1u, m_cbShadowMatrix.GetAddressOf());
 
-            // Draw
-            m_immediateContext->DrawIndexed(
-                it->get()->GetNumIndices(),
+            // Draw every instance, the draw ranges are culled for the camera and not the light
+            m_immediateContext->DrawIndexedInstanced(
+                voxel->GetNumIndices(),
+                voxel->GetNumInstances(),
+                0,
                 0,
                 0
             );
@@ -1044,17 +1344,29 @@ namespace library
         // Render models with shadow map shaders
         for (auto it = (scene->second)->GetModels().begin(); it != (scene->second)->GetModels().end(); ++it)
         {
-            UINT uStride = sizeof(SimpleVertex);
+            UINT uStride = it->second->GetVertexStride();
             UINT uOffset = 0;
             m_immediateContext->IASetVertexBuffers(0u, 1u, it->second->GetVertexBuffer().GetAddressOf(), &uStride, &uOffset);
-            m_immediateContext->IASetIndexBuffer(it->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-            m_immediateContext->IASetInputLayout(m_shadowVertexShader->GetVertexLayout().Get());
+            m_immediateContext->IASetIndexBuffer(it->second->GetIndexBuffer().Get(), it->second->GetIndexFormat(), 0);
+
+            // Compressed positions are moved back into the box of the model by the world matrix
+            XMMATRIX world = it->second->GetWorldMatrix();
+            if (it->second->IsVertexCompressed())
+            {
+                const XMFLOAT4& scale = it->second->GetPositionScale();
+                world = XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixTranslationFromVector(XMLoadFloat4(&it->second->GetPositionOffset())) * world;
+                m_immediateContext->IASetInputLayout(m_shadowVertexShader->GetQuantizedVertexLayout().Get());
+            }
+            else
+            {
+                m_immediateContext->IASetInputLayout(m_shadowVertexShader->GetVertexLayout().Get());
+            }
 
             // Update and bind CBShadowMatrix constant buffer
             CBShadowMatrix cbShadow = {};
             for (int i = 0u; i < NUM_LIGHTS; ++i)
             {
-                cbShadow.World = XMMatrixTranspose(it->second->GetWorldMatrix());
+                cbShadow.World = XMMatrixTranspose(world);
                 cbShadow.View = XMMatrixTranspose((scene->second)->GetPointLight(i)->GetViewMatrix());
                 cbShadow.Projection = XMMatrixTranspose((scene->second)->GetPointLight(i)->GetProjectionMatrix());
                 cbShadow.IsVoxel = false;
@@ -1068,12 +1380,19 @@ namespace library
             m_immediateContext->PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0u);
             m_immediateContext->PSSetConstantBuffers(0u, 1u, m_cbShadowMatrix.GetAddressOf());
 
-            // Draw
-            m_immediateContext->DrawIndexed(
-                it->second->GetNumIndices(),
-                0,
-                0
-            );
+            // Draw each mesh at the level of detail the camera sees, so the shadow matches the model
+            XMFLOAT3 boundsMin, boundsMax;
+            it->second->GetWorldBounds(boundsMin, boundsMax);
+            const UINT uLod = it->second->SelectLod(boundsMin, boundsMax, m_camera.GetEye());
+            for (UINT i = 0u; i < it->second->GetNumMeshes(); ++i)
+            {
+                const auto& lodMesh = it->second->GetLodMesh(i, uLod);
+                m_immediateContext->DrawIndexed(
+                    lodMesh.uNumIndices,
+                    lodMesh.uBaseIndex,
+                    lodMesh.uBaseVertex
+                );
+            }
         }
 
         // m_swapChain->Present(0, 0);
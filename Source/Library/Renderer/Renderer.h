@@ -72,6 +72,12 @@ namespace library
 
         D3D_DRIVER_TYPE GetDriverType() const;
 
+    private:
+        static constexpr const UINT FRAME_TIME_LOG_INTERVAL = 600u;
+
+    private:
+        void logStatistics() const;
+
     private:
         D3D_DRIVER_TYPE m_driverType;
         D3D_FEATURE_LEVEL m_featureLevel;
@@ -97,5 +103,8 @@ namespace library
         std::shared_ptr<RenderTexture> m_shadowMapTexture;
         std::shared_ptr<ShadowVertexShader> m_shadowVertexShader;
         std::shared_ptr<PixelShader> m_shadowPixelShader;
+        FLOAT m_frameTimeSum;
+        UINT m_uNumTimedFrames;
+        UINT64 m_uNumModelTriangles;
     };
 }
\ No newline at end of file
@@ -54,6 +54,9 @@ namespace library
         // Set the first meshs material index to 0
         m_aMeshes[0].uMaterialIndex = 0;
 
+        // The materials are shared with the other skyboxes of the file, so this one changes its own copy
+        m_aMaterials[0] = std::make_shared<Material>(*m_aMaterials[0]);
+
         // Set and initialize the first(0th) materials diffuse texture by the m_cubeMapFileName
         m_aMaterials[0]->pDiffuse = std::make_shared<Texture>(m_cubeMapFileName);
         hr = m_aMaterials[0]->pDiffuse->Initialize(pDevice, pImmediateContext);
@@ -104,7 +107,7 @@ namespace library
             const aiVector3D& normal = pMesh->mNormals[i];
             const aiVector3D& texCoord = pMesh->HasTextureCoords(0u) ? pMesh->mTextureCoords[0][i] : zero3d;
 
-            m_aVertices.push_back(
+            m_asset->aVertices.push_back(
                 SimpleVertex
                 {
                     .Position = XMFLOAT3(position.x, position.y, position.z),
@@ -116,7 +119,7 @@ namespace library
             const aiVector3D& tangent = pMesh->HasTangentsAndBitangents() ? pMesh->mTangents[i] : zero3d;
             const aiVector3D& bitangent = pMesh->HasTangentsAndBitangents() ? pMesh->mBitangents[i] : zero3d;
 
-            m_aNormalData.push_back(
+            m_asset->aNormalData.push_back(
                 NormalData
                 {
                     .Tangent = XMFLOAT3(tangent.x, tangent.y, tangent.z),
@@ -135,10 +138,54 @@ namespace library
             const aiFace& face = pMesh->mFaces[i];
             assert(face.mNumIndices == 3u);
 
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[2]));
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[1]));
-            m_aIndices.push_back(static_cast<WORD>(face.mIndices[0]));
+            m_asset->aIndices.push_back(face.mIndices[2]);
+            m_asset->aIndices.push_back(face.mIndices[1]);
+            m_asset->aIndices.push_back(face.mIndices[0]);
         }
     }
 
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Skybox::usesLods
+
+      Summary:  The skybox surrounds the camera and is always drawn
+                whole, so it needs no levels of detail
+
+      Returns:  BOOL
+                  FALSE
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Skybox::usesLods() const
+    {
+        return FALSE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Skybox::usesMeshCache
+
+      Summary:  The skybox reverses the winding of the sphere, so it
+                does not share the mesh cache Model writes for it
+
+      Returns:  BOOL
+                  FALSE
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Skybox::usesMeshCache() const
+    {
+        return FALSE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Skybox::usesRayBvh
+
+      Summary:  Rays start inside the skybox and are meant for the
+                scene, so it has no triangle BVH
+
+      Returns:  BOOL
+                  FALSE
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Skybox::usesRayBvh() const
+    {
+        return FALSE;
+    }
 }
\ No newline at end of file
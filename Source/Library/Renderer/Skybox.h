@@ -34,6 +34,9 @@ namespace library
 
     protected:
         virtual void initSingleMesh(_In_ UINT uMeshIndex, _In_ const aiMesh* pMesh) override;
+        virtual BOOL usesLods() const override;
+        virtual BOOL usesMeshCache() const override;
+        virtual BOOL usesRayBvh() const override;
 
     protected:
         std::filesystem::path m_cubeMapFileName;
@@ -0,0 +1,602 @@
+#include "Renderer/TangentGenerator.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const FLOAT MIN_LENGTH_SQUARED = 1e-20f;
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Float3x4
+
+          Summary:  TangentGenerator::NUM_LANES 3D vectors, one per lane
+                    of each component
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Float3x4
+        {
+            XMVECTOR x;
+            XMVECTOR y;
+            XMVECTOR z;
+        };
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: subtract
+
+          Summary:  Subtracts the vectors of every lane
+
+          Args:     const Float3x4& a
+                      Vectors to subtract from
+                    const Float3x4& b
+                      Vectors to subtract
+
+          Returns:  Float3x4
+                      a - b
+        -----------------------------------------------------------------F-F*/
+        Float3x4 subtract(_In_ const Float3x4& a, _In_ const Float3x4& b)
+        {
+            return Float3x4{ XMVectorSubtract(a.x, b.x), XMVectorSubtract(a.y, b.y), XMVectorSubtract(a.z, b.z) };
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: dot
+
+          Summary:  Dot products of the vectors of every lane
+
+          Args:     const Float3x4& a
+                      First vectors
+                    const Float3x4& b
+                      Second vectors
+
+          Returns:  XMVECTOR
+                      Dot product of each lane
+        -----------------------------------------------------------------F-F*/
+        XMVECTOR dot(_In_ const Float3x4& a, _In_ const Float3x4& b)
+        {
+            return XMVectorMultiplyAdd(a.x, b.x, XMVectorMultiplyAdd(a.y, b.y, XMVectorMultiply(a.z, b.z)));
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: scale
+
+          Summary:  Scales the vector of every lane by the scale of its
+                    lane
+
+          Args:     const Float3x4& v
+                      Vectors to scale
+                    FXMVECTOR scales
+                      Scale of each lane
+
+          Returns:  Float3x4
+                      Scaled vectors
+        -----------------------------------------------------------------F-F*/
+        Float3x4 scale(_In_ const Float3x4& v, _In_ FXMVECTOR scales)
+        {
+            return Float3x4{ XMVectorMultiply(v.x, scales), XMVectorMultiply(v.y, scales), XMVectorMultiply(v.z, scales) };
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: normalizeOrZero
+
+          Summary:  Normalizes the vectors of every lane, leaving zero in
+                    the lanes too short to have a direction
+
+          Args:     const Float3x4& v
+                      Vectors to normalize
+
+          Returns:  Float3x4
+                      Unit or zero vectors
+        -----------------------------------------------------------------F-F*/
+        Float3x4 normalizeOrZero(_In_ const Float3x4& v)
+        {
+            const XMVECTOR lengthSquared = dot(v, v);
+            const XMVECTOR minLengthSquared = XMVectorReplicate(MIN_LENGTH_SQUARED);
+            const XMVECTOR inverseLength = XMVectorDivide(XMVectorReplicate(1.0f), XMVectorSqrt(XMVectorMax(lengthSquared, minLengthSquared)));
+            return scale(v, XMVectorSelect(XMVectorZero(), inverseLength, XMVectorGreater(lengthSquared, minLengthSquared)));
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: orthogonalize
+
+          Summary:  Removes from the vectors of every lane their part
+                    along the unit normal of the lane, which is the
+                    Gram-Schmidt step of the tangent frame
+
+          Args:     const Float3x4& v
+                      Vectors to orthogonalize
+                    const Float3x4& normal
+                      Unit normals, or zero to leave the vector as is
+
+          Returns:  Float3x4
+                      Vectors perpendicular to the normals
+        -----------------------------------------------------------------F-F*/
+        Float3x4 orthogonalize(_In_ const Float3x4& v, _In_ const Float3x4& normal)
+        {
+            const XMVECTOR projection = dot(normal, v);
+            return Float3x4{
+                XMVectorNegativeMultiplySubtract(normal.x, projection, v.x),
+                XMVectorNegativeMultiplySubtract(normal.y, projection, v.y),
+                XMVectorNegativeMultiplySubtract(normal.z, projection, v.z)
+            };
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TangentGenerator::TangentGenerator
+
+      Summary:  Constructor
+
+      Modifies: [m_uNumThreads].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    TangentGenerator::TangentGenerator()
+        : m_uNumThreads(0u)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TangentGenerator::Generate
+
+      Summary:  Builds the tangent frames of the vertices. Each part of
+                the faces is summed into its own copy of the vertices,
+                then the copies are added up and resolved in blocks of
+                vertices, so no two threads ever write the same memory
+                and the sums are added in the same order on any number
+                of threads
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices, with their normals and texture coordinates
+                UINT uNumVertices
+                  Number of vertices
+                const void* pIndexData
+                  Triangle list
+                DXGI_FORMAT indexFormat
+                  DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+                UINT uNumIndices
+                  Number of indices
+                std::vector<NormalData>& outNormalData
+                  Tangent frame of every vertex
+                UINT uNumThreads
+                  Number of threads, 0 for the hardware concurrency
+
+      Modifies: [m_uNumThreads].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if the index format is not
+                  supported or an index is out of range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TangentGenerator::Generate(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_ UINT uNumVertices,
+        _In_ const void* pIndexData,
+        _In_ DXGI_FORMAT indexFormat,
+        _In_ UINT uNumIndices,
+        _Out_ std::vector<NormalData>& outNormalData,
+        _In_opt_ UINT uNumThreads
+    )
+    {
+        outNormalData.clear();
+        m_uNumThreads = 0u;
+        if (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT)
+        {
+            return E_INVALIDARG;
+        }
+
+        const BOOL bIs32Bit = indexFormat == DXGI_FORMAT_R32_UINT;
+        const UINT uNumFaces = uNumIndices / 3u;
+        for (UINT i = 0u; i < uNumFaces * 3u; ++i)
+        {
+            const UINT uIndex = bIs32Bit ? static_cast<const UINT*>(pIndexData)[i] : static_cast<const WORD*>(pIndexData)[i];
+            if (uIndex >= uNumVertices)
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        const UINT uNumFaceBlocks = (uNumFaces + NUM_FACES_PER_BLOCK - 1u) / NUM_FACES_PER_BLOCK;
+        const UINT uNumVertexBlocks = (uNumVertices + NUM_VERTICES_PER_BLOCK - 1u) / NUM_VERTICES_PER_BLOCK;
+        const UINT uNumParts = std::min(NUM_PARTS, std::max(uNumFaceBlocks, 1u));
+
+        // Every part clears and fills its own sums, so a small mesh never leaves the calling thread
+        std::vector<std::vector<NormalData>> aaSums(uNumParts);
+        m_uNumThreads = ParallelFor(uNumParts, uNumThreads,
+            [&](UINT uPart, UINT)
+            {
+                std::vector<NormalData>& aSums = aaSums[uPart];
+                aSums.assign(uNumVertices, NormalData());
+
+                const UINT uEndBlock = (uPart + 1u) * uNumFaceBlocks / uNumParts;
+                for (UINT uBlock = uPart * uNumFaceBlocks / uNumParts; uBlock < uEndBlock; ++uBlock)
+                {
+                    const UINT uFirstFace = uBlock * NUM_FACES_PER_BLOCK;
+                    accumulateFaces(pVertices, pIndexData, bIs32Bit, uFirstFace, std::min(NUM_FACES_PER_BLOCK, uNumFaces - uFirstFace), aSums.data());
+                }
+            }
+        );
+
+        outNormalData.resize(uNumVertices);
+        ParallelFor(uNumVertexBlocks, uNumThreads,
+            [&](UINT uBlock, UINT)
+            {
+                const UINT uEnd = std::min((uBlock + 1u) * NUM_VERTICES_PER_BLOCK, uNumVertices);
+                for (UINT uVertex = uBlock * NUM_VERTICES_PER_BLOCK; uVertex < uEnd; ++uVertex)
+                {
+                    NormalData sum = aaSums[0][uVertex];
+                    for (UINT uPart = 1u; uPart < uNumParts; ++uPart)
+                    {
+                        const NormalData& partSum = aaSums[uPart][uVertex];
+                        sum.Tangent.x += partSum.Tangent.x;
+                        sum.Tangent.y += partSum.Tangent.y;
+                        sum.Tangent.z += partSum.Tangent.z;
+                        sum.Bitangent.x += partSum.Bitangent.x;
+                        sum.Bitangent.y += partSum.Bitangent.y;
+                        sum.Bitangent.z += partSum.Bitangent.z;
+                    }
+
+                    resolveVertex(pVertices[uVertex], sum, outNormalData[uVertex]);
+                }
+            }
+        );
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TangentGenerator::GetNumThreads
+
+      Summary:  Returns the number of threads of the last Generate
+
+      Returns:  UINT
+                  Number of threads, the calling one included
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TangentGenerator::GetNumThreads() const
+    {
+        return m_uNumThreads;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TangentGenerator::Check
+
+      Summary:  Generates the tangent frames of three meshes and logs
+                whether they hold. The tangents of a UV sphere are
+                compared with the analytic ones away from the poles,
+                two quads with mirrored UVs must get opposite
+                handedness, and a wavy grid spanning every part must
+                come out bit-identical on one thread and on a thread
+                per part
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if a check fails
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TangentGenerator::Check()
+    {
+        static constexpr const UINT NUM_SPHERE_SLICES = 64u;
+        static constexpr const UINT NUM_SPHERE_STACKS = 32u;
+        static constexpr const FLOAT MAX_SPHERE_ERROR_DEGREES = 5.0f;
+        static constexpr const UINT NUM_GRID_QUADS = 200u;
+
+        TangentGenerator generator;
+        std::vector<NormalData> aNormalData;
+        HRESULT hr = S_OK;
+
+        // UV sphere with a seam, u around the y axis and v from the top
+        std::vector<SimpleVertex> aVertices;
+        std::vector<WORD> aSphereIndices;
+        for (UINT uStack = 0u; uStack <= NUM_SPHERE_STACKS; ++uStack)
+        {
+            for (UINT uSlice = 0u; uSlice <= NUM_SPHERE_SLICES; ++uSlice)
+            {
+                const FLOAT u = static_cast<FLOAT>(uSlice) / static_cast<FLOAT>(NUM_SPHERE_SLICES);
+                const FLOAT v = static_cast<FLOAT>(uStack) / static_cast<FLOAT>(NUM_SPHERE_STACKS);
+                const FLOAT theta = u * XM_2PI;
+                const FLOAT phi = v * XM_PI;
+                const XMFLOAT3 position(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+                aVertices.push_back({ position, XMFLOAT2(u, v), position });
+
+                if (uStack < NUM_SPHERE_STACKS && uSlice < NUM_SPHERE_SLICES)
+                {
+                    const WORD uCorner = static_cast<WORD>(uStack * (NUM_SPHERE_SLICES + 1u) + uSlice);
+                    const WORD uBelow = static_cast<WORD>(uCorner + NUM_SPHERE_SLICES + 1u);
+                    aSphereIndices.insert(aSphereIndices.end(), { uCorner, uBelow, static_cast<WORD>(uCorner + 1u), static_cast<WORD>(uCorner + 1u), uBelow, static_cast<WORD>(uBelow + 1u) });
+                }
+            }
+        }
+
+        hr = generator.Generate(aVertices.data(), static_cast<UINT>(aVertices.size()), aSphereIndices.data(), DXGI_FORMAT_R16_UINT, static_cast<UINT>(aSphereIndices.size()), aNormalData);
+        if (FAILED(hr))
+            return hr;
+
+        FLOAT maxSphereError = 0.0f;
+        BOOL bIsSphereRightHanded = TRUE;
+        for (UINT uStack = 1u; uStack < NUM_SPHERE_STACKS; ++uStack)
+        {
+            for (UINT uSlice = 0u; uSlice <= NUM_SPHERE_SLICES; ++uSlice)
+            {
+                const UINT uVertex = uStack * (NUM_SPHERE_SLICES + 1u) + uSlice;
+                const FLOAT theta = static_cast<FLOAT>(uSlice) / static_cast<FLOAT>(NUM_SPHERE_SLICES) * XM_2PI;
+                const FLOAT phi = static_cast<FLOAT>(uStack) / static_cast<FLOAT>(NUM_SPHERE_STACKS) * XM_PI;
+                const XMVECTOR tangent = XMVectorSet(-sinf(theta), 0.0f, cosf(theta), 0.0f);
+                const XMVECTOR bitangent = XMVectorSet(cosf(phi) * cosf(theta), -sinf(phi), cosf(phi) * sinf(theta), 0.0f);
+
+                const FLOAT cosError = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&aNormalData[uVertex].Tangent), tangent));
+                maxSphereError = std::max(maxSphereError, XMConvertToDegrees(acosf(std::clamp(cosError, -1.0f, 1.0f))));
+                if (XMVectorGetX(XMVector3Dot(XMLoadFloat3(&aNormalData[uVertex].Bitangent), bitangent)) <= 0.0f)
+                {
+                    bIsSphereRightHanded = FALSE;
+                }
+            }
+        }
+        const BOOL bIsSphereCorrect = maxSphereError <= MAX_SPHERE_ERROR_DEGREES && bIsSphereRightHanded;
+
+        // Two quads facing +z, the second with u running against x
+        aVertices.clear();
+        for (UINT uQuad = 0u; uQuad < 2u; ++uQuad)
+        {
+            for (UINT uCorner = 0u; uCorner < 4u; ++uCorner)
+            {
+                const FLOAT x = static_cast<FLOAT>(uCorner & 1u);
+                const FLOAT y = static_cast<FLOAT>(uCorner >> 1u);
+                aVertices.push_back({ XMFLOAT3(x + 2.0f * uQuad, y, 0.0f), XMFLOAT2(uQuad == 0u ? x : 1.0f - x, y), XMFLOAT3(0.0f, 0.0f, 1.0f) });
+            }
+        }
+        const UINT aQuadIndices[12] = { 0u, 1u, 2u, 2u, 1u, 3u, 4u, 5u, 6u, 6u, 5u, 7u };
+
+        hr = generator.Generate(aVertices.data(), static_cast<UINT>(aVertices.size()), aQuadIndices, DXGI_FORMAT_R32_UINT, ARRAYSIZE(aQuadIndices), aNormalData);
+        if (FAILED(hr))
+            return hr;
+
+        BOOL bIsMirrorCorrect = TRUE;
+        for (UINT uVertex = 0u; uVertex < aVertices.size(); ++uVertex)
+        {
+            const XMVECTOR tangent = XMVectorSet(uVertex < 4u ? 1.0f : -1.0f, 0.0f, 0.0f, 0.0f);
+            if (XMVectorGetX(XMVector3Dot(XMLoadFloat3(&aNormalData[uVertex].Tangent), tangent)) < 0.999f ||
+                aNormalData[uVertex].Bitangent.y < 0.999f)
+            {
+                bIsMirrorCorrect = FALSE;
+            }
+        }
+
+        // Wavy grid with skewed UVs, large enough for every part
+        aVertices.clear();
+        std::vector<UINT> aGridIndices;
+        for (UINT uRow = 0u; uRow <= NUM_GRID_QUADS; ++uRow)
+        {
+            for (UINT uColumn = 0u; uColumn <= NUM_GRID_QUADS; ++uColumn)
+            {
+                const FLOAT x = static_cast<FLOAT>(uColumn);
+                const FLOAT y = static_cast<FLOAT>(uRow);
+                const XMVECTOR normal = XMVector3Normalize(XMVectorSet(-0.37f * cosf(x * 0.37f) * cosf(y * 0.23f), 0.23f * sinf(x * 0.37f) * sinf(y * 0.23f), 1.0f, 0.0f));
+                SimpleVertex vertex = { XMFLOAT3(x, y, sinf(x * 0.37f) * cosf(y * 0.23f)), XMFLOAT2(x * 0.05f + 0.01f * sinf(y), y * 0.05f), XMFLOAT3() };
+                XMStoreFloat3(&vertex.Normal, normal);
+                aVertices.push_back(vertex);
+
+                if (uRow < NUM_GRID_QUADS && uColumn < NUM_GRID_QUADS)
+                {
+                    const UINT uCorner = uRow * (NUM_GRID_QUADS + 1u) + uColumn;
+                    const UINT uAbove = uCorner + NUM_GRID_QUADS + 1u;
+                    aGridIndices.insert(aGridIndices.end(), { uCorner, uCorner + 1u, uAbove, uAbove, uCorner + 1u, uAbove + 1u });
+                }
+            }
+        }
+
+        std::vector<NormalData> aSingleThreadNormalData;
+        hr = generator.Generate(aVertices.data(), static_cast<UINT>(aVertices.size()), aGridIndices.data(), DXGI_FORMAT_R32_UINT, static_cast<UINT>(aGridIndices.size()), aSingleThreadNormalData, 1u);
+        if (FAILED(hr))
+            return hr;
+
+        hr = generator.Generate(aVertices.data(), static_cast<UINT>(aVertices.size()), aGridIndices.data(), DXGI_FORMAT_R32_UINT, static_cast<UINT>(aGridIndices.size()), aNormalData, NUM_PARTS);
+        if (FAILED(hr))
+            return hr;
+
+        const BOOL bIsDeterministic = aNormalData.size() == aSingleThreadNormalData.size() &&
+            memcmp(aNormalData.data(), aSingleThreadNormalData.data(), aNormalData.size() * sizeof(NormalData)) == 0;
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "TangentGenerator check: sphere %.2f degrees at worst (%s), mirrored UVs (%s), %u faces on 1 and %u threads (%s)\n",
+            maxSphereError,
+            bIsSphereCorrect ? "passed" : "FAILED",
+            bIsMirrorCorrect ? "passed" : "FAILED",
+            static_cast<UINT>(aGridIndices.size() / 3u),
+            generator.GetNumThreads(),
+            bIsDeterministic ? "bit-identical" : "FAILED"
+        );
+        OutputDebugStringA(szDebugMessage);
+
+        return bIsSphereCorrect && bIsMirrorCorrect && bIsDeterministic ? S_OK : E_FAIL;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TangentGenerator::accumulateFaces
+
+      Summary:  Adds the angle weighted tangent and bitangent of every
+                corner of a range of faces to its vertex, NUM_LANES
+                faces at a time. Faces without a UV area and the lanes
+                past the last face add nothing
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices
+                const void* pIndexData
+                  Triangle list
+                BOOL bIs32Bit
+                  Whether the indices are UINT rather than WORD
+                UINT uFirstFace
+                  First face of the range
+                UINT uNumFaces
+                  Number of faces in the range
+                NormalData* pSums
+                  Sums of the vertices to add to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TangentGenerator::accumulateFaces(
+        _In_ const SimpleVertex* pVertices,
+        _In_ const void* pIndexData,
+        _In_ BOOL bIs32Bit,
+        _In_ UINT uFirstFace,
+        _In_ UINT uNumFaces,
+        _Inout_ NormalData* pSums
+    )
+    {
+        auto getIndex = [&](UINT i) -> UINT
+        {
+            return bIs32Bit ? static_cast<const UINT*>(pIndexData)[i] : static_cast<const WORD*>(pIndexData)[i];
+        };
+
+        const XMVECTOR laneIndices = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+        const UINT uEnd = uFirstFace + uNumFaces;
+        for (UINT uFace = uFirstFace; uFace < uEnd; uFace += NUM_LANES)
+        {
+            const UINT uNumLanes = std::min(NUM_LANES, uEnd - uFace);
+
+            // Lanes past the last face repeat it, their weight is zeroed below
+            UINT aaIndices[3][NUM_LANES];
+            Float3x4 aPositions[3];
+            Float3x4 aNormals[3];
+            XMVECTOR aU[3];
+            XMVECTOR aV[3];
+            for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+            {
+                for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+                {
+                    aaIndices[uCorner][uLane] = getIndex((uFace + std::min(uLane, uNumLanes - 1u)) * 3u + uCorner);
+                }
+
+                const SimpleVertex& v0 = pVertices[aaIndices[uCorner][0]];
+                const SimpleVertex& v1 = pVertices[aaIndices[uCorner][1]];
+                const SimpleVertex& v2 = pVertices[aaIndices[uCorner][2]];
+                const SimpleVertex& v3 = pVertices[aaIndices[uCorner][3]];
+                aPositions[uCorner] = Float3x4{
+                    XMVectorSet(v0.Position.x, v1.Position.x, v2.Position.x, v3.Position.x),
+                    XMVectorSet(v0.Position.y, v1.Position.y, v2.Position.y, v3.Position.y),
+                    XMVectorSet(v0.Position.z, v1.Position.z, v2.Position.z, v3.Position.z)
+                };
+                aNormals[uCorner] = normalizeOrZero(Float3x4{
+                    XMVectorSet(v0.Normal.x, v1.Normal.x, v2.Normal.x, v3.Normal.x),
+                    XMVectorSet(v0.Normal.y, v1.Normal.y, v2.Normal.y, v3.Normal.y),
+                    XMVectorSet(v0.Normal.z, v1.Normal.z, v2.Normal.z, v3.Normal.z)
+                });
+                aU[uCorner] = XMVectorSet(v0.TexCoord.x, v1.TexCoord.x, v2.TexCoord.x, v3.TexCoord.x);
+                aV[uCorner] = XMVectorSet(v0.TexCoord.y, v1.TexCoord.y, v2.TexCoord.y, v3.TexCoord.y);
+            }
+
+            // Solve edge = du * T + dv * B, keeping the directions and orienting them by the sign of the UV area
+            const Float3x4 edge1 = subtract(aPositions[1], aPositions[0]);
+            const Float3x4 edge2 = subtract(aPositions[2], aPositions[0]);
+            const XMVECTOR du1 = XMVectorSubtract(aU[1], aU[0]);
+            const XMVECTOR dv1 = XMVectorSubtract(aV[1], aV[0]);
+            const XMVECTOR du2 = XMVectorSubtract(aU[2], aU[0]);
+            const XMVECTOR dv2 = XMVectorSubtract(aV[2], aV[0]);
+            const XMVECTOR signedArea = XMVectorSubtract(XMVectorMultiply(du1, dv2), XMVectorMultiply(du2, dv1));
+            const XMVECTOR orientation = XMVectorSelect(XMVectorReplicate(1.0f), XMVectorReplicate(-1.0f), XMVectorLess(signedArea, XMVectorZero()));
+
+            const Float3x4 faceTangent = scale(normalizeOrZero(Float3x4{
+                XMVectorSubtract(XMVectorMultiply(dv2, edge1.x), XMVectorMultiply(dv1, edge2.x)),
+                XMVectorSubtract(XMVectorMultiply(dv2, edge1.y), XMVectorMultiply(dv1, edge2.y)),
+                XMVectorSubtract(XMVectorMultiply(dv2, edge1.z), XMVectorMultiply(dv1, edge2.z))
+            }), orientation);
+            const Float3x4 faceBitangent = scale(normalizeOrZero(Float3x4{
+                XMVectorSubtract(XMVectorMultiply(du1, edge2.x), XMVectorMultiply(du2, edge1.x)),
+                XMVectorSubtract(XMVectorMultiply(du1, edge2.y), XMVectorMultiply(du2, edge1.y)),
+                XMVectorSubtract(XMVectorMultiply(du1, edge2.z), XMVectorMultiply(du2, edge1.z))
+            }), orientation);
+
+            const XMVECTOR hasArea = XMVectorGreater(XMVectorAbs(signedArea), XMVectorReplicate(MIN_LENGTH_SQUARED));
+            const XMVECTOR isFace = XMVectorLess(laneIndices, XMVectorReplicate(static_cast<FLOAT>(uNumLanes)));
+            const XMVECTOR isValid = XMVectorAndInt(hasArea, isFace);
+
+            for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+            {
+                const Float3x4& normal = aNormals[uCorner];
+                const Float3x4 toNext = normalizeOrZero(orthogonalize(subtract(aPositions[(uCorner + 1u) % 3u], aPositions[uCorner]), normal));
+                const Float3x4 toPrevious = normalizeOrZero(orthogonalize(subtract(aPositions[(uCorner + 2u) % 3u], aPositions[uCorner]), normal));
+                const XMVECTOR angle = XMVectorACos(XMVectorClamp(dot(toNext, toPrevious), XMVectorReplicate(-1.0f), XMVectorReplicate(1.0f)));
+                const XMVECTOR weight = XMVectorSelect(XMVectorZero(), angle, isValid);
+
+                const Float3x4 tangent = scale(normalizeOrZero(orthogonalize(faceTangent, normal)), weight);
+                const Float3x4 bitangent = scale(normalizeOrZero(orthogonalize(faceBitangent, normal)), weight);
+
+                FLOAT aaLanes[6][NUM_LANES];
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(aaLanes[0]), tangent.x);
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(aaLanes[1]), tangent.y);
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(aaLanes[2]), tangent.z);
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(aaLanes[3]), bitangent.x);
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(aaLanes[4]), bitangent.y);
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(aaLanes[5]), bitangent.z);
+                for (UINT uLane = 0u; uLane < uNumLanes; ++uLane)
+                {
+                    NormalData& sum = pSums[aaIndices[uCorner][uLane]];
+                    sum.Tangent.x += aaLanes[0][uLane];
+                    sum.Tangent.y += aaLanes[1][uLane];
+                    sum.Tangent.z += aaLanes[2][uLane];
+                    sum.Bitangent.x += aaLanes[3][uLane];
+                    sum.Bitangent.y += aaLanes[4][uLane];
+                    sum.Bitangent.z += aaLanes[5][uLane];
+                }
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TangentGenerator::resolveVertex
+
+      Summary:  Turns the sums of a vertex into its tangent frame. The
+                tangent is orthogonalized against the normal, and the
+                bitangent is cross(normal, tangent) on the side of the
+                summed bitangents. A vertex no face gave a tangent gets
+                any tangent perpendicular to its normal
+
+      Args:     const SimpleVertex& vertex
+                  Vertex
+                const NormalData& sum
+                  Angle weighted sums of its corners
+                NormalData& normalData
+                  Tangent frame of the vertex
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TangentGenerator::resolveVertex(_In_ const SimpleVertex& vertex, _In_ const NormalData& sum, _Out_ NormalData& normalData)
+    {
+        const XMVECTOR minLengthSquared = XMVectorReplicate(MIN_LENGTH_SQUARED);
+        const XMVECTOR bitangentSum = XMLoadFloat3(&sum.Bitangent);
+
+        XMVECTOR normal = XMLoadFloat3(&vertex.Normal);
+        if (XMVector3Less(XMVector3LengthSq(normal), minLengthSquared))
+        {
+            // Without a normal, keep the summed frame as it is
+            XMVECTOR tangent = XMLoadFloat3(&sum.Tangent);
+            tangent = XMVector3Less(XMVector3LengthSq(tangent), minLengthSquared) ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVector3Normalize(tangent);
+            XMVECTOR bitangent = XMVectorSubtract(bitangentSum, XMVectorMultiply(tangent, XMVector3Dot(tangent, bitangentSum)));
+            bitangent = XMVector3Less(XMVector3LengthSq(bitangent), minLengthSquared) ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVector3Normalize(bitangent);
+            XMStoreFloat3(&normalData.Tangent, tangent);
+            XMStoreFloat3(&normalData.Bitangent, bitangent);
+            return;
+        }
+        normal = XMVector3Normalize(normal);
+
+        XMVECTOR tangent = XMLoadFloat3(&sum.Tangent);
+        tangent = XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent)));
+        if (XMVector3Less(XMVector3LengthSq(tangent), minLengthSquared))
+        {
+            const XMVECTOR axis = fabsf(XMVectorGetX(normal)) < 0.9f
+                ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f)
+                : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+            tangent = XMVectorSubtract(axis, XMVectorMultiply(normal, XMVector3Dot(normal, axis)));
+        }
+        tangent = XMVector3Normalize(tangent);
+
+        XMVECTOR bitangent = XMVector3Cross(normal, tangent);
+        if (XMVectorGetX(XMVector3Dot(bitangent, bitangentSum)) < 0.0f)
+        {
+            bitangent = XMVectorNegate(bitangent);
+        }
+
+        XMStoreFloat3(&normalData.Tangent, tangent);
+        XMStoreFloat3(&normalData.Bitangent, bitangent);
+    }
+}
@@ -0,0 +1,101 @@
+/*+===================================================================
+  File:      TANGENTGENERATOR.H
+
+  Summary:   TangentGenerator header file contains declarations of
+             TangentGenerator class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: TangentGenerator
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    TangentGenerator
+
+      Summary:  Builds the tangent frame of every vertex the way
+                MikkTSpace does, without splitting vertices. Each face
+                gives a tangent and a bitangent from its UV mapping,
+                oriented by the sign of its UV area. At each corner
+                they are made perpendicular to the vertex normal and
+                added to the vertex weighted by the angle of the
+                corner. The tangent of a vertex is then
+                orthogonalized against its normal once more, and its
+                bitangent is the cross product of the normal and the
+                tangent, flipped to the side the summed bitangents
+                lean to. Faces are processed NUM_LANES at a time, one
+                per SIMD lane, in blocks of NUM_FACES_PER_BLOCK. The
+                blocks are cut into at most NUM_PARTS contiguous
+                parts, each summed into its own copy of the vertices
+                by whichever thread takes it, and the copies are added
+                in part order in blocks of NUM_VERTICES_PER_BLOCK. The
+                parts do not depend on the threads, so neither do the
+                tangent frames
+
+      Methods:  Generate
+                  Builds the tangent frames of the vertices
+                GetNumThreads
+                  Returns the number of threads of the last Generate
+                Check
+                  Checks the tangent frames of generated meshes
+                TangentGenerator
+                  Constructor.
+                ~TangentGenerator
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class TangentGenerator
+    {
+    public:
+        static constexpr const UINT NUM_LANES = 4u;
+        static constexpr const UINT NUM_FACES_PER_BLOCK = 4096u;
+        static constexpr const UINT NUM_VERTICES_PER_BLOCK = 8192u;
+        static constexpr const UINT NUM_PARTS = 8u;
+
+    public:
+        TangentGenerator();
+        TangentGenerator(const TangentGenerator& other) = delete;
+        TangentGenerator(TangentGenerator&& other) = delete;
+        TangentGenerator& operator=(const TangentGenerator& other) = delete;
+        TangentGenerator& operator=(TangentGenerator&& other) = delete;
+        ~TangentGenerator() = default;
+
+        HRESULT Generate(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_ UINT uNumVertices,
+            _In_ const void* pIndexData,
+            _In_ DXGI_FORMAT indexFormat,
+            _In_ UINT uNumIndices,
+            _Out_ std::vector<NormalData>& outNormalData,
+            _In_opt_ UINT uNumThreads = 0u
+        );
+
+        UINT GetNumThreads() const;
+
+        static HRESULT Check();
+
+    private:
+        static void accumulateFaces(
+            _In_ const SimpleVertex* pVertices,
+            _In_ const void* pIndexData,
+            _In_ BOOL bIs32Bit,
+            _In_ UINT uFirstFace,
+            _In_ UINT uNumFaces,
+            _Inout_ NormalData* pSums
+        );
+        static void resolveVertex(
+            _In_ const SimpleVertex& vertex,
+            _In_ const NormalData& sum,
+            _Out_ NormalData& normalData
+        );
+
+    private:
+        UINT m_uNumThreads;
+    };
+}
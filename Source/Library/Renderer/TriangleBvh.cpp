@@ -0,0 +1,1210 @@
+#include "Renderer/TriangleBvh.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const FLOAT MIN_DIRECTION = 1e-20f;
+
+        // Ize, "Robust BVH Ray Traversal", widens the far distance so rounding cannot miss a tight box
+        constexpr const FLOAT FAR_DISTANCE_SCALE = 1.0f + 2.0f * 3.0f * 0.5f * FLT_EPSILON / (1.0f - 3.0f * 0.5f * FLT_EPSILON);
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: setLane
+
+          Summary:  Sets one lane of a vector stored as XMFLOAT4
+
+          Args:     XMFLOAT4& lanes
+                      Lanes to set
+                    UINT uLane
+                      Lane, from 0 to 3
+                    FLOAT value
+                      Value of the lane
+        -----------------------------------------------------------------F-F*/
+        void setLane(_Inout_ XMFLOAT4& lanes, _In_ UINT uLane, _In_ FLOAT value)
+        {
+            reinterpret_cast<FLOAT*>(&lanes.x)[uLane] = value;
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: getLane
+
+          Summary:  Returns one lane of a vector stored as XMFLOAT4
+
+          Args:     const XMFLOAT4& lanes
+                      Lanes to read
+                    UINT uLane
+                      Lane, from 0 to 3
+
+          Returns:  FLOAT
+                      Value of the lane
+        -----------------------------------------------------------------F-F*/
+        FLOAT getLane(_In_ const XMFLOAT4& lanes, _In_ UINT uLane)
+        {
+            return reinterpret_cast<const FLOAT*>(&lanes.x)[uLane];
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: getHalfArea
+
+          Summary:  Returns half the surface area of a box, which is all
+                    the surface area heuristic needs
+
+          Args:     FXMVECTOR boxMin
+                      Minimum corner
+                    FXMVECTOR boxMax
+                      Maximum corner
+
+          Returns:  FLOAT
+                      Half the surface area, 0 for an empty box
+        -----------------------------------------------------------------F-F*/
+        FLOAT getHalfArea(_In_ FXMVECTOR boxMin, _In_ FXMVECTOR boxMax)
+        {
+            XMFLOAT3 extents;
+            XMStoreFloat3(&extents, XMVectorMax(XMVectorSubtract(boxMax, boxMin), XMVectorZero()));
+            return extents.x * extents.y + extents.y * extents.z + extents.z * extents.x;
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: createEmptyNode
+
+          Summary:  Returns a node whose lanes are all unused
+
+          Returns:  TriangleBvh::Node
+                      Node with inverted boxes and no children
+        -----------------------------------------------------------------F-F*/
+        TriangleBvh::Node createEmptyNode()
+        {
+            TriangleBvh::Node node;
+            node.MinX = node.MinY = node.MinZ = XMFLOAT4(FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX);
+            node.MaxX = node.MaxY = node.MaxZ = XMFLOAT4(-FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (UINT uLane = 0u; uLane < TriangleBvh::NUM_LANES; ++uLane)
+            {
+                node.aChildren[uLane] = TriangleBvh::INVALID_INDEX;
+                node.aNumTriangles[uLane] = 0u;
+            }
+
+            return node;
+        }
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: setLaneBox
+
+          Summary:  Sets the box of one lane of a node
+
+          Args:     TriangleBvh::Node& node
+                      Node to set
+                    UINT uLane
+                      Lane of the child
+                    FXMVECTOR boxMin
+                      Minimum corner
+                    FXMVECTOR boxMax
+                      Maximum corner
+        -----------------------------------------------------------------F-F*/
+        void setLaneBox(_Inout_ TriangleBvh::Node& node, _In_ UINT uLane, _In_ FXMVECTOR boxMin, _In_ FXMVECTOR boxMax)
+        {
+            setLane(node.MinX, uLane, XMVectorGetX(boxMin));
+            setLane(node.MinY, uLane, XMVectorGetY(boxMin));
+            setLane(node.MinZ, uLane, XMVectorGetZ(boxMin));
+            setLane(node.MaxX, uLane, XMVectorGetX(boxMax));
+            setLane(node.MaxY, uLane, XMVectorGetY(boxMax));
+            setLane(node.MaxZ, uLane, XMVectorGetZ(boxMax));
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::TriangleBvh
+
+      Summary:  Constructor
+
+      Modifies: [m_aNodes, m_aTriangles, m_aMeshRoots, m_aPositions,
+                 m_buildTime, m_uNumThreads].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    TriangleBvh::TriangleBvh()
+        : m_aNodes(std::vector<Node>())
+        , m_aTriangles(std::vector<Triangle>())
+        , m_aMeshRoots(std::vector<MeshRoot>())
+        , m_aPositions(std::vector<XMFLOAT3>())
+        , m_buildTime(0.0f)
+        , m_uNumThreads(0u)
+    {
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::Build
+
+      Summary:  Builds the tree of every mesh, one job per mesh taken by
+                worker threads. Each job builds its nodes on their own,
+                and the trees are then laid one after the other, the
+                nodes of a mesh always after their parent
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices of every mesh
+                UINT uNumVertices
+                  Number of vertices
+                const void* pIndexData
+                  Index buffer of every mesh
+                DXGI_FORMAT indexFormat
+                  DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+                const std::vector<MeshRange>& aMeshes
+                  Index range of every mesh
+
+      Modifies: [m_aNodes, m_aTriangles, m_aMeshRoots, m_aPositions,
+                 m_buildTime, m_uNumThreads].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if the index format is not
+                  supported or an index is out of range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TriangleBvh::Build(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_ UINT uNumVertices,
+        _In_ const void* pIndexData,
+        _In_ DXGI_FORMAT indexFormat,
+        _In_ const std::vector<MeshRange>& aMeshes
+    )
+    {
+        m_aNodes.clear();
+        m_aTriangles.clear();
+        m_aMeshRoots.clear();
+        m_aPositions.clear();
+        m_buildTime = 0.0f;
+        m_uNumThreads = 0u;
+        if (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT)
+        {
+            return E_INVALIDARG;
+        }
+
+        LARGE_INTEGER startingTime;
+        LARGE_INTEGER endingTime;
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        const BOOL bIs32Bit = indexFormat == DXGI_FORMAT_R32_UINT;
+        auto getIndex = [&](UINT i) -> UINT
+        {
+            return bIs32Bit ? static_cast<const UINT*>(pIndexData)[i] : static_cast<const WORD*>(pIndexData)[i];
+        };
+
+        m_aPositions.resize(uNumVertices);
+        for (UINT i = 0u; i < uNumVertices; ++i)
+        {
+            m_aPositions[i] = pVertices[i].Position;
+        }
+
+        const UINT uNumMeshes = static_cast<UINT>(aMeshes.size());
+        const UINT uNumThreads = GetNumParallelThreads(uNumMeshes);
+
+        // Jobs only read the vertices and write the tree of their own mesh
+        std::vector<std::vector<Node>> aaMeshNodes(uNumMeshes);
+        std::vector<std::vector<Triangle>> aaMeshTriangles(uNumMeshes);
+        std::vector<HRESULT> aResults(uNumMeshes, S_OK);
+        std::vector<std::vector<BuildTriangle>> aaBuildTriangles(uNumThreads);
+        m_uNumThreads = ParallelFor(uNumMeshes, uNumThreads,
+            [&](UINT uJob, UINT uThread)
+            {
+                std::vector<BuildTriangle>& aBuildTriangles = aaBuildTriangles[uThread];
+                const MeshRange& mesh = aMeshes[uJob];
+                const UINT uNumTriangles = mesh.uNumIndices / 3u;
+                std::vector<Triangle> aTriangles(uNumTriangles);
+                aBuildTriangles.resize(uNumTriangles);
+                for (UINT uTriangle = 0u; uTriangle < uNumTriangles && SUCCEEDED(aResults[uJob]); ++uTriangle)
+                {
+                    Triangle& triangle = aTriangles[uTriangle];
+                    triangle.uFirstIndex = mesh.uBaseIndex + uTriangle * 3u;
+
+                    XMVECTOR boxMin = XMVectorReplicate(FLT_MAX);
+                    XMVECTOR boxMax = XMVectorReplicate(-FLT_MAX);
+                    for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+                    {
+                        triangle.aVertices[uCorner] = mesh.uBaseVertex + getIndex(triangle.uFirstIndex + uCorner);
+                        if (triangle.aVertices[uCorner] >= uNumVertices)
+                        {
+                            aResults[uJob] = E_INVALIDARG;
+                            break;
+                        }
+
+                        const XMVECTOR position = XMLoadFloat3(&m_aPositions[triangle.aVertices[uCorner]]);
+                        boxMin = XMVectorMin(boxMin, position);
+                        boxMax = XMVectorMax(boxMax, position);
+                    }
+
+                    BuildTriangle& buildTriangle = aBuildTriangles[uTriangle];
+                    XMStoreFloat3(&buildTriangle.Min, boxMin);
+                    XMStoreFloat3(&buildTriangle.Max, boxMax);
+                    XMStoreFloat3(&buildTriangle.Centroid, XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f));
+                    buildTriangle.uTriangle = uTriangle;
+                }
+                if (FAILED(aResults[uJob]))
+                {
+                    return;
+                }
+
+                buildMesh(aBuildTriangles, aaMeshNodes[uJob]);
+
+                // The leaves point into the build order, which becomes the order of the triangles
+                aaMeshTriangles[uJob].resize(uNumTriangles);
+                for (UINT uTriangle = 0u; uTriangle < uNumTriangles; ++uTriangle)
+                {
+                    aaMeshTriangles[uJob][uTriangle] = aTriangles[aBuildTriangles[uTriangle].uTriangle];
+                }
+            }
+        );
+
+        for (HRESULT hr : aResults)
+        {
+            if (FAILED(hr))
+            {
+                m_aPositions.clear();
+                return hr;
+            }
+        }
+
+        m_aMeshRoots.reserve(uNumMeshes);
+        for (UINT uMesh = 0u; uMesh < uNumMeshes; ++uMesh)
+        {
+            const UINT uNodeOffset = static_cast<UINT>(m_aNodes.size());
+            const UINT uTriangleOffset = static_cast<UINT>(m_aTriangles.size());
+            const std::vector<Node>& aNodes = aaMeshNodes[uMesh];
+            m_aMeshRoots.push_back({ aNodes.empty() ? INVALID_INDEX : uNodeOffset, static_cast<UINT>(aNodes.size()), uMesh, 0u });
+
+            for (Node node : aNodes)
+            {
+                for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+                {
+                    if (node.aChildren[uLane] != INVALID_INDEX)
+                    {
+                        node.aChildren[uLane] += node.aNumTriangles[uLane] > 0u ? uTriangleOffset : uNodeOffset;
+                    }
+                }
+                m_aNodes.push_back(node);
+            }
+            m_aTriangles.insert(m_aTriangles.end(), aaMeshTriangles[uMesh].begin(), aaMeshTriangles[uMesh].end());
+        }
+
+        QueryPerformanceCounter(&endingTime);
+        m_buildTime = static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart));
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::Restore
+
+      Summary:  Takes over trees built before, such as read from a
+                cache, after checking every index they hold. The
+                positions are taken from the vertices
+
+      Args:     const SimpleVertex* pVertices
+                  Vertices the trees were built from
+                UINT uNumVertices
+                  Number of vertices
+                std::vector<Node>& aNodes
+                  Nodes, taken over on success
+                std::vector<Triangle>& aTriangles
+                  Triangles, taken over on success
+                std::vector<MeshRoot>& aMeshRoots
+                  Roots, taken over on success
+
+      Modifies: [m_aNodes, m_aTriangles, m_aMeshRoots, m_aPositions,
+                 m_buildTime, m_uNumThreads].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if an index is out of range
+                  or a node comes before its parent
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TriangleBvh::Restore(
+        _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+        _In_ UINT uNumVertices,
+        _Inout_ std::vector<Node>& aNodes,
+        _Inout_ std::vector<Triangle>& aTriangles,
+        _Inout_ std::vector<MeshRoot>& aMeshRoots
+    )
+    {
+        const SIZE_T uNumNodes = aNodes.size();
+        const SIZE_T uNumTriangles = aTriangles.size();
+        for (const MeshRoot& root : aMeshRoots)
+        {
+            if (root.uRootNode != INVALID_INDEX && (root.uNumNodes == 0u || static_cast<SIZE_T>(root.uRootNode) + root.uNumNodes > uNumNodes))
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        for (SIZE_T uNode = 0u; uNode < uNumNodes; ++uNode)
+        {
+            const Node& node = aNodes[uNode];
+            for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+            {
+                const UINT uChild = node.aChildren[uLane];
+                if (uChild == INVALID_INDEX)
+                {
+                    continue;
+                }
+
+                if (node.aNumTriangles[uLane] > 0u ? static_cast<SIZE_T>(uChild) + node.aNumTriangles[uLane] > uNumTriangles : uChild <= uNode || uChild >= uNumNodes)
+                {
+                    return E_INVALIDARG;
+                }
+            }
+        }
+
+        for (const Triangle& triangle : aTriangles)
+        {
+            if (triangle.aVertices[0] >= uNumVertices || triangle.aVertices[1] >= uNumVertices || triangle.aVertices[2] >= uNumVertices)
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        m_aNodes.swap(aNodes);
+        m_aTriangles.swap(aTriangles);
+        m_aMeshRoots.swap(aMeshRoots);
+        m_aPositions.resize(uNumVertices);
+        for (UINT i = 0u; i < uNumVertices; ++i)
+        {
+            m_aPositions[i] = pVertices[i].Position;
+        }
+        m_buildTime = 0.0f;
+        m_uNumThreads = 0u;
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::Refit
+
+      Summary:  Moves the triangles to new positions, such as the posed
+                vertices of a skinned model, and refits every box from
+                the leaves up. The tree keeps its shape, so it slows
+                down as the pose drifts from the one it was built for,
+                but stays correct
+
+      Args:     const XMFLOAT3* pPositions
+                  New position of every vertex
+                UINT uNumPositions
+                  Number of positions, the number of vertices
+
+      Modifies: [m_aPositions, m_aNodes].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if the number of positions
+                  differs from the number of vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TriangleBvh::Refit(_In_reads_(uNumPositions) const XMFLOAT3* pPositions, _In_ UINT uNumPositions)
+    {
+        if (uNumPositions != m_aPositions.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        m_aPositions.assign(pPositions, pPositions + uNumPositions);
+
+        // Children always come after their parent, so going backwards refits them first
+        for (UINT uNode = static_cast<UINT>(m_aNodes.size()); uNode-- > 0u;)
+        {
+            refitNode(uNode);
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::Intersect
+
+      Summary:  Finds the nearest hit of every ray of a batch. The rays
+                are split into jobs of NUM_RAYS_PER_JOB taken by worker
+                threads, so a small batch stays on the calling thread
+
+      Args:     const Ray* pRays
+                  Rays in world space
+                UINT uNumRays
+                  Number of rays
+                const XMMATRIX& world
+                  World matrix of the geometry
+                RayHit* pOutHits
+                  Nearest hit of every ray
+                UINT uNumThreads
+                  Number of threads, 0 for every hardware thread
+
+      Returns:  UINT
+                  Number of rays that hit a triangle
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TriangleBvh::Intersect(
+        _In_reads_(uNumRays) const Ray* pRays,
+        _In_ UINT uNumRays,
+        _In_ const XMMATRIX& world,
+        _Out_writes_(uNumRays) RayHit* pOutHits,
+        _In_opt_ UINT uNumThreads
+    ) const
+    {
+        XMVECTOR det = XMMatrixDeterminant(world);
+        const XMMATRIX inverseWorld = XMMatrixInverse(&det, world);
+
+        const UINT uNumJobs = (uNumRays + NUM_RAYS_PER_JOB - 1u) / NUM_RAYS_PER_JOB;
+        const UINT uNumJobThreads = GetNumParallelThreads(uNumJobs, uNumThreads);
+
+        // Each thread keeps its stack of nodes, the hits are counted per job
+        std::vector<std::vector<UINT>> aaStacks(uNumJobThreads);
+        std::atomic<UINT> uNumHits = 0u;
+        ParallelFor(uNumJobs, uNumJobThreads,
+            [&](UINT uJob, UINT uThread)
+            {
+                UINT uNumJobHits = 0u;
+                const UINT uEnd = std::min((uJob + 1u) * NUM_RAYS_PER_JOB, uNumRays);
+                for (UINT uRay = uJob * NUM_RAYS_PER_JOB; uRay < uEnd; ++uRay)
+                {
+                    intersectRay(pRays[uRay], inverseWorld, pOutHits[uRay], aaStacks[uThread]);
+                    if (pOutHits[uRay].uMeshIndex != INVALID_INDEX)
+                    {
+                        ++uNumJobHits;
+                    }
+                }
+                uNumHits += uNumJobHits;
+            }
+        );
+
+        return uNumHits;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::Benchmark
+
+      Summary:  Casts uNumRays rays from a sphere around the geometry
+                at random points of its box, on one thread and on every
+                hardware thread, and logs the size of the tree and the
+                rays cast per second of both. The first
+                NUM_BRUTE_FORCE_RAYS rays are cast again against every
+                triangle without the tree, and must hit at the same
+                distance
+
+      Args:     PCSTR pszName
+                  Name of the geometry in the log
+                UINT uNumRays
+                  Number of rays per thread count
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the tree is empty or a hit
+                  differs from brute force
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TriangleBvh::Benchmark(_In_ PCSTR pszName, _In_ UINT uNumRays) const
+    {
+        if (IsEmpty() || uNumRays == 0u)
+        {
+            return E_FAIL;
+        }
+
+        XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+        for (const XMFLOAT3& position : m_aPositions)
+        {
+            boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&position));
+            boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&position));
+        }
+        const XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+        const FLOAT radius = std::max(XMVectorGetX(XMVector3Length(XMVectorSubtract(boundsMax, boundsMin))), 1e-3f);
+
+        // The same rays every run, so the numbers compare between builds
+        std::mt19937 generator(0u);
+        std::uniform_real_distribution<FLOAT> distribution(0.0f, 1.0f);
+        std::vector<Ray> aRays(uNumRays);
+        for (Ray& ray : aRays)
+        {
+            const FLOAT z = distribution(generator) * 2.0f - 1.0f;
+            const FLOAT angle = distribution(generator) * XM_2PI;
+            const FLOAT r = sqrtf(std::max(1.0f - z * z, 0.0f));
+            const XMVECTOR origin = XMVectorAdd(center, XMVectorScale(XMVectorSet(r * cosf(angle), r * sinf(angle), z, 0.0f), radius));
+            const XMVECTOR target = XMVectorLerpV(boundsMin, boundsMax, XMVectorSet(distribution(generator), distribution(generator), distribution(generator), 0.0f));
+
+            XMStoreFloat3(&ray.Origin, origin);
+            XMStoreFloat3(&ray.Direction, XMVector3Normalize(XMVectorSubtract(target, origin)));
+            ray.maxDistance = FLT_MAX;
+        }
+
+        std::vector<RayHit> aHits(uNumRays);
+        const UINT aNumThreads[2] = { 1u, 0u };
+        DOUBLE aRaysPerSecond[2] = { 0.0, 0.0 };
+        UINT uNumHits = 0u;
+        for (UINT i = 0u; i < ARRAYSIZE(aNumThreads); ++i)
+        {
+            LARGE_INTEGER startingTime;
+            LARGE_INTEGER endingTime;
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            QueryPerformanceCounter(&startingTime);
+
+            uNumHits = Intersect(aRays.data(), uNumRays, XMMatrixIdentity(), aHits.data(), aNumThreads[i]);
+
+            QueryPerformanceCounter(&endingTime);
+            const DOUBLE time = static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) / static_cast<DOUBLE>(frequency.QuadPart);
+            aRaysPerSecond[i] = static_cast<DOUBLE>(uNumRays) / std::max(time, 1e-9);
+        }
+
+        // Ties between triangles may pick either one, but never another distance
+        const UINT uNumCheckedRays = std::min(uNumRays, NUM_BRUTE_FORCE_RAYS);
+        UINT uNumMatchingRays = 0u;
+        for (UINT uRay = 0u; uRay < uNumCheckedRays; ++uRay)
+        {
+            RayHit bruteForceHit;
+            intersectRayBruteForce(aRays[uRay], XMMatrixIdentity(), bruteForceHit);
+            if ((bruteForceHit.uMeshIndex == INVALID_INDEX) == (aHits[uRay].uMeshIndex == INVALID_INDEX) &&
+                bruteForceHit.distance == aHits[uRay].distance)
+            {
+                ++uNumMatchingRays;
+            }
+        }
+
+        const UINT uNumJobs = (uNumRays + NUM_RAYS_PER_JOB - 1u) / NUM_RAYS_PER_JOB;
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "Ray casts %s: %zu triangles, %zu nodes, %.1f KB, %.1f%% hit, %.2f M rays/s on 1 thread, %.2f M rays/s on %u threads, %u of %u rays match brute force\n",
+            pszName,
+            m_aTriangles.size(),
+            m_aNodes.size(),
+            static_cast<DOUBLE>(GetMemorySize()) / 1024.0,
+            static_cast<DOUBLE>(uNumHits) * 100.0 / static_cast<DOUBLE>(uNumRays),
+            aRaysPerSecond[0] / 1000000.0,
+            aRaysPerSecond[1] / 1000000.0,
+            GetNumParallelThreads(uNumJobs),
+            uNumMatchingRays,
+            uNumCheckedRays
+        );
+        OutputDebugStringA(szDebugMessage);
+
+        return uNumMatchingRays == uNumCheckedRays ? S_OK : E_FAIL;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::IsEmpty
+
+      Summary:  Returns whether the tree has no triangles
+
+      Returns:  BOOL
+                  TRUE if no ray can hit anything
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL TriangleBvh::IsEmpty() const
+    {
+        return m_aTriangles.empty();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::GetNodes
+
+      Summary:  Returns the nodes of every mesh
+
+      Returns:  const std::vector<Node>&
+                  Nodes, mesh after mesh
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<TriangleBvh::Node>& TriangleBvh::GetNodes() const
+    {
+        return m_aNodes;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::GetTriangles
+
+      Summary:  Returns the triangles in the order of the leaves
+
+      Returns:  const std::vector<Triangle>&
+                  Triangles, mesh after mesh
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<TriangleBvh::Triangle>& TriangleBvh::GetTriangles() const
+    {
+        return m_aTriangles;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::GetMeshRoots
+
+      Summary:  Returns the root node of every mesh
+
+      Returns:  const std::vector<MeshRoot>&
+                  Roots, one per mesh
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<TriangleBvh::MeshRoot>& TriangleBvh::GetMeshRoots() const
+    {
+        return m_aMeshRoots;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::GetMemorySize
+
+      Summary:  Returns the bytes held by the tree
+
+      Returns:  SIZE_T
+                  Size of the nodes, triangles, roots and positions
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    SIZE_T TriangleBvh::GetMemorySize() const
+    {
+        return m_aNodes.size() * sizeof(Node) + m_aTriangles.size() * sizeof(Triangle) +
+            m_aMeshRoots.size() * sizeof(MeshRoot) + m_aPositions.size() * sizeof(XMFLOAT3);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::GetBuildTime
+
+      Summary:  Returns the time the last Build took
+
+      Returns:  FLOAT
+                  Build time in milliseconds, 0 after Restore
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT TriangleBvh::GetBuildTime() const
+    {
+        return m_buildTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::GetNumThreads
+
+      Summary:  Returns the number of threads of the last Build
+
+      Returns:  UINT
+                  Number of threads, the calling one included
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TriangleBvh::GetNumThreads() const
+    {
+        return m_uNumThreads;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::buildMesh
+
+      Summary:  Builds the tree of one mesh top-down. A node starts
+                with all its triangles as one child and splits its
+                largest child until it has NUM_LANES of them or none
+                is worth splitting. Children left with more than
+                MAX_NUM_LEAF_TRIANGLES become nodes of their own, built
+                from a work list rather than by recursion
+
+      Args:     std::vector<BuildTriangle>& aBuildTriangles
+                  Triangles of the mesh, reordered so every leaf is a
+                  contiguous range
+                std::vector<Node>& aOutNodes
+                  Nodes of the mesh, root first, leaves indexing
+                  aBuildTriangles
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TriangleBvh::buildMesh(_Inout_ std::vector<BuildTriangle>& aBuildTriangles, _Inout_ std::vector<Node>& aOutNodes)
+    {
+        aOutNodes.clear();
+        if (aBuildTriangles.empty())
+        {
+            return;
+        }
+
+        struct Task
+        {
+            UINT uNode;
+            UINT uFirst;
+            UINT uCount;
+        };
+
+        std::vector<Task> aTasks;
+        aOutNodes.push_back(createEmptyNode());
+        aTasks.push_back({ 0u, 0u, static_cast<UINT>(aBuildTriangles.size()) });
+        while (!aTasks.empty())
+        {
+            const Task task = aTasks.back();
+            aTasks.pop_back();
+
+            UINT aFirsts[NUM_LANES] = { task.uFirst, };
+            UINT aCounts[NUM_LANES] = { task.uCount, };
+            BOOL abLeaves[NUM_LANES] = { task.uCount <= MAX_NUM_LEAF_TRIANGLES, };
+            UINT uNumChildren = 1u;
+            while (uNumChildren < NUM_LANES)
+            {
+                UINT uLargest = INVALID_INDEX;
+                for (UINT uChild = 0u; uChild < uNumChildren; ++uChild)
+                {
+                    if (!abLeaves[uChild] && (uLargest == INVALID_INDEX || aCounts[uChild] > aCounts[uLargest]))
+                    {
+                        uLargest = uChild;
+                    }
+                }
+                if (uLargest == INVALID_INDEX)
+                {
+                    break;
+                }
+
+                const UINT uNumLeft = split(aBuildTriangles.data() + aFirsts[uLargest], aCounts[uLargest]);
+                if (uNumLeft == 0u)
+                {
+                    abLeaves[uLargest] = TRUE;
+                    continue;
+                }
+
+                aFirsts[uNumChildren] = aFirsts[uLargest] + uNumLeft;
+                aCounts[uNumChildren] = aCounts[uLargest] - uNumLeft;
+                abLeaves[uNumChildren] = aCounts[uNumChildren] <= MAX_NUM_LEAF_TRIANGLES;
+                aCounts[uLargest] = uNumLeft;
+                abLeaves[uLargest] = uNumLeft <= MAX_NUM_LEAF_TRIANGLES;
+                ++uNumChildren;
+            }
+
+            Node node = createEmptyNode();
+            for (UINT uChild = 0u; uChild < uNumChildren; ++uChild)
+            {
+                XMVECTOR boxMin = XMVectorReplicate(FLT_MAX);
+                XMVECTOR boxMax = XMVectorReplicate(-FLT_MAX);
+                for (UINT i = aFirsts[uChild]; i < aFirsts[uChild] + aCounts[uChild]; ++i)
+                {
+                    boxMin = XMVectorMin(boxMin, XMLoadFloat3(&aBuildTriangles[i].Min));
+                    boxMax = XMVectorMax(boxMax, XMLoadFloat3(&aBuildTriangles[i].Max));
+                }
+                setLaneBox(node, uChild, boxMin, boxMax);
+
+                if (abLeaves[uChild])
+                {
+                    node.aChildren[uChild] = aFirsts[uChild];
+                    node.aNumTriangles[uChild] = aCounts[uChild];
+                }
+                else
+                {
+                    node.aChildren[uChild] = static_cast<UINT>(aOutNodes.size());
+                    aOutNodes.push_back(createEmptyNode());
+                    aTasks.push_back({ node.aChildren[uChild], aFirsts[uChild], aCounts[uChild] });
+                }
+            }
+            aOutNodes[task.uNode] = node;
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::split
+
+      Summary:  Splits a range of triangles in two by the surface area
+                heuristic. The centroids are binned along each axis
+                and every plane between bins is costed. A range that
+                is cheaper to test whole is kept as a leaf unless it
+                exceeds MAX_NUM_FORCED_LEAF_TRIANGLES, and a range no
+                plane separates is split at its median
+
+      Args:     BuildTriangle* pBuildTriangles
+                  Triangles of the range, partitioned on return
+                UINT uNumTriangles
+                  Number of triangles
+
+      Returns:  UINT
+                  Number of triangles on the left, 0 to keep a leaf
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TriangleBvh::split(_Inout_updates_(uNumTriangles) BuildTriangle* pBuildTriangles, _In_ UINT uNumTriangles)
+    {
+        XMVECTOR boxMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR boxMax = XMVectorReplicate(-FLT_MAX);
+        XMVECTOR centroidMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR centroidMax = XMVectorReplicate(-FLT_MAX);
+        for (UINT i = 0u; i < uNumTriangles; ++i)
+        {
+            boxMin = XMVectorMin(boxMin, XMLoadFloat3(&pBuildTriangles[i].Min));
+            boxMax = XMVectorMax(boxMax, XMLoadFloat3(&pBuildTriangles[i].Max));
+            centroidMin = XMVectorMin(centroidMin, XMLoadFloat3(&pBuildTriangles[i].Centroid));
+            centroidMax = XMVectorMax(centroidMax, XMLoadFloat3(&pBuildTriangles[i].Centroid));
+        }
+
+        XMFLOAT3 aCentroidMin;
+        XMFLOAT3 aCentroidMax;
+        XMStoreFloat3(&aCentroidMin, centroidMin);
+        XMStoreFloat3(&aCentroidMax, centroidMax);
+        const FLOAT* pCentroidMin = &aCentroidMin.x;
+        const FLOAT* pCentroidMax = &aCentroidMax.x;
+
+        FLOAT bestCost = FLT_MAX;
+        UINT uBestAxis = INVALID_INDEX;
+        UINT uBestBin = 0u;
+        for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+        {
+            const FLOAT extent = pCentroidMax[uAxis] - pCentroidMin[uAxis];
+            if (extent <= 0.0f)
+            {
+                continue;
+            }
+
+            XMVECTOR aBinMin[NUM_BINS];
+            XMVECTOR aBinMax[NUM_BINS];
+            UINT aBinCounts[NUM_BINS] = { 0u, };
+            for (UINT uBin = 0u; uBin < NUM_BINS; ++uBin)
+            {
+                aBinMin[uBin] = XMVectorReplicate(FLT_MAX);
+                aBinMax[uBin] = XMVectorReplicate(-FLT_MAX);
+            }
+
+            const FLOAT binScale = static_cast<FLOAT>(NUM_BINS) / extent;
+            for (UINT i = 0u; i < uNumTriangles; ++i)
+            {
+                const UINT uBin = std::min(static_cast<UINT>((reinterpret_cast<const FLOAT*>(&pBuildTriangles[i].Centroid.x)[uAxis] - pCentroidMin[uAxis]) * binScale), NUM_BINS - 1u);
+                aBinMin[uBin] = XMVectorMin(aBinMin[uBin], XMLoadFloat3(&pBuildTriangles[i].Min));
+                aBinMax[uBin] = XMVectorMax(aBinMax[uBin], XMLoadFloat3(&pBuildTriangles[i].Max));
+                ++aBinCounts[uBin];
+            }
+
+            // Sweep from the right first, so each plane is costed in one pass from the left
+            FLOAT aRightAreas[NUM_BINS];
+            UINT aRightCounts[NUM_BINS];
+            XMVECTOR sweepMin = XMVectorReplicate(FLT_MAX);
+            XMVECTOR sweepMax = XMVectorReplicate(-FLT_MAX);
+            UINT uSweepCount = 0u;
+            for (UINT uBin = NUM_BINS; uBin-- > 1u;)
+            {
+                sweepMin = XMVectorMin(sweepMin, aBinMin[uBin]);
+                sweepMax = XMVectorMax(sweepMax, aBinMax[uBin]);
+                uSweepCount += aBinCounts[uBin];
+                aRightAreas[uBin] = getHalfArea(sweepMin, sweepMax);
+                aRightCounts[uBin] = uSweepCount;
+            }
+
+            sweepMin = XMVectorReplicate(FLT_MAX);
+            sweepMax = XMVectorReplicate(-FLT_MAX);
+            uSweepCount = 0u;
+            for (UINT uBin = 1u; uBin < NUM_BINS; ++uBin)
+            {
+                sweepMin = XMVectorMin(sweepMin, aBinMin[uBin - 1u]);
+                sweepMax = XMVectorMax(sweepMax, aBinMax[uBin - 1u]);
+                uSweepCount += aBinCounts[uBin - 1u];
+                if (uSweepCount == 0u || aRightCounts[uBin] == 0u)
+                {
+                    continue;
+                }
+
+                const FLOAT cost = getHalfArea(sweepMin, sweepMax) * static_cast<FLOAT>(uSweepCount) + aRightAreas[uBin] * static_cast<FLOAT>(aRightCounts[uBin]);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    uBestAxis = uAxis;
+                    uBestBin = uBin;
+                }
+            }
+        }
+
+        const FLOAT area = getHalfArea(boxMin, boxMax);
+        const BOOL bIsLeafCheaper = uBestAxis == INVALID_INDEX || area <= 0.0f || TRAVERSAL_COST + bestCost / area >= static_cast<FLOAT>(uNumTriangles);
+        if (bIsLeafCheaper && uNumTriangles <= MAX_NUM_FORCED_LEAF_TRIANGLES)
+        {
+            return 0u;
+        }
+
+        if (uBestAxis == INVALID_INDEX)
+        {
+            // Every centroid is at the same point, any half is as good as the other
+            return uNumTriangles / 2u;
+        }
+
+        const FLOAT binScale = static_cast<FLOAT>(NUM_BINS) / (pCentroidMax[uBestAxis] - pCentroidMin[uBestAxis]);
+        const BuildTriangle* pMiddle = std::partition(
+            pBuildTriangles,
+            pBuildTriangles + uNumTriangles,
+            [&](const BuildTriangle& buildTriangle)
+            {
+                return std::min(static_cast<UINT>((reinterpret_cast<const FLOAT*>(&buildTriangle.Centroid.x)[uBestAxis] - pCentroidMin[uBestAxis]) * binScale), NUM_BINS - 1u) < uBestBin;
+            }
+        );
+
+        // Rounding can still leave a side empty, which a split in half always fixes
+        const UINT uNumLeft = static_cast<UINT>(pMiddle - pBuildTriangles);
+        return uNumLeft == 0u || uNumLeft == uNumTriangles ? uNumTriangles / 2u : uNumLeft;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::intersectRay
+
+      Summary:  Finds the nearest hit of one ray in every mesh. The ray
+                tests the NUM_LANES boxes of a node at once, visits the
+                leaves it hits nearest first, and pushes the nodes it
+                hits so the nearest is popped next. Boxes farther than
+                the nearest hit so far are skipped. Triangles are hit
+                from both sides
+
+      Args:     const Ray& ray
+                  Ray in world space
+                const XMMATRIX& inverseWorld
+                  Inverse of the world matrix of the geometry
+                RayHit& outHit
+                  Nearest hit
+                std::vector<UINT>& aStack
+                  Stack of nodes to visit, reused between rays
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TriangleBvh::intersectRay(_In_ const Ray& ray, _In_ const XMMATRIX& inverseWorld, _Out_ RayHit& outHit, _Inout_ std::vector<UINT>& aStack) const
+    {
+        outHit = { ray.maxDistance, 0.0f, 0.0f, INVALID_INDEX, INVALID_INDEX };
+
+        const XMVECTOR origin = XMVector3Transform(XMLoadFloat3(&ray.Origin), inverseWorld);
+        XMVECTOR direction = XMVector3TransformNormal(XMLoadFloat3(&ray.Direction), inverseWorld);
+
+        // A zero component would give 0 * infinity in the slab test, a tiny one only a huge but finite distance
+        const XMVECTOR minDirection = XMVectorReplicate(MIN_DIRECTION);
+        const XMVECTOR safeDirection = XMVectorSelect(direction, minDirection, XMVectorLess(XMVectorAbs(direction), minDirection));
+        const XMVECTOR inverseDirection = XMVectorReciprocal(safeDirection);
+        const XMVECTOR originX = XMVectorSplatX(origin);
+        const XMVECTOR originY = XMVectorSplatY(origin);
+        const XMVECTOR originZ = XMVectorSplatZ(origin);
+        const XMVECTOR inverseDirectionX = XMVectorSplatX(inverseDirection);
+        const XMVECTOR inverseDirectionY = XMVectorSplatY(inverseDirection);
+        const XMVECTOR inverseDirectionZ = XMVectorSplatZ(inverseDirection);
+
+        for (const MeshRoot& root : m_aMeshRoots)
+        {
+            if (root.uRootNode == INVALID_INDEX)
+            {
+                continue;
+            }
+
+            aStack.clear();
+            aStack.push_back(root.uRootNode);
+            while (!aStack.empty())
+            {
+                const Node& node = m_aNodes[aStack.back()];
+                aStack.pop_back();
+
+                const XMVECTOR t0X = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(&node.MinX), originX), inverseDirectionX);
+                const XMVECTOR t1X = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(&node.MaxX), originX), inverseDirectionX);
+                const XMVECTOR t0Y = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(&node.MinY), originY), inverseDirectionY);
+                const XMVECTOR t1Y = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(&node.MaxY), originY), inverseDirectionY);
+                const XMVECTOR t0Z = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(&node.MinZ), originZ), inverseDirectionZ);
+                const XMVECTOR t1Z = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(&node.MaxZ), originZ), inverseDirectionZ);
+                const XMVECTOR tNear = XMVectorMax(
+                    XMVectorMax(XMVectorMin(t0X, t1X), XMVectorMin(t0Y, t1Y)),
+                    XMVectorMax(XMVectorMin(t0Z, t1Z), XMVectorZero())
+                );
+                const XMVECTOR tFar = XMVectorMin(
+                    XMVectorScale(XMVectorMin(XMVectorMin(XMVectorMax(t0X, t1X), XMVectorMax(t0Y, t1Y)), XMVectorMax(t0Z, t1Z)), FAR_DISTANCE_SCALE),
+                    XMVectorReplicate(outHit.distance)
+                );
+
+                XMFLOAT4 nearLanes;
+                UINT aHitLanes[NUM_LANES];
+                XMStoreFloat4(&nearLanes, tNear);
+                XMStoreInt4(aHitLanes, XMVectorLessOrEqual(tNear, tFar));
+
+                // Nearest child first, the lanes of an unused child are inverted boxes that can still pass
+                UINT aOrder[NUM_LANES];
+                UINT uNumHitChildren = 0u;
+                for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+                {
+                    if (aHitLanes[uLane] == 0u || node.aChildren[uLane] == INVALID_INDEX)
+                    {
+                        continue;
+                    }
+
+                    UINT uSlot = uNumHitChildren++;
+                    for (; uSlot > 0u && getLane(nearLanes, aOrder[uSlot - 1u]) > getLane(nearLanes, uLane); --uSlot)
+                    {
+                        aOrder[uSlot] = aOrder[uSlot - 1u];
+                    }
+                    aOrder[uSlot] = uLane;
+                }
+
+                for (UINT i = 0u; i < uNumHitChildren; ++i)
+                {
+                    const UINT uLane = aOrder[i];
+                    if (node.aNumTriangles[uLane] == 0u || getLane(nearLanes, uLane) > outHit.distance)
+                    {
+                        continue;
+                    }
+
+                    const UINT uEnd = node.aChildren[uLane] + node.aNumTriangles[uLane];
+                    for (UINT uTriangle = node.aChildren[uLane]; uTriangle < uEnd; ++uTriangle)
+                    {
+                        intersectTriangle(uTriangle, origin, direction, root.uMeshIndex, outHit);
+                    }
+                }
+
+                for (UINT i = uNumHitChildren; i-- > 0u;)
+                {
+                    const UINT uLane = aOrder[i];
+                    if (node.aNumTriangles[uLane] == 0u && getLane(nearLanes, uLane) <= outHit.distance)
+                    {
+                        aStack.push_back(node.aChildren[uLane]);
+                    }
+                }
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::intersectRayBruteForce
+
+      Summary:  Finds the nearest hit of one ray by testing every
+                triangle of every mesh, visiting the leaves of the
+                nodes without testing their boxes
+
+      Args:     const Ray& ray
+                  Ray in world space
+                const XMMATRIX& inverseWorld
+                  Inverse of the world matrix of the geometry
+                RayHit& outHit
+                  Nearest hit
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TriangleBvh::intersectRayBruteForce(_In_ const Ray& ray, _In_ const XMMATRIX& inverseWorld, _Out_ RayHit& outHit) const
+    {
+        outHit = { ray.maxDistance, 0.0f, 0.0f, INVALID_INDEX, INVALID_INDEX };
+
+        const XMVECTOR origin = XMVector3Transform(XMLoadFloat3(&ray.Origin), inverseWorld);
+        const XMVECTOR direction = XMVector3TransformNormal(XMLoadFloat3(&ray.Direction), inverseWorld);
+
+        for (const MeshRoot& root : m_aMeshRoots)
+        {
+            if (root.uRootNode == INVALID_INDEX)
+            {
+                continue;
+            }
+
+            for (UINT uNode = root.uRootNode; uNode < root.uRootNode + root.uNumNodes; ++uNode)
+            {
+                const Node& node = m_aNodes[uNode];
+                for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+                {
+                    if (node.aChildren[uLane] == INVALID_INDEX || node.aNumTriangles[uLane] == 0u)
+                    {
+                        continue;
+                    }
+
+                    const UINT uEnd = node.aChildren[uLane] + node.aNumTriangles[uLane];
+                    for (UINT uTriangle = node.aChildren[uLane]; uTriangle < uEnd; ++uTriangle)
+                    {
+                        intersectTriangle(uTriangle, origin, direction, root.uMeshIndex, outHit);
+                    }
+                }
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::intersectTriangle
+
+      Summary:  Tests a ray against a triangle from both sides with the
+                Moller and Trumbore test, "Fast, Minimum Storage
+                Ray/Triangle Intersection", and keeps the hit if it is
+                nearer than the one so far
+
+      Args:     UINT uTriangle
+                  Index of the triangle
+                FXMVECTOR origin
+                  Origin of the ray in the space of the geometry
+                FXMVECTOR direction
+                  Direction of the ray in the space of the geometry
+                UINT uMeshIndex
+                  Mesh of the triangle
+                RayHit& hit
+                  Nearest hit so far, replaced by a nearer one
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TriangleBvh::intersectTriangle(
+        _In_ UINT uTriangle,
+        _In_ FXMVECTOR origin,
+        _In_ FXMVECTOR direction,
+        _In_ UINT uMeshIndex,
+        _Inout_ RayHit& hit
+    ) const
+    {
+        const Triangle& triangle = m_aTriangles[uTriangle];
+        const XMVECTOR position0 = XMLoadFloat3(&m_aPositions[triangle.aVertices[0]]);
+        const XMVECTOR edge1 = XMVectorSubtract(XMLoadFloat3(&m_aPositions[triangle.aVertices[1]]), position0);
+        const XMVECTOR edge2 = XMVectorSubtract(XMLoadFloat3(&m_aPositions[triangle.aVertices[2]]), position0);
+        const XMVECTOR p = XMVector3Cross(direction, edge2);
+        const FLOAT determinant = XMVectorGetX(XMVector3Dot(edge1, p));
+        if (fabsf(determinant) < MIN_DIRECTION)
+        {
+            return;
+        }
+
+        const FLOAT inverseDeterminant = 1.0f / determinant;
+        const XMVECTOR s = XMVectorSubtract(origin, position0);
+        const FLOAT u = XMVectorGetX(XMVector3Dot(s, p)) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return;
+        }
+
+        const XMVECTOR q = XMVector3Cross(s, edge1);
+        const FLOAT v = XMVectorGetX(XMVector3Dot(direction, q)) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return;
+        }
+
+        const FLOAT t = XMVectorGetX(XMVector3Dot(edge2, q)) * inverseDeterminant;
+        if (t >= 0.0f && t < hit.distance)
+        {
+            hit = { t, u, v, uMeshIndex, triangle.uFirstIndex };
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TriangleBvh::refitNode
+
+      Summary:  Refits the boxes of the children of a node, from the
+                positions for a leaf and from the boxes of the child
+                node otherwise, which must be refit already
+
+      Args:     UINT uNode
+                  Index of the node
+
+      Modifies: [m_aNodes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TriangleBvh::refitNode(_In_ UINT uNode)
+    {
+        Node& node = m_aNodes[uNode];
+        for (UINT uLane = 0u; uLane < NUM_LANES; ++uLane)
+        {
+            if (node.aChildren[uLane] == INVALID_INDEX)
+            {
+                continue;
+            }
+
+            XMVECTOR boxMin = XMVectorReplicate(FLT_MAX);
+            XMVECTOR boxMax = XMVectorReplicate(-FLT_MAX);
+            if (node.aNumTriangles[uLane] > 0u)
+            {
+                const UINT uEnd = node.aChildren[uLane] + node.aNumTriangles[uLane];
+                for (UINT uTriangle = node.aChildren[uLane]; uTriangle < uEnd; ++uTriangle)
+                {
+                    for (UINT uCorner = 0u; uCorner < 3u; ++uCorner)
+                    {
+                        const XMVECTOR position = XMLoadFloat3(&m_aPositions[m_aTriangles[uTriangle].aVertices[uCorner]]);
+                        boxMin = XMVectorMin(boxMin, position);
+                        boxMax = XMVectorMax(boxMax, position);
+                    }
+                }
+            }
+            else
+            {
+                const Node& child = m_aNodes[node.aChildren[uLane]];
+                for (UINT uChildLane = 0u; uChildLane < NUM_LANES; ++uChildLane)
+                {
+                    if (child.aChildren[uChildLane] != INVALID_INDEX)
+                    {
+                        boxMin = XMVectorMin(boxMin, XMVectorSet(getLane(child.MinX, uChildLane), getLane(child.MinY, uChildLane), getLane(child.MinZ, uChildLane), 0.0f));
+                        boxMax = XMVectorMax(boxMax, XMVectorSet(getLane(child.MaxX, uChildLane), getLane(child.MaxY, uChildLane), getLane(child.MaxZ, uChildLane), 0.0f));
+                    }
+                }
+            }
+
+            setLaneBox(node, uLane, boxMin, boxMax);
+        }
+    }
+}
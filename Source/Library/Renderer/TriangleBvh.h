@@ -0,0 +1,251 @@
+/*+===================================================================
+  File:      TRIANGLEBVH.H
+
+  Summary:   TriangleBvh header file contains declarations of
+             TriangleBvh class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: TriangleBvh
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    TriangleBvh
+
+      Summary:  Bounding volume hierarchy over the triangles of each
+                mesh, for ray casts against geometry on the CPU. A mesh
+                gets its own tree, built top-down with the surface area
+                heuristic over NUM_BINS bins and split twice per level,
+                so a node holds the boxes of NUM_LANES children in SIMD
+                lanes and a ray tests them at once. The meshes are
+                built in parallel, one job per mesh. The tree keeps a
+                copy of the positions, so it can be refit to the posed
+                vertices of a skinned model without rebuilding. Rays
+                are given in world space and taken into the space of
+                the geometry with the inverse of its world matrix, and
+                large batches are split into jobs of NUM_RAYS_PER_JOB
+                taken by worker threads
+
+      Methods:  Build
+                  Builds the trees of the meshes
+                Restore
+                  Takes trees built before, such as from a cache
+                Refit
+                  Moves the triangles to new positions and refits the
+                  boxes
+                Intersect
+                  Finds the nearest hit of every ray of a batch
+                Benchmark
+                  Casts random rays at the geometry, logs the
+                  throughput and checks the hits against brute force
+                IsEmpty
+                  Returns whether the tree has no triangles
+                GetNodes
+                  Returns the nodes of every mesh
+                GetTriangles
+                  Returns the triangles in the order of the leaves
+                GetMeshRoots
+                  Returns the root node of every mesh
+                GetMemorySize
+                  Returns the bytes held by the tree
+                GetBuildTime
+                  Returns the time the last Build took
+                GetNumThreads
+                  Returns the number of threads of the last Build
+                TriangleBvh
+                  Constructor.
+                ~TriangleBvh
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class TriangleBvh
+    {
+    public:
+        static constexpr const UINT NUM_LANES = 4u;
+        static constexpr const UINT NUM_BINS = 16u;
+        static constexpr const UINT MAX_NUM_LEAF_TRIANGLES = 4u;
+        static constexpr const UINT MAX_NUM_FORCED_LEAF_TRIANGLES = 16u;
+        static constexpr const FLOAT TRAVERSAL_COST = 1.0f;
+        static constexpr const UINT NUM_RAYS_PER_JOB = 256u;
+        static constexpr const UINT NUM_BRUTE_FORCE_RAYS = 1000u;
+        static constexpr const UINT INVALID_INDEX = (0xFFFFFFFF);
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Node
+
+          Summary:  Boxes of NUM_LANES children, one per lane of each
+                    component. A child with triangles is a leaf over
+                    aNumTriangles[i] triangles from aChildren[i], a
+                    child without is the node aChildren[i], and an
+                    unused lane has INVALID_INDEX. 128 bytes, two cache
+                    lines
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Node
+        {
+            XMFLOAT4 MinX;
+            XMFLOAT4 MinY;
+            XMFLOAT4 MinZ;
+            XMFLOAT4 MaxX;
+            XMFLOAT4 MaxY;
+            XMFLOAT4 MaxZ;
+            UINT aChildren[NUM_LANES];
+            UINT aNumTriangles[NUM_LANES];
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Triangle
+
+          Summary:  Vertices of a triangle and where it starts in the
+                    index buffer
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Triangle
+        {
+            UINT aVertices[3];
+            UINT uFirstIndex;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   MeshRoot
+
+          Summary:  Root node of a mesh and the range of its nodes,
+                    INVALID_INDEX for a mesh without triangles
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct MeshRoot
+        {
+            UINT uRootNode;
+            UINT uNumNodes;
+            UINT uMeshIndex;
+            UINT uReserved;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   MeshRange
+
+          Summary:  Indices of a mesh in the index buffer and the vertex
+                    they are relative to
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct MeshRange
+        {
+            UINT uBaseIndex;
+            UINT uNumIndices;
+            UINT uBaseVertex;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Ray
+
+          Summary:  Ray in world space. Hits are measured along Direction,
+                    so they are distances when it is a unit vector
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Ray
+        {
+            XMFLOAT3 Origin;
+            XMFLOAT3 Direction;
+            FLOAT maxDistance;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   RayHit
+
+          Summary:  Nearest hit of a ray, with the barycentric
+                    coordinates of the second and third vertices of the
+                    triangle. A ray that hits nothing has uMeshIndex
+                    INVALID_INDEX and distance maxDistance
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct RayHit
+        {
+            FLOAT distance;
+            FLOAT u;
+            FLOAT v;
+            UINT uMeshIndex;
+            UINT uFirstIndex;
+        };
+
+    public:
+        TriangleBvh();
+        TriangleBvh(const TriangleBvh& other) = delete;
+        TriangleBvh(TriangleBvh&& other) = delete;
+        TriangleBvh& operator=(const TriangleBvh& other) = delete;
+        TriangleBvh& operator=(TriangleBvh&& other) = delete;
+        ~TriangleBvh() = default;
+
+        HRESULT Build(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_ UINT uNumVertices,
+            _In_ const void* pIndexData,
+            _In_ DXGI_FORMAT indexFormat,
+            _In_ const std::vector<MeshRange>& aMeshes
+        );
+        HRESULT Restore(
+            _In_reads_(uNumVertices) const SimpleVertex* pVertices,
+            _In_ UINT uNumVertices,
+            _Inout_ std::vector<Node>& aNodes,
+            _Inout_ std::vector<Triangle>& aTriangles,
+            _Inout_ std::vector<MeshRoot>& aMeshRoots
+        );
+        HRESULT Refit(_In_reads_(uNumPositions) const XMFLOAT3* pPositions, _In_ UINT uNumPositions);
+
+        UINT Intersect(
+            _In_reads_(uNumRays) const Ray* pRays,
+            _In_ UINT uNumRays,
+            _In_ const XMMATRIX& world,
+            _Out_writes_(uNumRays) RayHit* pOutHits,
+            _In_opt_ UINT uNumThreads = 0u
+        ) const;
+        HRESULT Benchmark(_In_ PCSTR pszName, _In_ UINT uNumRays) const;
+
+        BOOL IsEmpty() const;
+        const std::vector<Node>& GetNodes() const;
+        const std::vector<Triangle>& GetTriangles() const;
+        const std::vector<MeshRoot>& GetMeshRoots() const;
+        SIZE_T GetMemorySize() const;
+        FLOAT GetBuildTime() const;
+        UINT GetNumThreads() const;
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   BuildTriangle
+
+          Summary:  Box and centroid of a triangle while the tree is
+                    built
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct BuildTriangle
+        {
+            XMFLOAT3 Min;
+            XMFLOAT3 Max;
+            XMFLOAT3 Centroid;
+            UINT uTriangle;
+        };
+
+        static void buildMesh(
+            _Inout_ std::vector<BuildTriangle>& aBuildTriangles,
+            _Inout_ std::vector<Node>& aOutNodes
+        );
+        static UINT split(_Inout_updates_(uNumTriangles) BuildTriangle* pBuildTriangles, _In_ UINT uNumTriangles);
+        void intersectRay(_In_ const Ray& ray, _In_ const XMMATRIX& inverseWorld, _Out_ RayHit& outHit, _Inout_ std::vector<UINT>& aStack) const;
+        void intersectRayBruteForce(_In_ const Ray& ray, _In_ const XMMATRIX& inverseWorld, _Out_ RayHit& outHit) const;
+        void intersectTriangle(
+            _In_ UINT uTriangle,
+            _In_ FXMVECTOR origin,
+            _In_ FXMVECTOR direction,
+            _In_ UINT uMeshIndex,
+            _Inout_ RayHit& hit
+        ) const;
+        void refitNode(_In_ UINT uNode);
+
+    private:
+        std::vector<Node> m_aNodes;
+        std::vector<Triangle> m_aTriangles;
+        std::vector<MeshRoot> m_aMeshRoots;
+        std::vector<XMFLOAT3> m_aPositions;
+        FLOAT m_buildTime;
+        UINT m_uNumThreads;
+    };
+}
@@ -0,0 +1,417 @@
+#include "Scene/AnimationScheduler.h"
+#include "Statistics.h"
+
+#include <algorithm>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::AnimationScheduler
+
+      Summary:  Constructor with the default thresholds and budget, and
+                without interpolation
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AnimationScheduler::AnimationScheduler()
+        : m_eye(0.0f, 0.0f, 0.0f)
+        , m_fullRateScreenSize(DEFAULT_FULL_RATE_SCREEN_SIZE)
+        , m_halfRateScreenSize(DEFAULT_HALF_RATE_SCREEN_SIZE)
+        , m_budget(DEFAULT_BUDGET)
+        , m_bInterpolate(FALSE)
+        , m_scheduledModels()
+        , m_aDueModels()
+        , m_uFrameIndex(0u)
+        , m_uNumEvaluations(0u)
+        , m_uNumDeferred(0u)
+        , m_evaluationTime(0.0f)
+    { }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::Update
+
+      Summary:  Adds the frame time to every animated model, evaluates
+                the models due this frame within the budget, and blends
+                the palettes of the others when interpolating. Models
+                without clips are updated every frame as before
+
+      Args:     std::unordered_map<std::wstring, std::shared_ptr<Model>>& models
+                  Models of the scene
+                FLOAT deltaTime
+                  Time difference of a frame
+
+      Modifies: [m_scheduledModels, m_aDueModels, m_uFrameIndex,
+                  m_uNumEvaluations, m_uNumDeferred, m_evaluationTime].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::Update(_In_ std::unordered_map<std::wstring, std::shared_ptr<Model>>& models, _In_ FLOAT deltaTime)
+    {
+        ++m_uFrameIndex;
+        m_uNumEvaluations = 0u;
+        m_uNumDeferred = 0u;
+        m_evaluationTime = 0.0f;
+
+        m_aDueModels.clear();
+        for (auto it = models.begin(); it != models.end(); ++it)
+        {
+            Model& model = *it->second;
+            if (model.GetAnimationClips().empty())
+            {
+                model.Update(deltaTime);
+                continue;
+            }
+
+            auto [scheduledIt, bInserted] = m_scheduledModels.try_emplace(&model);
+            ScheduledModel& scheduledModel = scheduledIt->second;
+            if (bInserted)
+            {
+                scheduledModel.uPhase = static_cast<UINT>(m_scheduledModels.size() - 1u);
+                scheduledModel.uInterval = 1u;
+                scheduledModel.uNumFramesSinceEvaluation = 0u;
+                scheduledModel.pendingTime = 0.0f;
+                scheduledModel.bOverdue = TRUE;
+            }
+
+            scheduledModel.pendingTime += deltaTime;
+            ++scheduledModel.uNumFramesSinceEvaluation;
+            scheduledModel.screenSize = getScreenSize(model);
+            scheduledModel.uInterval = getInterval(scheduledModel.screenSize);
+
+            // A model whose interval shrank does not wait for its phase
+            if (scheduledModel.bOverdue ||
+                scheduledModel.uNumFramesSinceEvaluation >= scheduledModel.uInterval ||
+                (m_uFrameIndex + scheduledModel.uPhase) % scheduledModel.uInterval == 0u)
+            {
+                m_aDueModels.push_back({ &model, &scheduledModel });
+            }
+            else if (m_bInterpolate)
+            {
+                interpolate(model, scheduledModel);
+            }
+        }
+
+        // Deferred models first so none starves, then the largest on screen
+        std::sort(m_aDueModels.begin(), m_aDueModels.end(),
+            [](const std::pair<Model*, ScheduledModel*>& a, const std::pair<Model*, ScheduledModel*>& b)
+            {
+                if (a.second->bOverdue != b.second->bOverdue)
+                {
+                    return a.second->bOverdue > b.second->bOverdue;
+                }
+                return a.second->screenSize > b.second->screenSize;
+            }
+        );
+
+        LARGE_INTEGER frequency, startingTime, endingTime;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        for (std::pair<Model*, ScheduledModel*>& dueModel : m_aDueModels)
+        {
+            if (m_uNumEvaluations > 0u && m_budget > 0.0f && m_evaluationTime >= m_budget)
+            {
+                dueModel.second->bOverdue = TRUE;
+                ++m_uNumDeferred;
+                if (m_bInterpolate)
+                {
+                    interpolate(*dueModel.first, *dueModel.second);
+                }
+                continue;
+            }
+
+            evaluate(*dueModel.first, *dueModel.second);
+            ++m_uNumEvaluations;
+
+            QueryPerformanceCounter(&endingTime);
+            m_evaluationTime = static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart));
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::SetEyePosition
+
+      Summary:  Sets the position the screen sizes are measured from
+
+      Args:     const XMFLOAT3& eye
+                  Position of the camera
+
+      Modifies: [m_eye].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::SetEyePosition(_In_ const XMFLOAT3& eye)
+    {
+        m_eye = eye;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::SetScreenSizeThresholds
+
+      Summary:  Sets the screen sizes a model is evaluated every frame
+                and every 2nd frame from, smaller models being evaluated
+                every 4th frame
+
+      Args:     FLOAT fullRateScreenSize
+                FLOAT halfRateScreenSize
+                  Radius of the world box over its distance to the eye
+
+      Modifies: [m_fullRateScreenSize, m_halfRateScreenSize].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::SetScreenSizeThresholds(_In_ FLOAT fullRateScreenSize, _In_ FLOAT halfRateScreenSize)
+    {
+        m_fullRateScreenSize = fullRateScreenSize;
+        m_halfRateScreenSize = std::min(halfRateScreenSize, fullRateScreenSize);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::SetBudget
+
+      Summary:  Sets the time the evaluations of a frame may take. The
+                first due model is always evaluated
+
+      Args:     FLOAT budget
+                  Budget in milliseconds, 0 for no budget
+
+      Modifies: [m_budget].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::SetBudget(_In_ FLOAT budget)
+    {
+        m_budget = budget;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::SetInterpolation
+
+      Summary:  Enables blending the bone palettes in between
+                evaluations, at the cost of showing each model one
+                interval late
+
+      Args:     BOOL bInterpolate
+                  TRUE to interpolate
+
+      Modifies: [m_bInterpolate, m_scheduledModels].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::SetInterpolation(_In_ BOOL bInterpolate)
+    {
+        m_bInterpolate = bInterpolate;
+        for (auto it = m_scheduledModels.begin(); it != m_scheduledModels.end(); ++it)
+        {
+            it->second.aPreviousTransforms.clear();
+            it->second.aNextTransforms.clear();
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::GetNumEvaluations
+
+      Summary:  Returns the number of models evaluated this frame
+
+      Returns:  UINT
+                  Number of evaluations
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT AnimationScheduler::GetNumEvaluations() const
+    {
+        return m_uNumEvaluations;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::GetNumDeferred
+
+      Summary:  Returns the number of due models deferred to the next
+                frame because the budget ran out
+
+      Returns:  UINT
+                  Number of deferred models
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT AnimationScheduler::GetNumDeferred() const
+    {
+        return m_uNumDeferred;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::GetEvaluationTime
+
+      Summary:  Returns the time the evaluations took this frame
+
+      Returns:  FLOAT
+                  Evaluation time in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationScheduler::GetEvaluationTime() const
+    {
+        return m_evaluationTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::GetBudget
+
+      Summary:  Returns the time the evaluations of a frame may take
+
+      Returns:  FLOAT
+                  Budget in milliseconds, 0 for no budget
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationScheduler::GetBudget() const
+    {
+        return m_budget;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::LogStatistics
+
+      Summary:  Logs the models evaluated and deferred this frame and
+                the time they took of the budget, when the statistics
+                are logged
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::LogStatistics() const
+    {
+        if (!Statistics::IsLogging())
+        {
+            return;
+        }
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "AnimationScheduler: %u animations evaluated in %.3f of %.3f ms with %u deferred\n",
+            m_uNumEvaluations,
+            m_evaluationTime,
+            m_budget,
+            m_uNumDeferred
+        );
+        OutputDebugStringA(szDebugMessage);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::evaluate
+
+      Summary:  Updates the model over the time it missed. When
+                interpolating, the new palette becomes the target and
+                the model shows the previous one until it blends over
+
+      Args:     Model& model
+                  Model to evaluate
+                ScheduledModel& scheduledModel
+                  Schedule of the model
+
+      Modifies: [scheduledModel].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::evaluate(_In_ Model& model, _Inout_ ScheduledModel& scheduledModel)
+    {
+        model.Update(scheduledModel.pendingTime);
+
+        scheduledModel.pendingTime = 0.0f;
+        scheduledModel.uNumFramesSinceEvaluation = 0u;
+        scheduledModel.bOverdue = FALSE;
+
+        if (m_bInterpolate)
+        {
+            std::vector<XMMATRIX>& aBoneTransforms = model.GetBoneTransforms();
+            scheduledModel.aPreviousTransforms.swap(scheduledModel.aNextTransforms);
+            scheduledModel.aNextTransforms.assign(aBoneTransforms.begin(), aBoneTransforms.end());
+            if (scheduledModel.uInterval > 1u && scheduledModel.aPreviousTransforms.size() == aBoneTransforms.size())
+            {
+                std::copy(scheduledModel.aPreviousTransforms.begin(), scheduledModel.aPreviousTransforms.end(), aBoneTransforms.begin());
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::interpolate
+
+      Summary:  Blends the bone palette of the model from its previous
+                evaluation toward its last one, by the part of the
+                interval that has passed. Models evaluated every frame
+                show their new palette at once. The matrices are blended per
+                element, as the baked crowds do between frames
+
+      Args:     Model& model
+                  Model to blend the palette of
+                const ScheduledModel& scheduledModel
+                  Schedule of the model
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void AnimationScheduler::interpolate(_In_ Model& model, _In_ const ScheduledModel& scheduledModel) const
+    {
+        std::vector<XMMATRIX>& aBoneTransforms = model.GetBoneTransforms();
+        if (scheduledModel.aPreviousTransforms.size() != aBoneTransforms.size() ||
+            scheduledModel.aNextTransforms.size() != aBoneTransforms.size())
+        {
+            return;
+        }
+
+        const FLOAT blend = std::min(static_cast<FLOAT>(scheduledModel.uNumFramesSinceEvaluation) / static_cast<FLOAT>(scheduledModel.uInterval), 1.0f);
+        for (size_t i = 0u; i < aBoneTransforms.size(); ++i)
+        {
+            const XMMATRIX& previous = scheduledModel.aPreviousTransforms[i];
+            const XMMATRIX& next = scheduledModel.aNextTransforms[i];
+            aBoneTransforms[i].r[0] = XMVectorLerp(previous.r[0], next.r[0], blend);
+            aBoneTransforms[i].r[1] = XMVectorLerp(previous.r[1], next.r[1], blend);
+            aBoneTransforms[i].r[2] = XMVectorLerp(previous.r[2], next.r[2], blend);
+            aBoneTransforms[i].r[3] = XMVectorLerp(previous.r[3], next.r[3], blend);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::getInterval
+
+      Summary:  Returns the number of frames between two evaluations of
+                a model of the given screen size
+
+      Args:     FLOAT screenSize
+                  Radius of the world box over its distance to the eye
+
+      Returns:  UINT
+                  1, 2 or MAX_UPDATE_INTERVAL
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT AnimationScheduler::getInterval(_In_ FLOAT screenSize) const
+    {
+        if (screenSize >= m_fullRateScreenSize)
+        {
+            return 1u;
+        }
+
+        if (screenSize >= m_halfRateScreenSize)
+        {
+            return 2u;
+        }
+
+        return MAX_UPDATE_INTERVAL;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   AnimationScheduler::getScreenSize
+
+      Summary:  Returns the radius of the world box of the model over
+                its distance to the eye, 1 when the eye is inside
+
+      Args:     const Model& model
+                  Model to measure
+
+      Returns:  FLOAT
+                  Screen size in (0, 1]
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT AnimationScheduler::getScreenSize(_In_ const Model& model) const
+    {
+        XMFLOAT3 boundsMin;
+        XMFLOAT3 boundsMax;
+        model.GetWorldBounds(boundsMin, boundsMax);
+
+        XMVECTOR lower = XMLoadFloat3(&boundsMin);
+        XMVECTOR upper = XMLoadFloat3(&boundsMax);
+        FLOAT radius = XMVectorGetX(XMVector3Length(upper - lower)) * 0.5f;
+        FLOAT distance = XMVectorGetX(XMVector3Length((lower + upper) * 0.5f - XMLoadFloat3(&m_eye)));
+        if (distance <= radius)
+        {
+            return 1.0f;
+        }
+
+        return radius / distance;
+    }
+}
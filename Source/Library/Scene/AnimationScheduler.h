@@ -0,0 +1,132 @@
+/*+===================================================================
+  File:      ANIMATIONSCHEDULER.H
+
+  Summary:   AnimationScheduler header file contains declarations of
+             AnimationScheduler class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: AnimationScheduler
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Model/Model.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    AnimationScheduler
+
+      Summary:  Decides which animated models are evaluated each frame.
+                The screen size of a model, the radius of its world box
+                over its distance to the eye, sets its interval: every
+                frame, every 2nd or every 4th. Each model gets its own
+                phase, so models with the same interval are spread over
+                the frames. A skipped model keeps the time it missed and
+                is evaluated over all of it. The models due in a frame
+                are evaluated largest first until the millisecond budget
+                runs out, and the rest are deferred to the next frame.
+                With interpolation, the bone palette of a model lags by
+                one interval and blends between its last two
+                evaluations on the frames in between
+
+      Methods:  Update
+                  Evaluates the models due this frame
+                SetEyePosition
+                  Sets the position the screen sizes are measured from
+                SetScreenSizeThresholds
+                  Sets the screen sizes of the full and half rates
+                SetBudget
+                  Sets the milliseconds the evaluations may take
+                SetInterpolation
+                  Enables blending the bone palettes in between
+                  evaluations
+                GetNumEvaluations
+                  Returns the number of models evaluated this frame
+                GetNumDeferred
+                  Returns the number of due models deferred this frame
+                GetEvaluationTime
+                  Returns the time the evaluations took this frame
+                GetBudget
+                  Returns the milliseconds the evaluations may take
+                LogStatistics
+                  Logs the evaluations of the frame against the
+                  budget
+                AnimationScheduler
+                  Constructor.
+                ~AnimationScheduler
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class AnimationScheduler
+    {
+    public:
+        static constexpr const UINT MAX_UPDATE_INTERVAL = 4u;
+        static constexpr const FLOAT DEFAULT_FULL_RATE_SCREEN_SIZE = 0.1f;
+        static constexpr const FLOAT DEFAULT_HALF_RATE_SCREEN_SIZE = 0.03f;
+        static constexpr const FLOAT DEFAULT_BUDGET = 2.0f;
+
+    public:
+        AnimationScheduler();
+        AnimationScheduler(const AnimationScheduler& other) = delete;
+        AnimationScheduler(AnimationScheduler&& other) = delete;
+        AnimationScheduler& operator=(const AnimationScheduler& other) = delete;
+        AnimationScheduler& operator=(AnimationScheduler&& other) = delete;
+        ~AnimationScheduler() = default;
+
+        void Update(_In_ std::unordered_map<std::wstring, std::shared_ptr<Model>>& models, _In_ FLOAT deltaTime);
+
+        void SetEyePosition(_In_ const XMFLOAT3& eye);
+        void SetScreenSizeThresholds(_In_ FLOAT fullRateScreenSize, _In_ FLOAT halfRateScreenSize);
+        void SetBudget(_In_ FLOAT budget);
+        void SetInterpolation(_In_ BOOL bInterpolate);
+
+        UINT GetNumEvaluations() const;
+        UINT GetNumDeferred() const;
+        FLOAT GetEvaluationTime() const;
+        FLOAT GetBudget() const;
+        void LogStatistics() const;
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   ScheduledModel
+
+          Summary:  Schedule of a model, the time it has not been
+                    evaluated over yet, and its last two bone palettes
+                    when interpolating
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct ScheduledModel
+        {
+            UINT uPhase;
+            UINT uInterval;
+            UINT uNumFramesSinceEvaluation;
+            FLOAT pendingTime;
+            FLOAT screenSize;
+            BOOL bOverdue;
+            std::vector<XMMATRIX> aPreviousTransforms;
+            std::vector<XMMATRIX> aNextTransforms;
+        };
+
+        void evaluate(_In_ Model& model, _Inout_ ScheduledModel& scheduledModel);
+        void interpolate(_In_ Model& model, _In_ const ScheduledModel& scheduledModel) const;
+        UINT getInterval(_In_ FLOAT screenSize) const;
+        FLOAT getScreenSize(_In_ const Model& model) const;
+
+    private:
+        XMFLOAT3 m_eye;
+        FLOAT m_fullRateScreenSize;
+        FLOAT m_halfRateScreenSize;
+        FLOAT m_budget;
+        BOOL m_bInterpolate;
+
+        std::unordered_map<const Model*, ScheduledModel> m_scheduledModels;
+        std::vector<std::pair<Model*, ScheduledModel*>> m_aDueModels;
+
+        UINT m_uFrameIndex;
+        UINT m_uNumEvaluations;
+        UINT m_uNumDeferred;
+        FLOAT m_evaluationTime;
+    };
+}
@@ -0,0 +1,205 @@
+#include "Scene/HeightField.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HeightField::HeightField
+
+      Summary:  Constructor of an empty height field
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HeightField::HeightField()
+        : m_uWidth(0u)
+        , m_uHeight(0u)
+        , m_uDepth(0u)
+        , m_aNumBlocks()
+        , m_aBlockTypes()
+        , m_aColors()
+    { }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HeightField::HeightField
+
+      Summary:  Constructor
+
+      Args:     UINT uWidth
+                  Number of columns along x
+                UINT uHeight
+                  Maximum number of blocks of a column
+                UINT uDepth
+                  Number of columns along z
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HeightField::HeightField(_In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth)
+        : m_uWidth(uWidth)
+        , m_uHeight(uHeight)
+        , m_uDepth(uDepth)
+        , m_aNumBlocks(static_cast<size_t>(uWidth) * static_cast<size_t>(uDepth), 0u)
+        , m_aBlockTypes(static_cast<size_t>(uWidth) * static_cast<size_t>(uDepth), eBlockType::GRASSLAND)
+        , m_aColors()
+    { }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HeightField::SetColumn
+
+      Summary:  Sets the block type and block count of a column
+
+      Args:     UINT uX
+                  Column index along x
+                UINT uZ
+                  Column index along z
+                eBlockType blockType
+                  Biome type of the column
+                UINT uNumBlocks
+                  Number of stacked blocks
+
+      Modifies: [m_aNumBlocks, m_aBlockTypes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HeightField::SetColumn(_In_ UINT uX, _In_ UINT uZ, _In_ eBlockType blockType, _In_ UINT uNumBlocks)
+    {
+        assert(uX < m_uWidth && uZ < m_uDepth);
+
+        size_t index = static_cast<size_t>(uZ) * m_uWidth + uX;
+        m_aNumBlocks[index] = uNumBlocks;
+        m_aBlockTypes[index] = blockType;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HeightField::SetColors
+
+      Summary:  Sets the biome color table, indexed from GRASSLAND
+
+      Args:     std::vector<XMFLOAT4>&& aColors
+                  Colors of the biomes
+
+      Modifies: [m_aColors].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HeightField::SetColors(_In_ std::vector<XMFLOAT4>&& aColors)
+    {
+        m_aColors = std::move(aColors);
+    }
+
+
+    UINT HeightField::GetWidth() const
+    {
+        return m_uWidth;
+    }
+
+
+    UINT HeightField::GetHeight() const
+    {
+        return m_uHeight;
+    }
+
+
+    UINT HeightField::GetDepth() const
+    {
+        return m_uDepth;
+    }
+
+
+    UINT HeightField::GetNumBlocks(_In_ UINT uX, _In_ UINT uZ) const
+    {
+        return m_aNumBlocks[static_cast<size_t>(uZ) * m_uWidth + uX];
+    }
+
+
+    eBlockType HeightField::GetBlockType(_In_ UINT uX, _In_ UINT uZ) const
+    {
+        return m_aBlockTypes[static_cast<size_t>(uZ) * m_uWidth + uX];
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HeightField::GetColor
+
+      Summary:  Returns the biome color of a column
+
+      Args:     UINT uX
+                  Column index along x
+                UINT uZ
+                  Column index along z
+
+      Returns:  XMFLOAT4
+                  Color of the biome, white if the color table does not
+                  cover the biome
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    XMFLOAT4 HeightField::GetColor(_In_ UINT uX, _In_ UINT uZ) const
+    {
+        size_t colorIdx = static_cast<size_t>(GetBlockType(uX, uZ)) - static_cast<size_t>(eBlockType::GRASSLAND);
+        if (colorIdx >= m_aColors.size())
+        {
+            return XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+
+        return m_aColors[colorIdx];
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HeightField::GetSurfaceHeight
+
+      Summary:  Returns the world y of the top face of a column, matching
+                the translation Scene gives the voxel instances
+
+      Args:     UINT uX
+                  Column index along x
+                UINT uZ
+                  Column index along z
+
+      Returns:  FLOAT
+                  World y of the top face
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HeightField::GetSurfaceHeight(_In_ UINT uX, _In_ UINT uZ) const
+    {
+        FLOAT height = static_cast<FLOAT>(m_uHeight);
+
+        return CELL_SIZE * static_cast<FLOAT>(GetNumBlocks(uX, uZ)) - CELL_SIZE * 0.5f - height * 1.25f;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HeightField::GetCellPosition
+
+      Summary:  Returns the world center of a block
+
+      Args:     UINT uX
+                  Column index along x
+                UINT uY
+                  Block index inside the column
+                UINT uZ
+                  Column index along z
+
+      Returns:  XMFLOAT3
+                  World position of the block center
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    XMFLOAT3 HeightField::GetCellPosition(_In_ UINT uX, _In_ UINT uY, _In_ UINT uZ) const
+    {
+        FLOAT height = static_cast<FLOAT>(m_uHeight);
+
+        return XMFLOAT3(
+            GetWorldX(static_cast<FLOAT>(uX)),
+            CELL_SIZE * (static_cast<FLOAT>(uY) - height) + height * 0.75f,
+            GetWorldZ(static_cast<FLOAT>(uZ))
+        );
+    }
+
+
+    FLOAT HeightField::GetWorldX(_In_ FLOAT x) const
+    {
+        return CELL_SIZE * (x - static_cast<FLOAT>(m_uWidth) / 2.0f);
+    }
+
+
+    FLOAT HeightField::GetWorldZ(_In_ FLOAT z) const
+    {
+        return CELL_SIZE * (z - static_cast<FLOAT>(m_uDepth) / 2.0f);
+    }
+
+
+    BOOL HeightField::IsEmpty() const
+    {
+        return m_uWidth == 0u || m_uDepth == 0u;
+    }
+}
@@ -0,0 +1,98 @@
+/*+===================================================================
+  File:      HEIGHTFIELD.H
+
+  Summary:   HeightField header file contains declarations of
+             HeightField class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: HeightField
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    HeightField
+
+      Summary:  Column representation of the height map the scene
+                reads. Every (x, z) column stores the biome type and
+                the number of stacked blocks, and the class maps grid
+                cells onto the same world positions the voxel
+                instances use
+
+      Methods:  SetColumn
+                  Sets the block type and block count of a column
+                SetColors
+                  Sets the biome color table
+                GetWidth
+                  Returns the number of columns along x
+                GetHeight
+                  Returns the maximum number of blocks of a column
+                GetDepth
+                  Returns the number of columns along z
+                GetNumBlocks
+                  Returns the number of blocks of a column
+                GetBlockType
+                  Returns the biome type of a column
+                GetColor
+                  Returns the biome color of a column
+                GetSurfaceHeight
+                  Returns the world y of the top face of a column
+                GetCellPosition
+                  Returns the world center of a block
+                GetWorldX
+                  Returns the world x of a column center
+                GetWorldZ
+                  Returns the world z of a column center
+                IsEmpty
+                  Returns whether the height field has no columns
+                HeightField
+                  Constructor.
+                ~HeightField
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class HeightField
+    {
+    public:
+        static constexpr const FLOAT CELL_SIZE = 2.0f;
+
+    public:
+        HeightField();
+        HeightField(_In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth);
+        HeightField(const HeightField& other) = default;
+        HeightField(HeightField&& other) = default;
+        HeightField& operator=(const HeightField& other) = default;
+        HeightField& operator=(HeightField&& other) = default;
+        ~HeightField() = default;
+
+        void SetColumn(_In_ UINT uX, _In_ UINT uZ, _In_ eBlockType blockType, _In_ UINT uNumBlocks);
+        void SetColors(_In_ std::vector<XMFLOAT4>&& aColors);
+
+        UINT GetWidth() const;
+        UINT GetHeight() const;
+        UINT GetDepth() const;
+
+        UINT GetNumBlocks(_In_ UINT uX, _In_ UINT uZ) const;
+        eBlockType GetBlockType(_In_ UINT uX, _In_ UINT uZ) const;
+        XMFLOAT4 GetColor(_In_ UINT uX, _In_ UINT uZ) const;
+
+        FLOAT GetSurfaceHeight(_In_ UINT uX, _In_ UINT uZ) const;
+        XMFLOAT3 GetCellPosition(_In_ UINT uX, _In_ UINT uY, _In_ UINT uZ) const;
+        FLOAT GetWorldX(_In_ FLOAT x) const;
+        FLOAT GetWorldZ(_In_ FLOAT z) const;
+
+        BOOL IsEmpty() const;
+
+    private:
+        UINT m_uWidth;
+        UINT m_uHeight;
+        UINT m_uDepth;
+        std::vector<UINT> m_aNumBlocks;
+        std::vector<eBlockType> m_aBlockTypes;
+        std::vector<XMFLOAT4> m_aColors;
+    };
+}
@@ -0,0 +1,550 @@
+#include "Scene/HorizonCuller.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::HorizonCuller
+
+      Summary:  Constructor of an empty culler
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HorizonCuller::HorizonCuller()
+        : m_gridMin()
+        , m_gridMax()
+        , m_uBlockSize(1u)
+        , m_uNumBlocksX(0u)
+        , m_uNumBlocksZ(0u)
+        , m_blockExtent(0.0f)
+        , m_aBlockMinTops()
+        , m_uNumCoarseBlocksX(0u)
+        , m_uNumCoarseBlocksZ(0u)
+        , m_aCoarseMinTops()
+        , m_eye()
+        , m_maxDistance(0.0f)
+        , m_aHorizon()
+        , m_bHasHorizon(FALSE)
+        , m_updateTime(0.0f)
+        , m_uNumTests(0u)
+        , m_uNumOccluded(0u)
+    { }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::Build
+
+      Summary:  Groups the columns into at most MAX_NUM_BLOCKS_PER_AXIS
+                blocks on each axis and keeps the lowest top of every
+                block, so a block is solid up to that height over its
+                whole area. Coarse blocks of 2x2 blocks are kept for
+                the far rings
+
+      Args:     const HeightField& heightField
+                  Columns of the height map
+
+      Modifies: [m_gridMin, m_gridMax, m_uBlockSize, m_uNumBlocksX,
+                  m_uNumBlocksZ, m_blockExtent, m_aBlockMinTops,
+                  m_uNumCoarseBlocksX, m_uNumCoarseBlocksZ,
+                  m_aCoarseMinTops, m_aHorizon, m_bHasHorizon].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT HorizonCuller::Build(_In_ const HeightField& heightField)
+    {
+        if (heightField.IsEmpty())
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT uWidth = heightField.GetWidth();
+        UINT uDepth = heightField.GetDepth();
+
+        m_uBlockSize = 1u;
+        while ((uWidth + m_uBlockSize - 1u) / m_uBlockSize > MAX_NUM_BLOCKS_PER_AXIS || (uDepth + m_uBlockSize - 1u) / m_uBlockSize > MAX_NUM_BLOCKS_PER_AXIS)
+        {
+            m_uBlockSize *= 2u;
+        }
+        m_uNumBlocksX = (uWidth + m_uBlockSize - 1u) / m_uBlockSize;
+        m_uNumBlocksZ = (uDepth + m_uBlockSize - 1u) / m_uBlockSize;
+        m_blockExtent = static_cast<FLOAT>(m_uBlockSize) * HeightField::CELL_SIZE;
+
+        constexpr const FLOAT HALF_CELL = HeightField::CELL_SIZE * 0.5f;
+        m_gridMin = XMFLOAT3(heightField.GetWorldX(0.0f) - HALF_CELL, 0.0f, heightField.GetWorldZ(0.0f) - HALF_CELL);
+        m_gridMax = XMFLOAT3(heightField.GetWorldX(static_cast<FLOAT>(uWidth - 1u)) + HALF_CELL, 0.0f, heightField.GetWorldZ(static_cast<FLOAT>(uDepth - 1u)) + HALF_CELL);
+
+        m_aBlockMinTops.assign(static_cast<size_t>(m_uNumBlocksX) * m_uNumBlocksZ, FLT_MAX);
+        for (UINT z = 0u; z < uDepth; ++z)
+        {
+            for (UINT x = 0u; x < uWidth; ++x)
+            {
+                FLOAT& minTop = m_aBlockMinTops[static_cast<size_t>(z / m_uBlockSize) * m_uNumBlocksX + x / m_uBlockSize];
+                minTop = std::min(minTop, heightField.GetSurfaceHeight(x, z));
+            }
+        }
+
+        m_uNumCoarseBlocksX = (m_uNumBlocksX + 1u) / 2u;
+        m_uNumCoarseBlocksZ = (m_uNumBlocksZ + 1u) / 2u;
+        m_aCoarseMinTops.assign(static_cast<size_t>(m_uNumCoarseBlocksX) * m_uNumCoarseBlocksZ, FLT_MAX);
+        for (UINT z = 0u; z < m_uNumBlocksZ; ++z)
+        {
+            for (UINT x = 0u; x < m_uNumBlocksX; ++x)
+            {
+                FLOAT& minTop = m_aCoarseMinTops[static_cast<size_t>(z / 2u) * m_uNumCoarseBlocksX + x / 2u];
+                minTop = std::min(minTop, m_aBlockMinTops[static_cast<size_t>(z) * m_uNumBlocksX + x]);
+            }
+        }
+
+        m_aHorizon.assign(static_cast<size_t>(NUM_DISTANCE_LAYERS + 1u) * NUM_AZIMUTH_BINS, -FLT_MAX);
+        m_bHasHorizon = FALSE;
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::Update
+
+      Summary:  Sweeps the blocks in square rings from the block of the
+                eye outwards, switching to the coarse blocks past
+                NUM_FINE_RINGS rings where a block spans few bins.
+                Every block raises the horizon of its distance layer
+                over the azimuth bins it fully covers, then each layer
+                takes the maximum of the layers in front of it
+
+      Args:     const XMFLOAT3& eye
+                  Position of the camera
+
+      Modifies: [m_eye, m_maxDistance, m_aHorizon, m_bHasHorizon,
+                  m_updateTime, m_uNumTests, m_uNumOccluded].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::Update(_In_ const XMFLOAT3& eye)
+    {
+        if (!IsBuilt())
+        {
+            return;
+        }
+
+        LARGE_INTEGER frequency, startingTime, endingTime;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        m_eye = eye;
+        FLOAT farX = std::max(std::abs(eye.x - m_gridMin.x), std::abs(eye.x - m_gridMax.x));
+        FLOAT farZ = std::max(std::abs(eye.z - m_gridMin.z), std::abs(eye.z - m_gridMax.z));
+        m_maxDistance = std::max(std::sqrt(farX * farX + farZ * farZ), HeightField::CELL_SIZE);
+
+        std::fill(m_aHorizon.begin(), m_aHorizon.end(), -FLT_MAX);
+
+        // Close rings add the four blocks of each coarse block, farther rings the coarse block itself
+        FLOAT coarseExtent = m_blockExtent * 2.0f;
+        auto addCoarseBlock = [this, coarseExtent](INT x, INT z, INT ring)
+        {
+            FLOAT minX = m_gridMin.x + static_cast<FLOAT>(x) * coarseExtent;
+            FLOAT minZ = m_gridMin.z + static_cast<FLOAT>(z) * coarseExtent;
+            if (ring > static_cast<INT>(NUM_FINE_RINGS))
+            {
+                addOccluder(minX, minZ, coarseExtent, m_aCoarseMinTops[static_cast<size_t>(z) * m_uNumCoarseBlocksX + static_cast<size_t>(x)]);
+                return;
+            }
+
+            for (UINT uChild = 0u; uChild < 4u; ++uChild)
+            {
+                UINT uBlockX = static_cast<UINT>(x) * 2u + (uChild & 1u);
+                UINT uBlockZ = static_cast<UINT>(z) * 2u + (uChild >> 1u);
+                if (uBlockX < m_uNumBlocksX && uBlockZ < m_uNumBlocksZ)
+                {
+                    addOccluder(minX + static_cast<FLOAT>(uChild & 1u) * m_blockExtent, minZ + static_cast<FLOAT>(uChild >> 1u) * m_blockExtent, m_blockExtent, m_aBlockMinTops[static_cast<size_t>(uBlockZ) * m_uNumBlocksX + uBlockX]);
+                }
+            }
+        };
+
+        INT eyeBlockX = static_cast<INT>(std::floor((eye.x - m_gridMin.x) / coarseExtent));
+        INT eyeBlockZ = static_cast<INT>(std::floor((eye.z - m_gridMin.z) / coarseExtent));
+        INT lastX = static_cast<INT>(m_uNumCoarseBlocksX) - 1;
+        INT lastZ = static_cast<INT>(m_uNumCoarseBlocksZ) - 1;
+        INT maxRing = std::max(std::max(std::abs(eyeBlockX), std::abs(eyeBlockX - lastX)), std::max(std::abs(eyeBlockZ), std::abs(eyeBlockZ - lastZ)));
+
+        for (INT ring = 0; ring <= maxRing; ++ring)
+        {
+            INT x0 = std::max(eyeBlockX - ring, 0);
+            INT x1 = std::min(eyeBlockX + ring, lastX);
+            INT z0 = std::max(eyeBlockZ - ring + 1, 0);
+            INT z1 = std::min(eyeBlockZ + ring - 1, lastZ);
+
+            // Rows of the ring along x, then the columns along z without their corners
+            for (INT z : { eyeBlockZ - ring, eyeBlockZ + ring })
+            {
+                if (0 <= z && z <= lastZ)
+                {
+                    for (INT x = x0; x <= x1; ++x)
+                    {
+                        addCoarseBlock(x, z, ring);
+                    }
+                }
+                if (ring == 0)
+                {
+                    break;
+                }
+            }
+            for (INT x : { eyeBlockX - ring, eyeBlockX + ring })
+            {
+                if (ring > 0 && 0 <= x && x <= lastX)
+                {
+                    for (INT z = z0; z <= z1; ++z)
+                    {
+                        addCoarseBlock(x, z, ring);
+                    }
+                }
+            }
+        }
+
+        for (UINT uLayer = 1u; uLayer <= NUM_DISTANCE_LAYERS; ++uLayer)
+        {
+            const FLOAT* pFront = &m_aHorizon[static_cast<size_t>(uLayer - 1u) * NUM_AZIMUTH_BINS];
+            FLOAT* pLayer = &m_aHorizon[static_cast<size_t>(uLayer) * NUM_AZIMUTH_BINS];
+            for (UINT uBin = 0u; uBin < NUM_AZIMUTH_BINS; ++uBin)
+            {
+                pLayer[uBin] = std::max(pLayer[uBin], pFront[uBin]);
+            }
+        }
+
+        m_bHasHorizon = TRUE;
+        m_uNumTests = 0u;
+        m_uNumOccluded = 0u;
+
+        QueryPerformanceCounter(&endingTime);
+        m_updateTime = static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::IsBoxVisible
+
+      Summary:  Tests the top of a world box against the horizon of the
+                blocks lying entirely closer to the eye than the box.
+                The box is occluded when its steepest slope from the
+                eye is below the horizon in every azimuth bin it
+                touches
+
+      Args:     const XMFLOAT3& boundsMin
+                const XMFLOAT3& boundsMax
+                  World box to test
+
+      Modifies: [m_uNumTests, m_uNumOccluded].
+
+      Returns:  BOOL
+                  TRUE if the box may be visible
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL HorizonCuller::IsBoxVisible(_In_ const XMFLOAT3& boundsMin, _In_ const XMFLOAT3& boundsMax)
+    {
+        if (!m_bHasHorizon)
+        {
+            return TRUE;
+        }
+
+        ++m_uNumTests;
+
+        FLOAT nearX = std::max(std::max(boundsMin.x - m_eye.x, m_eye.x - boundsMax.x), 0.0f);
+        FLOAT nearZ = std::max(std::max(boundsMin.z - m_eye.z, m_eye.z - boundsMax.z), 0.0f);
+        if (nearX <= 0.0f && nearZ <= 0.0f)
+        {
+            return TRUE;
+        }
+
+        FLOAT nearDistance = std::sqrt(nearX * nearX + nearZ * nearZ);
+        UINT uLayer = static_cast<UINT>(getLayer(nearDistance));
+        if (uLayer == 0u)
+        {
+            return TRUE;
+        }
+
+        FLOAT farX = std::max(std::abs(boundsMin.x - m_eye.x), std::abs(boundsMax.x - m_eye.x));
+        FLOAT farZ = std::max(std::abs(boundsMin.z - m_eye.z), std::abs(boundsMax.z - m_eye.z));
+        FLOAT top = boundsMax.y - m_eye.y;
+        FLOAT slope = top > 0.0f ? top / nearDistance : top / std::sqrt(farX * farX + farZ * farZ);
+
+        FLOAT start, end;
+        getAzimuthRange(boundsMin.x, boundsMin.z, boundsMax.x, boundsMax.z, start, end);
+
+        constexpr const FLOAT BINS_PER_UNIT = static_cast<FLOAT>(NUM_AZIMUTH_BINS) / 4.0f;
+        INT firstBin = static_cast<INT>(start * BINS_PER_UNIT);
+        INT lastBin = static_cast<INT>(end * BINS_PER_UNIT);
+
+        const FLOAT* pHorizon = &m_aHorizon[static_cast<size_t>(uLayer) * NUM_AZIMUTH_BINS];
+        for (INT bin = firstBin; bin <= lastBin; ++bin)
+        {
+            if (pHorizon[static_cast<UINT>(bin) % NUM_AZIMUTH_BINS] <= slope)
+            {
+                return TRUE;
+            }
+        }
+
+        ++m_uNumOccluded;
+
+        return FALSE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::IsBuilt
+
+      Summary:  Returns whether the culler has been built
+
+      Returns:  BOOL
+                  TRUE if the blocks are built
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL HorizonCuller::IsBuilt() const
+    {
+        return !m_aBlockMinTops.empty();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::GetUpdateTime
+
+      Summary:  Returns the time the last update took
+
+      Returns:  FLOAT
+                  Update time in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HorizonCuller::GetUpdateTime() const
+    {
+        return m_updateTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::GetNumTests
+
+      Summary:  Returns the number of boxes tested since the update
+
+      Returns:  UINT
+                  Number of tests
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT HorizonCuller::GetNumTests() const
+    {
+        return m_uNumTests;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::GetNumOccluded
+
+      Summary:  Returns the number of boxes occluded since the update
+
+      Returns:  UINT
+                  Number of occluded boxes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT HorizonCuller::GetNumOccluded() const
+    {
+        return m_uNumOccluded;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::LogStatistics
+
+      Summary:  Logs the sweep time and the boxes occluded since the
+                update, when the statistics are logged
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::LogStatistics() const
+    {
+        if (!Statistics::IsLogging())
+        {
+            return;
+        }
+
+        CHAR szDebugMessage[256];
+        sprintf_s(
+            szDebugMessage,
+            "HorizonCuller: sweep %.3f ms with %u of %u boxes occluded\n",
+            m_updateTime,
+            m_uNumOccluded,
+            m_uNumTests
+        );
+        OutputDebugStringA(szDebugMessage);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::addOccluder
+
+      Summary:  Raises the horizon of the layer of a block. The lowest
+                top is projected from the distance that gives the
+                smallest slope, and only the bins the block covers
+                completely are raised
+
+      Args:     FLOAT minX
+                FLOAT minZ
+                  Corner of the block
+                FLOAT extent
+                  Size of the block, clipped to the grid
+                FLOAT minTop
+                  Lowest top of the columns of the block
+
+      Modifies: [m_aHorizon].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::addOccluder(_In_ FLOAT minX, _In_ FLOAT minZ, _In_ FLOAT extent, _In_ FLOAT minTop)
+    {
+        FLOAT maxX = std::min(minX + extent, m_gridMax.x);
+        FLOAT maxZ = std::min(minZ + extent, m_gridMax.z);
+
+        FLOAT nearX = std::max(std::max(minX - m_eye.x, m_eye.x - maxX), 0.0f);
+        FLOAT nearZ = std::max(std::max(minZ - m_eye.z, m_eye.z - maxZ), 0.0f);
+        if (nearX <= 0.0f && nearZ <= 0.0f)
+        {
+            return;
+        }
+
+        // Far blocks often cover no bin completely, so the azimuths are checked first
+        FLOAT start, end;
+        getAzimuthRange(minX, minZ, maxX, maxZ, start, end);
+
+        constexpr const FLOAT BINS_PER_UNIT = static_cast<FLOAT>(NUM_AZIMUTH_BINS) / 4.0f;
+        FLOAT startBin = start * BINS_PER_UNIT;
+        INT firstBin = static_cast<INT>(startBin);
+        firstBin += static_cast<FLOAT>(firstBin) < startBin ? 1 : 0;
+        INT endBin = static_cast<INT>(end * BINS_PER_UNIT);
+        if (firstBin >= endBin)
+        {
+            return;
+        }
+
+        FLOAT farX = std::max(std::abs(minX - m_eye.x), std::abs(maxX - m_eye.x));
+        FLOAT farZ = std::max(std::abs(minZ - m_eye.z), std::abs(maxZ - m_eye.z));
+        FLOAT farDistance = std::sqrt(farX * farX + farZ * farZ);
+
+        FLOAT top = minTop - m_eye.y;
+        FLOAT slope = top > 0.0f ? top / farDistance : top / std::sqrt(nearX * nearX + nearZ * nearZ);
+
+        FLOAT layer = getLayer(farDistance);
+        UINT uLayer = static_cast<UINT>(layer);
+        uLayer = std::min(uLayer + (static_cast<FLOAT>(uLayer) < layer ? 1u : 0u), NUM_DISTANCE_LAYERS);
+        FLOAT* pHorizon = &m_aHorizon[static_cast<size_t>(uLayer) * NUM_AZIMUTH_BINS];
+
+        // At most two contiguous runs, split where the bins wrap around
+        UINT uFirst = static_cast<UINT>(firstBin) % NUM_AZIMUTH_BINS;
+        UINT uCount = static_cast<UINT>(endBin - firstBin);
+        UINT uFirstRun = std::min(uCount, NUM_AZIMUTH_BINS - uFirst);
+        for (UINT i = 0u; i < uFirstRun; ++i)
+        {
+            pHorizon[uFirst + i] = std::max(pHorizon[uFirst + i], slope);
+        }
+        for (UINT i = 0u; i < uCount - uFirstRun; ++i)
+        {
+            pHorizon[i] = std::max(pHorizon[i], slope);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::getAzimuthRange
+
+      Summary:  Returns the azimuths of the two silhouette corners of a
+                rectangle seen from the eye, as pseudo angles in
+                [0, 4) with the end unwrapped past the start
+
+      Args:     FLOAT minX
+                FLOAT minZ
+                FLOAT maxX
+                FLOAT maxZ
+                  Rectangle on the xz plane, not containing the eye
+                FLOAT& outStart
+                FLOAT& outEnd
+                  Azimuth range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::getAzimuthRange(_In_ FLOAT minX, _In_ FLOAT minZ, _In_ FLOAT maxX, _In_ FLOAT maxZ, _Out_ FLOAT& outStart, _Out_ FLOAT& outEnd) const
+    {
+        // The silhouette corners depend on the region of the eye around the rectangle
+        BOOL bBelowZ = m_eye.z < minZ;
+        BOOL bAboveZ = m_eye.z > maxZ;
+        FLOAT aX[2] = { minX, maxX };
+        FLOAT aZ[2] = { minZ, maxZ };
+        if (m_eye.x < minX || m_eye.x > maxX)
+        {
+            FLOAT nearX = m_eye.x < minX ? minX : maxX;
+            FLOAT farX = m_eye.x < minX ? maxX : minX;
+            if (bBelowZ || bAboveZ)
+            {
+                // Diagonal corners, the near one in z paired with the far one in x
+                aX[0] = farX;
+                aZ[0] = bBelowZ ? minZ : maxZ;
+                aX[1] = nearX;
+                aZ[1] = bBelowZ ? maxZ : minZ;
+            }
+            else
+            {
+                aX[0] = nearX;
+                aX[1] = nearX;
+            }
+        }
+        else
+        {
+            aZ[0] = bBelowZ ? minZ : maxZ;
+            aZ[1] = aZ[0];
+        }
+
+        FLOAT a = getPseudoAngle(aX[0] - m_eye.x, aZ[0] - m_eye.z);
+        FLOAT b = getPseudoAngle(aX[1] - m_eye.x, aZ[1] - m_eye.z);
+
+        // Less than half a turn apart, two units of the pseudo angle
+        FLOAT delta = b - a;
+        if (delta > 2.0f)
+        {
+            delta -= 4.0f;
+        }
+        else if (delta < -2.0f)
+        {
+            delta += 4.0f;
+        }
+
+        outStart = delta >= 0.0f ? a : a + delta;
+        outEnd = outStart + std::abs(delta);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::getLayer
+
+      Summary:  Maps a distance from the eye onto the distance layers,
+                with finer layers close to the eye
+
+      Args:     FLOAT distance
+                  Distance on the xz plane
+
+      Returns:  FLOAT
+                  Continuous layer in [0, NUM_DISTANCE_LAYERS]
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HorizonCuller::getLayer(_In_ FLOAT distance) const
+    {
+        return static_cast<FLOAT>(NUM_DISTANCE_LAYERS) * std::sqrt(std::min(distance / m_maxDistance, 1.0f));
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::getPseudoAngle
+
+      Summary:  Monotonic replacement of atan2 without trigonometry,
+                one unit per quarter turn
+
+      Args:     FLOAT x
+                FLOAT z
+                  Direction on the xz plane
+
+      Returns:  FLOAT
+                  Pseudo angle in [0, 4)
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HorizonCuller::getPseudoAngle(_In_ FLOAT x, _In_ FLOAT z)
+    {
+        if (z >= 0.0f)
+        {
+            return x >= 0.0f ? z / (x + z) : 1.0f - x / (z - x);
+        }
+
+        return x < 0.0f ? 2.0f - z / (-x - z) : 3.0f + x / (x - z);
+    }
+}
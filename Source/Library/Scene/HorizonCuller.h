@@ -0,0 +1,110 @@
+/*+===================================================================
+  File:      HORIZONCULLER.H
+
+  Summary:   HorizonCuller header file contains declarations of
+             HorizonCuller class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: HorizonCuller
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Scene/HeightField.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    HorizonCuller
+
+      Summary:  Occlusion culling against the height map without any
+                GPU query. The columns are grouped into blocks that
+                keep their lowest top, and every frame the blocks are
+                swept in rings from the camera outwards, raising a 1D
+                horizon of elevation slopes per azimuth bin. The
+                horizon is kept per distance layer, so a box is only
+                tested against blocks that lie entirely in front of
+                it, and is occluded when its top is below the horizon
+                over all the azimuths it covers
+
+      Methods:  Build
+                  Computes the lowest top of every block of columns
+                Update
+                  Sweeps the blocks from the eye and builds the
+                  horizon of the frame
+                IsBoxVisible
+                  Returns whether a world box may be visible
+                IsBuilt
+                  Returns whether the culler has been built
+                GetUpdateTime
+                  Returns the time the last update took
+                GetNumTests
+                  Returns the number of boxes tested this frame
+                GetNumOccluded
+                  Returns the number of boxes occluded this frame
+                LogStatistics
+                  Logs the sweep time and the occluded boxes
+                HorizonCuller
+                  Constructor.
+                ~HorizonCuller
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class HorizonCuller
+    {
+    public:
+        static constexpr const UINT NUM_AZIMUTH_BINS = 1024u;
+        static constexpr const UINT NUM_DISTANCE_LAYERS = 32u;
+        static constexpr const UINT MAX_NUM_BLOCKS_PER_AXIS = 128u;
+        static constexpr const UINT NUM_FINE_RINGS = 12u;
+
+    public:
+        HorizonCuller();
+        HorizonCuller(const HorizonCuller& other) = delete;
+        HorizonCuller(HorizonCuller&& other) = delete;
+        HorizonCuller& operator=(const HorizonCuller& other) = delete;
+        HorizonCuller& operator=(HorizonCuller&& other) = delete;
+        ~HorizonCuller() = default;
+
+        HRESULT Build(_In_ const HeightField& heightField);
+        void Update(_In_ const XMFLOAT3& eye);
+
+        BOOL IsBoxVisible(_In_ const XMFLOAT3& boundsMin, _In_ const XMFLOAT3& boundsMax);
+
+        BOOL IsBuilt() const;
+        FLOAT GetUpdateTime() const;
+        UINT GetNumTests() const;
+        UINT GetNumOccluded() const;
+        void LogStatistics() const;
+
+    private:
+        void addOccluder(_In_ FLOAT minX, _In_ FLOAT minZ, _In_ FLOAT extent, _In_ FLOAT minTop);
+        void getAzimuthRange(_In_ FLOAT minX, _In_ FLOAT minZ, _In_ FLOAT maxX, _In_ FLOAT maxZ, _Out_ FLOAT& outStart, _Out_ FLOAT& outEnd) const;
+        FLOAT getLayer(_In_ FLOAT distance) const;
+
+        static FLOAT getPseudoAngle(_In_ FLOAT x, _In_ FLOAT z);
+
+    private:
+        XMFLOAT3 m_gridMin;
+        XMFLOAT3 m_gridMax;
+        UINT m_uBlockSize;
+        UINT m_uNumBlocksX;
+        UINT m_uNumBlocksZ;
+        FLOAT m_blockExtent;
+        std::vector<FLOAT> m_aBlockMinTops;
+        UINT m_uNumCoarseBlocksX;
+        UINT m_uNumCoarseBlocksZ;
+        std::vector<FLOAT> m_aCoarseMinTops;
+
+        XMFLOAT3 m_eye;
+        FLOAT m_maxDistance;
+        std::vector<FLOAT> m_aHorizon;
+        BOOL m_bHasHorizon;
+
+        FLOAT m_updateTime;
+        UINT m_uNumTests;
+        UINT m_uNumOccluded;
+    };
+}
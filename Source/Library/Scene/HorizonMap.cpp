@@ -0,0 +1,401 @@
+#include "Scene/HorizonMap.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const FLOAT STEP_GROWTH = 1.0f / 8.0f;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::HorizonMap
+
+      Summary:  Constructor of an empty horizon map
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HorizonMap::HorizonMap()
+        : m_uWidth(0u)
+        , m_uDepth(0u)
+        , m_gridOrigin()
+        , m_maxSurfaceHeight(0.0f)
+        , m_aSurfaceHeights()
+        , m_aDirections()
+        , m_aHorizons()
+        , m_texture()
+        , m_textureView()
+        , m_constantBuffer()
+        , m_buildTime(0.0f)
+        , m_uNumThreads(0u)
+    {
+        for (UINT i = 0u; i < NUM_AZIMUTHS; ++i)
+        {
+            FLOAT azimuth = XM_2PI * static_cast<FLOAT>(i) / static_cast<FLOAT>(NUM_AZIMUTHS);
+            m_aDirections[i] = XMFLOAT2(std::cos(azimuth), std::sin(azimuth));
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::Build
+
+      Summary:  Computes the horizon of every column in every azimuth.
+                The rows are independent, so they are split over
+                worker threads
+
+      Args:     const HeightField& heightField
+                  Columns of the height map
+                UINT uNumThreads
+                  Number of threads, 0 for the hardware concurrency
+
+      Modifies: [m_uWidth, m_uDepth, m_gridOrigin, m_maxSurfaceHeight,
+                  m_aSurfaceHeights, m_aHorizons, m_buildTime,
+                  m_uNumThreads].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT HorizonMap::Build(_In_ const HeightField& heightField, _In_opt_ UINT uNumThreads)
+    {
+        if (heightField.IsEmpty())
+        {
+            return E_INVALIDARG;
+        }
+
+        LARGE_INTEGER frequency, startingTime, endingTime;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        m_uWidth = heightField.GetWidth();
+        m_uDepth = heightField.GetDepth();
+        m_gridOrigin = XMFLOAT2(heightField.GetWorldX(0.0f), heightField.GetWorldZ(0.0f));
+
+        // Heights kept here, the march reads them millions of times
+        m_maxSurfaceHeight = -FLT_MAX;
+        m_aSurfaceHeights.resize(static_cast<size_t>(m_uWidth) * m_uDepth);
+        for (UINT z = 0u; z < m_uDepth; ++z)
+        {
+            for (UINT x = 0u; x < m_uWidth; ++x)
+            {
+                FLOAT surfaceHeight = heightField.GetSurfaceHeight(x, z);
+                m_aSurfaceHeights[static_cast<size_t>(z) * m_uWidth + x] = surfaceHeight;
+                m_maxSurfaceHeight = std::max(m_maxSurfaceHeight, surfaceHeight);
+            }
+        }
+
+        m_uNumThreads = GetNumParallelThreads(m_uDepth, uNumThreads);
+
+        m_aHorizons.assign(static_cast<size_t>(NUM_AZIMUTHS) * m_uWidth * m_uDepth * NUM_CHANNELS, 0u);
+        computeColumns(0u, 0u, m_uWidth - 1u, m_uDepth - 1u);
+
+        QueryPerformanceCounter(&endingTime);
+        m_buildTime = static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart));
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::Initialize
+
+      Summary:  Creates the texture array with a slice per azimuth,
+                filled with the built horizons and their distances,
+                and the constant buffer describing the column grid
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the resources
+
+      Modifies: [m_texture, m_textureView, m_constantBuffer].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT HorizonMap::Initialize(_In_ ID3D11Device* pDevice)
+    {
+        if (!IsBuilt())
+        {
+            return E_FAIL;
+        }
+
+        D3D11_SUBRESOURCE_DATA aInitData[NUM_AZIMUTHS];
+        for (UINT i = 0u; i < NUM_AZIMUTHS; ++i)
+        {
+            aInitData[i] =
+            {
+                .pSysMem = &m_aHorizons[static_cast<size_t>(i) * m_uWidth * m_uDepth * NUM_CHANNELS],
+                .SysMemPitch = m_uWidth * NUM_CHANNELS,
+                .SysMemSlicePitch = 0u
+            };
+        }
+
+        D3D11_TEXTURE2D_DESC textureDesc =
+        {
+            .Width = m_uWidth,
+            .Height = m_uDepth,
+            .MipLevels = 1u,
+            .ArraySize = NUM_AZIMUTHS,
+            .Format = DXGI_FORMAT_R8G8_UNORM,
+            .SampleDesc = {.Count = 1u, .Quality = 0u },
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+            .CPUAccessFlags = 0u,
+            .MiscFlags = 0u
+        };
+        HRESULT hr = pDevice->CreateTexture2D(&textureDesc, aInitData, m_texture.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = pDevice->CreateShaderResourceView(m_texture.Get(), nullptr, m_textureView.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        CBHorizonMap cbHorizonMap =
+        {
+            .GridOrigin = XMFLOAT4(m_gridOrigin.x, m_gridOrigin.y, HeightField::CELL_SIZE, 1.0f),
+            .GridDimensions = XMFLOAT4(
+                static_cast<FLOAT>(m_uWidth),
+                static_cast<FLOAT>(m_uDepth),
+                static_cast<FLOAT>(NUM_AZIMUTHS),
+                static_cast<FLOAT>(MAX_SEARCH_DISTANCE) * HeightField::CELL_SIZE
+            )
+        };
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(CBHorizonMap),
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = 0
+        };
+        D3D11_SUBRESOURCE_DATA initData = { .pSysMem = &cbHorizonMap };
+        hr = pDevice->CreateBuffer(&bd, &initData, m_constantBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::IsBuilt
+
+      Summary:  Returns whether the map has been built
+
+      Returns:  BOOL
+                  TRUE if the horizons are built
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL HorizonMap::IsBuilt() const
+    {
+        return !m_aHorizons.empty();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::GetHorizon
+
+      Summary:  Returns the horizon of a column in an azimuth
+
+      Args:     UINT uX
+                UINT uZ
+                  Column coordinates
+                UINT uAzimuth
+                  Index of the azimuth
+
+      Returns:  FLOAT
+                  Elevation angle of the horizon in radians
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HorizonMap::GetHorizon(_In_ UINT uX, _In_ UINT uZ, _In_ UINT uAzimuth) const
+    {
+        BYTE horizon = m_aHorizons[((static_cast<size_t>(uAzimuth) * m_uDepth + uZ) * m_uWidth + uX) * NUM_CHANNELS];
+
+        return static_cast<FLOAT>(horizon) / 255.0f * XM_PIDIV2;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::GetHorizonDistance
+
+      Summary:  Returns the horizontal distance from a column to the
+                column that makes its horizon in an azimuth
+
+      Args:     UINT uX
+                UINT uZ
+                  Column coordinates
+                UINT uAzimuth
+                  Index of the azimuth
+
+      Returns:  FLOAT
+                  Distance in world units, rounded down
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HorizonMap::GetHorizonDistance(_In_ UINT uX, _In_ UINT uZ, _In_ UINT uAzimuth) const
+    {
+        BYTE distance = m_aHorizons[((static_cast<size_t>(uAzimuth) * m_uDepth + uZ) * m_uWidth + uX) * NUM_CHANNELS + 1u];
+
+        return static_cast<FLOAT>(distance) / 255.0f * static_cast<FLOAT>(MAX_SEARCH_DISTANCE) * HeightField::CELL_SIZE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::GetTextureView
+
+      Summary:  Returns the horizon texture array
+
+      Returns:  ComPtr<ID3D11ShaderResourceView>&
+                  Texture array with a slice per azimuth
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11ShaderResourceView>& HorizonMap::GetTextureView()
+    {
+        return m_textureView;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::GetConstantBuffer
+
+      Summary:  Returns the constant buffer of the grid layout
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Constant buffer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& HorizonMap::GetConstantBuffer()
+    {
+        return m_constantBuffer;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::GetBuildTime
+
+      Summary:  Returns the time the last build took
+
+      Returns:  FLOAT
+                  Build time in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HorizonMap::GetBuildTime() const
+    {
+        return m_buildTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::GetNumThreads
+
+      Summary:  Returns the number of threads of the last build
+
+      Returns:  UINT
+                  Number of threads
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT HorizonMap::GetNumThreads() const
+    {
+        return m_uNumThreads;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::computeColumns
+
+      Summary:  Computes the horizons of a rectangle of columns, one
+                row at a time on each thread
+
+      Args:     UINT uMinX
+                UINT uMinZ
+                UINT uMaxX
+                UINT uMaxZ
+                  Inclusive rectangle of columns
+
+      Modifies: [m_aHorizons].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonMap::computeColumns(_In_ UINT uMinX, _In_ UINT uMinZ, _In_ UINT uMaxX, _In_ UINT uMaxZ)
+    {
+        ParallelFor(uMaxZ - uMinZ + 1u, m_uNumThreads,
+            [&](UINT uRow, UINT)
+            {
+                const UINT z = uMinZ + uRow;
+                for (UINT uAzimuth = 0u; uAzimuth < NUM_AZIMUTHS; ++uAzimuth)
+                {
+                    BYTE* pRow = &m_aHorizons[(static_cast<size_t>(uAzimuth) * m_uDepth + z) * m_uWidth * NUM_CHANNELS];
+                    for (UINT x = uMinX; x <= uMaxX; ++x)
+                    {
+                        pRow[x * NUM_CHANNELS] = computeHorizon(x, z, uAzimuth, pRow[x * NUM_CHANNELS + 1u]);
+                    }
+                }
+            }
+        );
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonMap::computeHorizon
+
+      Summary:  Marches from the top of a column in an azimuth with
+                steps growing with the distance, keeping the steepest
+                slope to the tops on the way. The march stops once even
+                the highest column of the map could not rise above it
+
+      Args:     UINT uX
+                UINT uZ
+                  Column coordinates
+                UINT uAzimuth
+                  Index of the azimuth
+                BYTE& outDistance
+                  Distance to the column of the steepest slope, 255
+                  for MAX_SEARCH_DISTANCE, rounded down. A lower
+                  column on the way may hide a light closer than it,
+                  which this one distance cannot tell
+
+      Returns:  BYTE
+                  Elevation angle of the horizon, 255 for a right
+                  angle, rounded up
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE HorizonMap::computeHorizon(_In_ UINT uX, _In_ UINT uZ, _In_ UINT uAzimuth, _Out_ BYTE& outDistance) const
+    {
+        FLOAT baseHeight = m_aSurfaceHeights[static_cast<size_t>(uZ) * m_uWidth + uX];
+        FLOAT reach = m_maxSurfaceHeight - baseHeight;
+        const XMFLOAT2& direction = m_aDirections[uAzimuth];
+
+        // Sample positions shifted by half a column, so truncation rounds to the nearest
+        FLOAT startX = static_cast<FLOAT>(uX) + 0.5f;
+        FLOAT startZ = static_cast<FLOAT>(uZ) + 0.5f;
+        FLOAT width = static_cast<FLOAT>(m_uWidth);
+        FLOAT depth = static_cast<FLOAT>(m_uDepth);
+
+        FLOAT maxSlope = 0.0f;
+        FLOAT maxSlopeT = 0.0f;
+        for (FLOAT t = 1.0f; t <= static_cast<FLOAT>(MAX_SEARCH_DISTANCE); t += std::max(1.0f, t * STEP_GROWTH))
+        {
+            FLOAT distance = t * HeightField::CELL_SIZE;
+            if (maxSlope * distance >= reach)
+            {
+                break;
+            }
+
+            FLOAT x = startX + direction.x * t;
+            FLOAT z = startZ + direction.y * t;
+            if (x < 0.0f || z < 0.0f || x >= width || z >= depth)
+            {
+                break;
+            }
+
+            FLOAT rise = m_aSurfaceHeights[static_cast<size_t>(z) * m_uWidth + static_cast<size_t>(x)] - baseHeight;
+            if (rise > maxSlope * distance)
+            {
+                maxSlope = rise / distance;
+                maxSlopeT = t;
+            }
+        }
+
+        // Rounded down, so a light at the column is still behind it
+        outDistance = static_cast<BYTE>(std::floor(maxSlopeT / static_cast<FLOAT>(MAX_SEARCH_DISTANCE) * 255.0f));
+
+        return static_cast<BYTE>(std::ceil(std::atan(maxSlope) / XM_PIDIV2 * 255.0f));
+    }
+}
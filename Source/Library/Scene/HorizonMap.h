@@ -0,0 +1,109 @@
+/*+===================================================================
+  File:      HORIZONMAP.H
+
+  Summary:   HorizonMap header file contains declarations of
+             HorizonMap class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: HorizonMap
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+#include "Scene/HeightField.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    HorizonMap
+
+      Summary:  Precomputed shadows of the height map. For every column
+                and NUM_AZIMUTHS directions around it, the elevation
+                angle of the highest column seen from its top and the
+                distance to that column are kept in a texture array, so
+                the voxel pixel shader lights a pixel only when the
+                light is above the horizon in its direction or closer
+                than the column that makes it. Only the steepest column
+                is kept, so a light closer than it is taken as visible
+                even when a nearer, lower column hides it. The voxels
+                still cast into the shadow map for the models and
+                renderables
+
+      Methods:  Build
+                  Computes the horizon of every column on worker
+                  threads
+                Initialize
+                  Creates the texture array and the constant buffer
+                IsBuilt
+                  Returns whether the map has been built
+                GetHorizon
+                  Returns the horizon angle of a column
+                GetHorizonDistance
+                  Returns the distance to the column making the
+                  horizon
+                GetTextureView
+                  Returns the horizon texture array
+                GetConstantBuffer
+                  Returns the constant buffer of the grid layout
+                GetBuildTime
+                  Returns the time the last build took
+                GetNumThreads
+                  Returns the number of threads of the last build
+                HorizonMap
+                  Constructor.
+                ~HorizonMap
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class HorizonMap
+    {
+    public:
+        static constexpr const UINT NUM_AZIMUTHS = 16u;
+        static constexpr const UINT MAX_SEARCH_DISTANCE = 64u;
+        static constexpr const UINT NUM_CHANNELS = 2u;
+
+    public:
+        HorizonMap();
+        HorizonMap(const HorizonMap& other) = delete;
+        HorizonMap(HorizonMap&& other) = delete;
+        HorizonMap& operator=(const HorizonMap& other) = delete;
+        HorizonMap& operator=(HorizonMap&& other) = delete;
+        ~HorizonMap() = default;
+
+        HRESULT Build(_In_ const HeightField& heightField, _In_opt_ UINT uNumThreads = 0u);
+        HRESULT Initialize(_In_ ID3D11Device* pDevice);
+
+        BOOL IsBuilt() const;
+        FLOAT GetHorizon(_In_ UINT uX, _In_ UINT uZ, _In_ UINT uAzimuth) const;
+        FLOAT GetHorizonDistance(_In_ UINT uX, _In_ UINT uZ, _In_ UINT uAzimuth) const;
+
+        ComPtr<ID3D11ShaderResourceView>& GetTextureView();
+        ComPtr<ID3D11Buffer>& GetConstantBuffer();
+
+        FLOAT GetBuildTime() const;
+        UINT GetNumThreads() const;
+
+    private:
+        void computeColumns(_In_ UINT uMinX, _In_ UINT uMinZ, _In_ UINT uMaxX, _In_ UINT uMaxZ);
+        BYTE computeHorizon(_In_ UINT uX, _In_ UINT uZ, _In_ UINT uAzimuth, _Out_ BYTE& outDistance) const;
+
+    private:
+        UINT m_uWidth;
+        UINT m_uDepth;
+        XMFLOAT2 m_gridOrigin;
+        FLOAT m_maxSurfaceHeight;
+        std::vector<FLOAT> m_aSurfaceHeights;
+        XMFLOAT2 m_aDirections[NUM_AZIMUTHS];
+        std::vector<BYTE> m_aHorizons;
+
+        ComPtr<ID3D11Texture2D> m_texture;
+        ComPtr<ID3D11ShaderResourceView> m_textureView;
+        ComPtr<ID3D11Buffer> m_constantBuffer;
+
+        FLOAT m_buildTime;
+        UINT m_uNumThreads;
+    };
+}
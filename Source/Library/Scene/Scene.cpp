@@ -1,4 +1,8 @@
 #include "Scene/Scene.h"
+#include "ParallelFor.h"
+#include "Statistics.h"
+
+#include <algorithm>
 
 namespace library
 {
@@ -29,11 +33,18 @@ namespace library
         , m_voxels()
         , m_renderables()
         , m_models()
+        , m_crowds()
         , m_aPointLights{ nullptr }
         , m_vertexShaders()
         , m_pixelShaders()
         , m_materials()
         , m_skyBox()
+        , m_heightField()
+        , m_terrain()
+        , m_voxelPvs()
+        , m_horizonCuller()
+        , m_animationScheduler()
+        , m_horizonMap()
     {
         std::ifstream inputFile;
         inputFile.open(m_filePath.string());
@@ -60,6 +71,10 @@ namespace library
             }
         }
 
+        m_heightField = HeightField(aDimension[0], aDimension[1], aDimension[2]);
+
+        std::vector<XMFLOAT4> aColors;
+        aColors.reserve(aDimension[3]);
         UINT uColorIdx = 0u;
         XMFLOAT4 color;
         while (!inputFile.eof() && uColorIdx < aDimension[3])
@@ -79,10 +94,13 @@ namespace library
             {
                 color.w = 1.0f;
                 m_voxels.push_back(std::make_shared<Voxel>(color));
+                aColors.push_back(color);
                 ++uColorIdx;
             }
         }
 
+        m_heightField.SetColors(std::move(aColors));
+
         std::vector<std::vector<InstanceData>> aInstanceData;
         aInstanceData.reserve(m_voxels.size());
         for (UINT renderableIdx = 0u; renderableIdx < m_voxels.size(); ++renderableIdx)
@@ -112,7 +130,13 @@ namespace library
             }
             else if (static_cast<CHAR>(eBlockType::GRASSLAND) <= voxelType && voxelType < static_cast<CHAR>(eBlockType::COUNT))
             {
-                for (UINT heightIdx = 0; heightIdx < static_cast<UINT>(static_cast<float>(aDimension[1]) * height); ++heightIdx)
+                UINT uNumBlocks = static_cast<UINT>(static_cast<float>(aDimension[1]) * height);
+                if (!m_heightField.IsEmpty())
+                {
+                    m_heightField.SetColumn(uWidthIdx, uDepthIdx, static_cast<eBlockType>(voxelType), uNumBlocks);
+                }
+
+                for (UINT heightIdx = 0; heightIdx < uNumBlocks; ++heightIdx)
                 {
                     aInstanceData[static_cast<size_t>(voxelType) - static_cast<size_t>(eBlockType::GRASSLAND)].push_back(
                         InstanceData
@@ -152,6 +176,10 @@ namespace library
             else
             {
                 (*it)->SetInstanceData(std::move(aInstanceData[uVoxelIdx]));
+                if (!m_heightField.IsEmpty())
+                {
+                    (*it)->SetGridOrigin(m_heightField.GetCellPosition(0u, 0u, 0u));
+                }
                 ++it;
             }
             ++uVoxelIdx;
@@ -162,7 +190,9 @@ namespace library
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Scene::Initialize
       Summary:  Initializes the voxels, shaders, renderables, models,
-                and skybox
+                crowds, and skybox. The models are loaded on worker
+                threads first, so only their GPU resources are created
+                here
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
@@ -179,6 +209,64 @@ namespace library
             }
         }
 
+        if (!m_heightField.IsEmpty() && !m_voxels.empty())
+        {
+            HRESULT hr = m_voxelPvs.Build(m_heightField);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            if (Statistics::IsLogging())
+            {
+                CHAR szDebugMessage[256];
+                sprintf_s(
+                    szDebugMessage,
+                    "Scene: PVS of %u chunks built in %.2f ms on %u threads, %.1f%% of the chunks visible on average\n",
+                    m_voxelPvs.GetNumChunks(),
+                    m_voxelPvs.GetBuildTime(),
+                    m_voxelPvs.GetNumThreads(),
+                    m_voxelPvs.GetAverageVisibleFraction() * 100.0f
+                );
+                OutputDebugStringA(szDebugMessage);
+            }
+
+            // The voxels are shadowed by their horizons, the shadow map only shadows the models
+            hr = m_horizonMap.Build(m_heightField);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            hr = m_horizonMap.Initialize(pDevice);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            if (Statistics::IsLogging())
+            {
+                CHAR szDebugMessage[256];
+                sprintf_s(
+                    szDebugMessage,
+                    "Scene: horizon map of %u azimuths built in %.2f ms on %u threads\n",
+                    HorizonMap::NUM_AZIMUTHS,
+                    m_horizonMap.GetBuildTime(),
+                    m_horizonMap.GetNumThreads()
+                );
+                OutputDebugStringA(szDebugMessage);
+            }
+        }
+
+        if (!m_heightField.IsEmpty())
+        {
+            HRESULT hr = m_horizonCuller.Build(m_heightField);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
         for (auto it = m_vertexShaders.begin(); it != m_vertexShaders.end(); ++it)
         {
             HRESULT hr = it->second->Initialize(pDevice);
@@ -206,6 +294,15 @@ namespace library
             }
         }
 
+        if (!m_models.empty() || !m_crowds.empty() || m_skyBox != nullptr)
+        {
+            HRESULT hr = loadModels();
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
         for (auto it = m_models.begin(); it != m_models.end(); ++it)
         {
             HRESULT hr = it->second->Initialize(pDevice, pImmediateContext);
@@ -220,6 +317,21 @@ namespace library
             }
         }
 
+        // Crowds bake the clips of their models, so they come after the models
+        for (auto it = m_crowds.begin(); it != m_crowds.end(); ++it)
+        {
+            HRESULT hr = it->second->Initialize(pDevice, pImmediateContext);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            for (UINT i = 0u; i < it->second->GetNumMaterials(); ++i)
+            {
+                AddMaterial(it->second->GetMaterial(i));
+            }
+        }
+
         for (auto it = m_materials.begin(); it != m_materials.end(); ++it)
         {
             HRESULT hr = it->second->Initialize(pDevice, pImmediateContext);
@@ -238,6 +350,15 @@ namespace library
             }
         }
 
+        if (m_terrain != nullptr)
+        {
+            HRESULT hr = m_terrain->Initialize(pDevice, pImmediateContext);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
         return S_OK;
     }
     
@@ -298,6 +419,31 @@ namespace library
     }
 
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::AddCrowd
+      Summary:  Add a skinned crowd, drawn with one instanced draw per
+                mesh of its model
+      Args:     PCWSTR pszCrowdName
+                  Key of the crowd
+                const std::shared_ptr<SkinnedCrowd>& crowd
+                  Crowd to add
+      Modifies: [m_crowds].
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::AddCrowd(_In_ PCWSTR pszCrowdName, _In_ const std::shared_ptr<SkinnedCrowd>& crowd)
+    {
+        if (crowd == nullptr || m_crowds.contains(pszCrowdName))
+        {
+            return E_FAIL;
+        }
+
+        m_crowds[pszCrowdName] = crowd;
+
+        return S_OK;
+    }
+
+
     HRESULT Scene::AddPointLight(_In_ size_t index, _In_ const std::shared_ptr<PointLight>& pPointLight)
     {
         HRESULT hr = S_OK;
@@ -396,6 +542,28 @@ namespace library
     }
 
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::AddTerrain
+      Summary:  Add the continuous terrain of the height map
+      Args:     const std::shared_ptr<Terrain>&
+                  Terrain to use
+      Modifies: [m_terrain].
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::AddTerrain(_In_ const std::shared_ptr<Terrain>& terrain)
+    {
+        if (terrain == nullptr)
+        {
+            return E_INVALIDARG;
+        }
+
+        m_terrain = terrain;
+
+        return S_OK;
+    }
+
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
      Method:   Scene::Update
      Summary:  Update the renderables, models, point lights, skybox
@@ -413,7 +581,10 @@ namespace library
             it->second->Update(deltaTime);
         }
 
-        for (auto it = m_models.begin(); it != m_models.end(); ++it)
+        // Distant models are evaluated less often, within the budget of the scheduler
+        m_animationScheduler.Update(m_models, deltaTime);
+
+        for (auto it = m_crowds.begin(); it != m_crowds.end(); ++it)
         {
             it->second->Update(deltaTime);
         }
@@ -424,6 +595,11 @@ namespace library
         }
 
         m_skyBox->Update(deltaTime);
+
+        if (m_terrain != nullptr)
+        {
+            m_terrain->Update(deltaTime);
+        }
     }
 
 
@@ -445,6 +621,18 @@ namespace library
     }
 
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetCrowds
+      Summary:  Returns the skinned crowds
+      Returns:  std::unordered_map<std::wstring, std::shared_ptr<SkinnedCrowd>>&
+                  Crowds by name
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::unordered_map<std::wstring, std::shared_ptr<SkinnedCrowd>>& Scene::GetCrowds()
+    {
+        return m_crowds;
+    }
+
+
     std::shared_ptr<PointLight>& Scene::GetPointLight(_In_ size_t index)
     {
         assert(index < NUM_LIGHTS);
@@ -483,6 +671,90 @@ namespace library
     }
 
 
+    std::shared_ptr<Terrain>& Scene::GetTerrain()
+    {
+        return m_terrain;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetHeightField
+      Summary:  Returns the columns parsed from the height map
+      Returns:  const HeightField&
+                  Height field of the scene
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const HeightField& Scene::GetHeightField() const
+    {
+        return m_heightField;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetNumVoxelTriangles
+      Summary:  Returns the number of triangles the voxel instances draw
+      Returns:  UINT
+                  Number of triangles
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Scene::GetNumVoxelTriangles() const
+    {
+        UINT uNumTriangles = 0u;
+        for (const std::shared_ptr<Voxel>& voxel : m_voxels)
+        {
+            uNumTriangles += voxel->GetNumInstances() * voxel->GetNumIndices() / 3u;
+        }
+
+        return uNumTriangles;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetVoxelPvs
+      Summary:  Returns the potentially visible set of the voxel chunks
+      Returns:  const VoxelPvs&
+                  Potentially visible set, empty until initialized
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const VoxelPvs& Scene::GetVoxelPvs() const
+    {
+        return m_voxelPvs;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetHorizonCuller
+      Summary:  Returns the occlusion culler of the height map
+      Returns:  HorizonCuller&
+                  Horizon culler, empty until initialized
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HorizonCuller& Scene::GetHorizonCuller()
+    {
+        return m_horizonCuller;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetAnimationScheduler
+      Summary:  Returns the scheduler of the model animations
+      Returns:  AnimationScheduler&
+                  Animation scheduler of the scene
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AnimationScheduler& Scene::GetAnimationScheduler()
+    {
+        return m_animationScheduler;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetHorizonMap
+      Summary:  Returns the precomputed horizons shadowing the voxels
+      Returns:  HorizonMap&
+                  Horizon map, empty until initialized
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HorizonMap& Scene::GetHorizonMap()
+    {
+        return m_horizonMap;
+    }
+
+
     const std::filesystem::path& Scene::GetFilePath() const
     {
         return m_filePath;
@@ -637,8 +909,113 @@ namespace library
 
         return S_OK;
     }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::SetInstanceOrderOfVoxel
+      Summary:  Sets the order the instances of the voxels are stored
+                and drawn in, before the scene is initialized
+      Args:     eVoxelInstanceOrder instanceOrder
+                  Order of the instances
+      Modifies: [m_voxels].
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::SetInstanceOrderOfVoxel(_In_ eVoxelInstanceOrder instanceOrder)
+    {
+        if (instanceOrder >= eVoxelInstanceOrder::COUNT)
+        {
+            return E_INVALIDARG;
+        }
+
+        for (std::shared_ptr<Voxel>& voxel : m_voxels)
+        {
+            voxel->SetInstanceOrder(instanceOrder);
+        }
+
+        return S_OK;
+    }
     
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::loadModels
+      Summary:  Loads the models, the models of the crowds and the
+                skybox on the CPU, one model per job taken by the
+                threads. Each load imports with its own importer, so
+                the time is that of the largest model rather than the
+                sum of all of them
+      Returns:  HRESULT
+                  Status code of the first model that failed
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::loadModels()
+    {
+        std::vector<Model*> aModels;
+        std::unordered_set<Model*> loadedModels;
+        auto addModel = [&](Model* pModel)
+        {
+            if (pModel != nullptr && loadedModels.insert(pModel).second)
+            {
+                aModels.push_back(pModel);
+            }
+        };
+
+        for (auto it = m_models.begin(); it != m_models.end(); ++it)
+        {
+            addModel(it->second.get());
+        }
+
+        for (auto it = m_crowds.begin(); it != m_crowds.end(); ++it)
+        {
+            addModel(it->second->GetModel().get());
+        }
+
+        addModel(m_skyBox.get());
+
+        if (aModels.empty())
+        {
+            return S_OK;
+        }
+
+        LARGE_INTEGER frequency, startingTime, endingTime;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        const UINT uNumJobs = static_cast<UINT>(aModels.size());
+
+        std::vector<HRESULT> aResults(uNumJobs, S_OK);
+        const UINT uNumThreads = ParallelFor(uNumJobs, 0u,
+            [&](UINT uJob, UINT)
+            {
+                aResults[uJob] = aModels[uJob]->Load();
+            }
+        );
+
+        QueryPerformanceCounter(&endingTime);
+        if (Statistics::IsLogging())
+        {
+            CHAR szDebugMessage[256];
+            sprintf_s(
+                szDebugMessage,
+                "Scene: %u models loaded in %.2f ms on %u threads\n",
+                uNumJobs,
+                static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart),
+                uNumThreads
+            );
+            OutputDebugStringA(szDebugMessage);
+        }
+
+        for (HRESULT hr : aResults)
+        {
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        return S_OK;
+    }
+
+
     FLOAT Scene::getNoise2(UINT x, UINT y)
     {
         UINT temp = ms_aHashes[y % 256u];
@@ -16,10 +16,17 @@
 #include <fstream>
 
 #include "Model/Model.h"
+#include "Model/SkinnedCrowd.h"
 #include "Light/PointLight.h"
 #include "Renderer/Skybox.h"
 #include "Renderer/Renderable.h"
+#include "Scene/AnimationScheduler.h"
+#include "Scene/HeightField.h"
+#include "Scene/HorizonCuller.h"
+#include "Scene/HorizonMap.h"
+#include "Scene/Terrain.h"
 #include "Scene/Voxel.h"
+#include "Scene/VoxelPvs.h"
 
 namespace library
 {
@@ -41,22 +48,32 @@ namespace library
         HRESULT AddVoxel(_In_ const std::shared_ptr<Voxel>& voxel);
         HRESULT AddRenderable(_In_ PCWSTR pszRenderableName, _In_ const std::shared_ptr<Renderable>& renderable);
         HRESULT AddModel(_In_ PCWSTR pszModelName, _In_ const std::shared_ptr<Model>& pModel);
+        HRESULT AddCrowd(_In_ PCWSTR pszCrowdName, _In_ const std::shared_ptr<SkinnedCrowd>& crowd);
         HRESULT AddPointLight(_In_ size_t index, _In_ const std::shared_ptr<PointLight>& pPointLight);
         HRESULT AddVertexShader(_In_ PCWSTR pszVertexShaderName, _In_ const std::shared_ptr<VertexShader>& vertexShader);
         HRESULT AddPixelShader(_In_ PCWSTR pszPixelShaderName, _In_ const std::shared_ptr<PixelShader>& pixelShader);
         HRESULT AddMaterial(_In_ const std::shared_ptr<Material>& material);
         HRESULT AddSkyBox(_In_ const std::shared_ptr<Skybox>& skybox);
+        HRESULT AddTerrain(_In_ const std::shared_ptr<Terrain>& terrain);
 
         void Update(_In_ FLOAT deltaTime);
 
         std::vector<std::shared_ptr<Voxel>>& GetVoxels();
         std::unordered_map<std::wstring, std::shared_ptr<Renderable>>& GetRenderables();
         std::unordered_map<std::wstring, std::shared_ptr<Model>>& GetModels();
+        std::unordered_map<std::wstring, std::shared_ptr<SkinnedCrowd>>& GetCrowds();
         std::shared_ptr<PointLight>& GetPointLight(_In_ size_t index);
         std::unordered_map<std::wstring, std::shared_ptr<VertexShader>>& GetVertexShaders();
         std::unordered_map<std::wstring, std::shared_ptr<PixelShader>>& GetPixelShaders();
         std::unordered_map<std::wstring, std::shared_ptr<Material>>& GetMaterials(); 
         std::shared_ptr<Skybox>& GetSkyBox();
+        std::shared_ptr<Terrain>& GetTerrain();
+        const HeightField& GetHeightField() const;
+        UINT GetNumVoxelTriangles() const;
+        const VoxelPvs& GetVoxelPvs() const;
+        HorizonCuller& GetHorizonCuller();
+        AnimationScheduler& GetAnimationScheduler();
+        HorizonMap& GetHorizonMap();
 
         const std::filesystem::path& GetFilePath() const;
         PCWSTR GetFileName() const;
@@ -71,9 +88,12 @@ namespace library
         HRESULT SetPixelShaderOfVoxel(_In_ PCWSTR pszPixelShaderName);
 
         HRESULT SetMaterialOfVoxel(_In_ PCWSTR pszMaterialName);
+        HRESULT SetInstanceOrderOfVoxel(_In_ eVoxelInstanceOrder instanceOrder);
 
 
     private:
+        HRESULT loadModels();
+
         static FLOAT getNoise2(UINT x, UINT y);
         static FLOAT getNoise2d(FLOAT x, FLOAT y);
         static FLOAT lerp(FLOAT x, FLOAT y, FLOAT s);
@@ -101,10 +121,17 @@ namespace library
         std::vector<std::shared_ptr<Voxel>> m_voxels;
         std::unordered_map<std::wstring, std::shared_ptr<Renderable>> m_renderables;
         std::unordered_map<std::wstring, std::shared_ptr<Model>> m_models;
+        std::unordered_map<std::wstring, std::shared_ptr<SkinnedCrowd>> m_crowds;
         std::shared_ptr<PointLight> m_aPointLights[NUM_LIGHTS];
         std::unordered_map<std::wstring, std::shared_ptr<VertexShader>> m_vertexShaders;
         std::unordered_map<std::wstring, std::shared_ptr<PixelShader>> m_pixelShaders;
         std::unordered_map<std::wstring, std::shared_ptr<Material>> m_materials;
         std::shared_ptr<Skybox> m_skyBox;
+        HeightField m_heightField;
+        std::shared_ptr<Terrain> m_terrain;
+        VoxelPvs m_voxelPvs;
+        HorizonCuller m_horizonCuller;
+        AnimationScheduler m_animationScheduler;
+        HorizonMap m_horizonMap;
     };
 }
\ No newline at end of file
@@ -0,0 +1,558 @@
+#include "Scene/Terrain.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::Terrain
+
+      Summary:  Constructor. Builds the grid patch: the vertices span
+                [0, 1] in x and z, and the indices are laid out per
+                quadrant so that every quadrant is a contiguous range
+
+      Args:     const HeightField& heightField
+                  Column heights and biome colors of the map
+
+      Modifies: [m_heightField, m_quadTree, m_instanceBuffer,
+                 m_terrainConstantBuffer, m_heightTexture,
+                 m_heightTextureView, m_colorTexture,
+                 m_colorTextureView, m_aVertices, m_aIndices,
+                 m_aSelection, m_aQuadrantStarts, m_aQuadrantCounts,
+                 m_uMaxInstances, m_uNumTriangles].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Terrain::Terrain(_In_ const HeightField& heightField)
+        : Renderable(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f))
+        , m_heightField(heightField)
+        , m_quadTree()
+        , m_instanceBuffer(nullptr)
+        , m_terrainConstantBuffer(nullptr)
+        , m_heightTexture(nullptr)
+        , m_heightTextureView(nullptr)
+        , m_colorTexture(nullptr)
+        , m_colorTextureView(nullptr)
+        , m_aVertices()
+        , m_aIndices()
+        , m_aSelection()
+        , m_aQuadrantStarts{ 0u, }
+        , m_aQuadrantCounts{ 0u, }
+        , m_uMaxInstances(0u)
+        , m_uNumTriangles(0u)
+    {
+        constexpr const UINT RESOLUTION = TerrainQuadTree::PATCH_RESOLUTION;
+        constexpr const UINT HALF_RESOLUTION = RESOLUTION / 2u;
+
+        m_aVertices.reserve((RESOLUTION + 1u) * (RESOLUTION + 1u));
+        for (UINT z = 0u; z <= RESOLUTION; ++z)
+        {
+            for (UINT x = 0u; x <= RESOLUTION; ++x)
+            {
+                FLOAT u = static_cast<FLOAT>(x) / static_cast<FLOAT>(RESOLUTION);
+                FLOAT v = static_cast<FLOAT>(z) / static_cast<FLOAT>(RESOLUTION);
+                m_aVertices.push_back(
+                    SimpleVertex
+                    {
+                        .Position = XMFLOAT3(u, 0.0f, v),
+                        .TexCoord = XMFLOAT2(u, v),
+                        .Normal = XMFLOAT3(0.0f, 1.0f, 0.0f)
+                    }
+                );
+            }
+        }
+
+        m_aIndices.reserve(RESOLUTION * RESOLUTION * 6u);
+        for (UINT uQuadrant = 0u; uQuadrant < 4u; ++uQuadrant)
+        {
+            UINT uStartX = (uQuadrant & 1u) * HALF_RESOLUTION;
+            UINT uStartZ = (uQuadrant >> 1u) * HALF_RESOLUTION;
+
+            for (UINT z = uStartZ; z < uStartZ + HALF_RESOLUTION; ++z)
+            {
+                for (UINT x = uStartX; x < uStartX + HALF_RESOLUTION; ++x)
+                {
+                    WORD v00 = static_cast<WORD>(z * (RESOLUTION + 1u) + x);
+                    WORD v10 = static_cast<WORD>(v00 + 1u);
+                    WORD v01 = static_cast<WORD>(v00 + RESOLUTION + 1u);
+                    WORD v11 = static_cast<WORD>(v01 + 1u);
+
+                    m_aIndices.push_back(v01);
+                    m_aIndices.push_back(v10);
+                    m_aIndices.push_back(v00);
+
+                    m_aIndices.push_back(v11);
+                    m_aIndices.push_back(v10);
+                    m_aIndices.push_back(v01);
+                }
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::Initialize
+
+      Summary:  Builds the quadtree and creates the buffers and the
+                textures. The LOD ranges are set by the renderer with
+                SetScreenSpaceError, which knows the viewport
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffers
+                ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to set buffers
+
+      Modifies: [m_quadTree, m_instanceBuffer, m_terrainConstantBuffer,
+                 m_uMaxInstances].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Terrain::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+    {
+        HRESULT hr = m_quadTree.Build(m_heightField);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = initialize(pDevice, pImmediateContext);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        // Every node can at most be drawn as its four quadrants
+        m_uMaxInstances = m_quadTree.GetNumNodes() * 4u;
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = static_cast<UINT>(sizeof(TerrainInstanceData)) * m_uMaxInstances,
+            .Usage = D3D11_USAGE_DYNAMIC,
+            .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+            .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE
+        };
+        hr = pDevice->CreateBuffer(&bd, nullptr, m_instanceBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        CBTerrain cbTerrain =
+        {
+            .GridOrigin = XMFLOAT4(
+                m_heightField.GetWorldX(0.0f),
+                m_heightField.GetWorldZ(0.0f),
+                HeightField::CELL_SIZE,
+                static_cast<FLOAT>(TerrainQuadTree::PATCH_RESOLUTION)
+            ),
+            .GridDimensions = XMFLOAT4(
+                static_cast<FLOAT>(m_heightField.GetWidth()),
+                static_cast<FLOAT>(m_heightField.GetDepth()),
+                1.0f / static_cast<FLOAT>(m_heightField.GetWidth()),
+                1.0f / static_cast<FLOAT>(m_heightField.GetDepth())
+            )
+        };
+        bd =
+        {
+            .ByteWidth = sizeof(CBTerrain),
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = 0
+        };
+        D3D11_SUBRESOURCE_DATA initData = { .pSysMem = &cbTerrain };
+        hr = pDevice->CreateBuffer(&bd, &initData, m_terrainConstantBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = initializeTextures(pDevice);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::Update
+
+      Summary:  Updates the terrain every frame
+
+      Args:     FLOAT deltaTime
+                  Elapsed time
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Terrain::Update(_In_ FLOAT deltaTime)
+    {
+        UNREFERENCED_PARAMETER(deltaTime);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::SetScreenSpaceError
+
+      Summary:  Computes the LOD ranges for the projection
+
+      Args:     FLOAT fovAngleY
+                  Vertical field of view of the projection in radians
+                FLOAT viewportHeight
+                  Height of the viewport in pixels
+                FLOAT pixelError
+                  Allowed height error on screen in pixels
+
+      Modifies: [m_quadTree].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Terrain::SetScreenSpaceError(_In_ FLOAT fovAngleY, _In_ FLOAT viewportHeight, _In_ FLOAT pixelError)
+    {
+        m_quadTree.SetScreenSpaceError(fovAngleY, viewportHeight, pixelError);
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::SelectNodes
+
+      Summary:  Selects the node quadrants for the camera and writes
+                their instance data grouped by quadrant, so every
+                quadrant index range is drawn with one instanced call
+
+      Args:     ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to map the instance buffer
+                const XMVECTOR& eye
+                  Position of the camera
+                const XMMATRIX& viewProjection
+                  View matrix times projection matrix
+
+      Modifies: [m_aSelection, m_aQuadrantStarts, m_aQuadrantCounts,
+                 m_uNumTriangles].
+
+      Returns:  UINT
+                  Number of selected quadrants
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Terrain::SelectNodes(_In_ ID3D11DeviceContext* pImmediateContext, _In_ const XMVECTOR& eye, _In_ const XMMATRIX& viewProjection)
+    {
+        XMFLOAT3 eyePosition;
+        XMStoreFloat3(&eyePosition, eye);
+
+        m_aSelection.clear();
+        m_quadTree.Select(eyePosition, viewProjection, m_aSelection);
+
+        ZeroMemory(m_aQuadrantCounts, sizeof(m_aQuadrantCounts));
+        for (const TerrainQuadTree::SelectedNode& selected : m_aSelection)
+        {
+            ++m_aQuadrantCounts[selected.uQuadrant];
+        }
+
+        UINT uNumInstances = 0u;
+        for (UINT uQuadrant = 0u; uQuadrant < 4u; ++uQuadrant)
+        {
+            m_aQuadrantStarts[uQuadrant] = uNumInstances;
+            uNumInstances += m_aQuadrantCounts[uQuadrant];
+        }
+        assert(uNumInstances <= m_uMaxInstances);
+
+        D3D11_MAPPED_SUBRESOURCE mappedResource = {};
+        if (FAILED(pImmediateContext->Map(m_instanceBuffer.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mappedResource)))
+        {
+            ZeroMemory(m_aQuadrantCounts, sizeof(m_aQuadrantCounts));
+            return 0u;
+        }
+
+        TerrainInstanceData* aInstances = reinterpret_cast<TerrainInstanceData*>(mappedResource.pData);
+        UINT aWriteOffsets[4] = { m_aQuadrantStarts[0], m_aQuadrantStarts[1], m_aQuadrantStarts[2], m_aQuadrantStarts[3] };
+        for (const TerrainQuadTree::SelectedNode& selected : m_aSelection)
+        {
+            const TerrainQuadTree::Node& node = m_quadTree.GetNode(selected.uNodeIndex);
+            FLOAT lodRange = m_quadTree.GetLodRange(node.uLevel);
+            FLOAT morphStart = m_quadTree.GetMorphStart(node.uLevel);
+
+            aInstances[aWriteOffsets[selected.uQuadrant]++] = TerrainInstanceData
+            {
+                .OffsetScale = XMFLOAT4(
+                    node.BoundsMin.x,
+                    node.BoundsMin.z,
+                    HeightField::CELL_SIZE * static_cast<FLOAT>(node.uSize),
+                    static_cast<FLOAT>(node.uLevel)
+                ),
+                .MorphConstants = XMFLOAT4(
+                    morphStart,
+                    lodRange < FLT_MAX ? 1.0f / (lodRange - morphStart) : 0.0f,
+                    0.0f,
+                    0.0f
+                )
+            };
+        }
+
+        pImmediateContext->Unmap(m_instanceBuffer.Get(), 0u);
+
+        m_uNumTriangles = uNumInstances * GetNumIndicesPerQuadrant() / 3u;
+
+        return uNumInstances;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::CheckSelection
+
+      Summary:  Selects the node quadrants for an eye with a view from
+                above that holds the whole map, and checks that they
+                cover every column of the map exactly once, so there
+                are neither holes nor a node drawn with its children
+
+      Args:     const XMVECTOR& eye
+                  Position the LOD ranges are measured from
+                UINT& uOutNumTriangles
+                  Number of triangles of the selection
+
+      Returns:  BOOL
+                  TRUE if every column is covered once
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Terrain::CheckSelection(_In_ const XMVECTOR& eye, _Out_ UINT& uOutNumTriangles) const
+    {
+        uOutNumTriangles = 0u;
+        if (m_quadTree.GetNumNodes() == 0u)
+        {
+            return FALSE;
+        }
+
+        // The root is built first, an orthographic view of its bounds culls nothing
+        const TerrainQuadTree::Node& root = m_quadTree.GetNode(0u);
+        XMVECTOR center = XMVectorSet(
+            (root.BoundsMin.x + root.BoundsMax.x) * 0.5f,
+            root.BoundsMax.y + 1.0f,
+            (root.BoundsMin.z + root.BoundsMax.z) * 0.5f,
+            1.0f
+        );
+        XMMATRIX view = XMMatrixLookToLH(center, XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+        XMMATRIX projection = XMMatrixOrthographicLH(
+            root.BoundsMax.x - root.BoundsMin.x + 2.0f * HeightField::CELL_SIZE,
+            root.BoundsMax.z - root.BoundsMin.z + 2.0f * HeightField::CELL_SIZE,
+            0.0f,
+            root.BoundsMax.y - root.BoundsMin.y + 2.0f
+        );
+
+        XMFLOAT3 eyePosition;
+        XMStoreFloat3(&eyePosition, eye);
+
+        std::vector<TerrainQuadTree::SelectedNode> aSelection;
+        m_quadTree.Select(eyePosition, view * projection, aSelection);
+        uOutNumTriangles = static_cast<UINT>(aSelection.size()) * GetNumIndicesPerQuadrant() / 3u;
+
+        UINT uWidth = m_heightField.GetWidth();
+        UINT uDepth = m_heightField.GetDepth();
+        std::vector<BYTE> aCoverage(static_cast<size_t>(uWidth) * uDepth, 0u);
+        for (const TerrainQuadTree::SelectedNode& selected : aSelection)
+        {
+            const TerrainQuadTree::Node& node = m_quadTree.GetNode(selected.uNodeIndex);
+            UINT uHalfSize = std::max(node.uSize / 2u, 1u);
+            UINT uStartX = node.uX + (selected.uQuadrant & 1u) * uHalfSize;
+            UINT uStartZ = node.uZ + (selected.uQuadrant >> 1u) * uHalfSize;
+            for (UINT z = uStartZ; z < std::min(uStartZ + uHalfSize, uDepth); ++z)
+            {
+                for (UINT x = uStartX; x < std::min(uStartX + uHalfSize, uWidth); ++x)
+                {
+                    if (aCoverage[static_cast<size_t>(z) * uWidth + x]++ != 0u)
+                    {
+                        return FALSE;
+                    }
+                }
+            }
+        }
+
+        return std::find(aCoverage.begin(), aCoverage.end(), static_cast<BYTE>(0u)) == aCoverage.end();
+    }
+
+
+    ComPtr<ID3D11Buffer>& Terrain::GetInstanceBuffer()
+    {
+        return m_instanceBuffer;
+    }
+
+
+    ComPtr<ID3D11Buffer>& Terrain::GetTerrainConstantBuffer()
+    {
+        return m_terrainConstantBuffer;
+    }
+
+
+    ComPtr<ID3D11ShaderResourceView>& Terrain::GetHeightTextureView()
+    {
+        return m_heightTextureView;
+    }
+
+
+    ComPtr<ID3D11ShaderResourceView>& Terrain::GetColorTextureView()
+    {
+        return m_colorTextureView;
+    }
+
+
+    UINT Terrain::GetQuadrantInstanceStart(_In_ UINT uQuadrant) const
+    {
+        assert(uQuadrant < 4u);
+
+        return m_aQuadrantStarts[uQuadrant];
+    }
+
+
+    UINT Terrain::GetNumQuadrantInstances(_In_ UINT uQuadrant) const
+    {
+        assert(uQuadrant < 4u);
+
+        return m_aQuadrantCounts[uQuadrant];
+    }
+
+
+    UINT Terrain::GetNumIndicesPerQuadrant() const
+    {
+        return GetNumIndices() / 4u;
+    }
+
+
+    const TerrainQuadTree& Terrain::GetQuadTree() const
+    {
+        return m_quadTree;
+    }
+
+
+    UINT Terrain::GetNumSelectedPatches() const
+    {
+        return m_aQuadrantCounts[0] + m_aQuadrantCounts[1] + m_aQuadrantCounts[2] + m_aQuadrantCounts[3];
+    }
+
+
+    UINT Terrain::GetNumTriangles() const
+    {
+        return m_uNumTriangles;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::GetNumFullDetailTriangles
+
+      Summary:  Returns the number of triangles of a grid with one
+                vertex per column, the finest level of the terrain
+
+      Returns:  UINT
+                  Number of triangles
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Terrain::GetNumFullDetailTriangles() const
+    {
+        if (m_heightField.IsEmpty())
+        {
+            return 0u;
+        }
+
+        return (m_heightField.GetWidth() - 1u) * (m_heightField.GetDepth() - 1u) * 2u;
+    }
+
+
+    UINT Terrain::GetNumVertices() const
+    {
+        return static_cast<UINT>(m_aVertices.size());
+    }
+
+
+    UINT Terrain::GetNumIndices() const
+    {
+        return static_cast<UINT>(m_aIndices.size());
+    }
+
+
+    const SimpleVertex* Terrain::getVertices() const
+    {
+        return m_aVertices.data();
+    }
+
+
+    const WORD* Terrain::getIndices() const
+    {
+        return m_aIndices.data();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Terrain::initializeTextures
+
+      Summary:  Creates the column height texture and the biome color
+                texture the vertex shader samples
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the textures
+
+      Modifies: [m_heightTexture, m_heightTextureView, m_colorTexture,
+                 m_colorTextureView].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Terrain::initializeTextures(_In_ ID3D11Device* pDevice)
+    {
+        UINT uWidth = m_heightField.GetWidth();
+        UINT uDepth = m_heightField.GetDepth();
+
+        std::vector<FLOAT> aHeights;
+        std::vector<UINT> aColors;
+        aHeights.reserve(static_cast<size_t>(uWidth) * uDepth);
+        aColors.reserve(static_cast<size_t>(uWidth) * uDepth);
+        for (UINT z = 0u; z < uDepth; ++z)
+        {
+            for (UINT x = 0u; x < uWidth; ++x)
+            {
+                aHeights.push_back(m_heightField.GetSurfaceHeight(x, z));
+
+                XMFLOAT4 color = m_heightField.GetColor(x, z);
+                aColors.push_back(
+                    static_cast<UINT>(color.x * 255.0f + 0.5f)
+                    | (static_cast<UINT>(color.y * 255.0f + 0.5f) << 8u)
+                    | (static_cast<UINT>(color.z * 255.0f + 0.5f) << 16u)
+                    | (static_cast<UINT>(color.w * 255.0f + 0.5f) << 24u)
+                );
+            }
+        }
+
+        D3D11_TEXTURE2D_DESC textureDesc =
+        {
+            .Width = uWidth,
+            .Height = uDepth,
+            .MipLevels = 1u,
+            .ArraySize = 1u,
+            .Format = DXGI_FORMAT_R32_FLOAT,
+            .SampleDesc = {.Count = 1u, .Quality = 0u },
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+            .CPUAccessFlags = 0u,
+            .MiscFlags = 0u
+        };
+        D3D11_SUBRESOURCE_DATA initData =
+        {
+            .pSysMem = aHeights.data(),
+            .SysMemPitch = static_cast<UINT>(sizeof(FLOAT)) * uWidth
+        };
+        HRESULT hr = pDevice->CreateTexture2D(&textureDesc, &initData, m_heightTexture.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = pDevice->CreateShaderResourceView(m_heightTexture.Get(), nullptr, m_heightTextureView.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        initData.pSysMem = aColors.data();
+        initData.SysMemPitch = static_cast<UINT>(sizeof(UINT)) * uWidth;
+        hr = pDevice->CreateTexture2D(&textureDesc, &initData, m_colorTexture.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = pDevice->CreateShaderResourceView(m_colorTexture.Get(), nullptr, m_colorTextureView.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        return S_OK;
+    }
+}
@@ -0,0 +1,141 @@
+/*+===================================================================
+  File:      TERRAIN.H
+
+  Summary:   Terrain header file contains declarations of Terrain
+             class used for the lab samples of Game Graphics
+             Programming course.
+
+  Classes: Terrain
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+#include "Renderer/Renderable.h"
+#include "Scene/HeightField.h"
+#include "Scene/TerrainQuadTree.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    Terrain
+
+      Summary:  Continuous surface of the height map. A single grid
+                patch is drawn instanced once per selected quadtree
+                node quadrant, the heights and biome colors are read
+                from textures in the vertex shader, and the vertices
+                morph into the coarser level near the end of their
+                LOD range
+
+      Methods:  Initialize
+                  Builds the quadtree and creates the patch buffers,
+                  the instance buffer and the height/color textures
+                Update
+                  Updates the terrain each frame
+                SetScreenSpaceError
+                  Computes the LOD ranges for the projection
+                SelectNodes
+                  Selects the nodes for the camera and fills the
+                  instance buffer
+                CheckSelection
+                  Checks that a selection covers every column once
+                GetInstanceBuffer
+                  Returns the per node instance buffer
+                GetTerrainConstantBuffer
+                  Returns the constant buffer of the grid layout
+                GetHeightTextureView
+                  Returns the column height texture
+                GetColorTextureView
+                  Returns the biome color texture
+                GetQuadrantInstanceStart
+                  Returns the first instance of a quadrant
+                GetNumQuadrantInstances
+                  Returns the number of instances of a quadrant
+                GetNumIndicesPerQuadrant
+                  Returns the number of indices of a patch quadrant
+                GetQuadTree
+                  Returns the quadtree
+                GetNumSelectedPatches
+                  Returns the number of quadrants selected last
+                GetNumTriangles
+                  Returns the number of triangles selected last
+                GetNumFullDetailTriangles
+                  Returns the number of triangles of the whole map at
+                  the finest level
+                GetNumVertices
+                  Returns the number of vertices of the patch
+                GetNumIndices
+                  Returns the number of indices of the patch
+                Terrain
+                  Constructor.
+                ~Terrain
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class Terrain : public Renderable
+    {
+    public:
+        static constexpr const FLOAT DEFAULT_PIXEL_ERROR = 2.0f;
+
+    public:
+        Terrain() = delete;
+        Terrain(_In_ const HeightField& heightField);
+        Terrain(const Terrain& other) = delete;
+        Terrain(Terrain&& other) = delete;
+        Terrain& operator=(const Terrain& other) = delete;
+        Terrain& operator=(Terrain&& other) = delete;
+        ~Terrain() = default;
+
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) override;
+        virtual void Update(_In_ FLOAT deltaTime) override;
+
+        void SetScreenSpaceError(_In_ FLOAT fovAngleY, _In_ FLOAT viewportHeight, _In_ FLOAT pixelError);
+        UINT SelectNodes(_In_ ID3D11DeviceContext* pImmediateContext, _In_ const XMVECTOR& eye, _In_ const XMMATRIX& viewProjection);
+        BOOL CheckSelection(_In_ const XMVECTOR& eye, _Out_ UINT& uOutNumTriangles) const;
+
+        ComPtr<ID3D11Buffer>& GetInstanceBuffer();
+        ComPtr<ID3D11Buffer>& GetTerrainConstantBuffer();
+        ComPtr<ID3D11ShaderResourceView>& GetHeightTextureView();
+        ComPtr<ID3D11ShaderResourceView>& GetColorTextureView();
+
+        UINT GetQuadrantInstanceStart(_In_ UINT uQuadrant) const;
+        UINT GetNumQuadrantInstances(_In_ UINT uQuadrant) const;
+        UINT GetNumIndicesPerQuadrant() const;
+
+        const TerrainQuadTree& GetQuadTree() const;
+        UINT GetNumSelectedPatches() const;
+        UINT GetNumTriangles() const;
+        UINT GetNumFullDetailTriangles() const;
+
+        UINT GetNumVertices() const override;
+        UINT GetNumIndices() const override;
+
+    protected:
+        const SimpleVertex* getVertices() const override;
+        const WORD* getIndices() const override;
+
+        HRESULT initializeTextures(_In_ ID3D11Device* pDevice);
+
+    protected:
+        HeightField m_heightField;
+        TerrainQuadTree m_quadTree;
+
+        ComPtr<ID3D11Buffer> m_instanceBuffer;
+        ComPtr<ID3D11Buffer> m_terrainConstantBuffer;
+        ComPtr<ID3D11Texture2D> m_heightTexture;
+        ComPtr<ID3D11ShaderResourceView> m_heightTextureView;
+        ComPtr<ID3D11Texture2D> m_colorTexture;
+        ComPtr<ID3D11ShaderResourceView> m_colorTextureView;
+
+        std::vector<SimpleVertex> m_aVertices;
+        std::vector<WORD> m_aIndices;
+        std::vector<TerrainQuadTree::SelectedNode> m_aSelection;
+
+        UINT m_aQuadrantStarts[4];
+        UINT m_aQuadrantCounts[4];
+        UINT m_uMaxInstances;
+        UINT m_uNumTriangles;
+    };
+}
@@ -0,0 +1,463 @@
+#include "Scene/TerrainQuadTree.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::TerrainQuadTree
+
+      Summary:  Constructor
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    TerrainQuadTree::TerrainQuadTree()
+        : m_aNodes()
+        , m_uRootIndex(INVALID_NODE)
+        , m_uNumLevels(0u)
+        , m_aLevelErrors{ 0.0f, }
+        , m_aLodRanges{ 0.0f, }
+        , m_aMorphStarts{ 0.0f, }
+    { }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::Build
+
+      Summary:  Builds the nodes from the height field. The finest
+                level is 0 and its nodes span PATCH_RESOLUTION columns
+
+      Args:     const HeightField& heightField
+                  Column heights of the map
+
+      Modifies: [m_aNodes, m_uRootIndex, m_uNumLevels,
+                 m_aLevelErrors].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TerrainQuadTree::Build(_In_ const HeightField& heightField)
+    {
+        if (heightField.IsEmpty())
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT uRootSize = PATCH_RESOLUTION;
+        m_uNumLevels = 1u;
+        while (uRootSize < heightField.GetWidth() || uRootSize < heightField.GetDepth())
+        {
+            uRootSize *= 2u;
+            ++m_uNumLevels;
+        }
+
+        if (m_uNumLevels > MAX_NUM_LEVELS)
+        {
+            return E_FAIL;
+        }
+
+        m_aNodes.clear();
+        m_uRootIndex = buildNode(heightField, 0u, 0u, uRootSize, m_uNumLevels - 1u);
+
+        computeLevelErrors(heightField);
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::SetScreenSpaceError
+
+      Summary:  Computes the LOD ranges. A level is used from the
+                distance where the height error of the next finer
+                level spans less than pixelError pixels, and every
+                range is at least twice the previous one so adjacent
+                nodes never differ by more than one level
+
+      Args:     FLOAT fovAngleY
+                  Vertical field of view of the projection in radians
+                FLOAT viewportHeight
+                  Height of the viewport in pixels
+                FLOAT pixelError
+                  Allowed height error on screen in pixels
+
+      Modifies: [m_aLodRanges, m_aMorphStarts].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TerrainQuadTree::SetScreenSpaceError(_In_ FLOAT fovAngleY, _In_ FLOAT viewportHeight, _In_ FLOAT pixelError)
+    {
+        FLOAT errorToDistance = viewportHeight / (2.0f * tanf(fovAngleY * 0.5f) * pixelError);
+        FLOAT leafSize = HeightField::CELL_SIZE * static_cast<FLOAT>(PATCH_RESOLUTION);
+
+        FLOAT previousRange = 0.0f;
+        for (UINT uLevel = 0u; uLevel < m_uNumLevels; ++uLevel)
+        {
+            if (uLevel + 1u == m_uNumLevels)
+            {
+                // The root level covers everything up to the far plane and has no coarser level to morph into
+                m_aLodRanges[uLevel] = FLT_MAX;
+                m_aMorphStarts[uLevel] = FLT_MAX;
+                break;
+            }
+
+            FLOAT range = m_aLevelErrors[uLevel + 1u] * errorToDistance;
+            range = std::max(range, uLevel == 0u ? 2.0f * leafSize : 2.0f * previousRange);
+
+            m_aLodRanges[uLevel] = range;
+            m_aMorphStarts[uLevel] = previousRange + (range - previousRange) * MORPH_START_RATIO;
+            previousRange = range;
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::Select
+
+      Summary:  Selects the node quadrants to draw. A node whose
+                children are only partially in range is drawn by the
+                quadrants its children do not cover
+
+      Args:     const XMFLOAT3& eye
+                  Position of the camera
+                const XMMATRIX& viewProjection
+                  View matrix times projection matrix for culling
+                std::vector<SelectedNode>& aOutSelection
+                  Selected quadrants are appended here
+
+      Returns:  UINT
+                  Number of quadrants appended
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TerrainQuadTree::Select(_In_ const XMFLOAT3& eye, _In_ const XMMATRIX& viewProjection, _Inout_ std::vector<SelectedNode>& aOutSelection) const
+    {
+        if (m_uRootIndex == INVALID_NODE)
+        {
+            return 0u;
+        }
+
+        // Gribb-Hartmann plane extraction for row vectors
+        XMMATRIX columns = XMMatrixTranspose(viewProjection);
+        XMFLOAT4 aFrustumPlanes[6];
+        XMStoreFloat4(&aFrustumPlanes[0], XMVectorAdd(columns.r[3], columns.r[0]));
+        XMStoreFloat4(&aFrustumPlanes[1], XMVectorSubtract(columns.r[3], columns.r[0]));
+        XMStoreFloat4(&aFrustumPlanes[2], XMVectorAdd(columns.r[3], columns.r[1]));
+        XMStoreFloat4(&aFrustumPlanes[3], XMVectorSubtract(columns.r[3], columns.r[1]));
+        XMStoreFloat4(&aFrustumPlanes[4], columns.r[2]);
+        XMStoreFloat4(&aFrustumPlanes[5], XMVectorSubtract(columns.r[3], columns.r[2]));
+
+        size_t uPreviousSize = aOutSelection.size();
+        selectNode(m_uRootIndex, eye, aFrustumPlanes, aOutSelection);
+
+        return static_cast<UINT>(aOutSelection.size() - uPreviousSize);
+    }
+
+
+    const TerrainQuadTree::Node& TerrainQuadTree::GetNode(_In_ UINT uIndex) const
+    {
+        return m_aNodes[uIndex];
+    }
+
+
+    UINT TerrainQuadTree::GetNumNodes() const
+    {
+        return static_cast<UINT>(m_aNodes.size());
+    }
+
+
+    UINT TerrainQuadTree::GetNumLevels() const
+    {
+        return m_uNumLevels;
+    }
+
+
+    FLOAT TerrainQuadTree::GetLodRange(_In_ UINT uLevel) const
+    {
+        assert(uLevel < m_uNumLevels);
+
+        return m_aLodRanges[uLevel];
+    }
+
+
+    FLOAT TerrainQuadTree::GetMorphStart(_In_ UINT uLevel) const
+    {
+        assert(uLevel < m_uNumLevels);
+
+        return m_aMorphStarts[uLevel];
+    }
+
+
+    FLOAT TerrainQuadTree::GetLevelError(_In_ UINT uLevel) const
+    {
+        assert(uLevel < m_uNumLevels);
+
+        return m_aLevelErrors[uLevel];
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::buildNode
+
+      Summary:  Recursively creates a node and its children, and
+                computes the world bounds of the columns it covers
+
+      Args:     const HeightField& heightField
+                  Column heights of the map
+                UINT uX
+                  First column of the node along x
+                UINT uZ
+                  First column of the node along z
+                UINT uSize
+                  Number of columns the node spans
+                UINT uLevel
+                  LOD level of the node
+
+      Modifies: [m_aNodes].
+
+      Returns:  UINT
+                  Index of the node, INVALID_NODE if the node lies
+                  outside of the map
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TerrainQuadTree::buildNode(_In_ const HeightField& heightField, _In_ UINT uX, _In_ UINT uZ, _In_ UINT uSize, _In_ UINT uLevel)
+    {
+        if (uX >= heightField.GetWidth() || uZ >= heightField.GetDepth())
+        {
+            return INVALID_NODE;
+        }
+
+        UINT uIndex = static_cast<UINT>(m_aNodes.size());
+        m_aNodes.push_back(
+            Node
+            {
+                .uX = uX,
+                .uZ = uZ,
+                .uSize = uSize,
+                .uLevel = uLevel,
+                .BoundsMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX),
+                .BoundsMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX),
+                .aChildren = { INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE }
+            }
+        );
+
+        UINT uLastX = std::min(uX + uSize, heightField.GetWidth() - 1u);
+        UINT uLastZ = std::min(uZ + uSize, heightField.GetDepth() - 1u);
+        FLOAT minY = FLT_MAX;
+        FLOAT maxY = -FLT_MAX;
+
+        if (uLevel == 0u)
+        {
+            for (UINT z = uZ; z <= uLastZ; ++z)
+            {
+                for (UINT x = uX; x <= uLastX; ++x)
+                {
+                    FLOAT height = heightField.GetSurfaceHeight(x, z);
+                    minY = std::min(minY, height);
+                    maxY = std::max(maxY, height);
+                }
+            }
+        }
+        else
+        {
+            UINT uHalfSize = uSize / 2u;
+            for (UINT uQuadrant = 0u; uQuadrant < 4u; ++uQuadrant)
+            {
+                UINT uChild = buildNode(
+                    heightField,
+                    uX + (uQuadrant & 1u) * uHalfSize,
+                    uZ + (uQuadrant >> 1u) * uHalfSize,
+                    uHalfSize,
+                    uLevel - 1u
+                );
+                m_aNodes[uIndex].aChildren[uQuadrant] = uChild;
+
+                if (uChild != INVALID_NODE)
+                {
+                    minY = std::min(minY, m_aNodes[uChild].BoundsMin.y);
+                    maxY = std::max(maxY, m_aNodes[uChild].BoundsMax.y);
+                }
+            }
+        }
+
+        m_aNodes[uIndex].BoundsMin = XMFLOAT3(heightField.GetWorldX(static_cast<FLOAT>(uX)), minY, heightField.GetWorldZ(static_cast<FLOAT>(uZ)));
+        m_aNodes[uIndex].BoundsMax = XMFLOAT3(heightField.GetWorldX(static_cast<FLOAT>(uLastX)), maxY, heightField.GetWorldZ(static_cast<FLOAT>(uLastZ)));
+
+        return uIndex;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::computeLevelErrors
+
+      Summary:  Computes, for every level, the largest difference
+                between a column height and the height the patch grid
+                of that level interpolates at the column
+
+      Args:     const HeightField& heightField
+                  Column heights of the map
+
+      Modifies: [m_aLevelErrors].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TerrainQuadTree::computeLevelErrors(_In_ const HeightField& heightField)
+    {
+        UINT uWidth = heightField.GetWidth();
+        UINT uDepth = heightField.GetDepth();
+
+        auto clampedHeight = [&](UINT x, UINT z)
+        {
+            return heightField.GetSurfaceHeight(std::min(x, uWidth - 1u), std::min(z, uDepth - 1u));
+        };
+
+        m_aLevelErrors[0] = 0.0f;
+        for (UINT uLevel = 1u; uLevel < m_uNumLevels; ++uLevel)
+        {
+            UINT uSpacing = 1u << uLevel;
+            FLOAT invSpacing = 1.0f / static_cast<FLOAT>(uSpacing);
+            FLOAT maxError = m_aLevelErrors[uLevel - 1u];
+
+            for (UINT z = 0u; z < uDepth; ++z)
+            {
+                UINT z0 = z - z % uSpacing;
+                FLOAT fz = static_cast<FLOAT>(z - z0) * invSpacing;
+
+                for (UINT x = 0u; x < uWidth; ++x)
+                {
+                    UINT x0 = x - x % uSpacing;
+                    FLOAT fx = static_cast<FLOAT>(x - x0) * invSpacing;
+
+                    FLOAT top = clampedHeight(x0, z0) + (clampedHeight(x0 + uSpacing, z0) - clampedHeight(x0, z0)) * fx;
+                    FLOAT bottom = clampedHeight(x0, z0 + uSpacing) + (clampedHeight(x0 + uSpacing, z0 + uSpacing) - clampedHeight(x0, z0 + uSpacing)) * fx;
+                    FLOAT interpolated = top + (bottom - top) * fz;
+
+                    maxError = std::max(maxError, fabsf(heightField.GetSurfaceHeight(x, z) - interpolated));
+                }
+            }
+
+            m_aLevelErrors[uLevel] = maxError;
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::selectNode
+
+      Summary:  Recursive part of the selection
+
+      Args:     UINT uNodeIndex
+                  Node to select
+                const XMFLOAT3& eye
+                  Position of the camera
+                const XMFLOAT4* aFrustumPlanes
+                  Six frustum planes pointing inwards
+                std::vector<SelectedNode>& aOutSelection
+                  Selected quadrants are appended here
+
+      Returns:  BOOL
+                  FALSE if the node is out of its level range and the
+                  parent has to cover its area
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL TerrainQuadTree::selectNode(
+        _In_ UINT uNodeIndex,
+        _In_ const XMFLOAT3& eye,
+        _In_reads_(6) const XMFLOAT4* aFrustumPlanes,
+        _Inout_ std::vector<SelectedNode>& aOutSelection
+    ) const
+    {
+        const Node& node = m_aNodes[uNodeIndex];
+
+        if (!intersectsSphere(node, eye, m_aLodRanges[node.uLevel]))
+        {
+            return FALSE;
+        }
+
+        if (!intersectsFrustum(node, aFrustumPlanes))
+        {
+            // Culled, but the area is handled so the parent does not draw it
+            return TRUE;
+        }
+
+        if (node.uLevel == 0u || !intersectsSphere(node, eye, m_aLodRanges[node.uLevel - 1u]))
+        {
+            for (UINT uQuadrant = 0u; uQuadrant < 4u; ++uQuadrant)
+            {
+                if (hasQuadrant(node, uQuadrant))
+                {
+                    aOutSelection.push_back(SelectedNode{ .uNodeIndex = uNodeIndex, .uQuadrant = uQuadrant });
+                }
+            }
+            return TRUE;
+        }
+
+        for (UINT uQuadrant = 0u; uQuadrant < 4u; ++uQuadrant)
+        {
+            UINT uChild = node.aChildren[uQuadrant];
+            if (uChild == INVALID_NODE)
+            {
+                continue;
+            }
+
+            if (!selectNode(uChild, eye, aFrustumPlanes, aOutSelection))
+            {
+                aOutSelection.push_back(SelectedNode{ .uNodeIndex = uNodeIndex, .uQuadrant = uQuadrant });
+            }
+        }
+
+        return TRUE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainQuadTree::hasQuadrant
+
+      Summary:  Returns whether a quadrant of the node covers any column
+                of the map. Leaves on the map border may hang over it
+
+      Args:     const Node& node
+                  Node to test
+                UINT uQuadrant
+                  Quadrant of the node, x in bit 0 and z in bit 1
+
+      Returns:  BOOL
+                  TRUE if the quadrant covers the map
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL TerrainQuadTree::hasQuadrant(_In_ const Node& node, _In_ UINT uQuadrant)
+    {
+        if (node.uLevel > 0u)
+        {
+            return node.aChildren[uQuadrant] != INVALID_NODE;
+        }
+
+        FLOAT halfSize = HeightField::CELL_SIZE * static_cast<FLOAT>(node.uSize / 2u);
+
+        return ((uQuadrant & 1u) == 0u || node.BoundsMin.x + halfSize < node.BoundsMax.x)
+            && ((uQuadrant & 2u) == 0u || node.BoundsMin.z + halfSize < node.BoundsMax.z);
+    }
+
+
+    BOOL TerrainQuadTree::intersectsSphere(_In_ const Node& node, _In_ const XMFLOAT3& center, _In_ FLOAT radius)
+    {
+        if (radius >= FLT_MAX)
+        {
+            return TRUE;
+        }
+
+        FLOAT dx = std::max(std::max(node.BoundsMin.x - center.x, 0.0f), center.x - node.BoundsMax.x);
+        FLOAT dy = std::max(std::max(node.BoundsMin.y - center.y, 0.0f), center.y - node.BoundsMax.y);
+        FLOAT dz = std::max(std::max(node.BoundsMin.z - center.z, 0.0f), center.z - node.BoundsMax.z);
+
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    }
+
+
+    BOOL TerrainQuadTree::intersectsFrustum(_In_ const Node& node, _In_reads_(6) const XMFLOAT4* aFrustumPlanes)
+    {
+        for (UINT uPlane = 0u; uPlane < 6u; ++uPlane)
+        {
+            const XMFLOAT4& plane = aFrustumPlanes[uPlane];
+
+            // Test the corner furthest along the plane normal
+            FLOAT x = plane.x >= 0.0f ? node.BoundsMax.x : node.BoundsMin.x;
+            FLOAT y = plane.y >= 0.0f ? node.BoundsMax.y : node.BoundsMin.y;
+            FLOAT z = plane.z >= 0.0f ? node.BoundsMax.z : node.BoundsMin.z;
+
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+            {
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+}
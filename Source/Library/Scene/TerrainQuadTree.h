@@ -0,0 +1,124 @@
+/*+===================================================================
+  File:      TERRAINQUADTREE.H
+
+  Summary:   TerrainQuadTree header file contains declarations of
+             TerrainQuadTree class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: TerrainQuadTree
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <cfloat>
+
+#include "Scene/HeightField.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    TerrainQuadTree
+
+      Summary:  CPU side of the continuous distance-dependent LOD
+                terrain. Every node is drawn with the same grid patch
+                of PATCH_RESOLUTION quads, so the grid spacing doubles
+                at every level. The LOD ranges are derived from the
+                height error of every level projected onto the screen,
+                and the selection does not touch Direct3D so it can be
+                run without a device
+
+      Methods:  Build
+                  Builds the nodes and the per level height errors
+                SetScreenSpaceError
+                  Computes the LOD ranges from the projection and the
+                  allowed error in pixels
+                Select
+                  Selects the node quadrants to draw for a camera
+                GetNode
+                  Returns a node
+                GetNumNodes
+                  Returns the number of nodes
+                GetNumLevels
+                  Returns the number of LOD levels
+                GetLodRange
+                  Returns the far distance of a level
+                GetMorphStart
+                  Returns the distance where a level starts morphing
+                GetLevelError
+                  Returns the maximum height error of a level
+                TerrainQuadTree
+                  Constructor.
+                ~TerrainQuadTree
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class TerrainQuadTree
+    {
+    public:
+        static constexpr const UINT PATCH_RESOLUTION = 16u;
+        static constexpr const UINT MAX_NUM_LEVELS = 16u;
+        static constexpr const UINT INVALID_NODE = (0xFFFFFFFF);
+        static constexpr const FLOAT MORPH_START_RATIO = 0.66f;
+
+        struct Node
+        {
+            UINT uX;
+            UINT uZ;
+            UINT uSize;
+            UINT uLevel;
+            XMFLOAT3 BoundsMin;
+            XMFLOAT3 BoundsMax;
+            UINT aChildren[4];
+        };
+
+        struct SelectedNode
+        {
+            UINT uNodeIndex;
+            UINT uQuadrant;
+        };
+
+    public:
+        TerrainQuadTree();
+        TerrainQuadTree(const TerrainQuadTree& other) = delete;
+        TerrainQuadTree(TerrainQuadTree&& other) = delete;
+        TerrainQuadTree& operator=(const TerrainQuadTree& other) = delete;
+        TerrainQuadTree& operator=(TerrainQuadTree&& other) = delete;
+        ~TerrainQuadTree() = default;
+
+        HRESULT Build(_In_ const HeightField& heightField);
+        void SetScreenSpaceError(_In_ FLOAT fovAngleY, _In_ FLOAT viewportHeight, _In_ FLOAT pixelError);
+
+        UINT Select(_In_ const XMFLOAT3& eye, _In_ const XMMATRIX& viewProjection, _Inout_ std::vector<SelectedNode>& aOutSelection) const;
+
+        const Node& GetNode(_In_ UINT uIndex) const;
+        UINT GetNumNodes() const;
+        UINT GetNumLevels() const;
+        FLOAT GetLodRange(_In_ UINT uLevel) const;
+        FLOAT GetMorphStart(_In_ UINT uLevel) const;
+        FLOAT GetLevelError(_In_ UINT uLevel) const;
+
+    private:
+        UINT buildNode(_In_ const HeightField& heightField, _In_ UINT uX, _In_ UINT uZ, _In_ UINT uSize, _In_ UINT uLevel);
+        void computeLevelErrors(_In_ const HeightField& heightField);
+        BOOL selectNode(
+            _In_ UINT uNodeIndex,
+            _In_ const XMFLOAT3& eye,
+            _In_reads_(6) const XMFLOAT4* aFrustumPlanes,
+            _Inout_ std::vector<SelectedNode>& aOutSelection
+        ) const;
+
+        static BOOL hasQuadrant(_In_ const Node& node, _In_ UINT uQuadrant);
+        static BOOL intersectsSphere(_In_ const Node& node, _In_ const XMFLOAT3& center, _In_ FLOAT radius);
+        static BOOL intersectsFrustum(_In_ const Node& node, _In_reads_(6) const XMFLOAT4* aFrustumPlanes);
+
+    private:
+        std::vector<Node> m_aNodes;
+        UINT m_uRootIndex;
+        UINT m_uNumLevels;
+        FLOAT m_aLevelErrors[MAX_NUM_LEVELS];
+        FLOAT m_aLodRanges[MAX_NUM_LEVELS];
+        FLOAT m_aMorphStarts[MAX_NUM_LEVELS];
+    };
+}
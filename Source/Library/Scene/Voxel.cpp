@@ -1,5 +1,8 @@
 #include "Scene/Voxel.h"
 
+#include <algorithm>
+#include <numeric>
+
 #include "Texture/Material.h"
 
 namespace library
@@ -14,6 +17,13 @@ namespace library
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     Voxel::Voxel(_In_ const XMFLOAT4& outputColor)
         : InstancedRenderable(outputColor)
+        , m_instanceOrder(eVoxelInstanceOrder::MORTON_FRONT_TO_BACK)
+        , m_gridOrigin()
+        , m_bHasGridOrigin(FALSE)
+        , m_aBuckets()
+        , m_aBucketOrder()
+        , m_aBucketDistances()
+        , m_aDrawRanges()
     { }
 
 
@@ -29,6 +39,13 @@ namespace library
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     Voxel::Voxel(_In_ std::vector<InstanceData>&& aInstanceData, _In_ const XMFLOAT4& outputColor)
         : InstancedRenderable(move(aInstanceData), outputColor)
+        , m_instanceOrder(eVoxelInstanceOrder::MORTON_FRONT_TO_BACK)
+        , m_gridOrigin()
+        , m_bHasGridOrigin(FALSE)
+        , m_aBuckets()
+        , m_aBucketOrder()
+        , m_aBucketDistances()
+        , m_aDrawRanges()
     { }
 
 
@@ -58,6 +75,8 @@ namespace library
             return hr;
         }
 
+        sortInstances();
+
         hr = initializeInstance(pDevice);
         if (FAILED(hr))
         {
@@ -91,6 +110,201 @@ namespace library
     }
 
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::SetInstanceOrder
+
+      Summary:  Sets the order the instances are stored and drawn in.
+                Takes effect when the voxel is initialized
+
+      Args:     eVoxelInstanceOrder instanceOrder
+                  Order of the instances
+
+      Modifies: [m_instanceOrder].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::SetInstanceOrder(_In_ eVoxelInstanceOrder instanceOrder)
+    {
+        m_instanceOrder = instanceOrder;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetInstanceOrder
+
+      Summary:  Returns the order of the instances
+
+      Returns:  eVoxelInstanceOrder
+                  Order of the instances
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    eVoxelInstanceOrder Voxel::GetInstanceOrder() const
+    {
+        return m_instanceOrder;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::SetGridOrigin
+
+      Summary:  Sets the world center of the grid cell (0, 0, 0), so
+                the buckets line up with the chunks of the scene.
+                Takes effect when the voxel is initialized
+
+      Args:     const XMFLOAT3& gridOrigin
+                  World center of the first cell
+
+      Modifies: [m_gridOrigin, m_bHasGridOrigin].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::SetGridOrigin(_In_ const XMFLOAT3& gridOrigin)
+    {
+        m_gridOrigin = gridOrigin;
+        m_bHasGridOrigin = TRUE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::UpdateDrawRanges
+
+      Summary:  Drops the buckets the potentially visible set rules out
+                from the chunk of the eye and the buckets hidden below
+                the horizon of the height map, orders the others by
+                their distance from the eye and merges the buckets that
+                stay adjacent in the instance buffer into draw ranges.
+                Only the buckets are sorted, the instances inside a
+                bucket keep their Morton order
+
+      Args:     const XMVECTOR& eye
+                  Position of the camera
+                const VoxelPvs* pPvs
+                  Potentially visible set of the scene, or nullptr
+                HorizonCuller* pHorizonCuller
+                  Horizon culler updated for the eye, or nullptr
+
+      Modifies: [m_aBucketOrder, m_aBucketDistances, m_aDrawRanges].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::UpdateDrawRanges(_In_ const XMVECTOR& eye, _In_opt_ const VoxelPvs* pPvs, _In_opt_ HorizonCuller* pHorizonCuller)
+    {
+        // The file order has no buckets and is always drawn whole
+        if (m_aBuckets.empty())
+        {
+            return;
+        }
+
+        XMFLOAT3 eyePosition;
+        XMStoreFloat3(&eyePosition, eye);
+
+        UINT uEyeChunk = pPvs != nullptr ? pPvs->FindChunk(eyePosition) : VoxelPvs::INVALID_CHUNK;
+
+        m_aBucketOrder.clear();
+        for (UINT i = 0u; i < static_cast<UINT>(m_aBuckets.size()); ++i)
+        {
+            if (uEyeChunk != VoxelPvs::INVALID_CHUNK && !pPvs->IsBoxVisible(uEyeChunk, m_aBuckets[i].BoundsMin, m_aBuckets[i].BoundsMax))
+            {
+                continue;
+            }
+
+            if (pHorizonCuller != nullptr && !pHorizonCuller->IsBoxVisible(m_aBuckets[i].BoundsMin, m_aBuckets[i].BoundsMax))
+            {
+                continue;
+            }
+
+            m_aBucketOrder.push_back(i);
+        }
+
+        if (m_instanceOrder == eVoxelInstanceOrder::MORTON_FRONT_TO_BACK)
+        {
+            // Squared distance from the eye to the closest point of the bucket bounds
+            for (UINT uBucketIdx : m_aBucketOrder)
+            {
+                const VoxelBucket& bucket = m_aBuckets[uBucketIdx];
+                FLOAT dx = std::max(std::max(bucket.BoundsMin.x - eyePosition.x, eyePosition.x - bucket.BoundsMax.x), 0.0f);
+                FLOAT dy = std::max(std::max(bucket.BoundsMin.y - eyePosition.y, eyePosition.y - bucket.BoundsMax.y), 0.0f);
+                FLOAT dz = std::max(std::max(bucket.BoundsMin.z - eyePosition.z, eyePosition.z - bucket.BoundsMax.z), 0.0f);
+                m_aBucketDistances[uBucketIdx] = dx * dx + dy * dy + dz * dz;
+            }
+
+            std::sort(m_aBucketOrder.begin(), m_aBucketOrder.end(),
+                [this](UINT uLeft, UINT uRight)
+                {
+                    return m_aBucketDistances[uLeft] < m_aBucketDistances[uRight];
+                }
+            );
+        }
+
+        m_aDrawRanges.clear();
+        for (UINT uBucketIdx : m_aBucketOrder)
+        {
+            const VoxelBucket& bucket = m_aBuckets[uBucketIdx];
+            if (!m_aDrawRanges.empty() && m_aDrawRanges.back().uStartInstance + m_aDrawRanges.back().uNumInstances == bucket.uStartInstance)
+            {
+                m_aDrawRanges.back().uNumInstances += bucket.uNumInstances;
+            }
+            else
+            {
+                m_aDrawRanges.push_back(VoxelDrawRange{ .uStartInstance = bucket.uStartInstance, .uNumInstances = bucket.uNumInstances });
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetBuckets
+
+      Summary:  Returns the buckets of the instances, empty when the
+                instances are kept in the file order
+
+      Returns:  const std::vector<VoxelBucket>&
+                  Buckets in the instance buffer order
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<VoxelBucket>& Voxel::GetBuckets() const
+    {
+        return m_aBuckets;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetDrawRanges
+
+      Summary:  Returns the instance ranges to draw, in drawing order
+
+      Returns:  const std::vector<VoxelDrawRange>&
+                  Draw ranges
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<VoxelDrawRange>& Voxel::GetDrawRanges() const
+    {
+        return m_aDrawRanges;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetMortonCode
+
+      Summary:  Interleaves the lower 21 bits of the grid position into
+                a Z-order code
+
+      Args:     UINT uX
+                UINT uY
+                UINT uZ
+                  Grid position
+
+      Returns:  UINT64
+                  Morton code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 Voxel::GetMortonCode(_In_ UINT uX, _In_ UINT uY, _In_ UINT uZ)
+    {
+        auto splitBy3 = [](UINT u) -> UINT64
+        {
+            UINT64 x = static_cast<UINT64>(u) & 0x1FFFFFull;
+            x = (x | (x << 32ull)) & 0x001F00000000FFFFull;
+            x = (x | (x << 16ull)) & 0x001F0000FF0000FFull;
+            x = (x | (x << 8ull)) & 0x100F00F00F00F00Full;
+            x = (x | (x << 4ull)) & 0x10C30C30C30C30C3ull;
+            x = (x | (x << 2ull)) & 0x1249249249249249ull;
+            return x;
+        };
+
+        return splitBy3(uX) | (splitBy3(uY) << 1ull) | (splitBy3(uZ) << 2ull);
+    }
+
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Voxel::GetNumVertices
 
@@ -145,4 +359,104 @@ namespace library
         return INDICES;
     }
 
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::sortInstances
+
+      Summary:  Sorts the instances by the Morton code of their grid
+                position, so neighboring cubes are neighbors in the
+                instance buffer, and splits them into buckets of
+                2^BUCKET_SIZE_LOG2 cells on each axis, the chunks of
+                the scene when the grid origin is set
+
+      Modifies: [m_aInstanceData, m_aBuckets, m_aBucketOrder,
+                  m_aBucketDistances, m_aDrawRanges].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::sortInstances()
+    {
+        m_aBuckets.clear();
+        m_aBucketOrder.clear();
+        m_aBucketDistances.clear();
+        m_aDrawRanges.clear();
+
+        if (m_aInstanceData.empty())
+        {
+            return;
+        }
+
+        m_aDrawRanges.push_back(VoxelDrawRange{ .uStartInstance = 0u, .uNumInstances = GetNumInstances() });
+
+        if (m_instanceOrder == eVoxelInstanceOrder::FILE)
+        {
+            return;
+        }
+
+        std::vector<XMFLOAT3> aPositions(m_aInstanceData.size());
+        XMFLOAT3 gridOrigin(FLT_MAX, FLT_MAX, FLT_MAX);
+        for (size_t i = 0u; i < m_aInstanceData.size(); ++i)
+        {
+            XMStoreFloat3(&aPositions[i], m_aInstanceData[i].Transformation.r[3]);
+            gridOrigin.x = std::min(gridOrigin.x, aPositions[i].x);
+            gridOrigin.y = std::min(gridOrigin.y, aPositions[i].y);
+            gridOrigin.z = std::min(gridOrigin.z, aPositions[i].z);
+        }
+
+        if (m_bHasGridOrigin)
+        {
+            gridOrigin = m_gridOrigin;
+        }
+
+        std::vector<std::pair<UINT64, UINT>> aKeys(m_aInstanceData.size());
+        for (size_t i = 0u; i < m_aInstanceData.size(); ++i)
+        {
+            aKeys[i].first = GetMortonCode(
+                static_cast<UINT>((aPositions[i].x - gridOrigin.x) / CELL_SIZE + 0.5f),
+                static_cast<UINT>((aPositions[i].y - gridOrigin.y) / CELL_SIZE + 0.5f),
+                static_cast<UINT>((aPositions[i].z - gridOrigin.z) / CELL_SIZE + 0.5f)
+            );
+            aKeys[i].second = static_cast<UINT>(i);
+        }
+        std::sort(aKeys.begin(), aKeys.end());
+
+        std::vector<InstanceData> aSortedInstanceData;
+        aSortedInstanceData.reserve(m_aInstanceData.size());
+
+        // Instances sharing the high bits of the code lie in the same bucket, and are contiguous after the sort
+        constexpr const UINT64 BUCKET_SHIFT = 3ull * BUCKET_SIZE_LOG2;
+        constexpr const FLOAT HALF_EXTENT = CELL_SIZE * 0.5f;
+        for (size_t i = 0u; i < aKeys.size(); ++i)
+        {
+            const XMFLOAT3& position = aPositions[aKeys[i].second];
+            aSortedInstanceData.push_back(m_aInstanceData[aKeys[i].second]);
+
+            if (i == 0u || (aKeys[i].first >> BUCKET_SHIFT) != (aKeys[i - 1u].first >> BUCKET_SHIFT))
+            {
+                m_aBuckets.push_back(
+                    VoxelBucket
+                    {
+                        .uStartInstance = static_cast<UINT>(i),
+                        .uNumInstances = 0u,
+                        .BoundsMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX),
+                        .BoundsMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+                    }
+                );
+            }
+
+            VoxelBucket& bucket = m_aBuckets.back();
+            ++bucket.uNumInstances;
+            bucket.BoundsMin.x = std::min(bucket.BoundsMin.x, position.x - HALF_EXTENT);
+            bucket.BoundsMin.y = std::min(bucket.BoundsMin.y, position.y - HALF_EXTENT);
+            bucket.BoundsMin.z = std::min(bucket.BoundsMin.z, position.z - HALF_EXTENT);
+            bucket.BoundsMax.x = std::max(bucket.BoundsMax.x, position.x + HALF_EXTENT);
+            bucket.BoundsMax.y = std::max(bucket.BoundsMax.y, position.y + HALF_EXTENT);
+            bucket.BoundsMax.z = std::max(bucket.BoundsMax.z, position.z + HALF_EXTENT);
+        }
+
+        m_aInstanceData = std::move(aSortedInstanceData);
+
+        m_aBucketOrder.resize(m_aBuckets.size());
+        std::iota(m_aBucketOrder.begin(), m_aBucketOrder.end(), 0u);
+        m_aBucketDistances.resize(m_aBuckets.size(), 0.0f);
+    }
+
 }
\ No newline at end of file
@@ -13,17 +13,80 @@
 
 #include "Common.h"
 
+#include <cfloat>
+
 #include "Renderer/DataTypes.h"
 #include "Renderer/InstancedRenderable.h"
+#include "Scene/HorizonCuller.h"
+#include "Scene/VoxelPvs.h"
 
 namespace library
 {
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eVoxelInstanceOrder
+
+        Summary:  Enumeration of the orders the voxel instances are
+                  stored and drawn in
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eVoxelInstanceOrder : UINT
+    {
+        FILE = 0,
+        MORTON,
+        MORTON_FRONT_TO_BACK,
+        COUNT,
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   VoxelBucket
+
+      Summary:  Contiguous range of Morton ordered instances lying in
+                the same block of BUCKET_SIZE cells on each axis
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct VoxelBucket
+    {
+        UINT uStartInstance;
+        UINT uNumInstances;
+        XMFLOAT3 BoundsMin;
+        XMFLOAT3 BoundsMax;
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   VoxelDrawRange
+
+      Summary:  Range of instances drawn with a single instanced draw
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct VoxelDrawRange
+    {
+        UINT uStartInstance;
+        UINT uNumInstances;
+    };
+
     /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
       Class:    Voxel
 
       Summary:  Base class for renderable 3d cube object
 
-      Methods:  Voxel
+      Methods:  Initialize
+                  Orders the instances and creates the buffers
+                Update
+                  Updates the voxel every frame
+                SetInstanceOrder
+                  Sets the order of the instances, before Initialize
+                GetInstanceOrder
+                  Returns the order of the instances
+                SetGridOrigin
+                  Sets the world center of the grid cell (0, 0, 0)
+                UpdateDrawRanges
+                  Drops the buckets outside the potentially visible
+                  set or below the horizon, orders the rest front to
+                  back from the eye and merges them into draw ranges
+                GetBuckets
+                  Returns the buckets of the instances
+                GetDrawRanges
+                  Returns the ranges to draw this frame
+                GetMortonCode
+                  Interleaves the bits of a grid position
+                Voxel
                   Constructor.
                 ~Voxel
                   Destructor.
@@ -42,6 +105,16 @@ namespace library
         virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) override;
         virtual void Update(_In_ FLOAT deltaTime) override;
 
+        void SetInstanceOrder(_In_ eVoxelInstanceOrder instanceOrder);
+        eVoxelInstanceOrder GetInstanceOrder() const;
+
+        void SetGridOrigin(_In_ const XMFLOAT3& gridOrigin);
+        void UpdateDrawRanges(_In_ const XMVECTOR& eye, _In_opt_ const VoxelPvs* pPvs = nullptr, _In_opt_ HorizonCuller* pHorizonCuller = nullptr);
+        const std::vector<VoxelBucket>& GetBuckets() const;
+        const std::vector<VoxelDrawRange>& GetDrawRanges() const;
+
+        static UINT64 GetMortonCode(_In_ UINT uX, _In_ UINT uY, _In_ UINT uZ);
+
         UINT GetNumVertices() const override;
         UINT GetNumIndices() const override;
 
@@ -49,6 +122,11 @@ namespace library
         const SimpleVertex* getVertices() const override;
         const WORD* getIndices() const override;
 
+        void sortInstances();
+
+        static constexpr const UINT BUCKET_SIZE_LOG2 = VoxelPvs::CHUNK_SIZE_LOG2;
+        static constexpr const FLOAT CELL_SIZE = 2.0f;
+
         static constexpr const SimpleVertex VERTICES[] =
         {
             { .Position = XMFLOAT3(-1.0f, 1.0f, -1.0f), .TexCoord = XMFLOAT2(1.0f, 0.0f), .Normal = XMFLOAT3(0.0f, 1.0f, 0.0f) },
@@ -103,5 +181,14 @@ namespace library
             23,20,22
         };
         static constexpr const UINT NUM_INDICES = 36u;
+
+    protected:
+        eVoxelInstanceOrder m_instanceOrder;
+        XMFLOAT3 m_gridOrigin;
+        BOOL m_bHasGridOrigin;
+        std::vector<VoxelBucket> m_aBuckets;
+        std::vector<UINT> m_aBucketOrder;
+        std::vector<FLOAT> m_aBucketDistances;
+        std::vector<VoxelDrawRange> m_aDrawRanges;
     };
 }
\ No newline at end of file
@@ -0,0 +1,592 @@
+#include "Scene/VoxelPvs.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const UINT NUM_FACES = 6u;
+        constexpr const BYTE UNVISITED = 0xFF;
+
+        /*F+F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F+++F
+          Function: faceBit
+
+          Summary:  Returns the bit of the connection between two faces
+                    of a chunk, faces are -x, +x, -y, +y, -z, +z. The
+                    bit of a face with itself marks the face as touched
+                    by air
+
+          Args:     UINT uFrom
+                    UINT uTo
+                      Faces of the chunk
+
+          Returns:  UINT64
+                      Bit of the connection
+        -----------------------------------------------------------------F-F*/
+        constexpr UINT64 faceBit(_In_ UINT uFrom, _In_ UINT uTo)
+        {
+            return 1ull << (uFrom * NUM_FACES + uTo);
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::VoxelPvs
+
+      Summary:  Constructor of an empty set
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelPvs::VoxelPvs()
+        : m_gridOrigin()
+        , m_uNumCellsX(0u)
+        , m_uNumCellsY(0u)
+        , m_uNumCellsZ(0u)
+        , m_uNumChunksX(0u)
+        , m_uNumChunksY(0u)
+        , m_uNumChunksZ(0u)
+        , m_uWordsPerRow(0u)
+        , m_aFaceConnectivity()
+        , m_aVisibility()
+        , m_buildTime(0.0f)
+        , m_averageVisibleFraction(1.0f)
+        , m_uNumThreads(0u)
+    { }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::Build
+
+      Summary:  Splits the grid into chunks, finds the faces joined by
+                air inside every chunk, and floods the chunks from every
+                chunk to fill its visibility row
+
+      Args:     const HeightField& heightField
+                  Columns of the voxel grid
+                UINT uNumThreads
+                  Number of threads, 0 uses every hardware thread
+
+      Modifies: [m_gridOrigin, m_uNumCellsX, m_uNumCellsY, m_uNumCellsZ,
+                  m_uNumChunksX, m_uNumChunksY, m_uNumChunksZ,
+                  m_uWordsPerRow, m_aFaceConnectivity, m_aVisibility,
+                  m_buildTime, m_averageVisibleFraction, m_uNumThreads].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelPvs::Build(_In_ const HeightField& heightField, _In_opt_ UINT uNumThreads)
+    {
+        if (heightField.IsEmpty())
+        {
+            return E_INVALIDARG;
+        }
+
+        LARGE_INTEGER frequency, startingTime, endingTime;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&startingTime);
+
+        // Leave a layer of air above the highest column so the tops are connected
+        UINT uMaxNumBlocks = 0u;
+        for (UINT z = 0u; z < heightField.GetDepth(); ++z)
+        {
+            for (UINT x = 0u; x < heightField.GetWidth(); ++x)
+            {
+                uMaxNumBlocks = std::max(uMaxNumBlocks, heightField.GetNumBlocks(x, z));
+            }
+        }
+
+        m_gridOrigin = heightField.GetCellPosition(0u, 0u, 0u);
+        m_uNumCellsX = heightField.GetWidth();
+        m_uNumCellsY = uMaxNumBlocks + 1u;
+        m_uNumCellsZ = heightField.GetDepth();
+        m_uNumChunksX = (m_uNumCellsX + CHUNK_SIZE - 1u) >> CHUNK_SIZE_LOG2;
+        m_uNumChunksY = (m_uNumCellsY + CHUNK_SIZE - 1u) >> CHUNK_SIZE_LOG2;
+        m_uNumChunksZ = (m_uNumCellsZ + CHUNK_SIZE - 1u) >> CHUNK_SIZE_LOG2;
+
+        UINT uNumChunks = GetNumChunks();
+        m_uWordsPerRow = (uNumChunks + 63u) / 64u;
+        m_aFaceConnectivity.assign(uNumChunks, 0ull);
+        m_aVisibility.assign(static_cast<size_t>(uNumChunks) * m_uWordsPerRow, 0ull);
+
+        m_uNumThreads = GetNumParallelThreads(uNumChunks, uNumThreads);
+
+        // Faces joined by air inside every chunk, with the scratch memory of each thread
+        std::vector<std::vector<BYTE>> aaVisited(m_uNumThreads);
+        std::vector<std::vector<UINT>> aaStacks(m_uNumThreads);
+        ParallelFor(uNumChunks, m_uNumThreads,
+            [&](UINT uChunk, UINT uThread)
+            {
+                std::vector<BYTE>& aVisited = aaVisited[uThread];
+                aVisited.resize(static_cast<size_t>(CHUNK_SIZE) * CHUNK_SIZE * CHUNK_SIZE);
+
+                UINT uChunkX = uChunk % m_uNumChunksX;
+                UINT uChunkY = (uChunk / m_uNumChunksX) % m_uNumChunksY;
+                UINT uChunkZ = uChunk / (m_uNumChunksX * m_uNumChunksY);
+                m_aFaceConnectivity[uChunk] = computeFaceConnectivity(heightField, uChunkX, uChunkY, uChunkZ, aVisited, aaStacks[uThread]);
+            }
+        );
+
+        // Rows are independent, each thread floods from its own chunks
+        std::vector<std::vector<BYTE>> aaEntryMasks(m_uNumThreads);
+        std::vector<std::vector<UINT>> aaQueues(m_uNumThreads);
+        ParallelFor(uNumChunks, m_uNumThreads,
+            [&](UINT uChunk, UINT uThread)
+            {
+                std::vector<BYTE>& aEntryMasks = aaEntryMasks[uThread];
+                aEntryMasks.resize(static_cast<size_t>(uNumChunks) * NUM_FACES);
+                buildRow(uChunk, aEntryMasks, aaQueues[uThread]);
+            }
+        );
+
+        UINT64 uNumVisiblePairs = 0ull;
+        for (UINT64 word : m_aVisibility)
+        {
+            uNumVisiblePairs += static_cast<UINT64>(std::popcount(word));
+        }
+        m_averageVisibleFraction = static_cast<FLOAT>(static_cast<DOUBLE>(uNumVisiblePairs) / (static_cast<DOUBLE>(uNumChunks) * static_cast<DOUBLE>(uNumChunks)));
+
+        QueryPerformanceCounter(&endingTime);
+        m_buildTime = static_cast<FLOAT>(static_cast<DOUBLE>(endingTime.QuadPart - startingTime.QuadPart) * 1000.0 / static_cast<DOUBLE>(frequency.QuadPart));
+
+        return S_OK;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::IsBuilt
+
+      Summary:  Returns whether the set has been built
+
+      Returns:  BOOL
+                  TRUE if the set can be queried
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelPvs::IsBuilt() const
+    {
+        return !m_aVisibility.empty();
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::FindChunk
+
+      Summary:  Returns the chunk containing a world position
+
+      Args:     const XMFLOAT3& position
+                  World position
+
+      Returns:  UINT
+                  Index of the chunk, INVALID_CHUNK outside the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelPvs::FindChunk(_In_ const XMFLOAT3& position) const
+    {
+        INT x, y, z;
+        if (!IsBuilt() || !findCell(position, x, y, z))
+        {
+            return INVALID_CHUNK;
+        }
+
+        UINT uChunkX = static_cast<UINT>(x) >> CHUNK_SIZE_LOG2;
+        UINT uChunkY = static_cast<UINT>(y) >> CHUNK_SIZE_LOG2;
+        UINT uChunkZ = static_cast<UINT>(z) >> CHUNK_SIZE_LOG2;
+
+        return (uChunkZ * m_uNumChunksY + uChunkY) * m_uNumChunksX + uChunkX;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::IsVisible
+
+      Summary:  Returns whether a chunk is potentially visible from
+                another. Anything is visible from outside the grid
+
+      Args:     UINT uFromChunk
+                  Chunk of the eye
+                UINT uToChunk
+                  Chunk to test
+
+      Returns:  BOOL
+                  TRUE if the chunk may be visible
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelPvs::IsVisible(_In_ UINT uFromChunk, _In_ UINT uToChunk) const
+    {
+        if (uFromChunk >= GetNumChunks() || uToChunk >= GetNumChunks())
+        {
+            return TRUE;
+        }
+
+        const UINT64* pRow = &m_aVisibility[static_cast<size_t>(uFromChunk) * m_uWordsPerRow];
+
+        return (pRow[uToChunk / 64u] >> (uToChunk % 64u)) & 1ull ? TRUE : FALSE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::IsBoxVisible
+
+      Summary:  Returns whether any chunk holding a cell center inside
+                a world box is potentially visible from a chunk
+
+      Args:     UINT uFromChunk
+                  Chunk of the eye
+                const XMFLOAT3& boundsMin
+                const XMFLOAT3& boundsMax
+                  World box to test
+
+      Returns:  BOOL
+                  TRUE if the box may be visible
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelPvs::IsBoxVisible(_In_ UINT uFromChunk, _In_ const XMFLOAT3& boundsMin, _In_ const XMFLOAT3& boundsMax) const
+    {
+        if (uFromChunk >= GetNumChunks())
+        {
+            return TRUE;
+        }
+
+        // Shrink the box by half a cell so the faces shared with the next chunk are not counted
+        constexpr const FLOAT HALF_CELL = HeightField::CELL_SIZE * 0.5f;
+        INT aMin[3], aMax[3];
+        findCell(XMFLOAT3(boundsMin.x + HALF_CELL, boundsMin.y + HALF_CELL, boundsMin.z + HALF_CELL), aMin[0], aMin[1], aMin[2]);
+        findCell(XMFLOAT3(boundsMax.x - HALF_CELL, boundsMax.y - HALF_CELL, boundsMax.z - HALF_CELL), aMax[0], aMax[1], aMax[2]);
+
+        const INT aNumChunks[3] = { static_cast<INT>(m_uNumChunksX), static_cast<INT>(m_uNumChunksY), static_cast<INT>(m_uNumChunksZ) };
+        for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+        {
+            // Cells beyond the grid cannot be ruled out
+            if (aMin[uAxis] < 0 || (aMax[uAxis] >> CHUNK_SIZE_LOG2) >= aNumChunks[uAxis])
+            {
+                return TRUE;
+            }
+            aMin[uAxis] >>= CHUNK_SIZE_LOG2;
+            aMax[uAxis] >>= CHUNK_SIZE_LOG2;
+        }
+
+        for (INT z = aMin[2]; z <= aMax[2]; ++z)
+        {
+            for (INT y = aMin[1]; y <= aMax[1]; ++y)
+            {
+                for (INT x = aMin[0]; x <= aMax[0]; ++x)
+                {
+                    if (IsVisible(uFromChunk, static_cast<UINT>((z * aNumChunks[1] + y) * aNumChunks[0] + x)))
+                    {
+                        return TRUE;
+                    }
+                }
+            }
+        }
+
+        return FALSE;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::GetNumChunks
+
+      Summary:  Returns the number of chunks
+
+      Returns:  UINT
+                  Number of chunks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelPvs::GetNumChunks() const
+    {
+        return m_uNumChunksX * m_uNumChunksY * m_uNumChunksZ;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::GetBuildTime
+
+      Summary:  Returns the time the last build took
+
+      Returns:  FLOAT
+                  Build time in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT VoxelPvs::GetBuildTime() const
+    {
+        return m_buildTime;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::GetAverageVisibleFraction
+
+      Summary:  Returns the fraction of the chunks visible from a chunk
+                on average
+
+      Returns:  FLOAT
+                  Visible fraction in [0, 1]
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT VoxelPvs::GetAverageVisibleFraction() const
+    {
+        return m_averageVisibleFraction;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::GetNumThreads
+
+      Summary:  Returns the number of threads of the last build
+
+      Returns:  UINT
+                  Number of threads
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelPvs::GetNumThreads() const
+    {
+        return m_uNumThreads;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::computeFaceConnectivity
+
+      Summary:  Flood fills the air cells of a chunk and joins every
+                pair of faces the same air region touches
+
+      Args:     const HeightField& heightField
+                  Columns of the voxel grid
+                UINT uChunkX
+                UINT uChunkY
+                UINT uChunkZ
+                  Chunk coordinates
+                std::vector<BYTE>& aVisited
+                std::vector<UINT>& aStack
+                  Scratch memory of the calling thread
+
+      Returns:  UINT64
+                  Face connection bits, see faceBit
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 VoxelPvs::computeFaceConnectivity(
+        _In_ const HeightField& heightField,
+        _In_ UINT uChunkX,
+        _In_ UINT uChunkY,
+        _In_ UINT uChunkZ,
+        _Inout_ std::vector<BYTE>& aVisited,
+        _Inout_ std::vector<UINT>& aStack
+    ) const
+    {
+        const UINT uBaseX = uChunkX << CHUNK_SIZE_LOG2;
+        const UINT uBaseY = uChunkY << CHUNK_SIZE_LOG2;
+        const UINT uBaseZ = uChunkZ << CHUNK_SIZE_LOG2;
+
+        auto isAir = [&](UINT uLocalX, UINT uLocalY, UINT uLocalZ) -> BOOL
+        {
+            UINT x = uBaseX + uLocalX;
+            UINT y = uBaseY + uLocalY;
+            UINT z = uBaseZ + uLocalZ;
+
+            return x < m_uNumCellsX && y < m_uNumCellsY && z < m_uNumCellsZ && y >= heightField.GetNumBlocks(x, z);
+        };
+
+        std::fill(aVisited.begin(), aVisited.end(), static_cast<BYTE>(0u));
+
+        UINT64 uConnectivity = 0ull;
+        for (UINT uSeed = 0u; uSeed < aVisited.size(); ++uSeed)
+        {
+            if (aVisited[uSeed] || !isAir(uSeed % CHUNK_SIZE, (uSeed >> CHUNK_SIZE_LOG2) % CHUNK_SIZE, uSeed >> (2u * CHUNK_SIZE_LOG2)))
+            {
+                continue;
+            }
+
+            UINT uFaces = 0u;
+            aVisited[uSeed] = 1u;
+            aStack.clear();
+            aStack.push_back(uSeed);
+            while (!aStack.empty())
+            {
+                UINT uCell = aStack.back();
+                aStack.pop_back();
+
+                const UINT aLocal[3] = { uCell % CHUNK_SIZE, (uCell >> CHUNK_SIZE_LOG2) % CHUNK_SIZE, uCell >> (2u * CHUNK_SIZE_LOG2) };
+                const UINT aStrides[3] = { 1u, CHUNK_SIZE, CHUNK_SIZE * CHUNK_SIZE };
+                for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+                {
+                    if (aLocal[uAxis] == 0u)
+                    {
+                        uFaces |= 1u << (uAxis * 2u);
+                    }
+                    else if (!aVisited[uCell - aStrides[uAxis]])
+                    {
+                        UINT aNeighbor[3] = { aLocal[0], aLocal[1], aLocal[2] };
+                        --aNeighbor[uAxis];
+                        if (isAir(aNeighbor[0], aNeighbor[1], aNeighbor[2]))
+                        {
+                            aVisited[uCell - aStrides[uAxis]] = 1u;
+                            aStack.push_back(uCell - aStrides[uAxis]);
+                        }
+                    }
+
+                    if (aLocal[uAxis] == CHUNK_SIZE - 1u)
+                    {
+                        uFaces |= 1u << (uAxis * 2u + 1u);
+                    }
+                    else if (!aVisited[uCell + aStrides[uAxis]])
+                    {
+                        UINT aNeighbor[3] = { aLocal[0], aLocal[1], aLocal[2] };
+                        ++aNeighbor[uAxis];
+                        if (isAir(aNeighbor[0], aNeighbor[1], aNeighbor[2]))
+                        {
+                            aVisited[uCell + aStrides[uAxis]] = 1u;
+                            aStack.push_back(uCell + aStrides[uAxis]);
+                        }
+                    }
+                }
+            }
+
+            for (UINT uFrom = 0u; uFrom < NUM_FACES; ++uFrom)
+            {
+                if (uFaces & (1u << uFrom))
+                {
+                    for (UINT uTo = 0u; uTo < NUM_FACES; ++uTo)
+                    {
+                        if (uFaces & (1u << uTo))
+                        {
+                            uConnectivity |= faceBit(uFrom, uTo);
+                        }
+                    }
+                }
+            }
+        }
+
+        return uConnectivity;
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::buildRow
+
+      Summary:  Floods the chunks from a source chunk. A chunk is left
+                through a face joined by air to the face it was entered
+                from, and never against a direction already moved
+                along. Paths reaching the same face of a chunk keep the
+                directions they share, which can only add chunks, so
+                the set stays conservative
+
+      Args:     UINT uSourceChunk
+                  Chunk of the row
+                std::vector<BYTE>& aEntryMasks
+                std::vector<UINT>& aQueue
+                  Scratch memory of the calling thread
+
+      Modifies: [m_aVisibility].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelPvs::buildRow(_In_ UINT uSourceChunk, _Inout_ std::vector<BYTE>& aEntryMasks, _Inout_ std::vector<UINT>& aQueue)
+    {
+        UINT64* pRow = &m_aVisibility[static_cast<size_t>(uSourceChunk) * m_uWordsPerRow];
+        pRow[uSourceChunk / 64u] |= 1ull << (uSourceChunk % 64u);
+
+        std::fill(aEntryMasks.begin(), aEntryMasks.end(), UNVISITED);
+        aQueue.clear();
+
+        auto enter = [&](UINT uChunk, UINT uFace, BYTE directions)
+        {
+            BYTE& entryMask = aEntryMasks[static_cast<size_t>(uChunk) * NUM_FACES + uFace];
+            if (entryMask != UNVISITED && (entryMask & directions) == entryMask)
+            {
+                return;
+            }
+
+            entryMask = entryMask == UNVISITED ? directions : static_cast<BYTE>(entryMask & directions);
+            aQueue.push_back(uChunk * NUM_FACES + uFace);
+        };
+
+        // The eye may be anywhere in the source chunk, so every face touched by air is an exit
+        for (UINT uFace = 0u; uFace < NUM_FACES; ++uFace)
+        {
+            UINT uNeighbor = getNeighbor(uSourceChunk, uFace);
+            if ((m_aFaceConnectivity[uSourceChunk] & faceBit(uFace, uFace)) && uNeighbor != INVALID_CHUNK)
+            {
+                enter(uNeighbor, uFace ^ 1u, static_cast<BYTE>(1u << uFace));
+            }
+        }
+
+        for (size_t uHead = 0u; uHead < aQueue.size(); ++uHead)
+        {
+            UINT uChunk = aQueue[uHead] / NUM_FACES;
+            UINT uEntryFace = aQueue[uHead] % NUM_FACES;
+            BYTE directions = aEntryMasks[aQueue[uHead]];
+
+            pRow[uChunk / 64u] |= 1ull << (uChunk % 64u);
+
+            UINT64 uConnectivity = m_aFaceConnectivity[uChunk];
+            for (UINT uExitFace = 0u; uExitFace < NUM_FACES; ++uExitFace)
+            {
+                if (uExitFace == uEntryFace || !(uConnectivity & faceBit(uEntryFace, uExitFace)) || (directions & (1u << (uExitFace ^ 1u))))
+                {
+                    continue;
+                }
+
+                UINT uNeighbor = getNeighbor(uChunk, uExitFace);
+                if (uNeighbor != INVALID_CHUNK)
+                {
+                    enter(uNeighbor, uExitFace ^ 1u, static_cast<BYTE>(directions | (1u << uExitFace)));
+                }
+            }
+        }
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::getNeighbor
+
+      Summary:  Returns the chunk across a face
+
+      Args:     UINT uChunk
+                  Index of the chunk
+                UINT uFace
+                  Face of the chunk, -x, +x, -y, +y, -z, +z
+
+      Returns:  UINT
+                  Index of the neighbor, INVALID_CHUNK outside the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelPvs::getNeighbor(_In_ UINT uChunk, _In_ UINT uFace) const
+    {
+        UINT aCoordinates[3] = { uChunk % m_uNumChunksX, (uChunk / m_uNumChunksX) % m_uNumChunksY, uChunk / (m_uNumChunksX * m_uNumChunksY) };
+        const UINT aNumChunks[3] = { m_uNumChunksX, m_uNumChunksY, m_uNumChunksZ };
+
+        UINT uAxis = uFace / 2u;
+        if (uFace & 1u)
+        {
+            if (++aCoordinates[uAxis] >= aNumChunks[uAxis])
+            {
+                return INVALID_CHUNK;
+            }
+        }
+        else
+        {
+            if (aCoordinates[uAxis] == 0u)
+            {
+                return INVALID_CHUNK;
+            }
+            --aCoordinates[uAxis];
+        }
+
+        return (aCoordinates[2] * m_uNumChunksY + aCoordinates[1]) * m_uNumChunksX + aCoordinates[0];
+    }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPvs::findCell
+
+      Summary:  Returns the grid cell containing a world position
+
+      Args:     const XMFLOAT3& position
+                  World position
+                INT& x
+                INT& y
+                INT& z
+                  Cell coordinates, may lie outside the grid
+
+      Returns:  BOOL
+                  TRUE if the cell lies inside the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelPvs::findCell(_In_ const XMFLOAT3& position, _Out_ INT& x, _Out_ INT& y, _Out_ INT& z) const
+    {
+        x = static_cast<INT>(std::floor((position.x - m_gridOrigin.x) / HeightField::CELL_SIZE + 0.5f));
+        y = static_cast<INT>(std::floor((position.y - m_gridOrigin.y) / HeightField::CELL_SIZE + 0.5f));
+        z = static_cast<INT>(std::floor((position.z - m_gridOrigin.z) / HeightField::CELL_SIZE + 0.5f));
+
+        return x >= 0 && y >= 0 && z >= 0
+            && static_cast<UINT>(x) < m_uNumCellsX && static_cast<UINT>(y) < m_uNumCellsY && static_cast<UINT>(z) < m_uNumCellsZ;
+    }
+}
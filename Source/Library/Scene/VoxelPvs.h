@@ -0,0 +1,104 @@
+/*+===================================================================
+  File:      VOXELPVS.H
+
+  Summary:   VoxelPvs header file contains declarations of VoxelPvs
+             class used for the lab samples of Game Graphics
+             Programming course.
+
+  Classes: VoxelPvs
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Scene/HeightField.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VoxelPvs
+
+      Summary:  Potentially visible set of the voxel grid split into
+                chunks of CHUNK_SIZE cells on each axis. For every
+                chunk the faces joined by air inside the chunk are
+                found first, then a flood fill over the chunks, which
+                never walks back against a direction it already
+                moved along, marks the chunks seen from each chunk in
+                a bitset row. Every row is built independently, so the
+                rows are split over worker threads
+
+      Methods:  Build
+                  Builds the face connectivity and the visibility rows
+                IsBuilt
+                  Returns whether the set has been built
+                FindChunk
+                  Returns the chunk containing a world position
+                IsVisible
+                  Returns whether a chunk is visible from another
+                IsBoxVisible
+                  Returns whether any chunk overlapping a world box is
+                  visible from a chunk
+                GetNumChunks
+                  Returns the number of chunks
+                GetBuildTime
+                  Returns the time the last build took
+                GetAverageVisibleFraction
+                  Returns the fraction of chunks visible on average
+                GetNumThreads
+                  Returns the number of threads of the last build
+                VoxelPvs
+                  Constructor.
+                ~VoxelPvs
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VoxelPvs
+    {
+    public:
+        static constexpr const UINT CHUNK_SIZE_LOG2 = 4u;
+        static constexpr const UINT CHUNK_SIZE = 1u << CHUNK_SIZE_LOG2;
+        static constexpr const UINT INVALID_CHUNK = (0xFFFFFFFF);
+
+    public:
+        VoxelPvs();
+        VoxelPvs(const VoxelPvs& other) = delete;
+        VoxelPvs(VoxelPvs&& other) = delete;
+        VoxelPvs& operator=(const VoxelPvs& other) = delete;
+        VoxelPvs& operator=(VoxelPvs&& other) = delete;
+        ~VoxelPvs() = default;
+
+        HRESULT Build(_In_ const HeightField& heightField, _In_opt_ UINT uNumThreads = 0u);
+        BOOL IsBuilt() const;
+
+        UINT FindChunk(_In_ const XMFLOAT3& position) const;
+        BOOL IsVisible(_In_ UINT uFromChunk, _In_ UINT uToChunk) const;
+        BOOL IsBoxVisible(_In_ UINT uFromChunk, _In_ const XMFLOAT3& boundsMin, _In_ const XMFLOAT3& boundsMax) const;
+
+        UINT GetNumChunks() const;
+        FLOAT GetBuildTime() const;
+        FLOAT GetAverageVisibleFraction() const;
+        UINT GetNumThreads() const;
+
+    private:
+        UINT64 computeFaceConnectivity(_In_ const HeightField& heightField, _In_ UINT uChunkX, _In_ UINT uChunkY, _In_ UINT uChunkZ, _Inout_ std::vector<BYTE>& aVisited, _Inout_ std::vector<UINT>& aStack) const;
+        void buildRow(_In_ UINT uSourceChunk, _Inout_ std::vector<BYTE>& aEntryMasks, _Inout_ std::vector<UINT>& aQueue);
+        UINT getNeighbor(_In_ UINT uChunk, _In_ UINT uFace) const;
+        BOOL findCell(_In_ const XMFLOAT3& position, _Out_ INT& x, _Out_ INT& y, _Out_ INT& z) const;
+
+    private:
+        XMFLOAT3 m_gridOrigin;
+        UINT m_uNumCellsX;
+        UINT m_uNumCellsY;
+        UINT m_uNumCellsZ;
+        UINT m_uNumChunksX;
+        UINT m_uNumChunksY;
+        UINT m_uNumChunksZ;
+        UINT m_uWordsPerRow;
+        std::vector<UINT64> m_aFaceConnectivity;
+        std::vector<UINT64> m_aVisibility;
+        FLOAT m_buildTime;
+        FLOAT m_averageVisibleFraction;
+        UINT m_uNumThreads;
+    };
+}
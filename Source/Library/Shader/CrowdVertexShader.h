@@ -0,0 +1,47 @@
+/*+===================================================================
+  File:      CROWDVERTEXSHADER.H
+
+  Summary:   CrowdVertexShader header file contains declarations of
+             CrowdVertexShader class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: CrowdVertexShader
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Shader/VertexShader.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    CrowdVertexShader
+
+      Summary:  Vertex shader of the skinned crowds. The skinning
+                layout is followed by the instance transform and the
+                instance clip rows and time offset
+
+      Methods:  Initialize
+                  Initializes the vertex shader and the input layout
+                CrowdVertexShader
+                  Constructor.
+                ~CrowdVertexShader
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class CrowdVertexShader : public VertexShader
+    {
+    public:
+        CrowdVertexShader() = delete;
+        CrowdVertexShader(_In_ PCWSTR pszFileName, _In_ PCSTR pszEntryPoint, _In_ PCSTR pszShaderModel);
+        CrowdVertexShader(const CrowdVertexShader& other) = delete;
+        CrowdVertexShader(CrowdVertexShader&& other) = delete;
+        CrowdVertexShader& operator=(const CrowdVertexShader& other) = delete;
+        CrowdVertexShader& operator=(CrowdVertexShader&& other) = delete;
+        virtual ~CrowdVertexShader() = default;
+
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice) override;
+    };
+}
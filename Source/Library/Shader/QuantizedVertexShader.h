@@ -0,0 +1,50 @@
+/*+===================================================================
+  File:      QUANTIZEDVERTEXSHADER.H
+
+  Summary:   QuantizedVertexShader header file contains declarations of
+             QuantizedVertexShader class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: QuantizedVertexShader
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Shader/VertexShader.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    QuantizedVertexShader
+
+      Summary:  Vertex shader of the models with compressed vertices.
+                Positions are UNORM16 in the box of the model, texture
+                coordinates are halves, and the normal and tangent are
+                octahedral with the sign of the bitangent in the alpha
+                bits of the tangent. The bone influences follow as in
+                the skinning layout
+
+      Methods:  Initialize
+                  Initializes the vertex shader and the input layout
+                QuantizedVertexShader
+                  Constructor.
+                ~QuantizedVertexShader
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class QuantizedVertexShader : public VertexShader
+    {
+    public:
+        QuantizedVertexShader() = delete;
+        QuantizedVertexShader(_In_ PCWSTR pszFileName, _In_ PCSTR pszEntryPoint, _In_ PCSTR pszShaderModel);
+        QuantizedVertexShader(const QuantizedVertexShader& other) = delete;
+        QuantizedVertexShader(QuantizedVertexShader&& other) = delete;
+        QuantizedVertexShader& operator=(const QuantizedVertexShader& other) = delete;
+        QuantizedVertexShader& operator=(QuantizedVertexShader&& other) = delete;
+        virtual ~QuantizedVertexShader() = default;
+
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice) override;
+    };
+}
@@ -134,6 +134,36 @@ namespace library
             return hr;
         }
 
+        // Models with compressed vertices, the renderer folds the box of the model into the world matrix
+        D3D11_INPUT_ELEMENT_DESC aQuantizedLayouts[] =
+        {
+            { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "INSTANCE_TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 2, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "INSTANCE_TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 2, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "INSTANCE_TRANSFORM", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 2, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "INSTANCE_TRANSFORM", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 2, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+        };
+        hr = pDevice->CreateInputLayout(aQuantizedLayouts, ARRAYSIZE(aQuantizedLayouts), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), m_quantizedVertexLayout.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
         return hr;
     }
+
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ShadowVertexShader::GetQuantizedVertexLayout
+
+      Summary:  Returns the input layout of the compressed vertices,
+                reading the position only
+
+      Returns:  ComPtr<ID3D11InputLayout>&
+                  Vertex input layout of the compressed vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11InputLayout>& ShadowVertexShader::GetQuantizedVertexLayout()
+    {
+        return m_quantizedVertexLayout;
+    }
 }
\ No newline at end of file
@@ -29,5 +29,10 @@ namespace library
         virtual ~ShadowVertexShader() = default;
 
         virtual HRESULT Initialize(_In_ ID3D11Device* pDevice) override;
+
+        ComPtr<ID3D11InputLayout>& GetQuantizedVertexLayout();
+
+    protected:
+        ComPtr<ID3D11InputLayout> m_quantizedVertexLayout;
     };
 }
\ No newline at end of file
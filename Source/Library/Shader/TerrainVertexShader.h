@@ -0,0 +1,33 @@
+/*+===================================================================
+  File:      TERRAINVERTEXSHADER.H
+
+  Summary:   TerrainVertexShader header file contains declarations of
+             TerrainVertexShader class used for the lab samples of Game
+             Graphics Programming course.
+
+  Classes: TerrainVertexShader
+
+  2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Shader/VertexShader.h"
+
+namespace library
+{
+    class TerrainVertexShader : public VertexShader
+    {
+    public:
+        TerrainVertexShader() = delete;
+        TerrainVertexShader(_In_ PCWSTR pszFileName, _In_ PCSTR pszEntryPoint, _In_ PCSTR pszShaderModel);
+        TerrainVertexShader(const TerrainVertexShader& other) = delete;
+        TerrainVertexShader(TerrainVertexShader&& other) = delete;
+        TerrainVertexShader& operator=(const TerrainVertexShader& other) = delete;
+        TerrainVertexShader& operator=(TerrainVertexShader&& other) = delete;
+        virtual ~TerrainVertexShader() = default;
+
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice) override;
+    };
+}
\ No newline at end of file
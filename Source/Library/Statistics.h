@@ -0,0 +1,54 @@
+/*+===================================================================
+  File:      STATISTICS.H
+
+  Summary:   Statistics header file contains the switch of the
+             statistics the library logs, used for the lab samples
+             of Game Graphics Programming course.
+
+  Classes: Statistics
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <atomic>
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    Statistics
+
+      Summary:  Switch of the load and frame statistics every subsystem
+                reports about itself. It is off unless the game turns
+                it on, and release builds never log them
+
+      Methods:  SetLogging
+                  Turns the statistics on or off
+                IsLogging
+                  Returns whether the statistics are logged
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class Statistics
+    {
+    public:
+        Statistics() = delete;
+
+        static void SetLogging(_In_ BOOL bIsLogging)
+        {
+            sm_bIsLogging = bIsLogging;
+        }
+
+        static BOOL IsLogging()
+        {
+#ifdef _DEBUG
+            return sm_bIsLogging;
+#else
+            return FALSE;
+#endif
+        }
+
+    private:
+        static inline std::atomic<BOOL> sm_bIsLogging = FALSE;
+    };
+}